@@ -11,6 +11,8 @@
 #include <container/array_list.h>
 #include <function/method.h>
 #include <core/Exception.h>
+#include <core/release_queue.h>
+#include <core/shareable.h>
 
 #include <chrono>
 
@@ -24,6 +26,12 @@ namespace asd
 
 	template struct api(application) singleton<thread_loop, thread_local_model>;
 
+	/**
+	 *	@brief
+	 *	Loop of iterations of the current thread. After each pass over the
+	 *	iterations, the loop collects biased references and destroys deferred
+	 *	objects of the thread within the release budget (see release_queue).
+	 */
 	class thread_loop : public singleton<thread_loop, thread_local_model>
 	{
 		friend singleton<thread_loop, thread_local_model>;
@@ -77,6 +85,9 @@ namespace asd
 					if(!context.active)
 						return;
 				}
+
+				biased_refs::collect();
+				release_queue::drain(context.releaseBudget);
 			}
 		}
 
@@ -90,6 +101,15 @@ namespace asd
 			instance().active = false;
 		}
 
+		/**
+		 *	Sets the time which may be spent on destruction of deferred
+		 *	objects after each pass
+		 */
+		static void setReleaseBudget(std::chrono::nanoseconds budget)
+		{
+			instance().releaseBudget = budget;
+		}
+
 		// Conditional iterations
 		template<class F, useif<is_same<decltype(declval<F>()()), int>::value>>
 		static void add(F & iteration)
@@ -131,6 +151,7 @@ namespace asd
 
 		array_list<Iteration> iterations;
 		bool active = false;
+		std::chrono::nanoseconds releaseBudget = 1ms;
 	};
 }
 
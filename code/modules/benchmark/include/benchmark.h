@@ -23,8 +23,11 @@ namespace asd
 		benchmark(const char * title, int count = 1) : title(title), count(count) {}
 		benchmark(const std::string & title, int count = 1) : title(title), count(count) {}
 		
+		/**
+		 *	Prints and returns the average time of N runs in nanoseconds
+		 */
 		template <class F>
-		void operator << (F && func) {
+		long long operator << (F && func) {
 			using namespace std::chrono;
 			static const int N = 100;
 			
@@ -39,6 +42,7 @@ namespace asd
 			}
 			
 			std::cout << title << ": " << t / N << " ns" << std::endl;
+			return t / N;
 		}
 
 		template <class F>
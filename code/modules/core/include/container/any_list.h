@@ -53,6 +53,7 @@ namespace asd
             move,
             destroy,
             size,
+            align,
             type
         };
         
@@ -79,6 +80,11 @@ namespace asd
                     *static_cast<std::size_t *>(destination) = sizeof(T);
                     break;
                 }
+                case operation_t::align: {
+                    assert(source == nullptr);
+                    *static_cast<std::size_t *>(destination) = alignof(T);
+                    break;
+                }
                 case operation_t::type: {
                     assert(source == nullptr);
                     *static_cast<const std::type_info **>(destination) = std::addressof(typeid(T));
@@ -145,6 +151,20 @@ namespace asd
             return size;
         }
         
+        inline std::size_t size_of(manager_t manage) {
+            std::size_t size;
+            manage(operation_t::size, nullptr, std::addressof(size));
+            
+            return size;
+        }
+        
+        inline std::size_t align_of(manager_t manage) {
+            std::size_t alignment;
+            manage(operation_t::align, nullptr, std::addressof(alignment));
+            
+            return alignment;
+        }
+        
         inline const std::type_info & type(const object_info_t & object) {
             const std::type_info * type;
             object.manage(operation_t::type, nullptr, std::addressof(type));
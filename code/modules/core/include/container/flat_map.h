@@ -0,0 +1,183 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+//---------------------------------------------------------------------------
+
+#include <container/flat_table.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace internals
+	{
+		template<class K, class V>
+		struct flat_map_policy
+		{
+			using key_type = K;
+			using value_type = std::pair<const K, V>;
+
+			static const bool constant = false;
+
+			static const K & key(const value_type & value)
+			{
+				return value.first;
+			}
+
+			static std::pair<K &&, V &&> move(value_type & value)
+			{
+				return {std::move(const_cast<K &>(value.first)), std::move(value.second)};
+			}
+		};
+	}
+
+	/**
+	 *	@brief
+	 *	Hash map with open addressing, see internals::flat_table.
+	 *	Has the interface of std::unordered_map without buckets. References to
+	 *	elements are invalidated by rehashing.
+	 */
+	template<class K, class V, class Hash = asd::hash<K>, class Eq = std::equal_to<K>, class Alloc = std::allocator<std::pair<const K, V>>>
+	class flat_map : public internals::flat_table<internals::flat_map_policy<K, V>, Hash, Eq, Alloc>
+	{
+		using base = internals::flat_table<internals::flat_map_policy<K, V>, Hash, Eq, Alloc>;
+
+	public:
+		using mapped_type = V;
+		using typename base::key_type;
+		using typename base::value_type;
+		using typename base::iterator;
+		using typename base::const_iterator;
+
+		using base::base;
+		using base::insert;
+
+		flat_map() {}
+
+		flat_map(std::initializer_list<value_type> list, size_t count = 0, const Hash & hash = Hash(), const Eq & eq = Eq(), const Alloc & alloc = Alloc()) : base(count > list.size() ? count : list.size(), hash, eq, alloc)
+		{
+			insert(list.begin(), list.end());
+		}
+
+		template<class I>
+		flat_map(I first, I last, size_t count = 0, const Hash & hash = Hash(), const Eq & eq = Eq(), const Alloc & alloc = Alloc()) : base(count, hash, eq, alloc)
+		{
+			insert(first, last);
+		}
+
+		flat_map & operator = (std::initializer_list<value_type> list)
+		{
+			this->clear();
+			insert(list);
+			return *this;
+		}
+
+		template<class P, useif<std::is_constructible<value_type, P &&>::value>>
+		std::pair<iterator, bool> insert(P && value)
+		{
+			return this->emplace(std::forward<P>(value));
+		}
+
+		template<class ... A>
+		std::pair<iterator, bool> try_emplace(const K & key, A && ... args)
+		{
+			return try_emplace_impl(key, std::forward<A>(args)...);
+		}
+
+		template<class ... A>
+		std::pair<iterator, bool> try_emplace(K && key, A && ... args)
+		{
+			return try_emplace_impl(std::move(key), std::forward<A>(args)...);
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(const K & key, M && value)
+		{
+			auto r = try_emplace_impl(key, std::forward<M>(value));
+
+			if(!r.second)
+				r.first->second = std::forward<M>(value);
+
+			return r;
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(K && key, M && value)
+		{
+			auto r = try_emplace_impl(std::move(key), std::forward<M>(value));
+
+			if(!r.second)
+				r.first->second = std::forward<M>(value);
+
+			return r;
+		}
+
+		V & operator [] (const K & key)
+		{
+			return try_emplace_impl(key).first->second;
+		}
+
+		V & operator [] (K && key)
+		{
+			return try_emplace_impl(std::move(key)).first->second;
+		}
+
+		V & at(const K & key)
+		{
+			auto it = this->find(key);
+
+			if(it == this->end())
+				throw std::out_of_range("asd::flat_map::at: the key is not found");
+
+			return it->second;
+		}
+
+		const V & at(const K & key) const
+		{
+			return const_cast<flat_map *>(this)->at(key);
+		}
+
+		/**
+		 *	Gets the value by its key and the precomputed hash of the key
+		 */
+		V & at(const K & key, size_t hash)
+		{
+			auto it = this->find(key, hash);
+
+			if(it == this->end())
+				throw std::out_of_range("asd::flat_map::at: the key is not found");
+
+			return it->second;
+		}
+
+		const V & at(const K & key, size_t hash) const
+		{
+			return const_cast<flat_map *>(this)->at(key, hash);
+		}
+
+	private:
+		template<class Key, class ... A>
+		std::pair<iterator, bool> try_emplace_impl(Key && key, A && ... args)
+		{
+			auto r = this->find_or_prepare(key);
+
+			if(r.second)
+				this->construct_at(r.first, std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)), std::forward_as_tuple(std::forward<A>(args)...));
+
+			return {this->iterator_at(r.first), r.second};
+		}
+	};
+
+	template<class K, class V, class Hash, class Eq, class Alloc>
+	void swap(flat_map<K, V, Hash, Eq, Alloc> & a, flat_map<K, V, Hash, Eq, Alloc> & b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,82 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+//---------------------------------------------------------------------------
+
+#include <container/flat_table.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace internals
+	{
+		template<class T>
+		struct flat_set_policy
+		{
+			using key_type = T;
+			using value_type = T;
+
+			static const bool constant = true;
+
+			static const T & key(const value_type & value)
+			{
+				return value;
+			}
+
+			static T && move(value_type & value)
+			{
+				return std::move(value);
+			}
+		};
+	}
+
+	/**
+	 *	@brief
+	 *	Hash set with open addressing, see internals::flat_table.
+	 *	Has the interface of std::unordered_set without buckets.
+	 */
+	template<class T, class Hash = asd::hash<T>, class Eq = std::equal_to<T>, class Alloc = std::allocator<T>>
+	class flat_set : public internals::flat_table<internals::flat_set_policy<T>, Hash, Eq, Alloc>
+	{
+		using base = internals::flat_table<internals::flat_set_policy<T>, Hash, Eq, Alloc>;
+
+	public:
+		using typename base::value_type;
+
+		using base::base;
+
+		flat_set() {}
+
+		flat_set(std::initializer_list<value_type> list, size_t count = 0, const Hash & hash = Hash(), const Eq & eq = Eq(), const Alloc & alloc = Alloc()) : base(count > list.size() ? count : list.size(), hash, eq, alloc)
+		{
+			this->insert(list.begin(), list.end());
+		}
+
+		template<class I>
+		flat_set(I first, I last, size_t count = 0, const Hash & hash = Hash(), const Eq & eq = Eq(), const Alloc & alloc = Alloc()) : base(count, hash, eq, alloc)
+		{
+			this->insert(first, last);
+		}
+
+		flat_set & operator = (std::initializer_list<value_type> list)
+		{
+			this->clear();
+			this->insert(list);
+			return *this;
+		}
+	};
+
+	template<class T, class Hash, class Eq, class Alloc>
+	void swap(flat_set<T, Hash, Eq, Alloc> & a, flat_set<T, Hash, Eq, Alloc> & b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
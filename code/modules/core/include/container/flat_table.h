@@ -0,0 +1,873 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef FLAT_TABLE_H
+#define FLAT_TABLE_H
+
+//---------------------------------------------------------------------------
+
+#include <core/Hash.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace internals
+	{
+		/**
+		 *	@brief
+		 *	Control byte of a slot of the flat table. Full slots store 7 low
+		 *	bits of the hash of their key (h2), other states have the high bit set.
+		 */
+		using flat_ctrl = signed char;
+
+		static const flat_ctrl flat_empty = -128;
+		static const flat_ctrl flat_deleted = -2;
+		static const flat_ctrl flat_sentinel = -1;
+
+		inline uint flat_trailing_zeros(uint64_t bits)
+		{
+#if defined(_MSC_VER) && defined(ARCH_X64)
+			unsigned long index;
+			_BitScanForward64(&index, bits);
+			return index;
+#elif defined(_MSC_VER)
+			unsigned long index;
+
+			if(_BitScanForward(&index, static_cast<unsigned long>(bits)))
+				return index;
+
+			_BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+			return index + 32;
+#else
+			return static_cast<uint>(__builtin_ctzll(bits));
+#endif
+		}
+
+		/**
+		 *	@brief
+		 *	Set of matching slots of a group. Every slot is represented by
+		 *	1 << <shift> bits.
+		 */
+		template<class T, int shift>
+		struct flat_mask
+		{
+			explicit operator bool() const
+			{
+				return bits != 0;
+			}
+
+			uint lowest() const
+			{
+				return flat_trailing_zeros(bits) >> shift;
+			}
+
+			void next()
+			{
+				bits &= bits - 1;
+			}
+
+			T bits;
+		};
+
+#ifdef FLAT_TABLE_SSE2
+		/**
+		 *	@brief
+		 *	Group of 16 control bytes which are matched with SSE2 instructions.
+		 */
+		struct flat_group
+		{
+			using mask = flat_mask<uint, 0>;
+			static const size_t width = 16;
+
+			explicit flat_group(const flat_ctrl * ctrl) : _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl))) {}
+
+			mask match(flat_ctrl h2) const
+			{
+				return {static_cast<uint>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)))};
+			}
+
+			mask match_empty() const
+			{
+				return match(flat_empty);
+			}
+
+			mask match_empty_or_deleted() const
+			{
+				return {static_cast<uint>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(flat_sentinel), _ctrl)))};
+			}
+
+			uint count_leading_empty_or_deleted() const
+			{
+				return flat_trailing_zeros(match_empty_or_deleted().bits + 1);
+			}
+
+		private:
+			__m128i _ctrl;
+		};
+#else
+		/**
+		 *	@brief
+		 *	Group of 8 control bytes which are matched bytewise inside of a
+		 *	64-bit word. match() may report false positives among full slots,
+		 *	so keys of matched slots must be compared anyway.
+		 */
+		struct flat_group
+		{
+			using mask = flat_mask<uint64_t, 3>;
+			static const size_t width = 8;
+
+			explicit flat_group(const flat_ctrl * ctrl)
+			{
+				memcpy(&_ctrl, ctrl, sizeof(_ctrl));
+			}
+
+			mask match(flat_ctrl h2) const
+			{
+				uint64_t x = _ctrl ^ (lsbs * static_cast<unsigned char>(h2));
+				return {(x - lsbs) & ~x & msbs};
+			}
+
+			mask match_empty() const
+			{
+				return {_ctrl & (~_ctrl << 6) & msbs};
+			}
+
+			mask match_empty_or_deleted() const
+			{
+				return {_ctrl & (~_ctrl << 7) & msbs};
+			}
+
+			uint count_leading_empty_or_deleted() const
+			{
+				uint64_t rest = ~match_empty_or_deleted().bits & msbs;
+				return rest != 0 ? flat_trailing_zeros(rest) >> 3 : static_cast<uint>(width);
+			}
+
+		private:
+			static const uint64_t lsbs = 0x0101010101010101ull;
+			static const uint64_t msbs = 0x8080808080808080ull;
+
+			uint64_t _ctrl;
+		};
+#endif
+
+		/**
+		 *	@brief
+		 *	Finalizer of hash values, spreads bits of weak hashes (e.g. identity
+		 *	hashes of integers) over the whole word.
+		 */
+		inline size_t flat_mix(size_t h)
+		{
+#ifdef ARCH_X64
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+#else
+			h ^= h >> 16;
+			h *= 0x85ebca6bu;
+			h ^= h >> 13;
+#endif
+			return h;
+		}
+
+		/**
+		 *	@brief
+		 *	Open-addressing hash table with metadata in the style of Swiss
+		 *	tables. Every slot has one control byte, groups of control bytes are
+		 *	matched at once, so a lookup usually touches one group of control
+		 *	bytes and one slot.
+		 *
+		 *	<Policy> describes stored values: value_type, key_type, key(),
+		 *	move() which allows to move a value including its constant key, and
+		 *	constant which tells that values can't be changed through iterators.
+		 *	Values are moved on rehash, so their move constructors should not
+		 *	throw.
+		 *	Capacity is always a power of 2 minus 1, the load factor is kept
+		 *	below 7/8. Erased slots are marked as deleted and are reclaimed on
+		 *	the next rehash. References and iterators are invalidated by
+		 *	insertions which cause a rehash.
+		 */
+		template<class Policy, class Hash, class Eq, class Alloc>
+		class flat_table
+		{
+			using value_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<typename Policy::value_type>;
+			using value_traits = std::allocator_traits<value_alloc>;
+
+			using slot_type = typename std::aligned_storage<sizeof(typename Policy::value_type), alignof(typename Policy::value_type)>::type;
+			using slot_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<slot_type>;
+			using slot_traits = std::allocator_traits<slot_alloc>;
+
+			static const size_t width = flat_group::width;
+			static const size_t cloned = width - 1;
+
+		public:
+			using key_type = typename Policy::key_type;
+			using value_type = typename Policy::value_type;
+			using size_type = size_t;
+			using difference_type = ptrdiff_t;
+			using hasher = Hash;
+			using key_equal = Eq;
+			using allocator_type = Alloc;
+
+			template<bool isConst>
+			class basic_iterator
+			{
+				friend class flat_table;
+
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = typename Policy::value_type;
+				using difference_type = ptrdiff_t;
+				using reference = std::conditional_t<isConst || Policy::constant, const value_type &, value_type &>;
+				using pointer = std::conditional_t<isConst || Policy::constant, const value_type *, value_type *>;
+
+				basic_iterator() {}
+
+				template<bool otherConst, useif<isConst && !otherConst>>
+				basic_iterator(const basic_iterator<otherConst> & it) : _ctrl(it._ctrl), _slot(it._slot) {}
+
+				reference operator * () const
+				{
+					return *_slot;
+				}
+
+				pointer operator -> () const
+				{
+					return _slot;
+				}
+
+				basic_iterator & operator ++ ()
+				{
+					++_ctrl;
+					++_slot;
+					skip();
+
+					return *this;
+				}
+
+				basic_iterator operator ++ (int)
+				{
+					auto it = *this;
+					++*this;
+					return it;
+				}
+
+				template<bool otherConst>
+				bool operator == (const basic_iterator<otherConst> & it) const
+				{
+					return _ctrl == it._ctrl;
+				}
+
+				template<bool otherConst>
+				bool operator != (const basic_iterator<otherConst> & it) const
+				{
+					return _ctrl != it._ctrl;
+				}
+
+			private:
+				template<bool>
+				friend class basic_iterator;
+
+				basic_iterator(const flat_ctrl * ctrl, value_type * slot) : _ctrl(ctrl), _slot(slot) {}
+
+				void skip()
+				{
+					while(*_ctrl < flat_sentinel)
+					{
+						uint shift = flat_group(_ctrl).count_leading_empty_or_deleted();
+						_ctrl += shift;
+						_slot += shift;
+					}
+				}
+
+				const flat_ctrl * _ctrl = nullptr;
+				value_type * _slot = nullptr;
+			};
+
+			using iterator = std::conditional_t<Policy::constant, basic_iterator<true>, basic_iterator<false>>;
+			using const_iterator = basic_iterator<true>;
+
+			flat_table() {}
+
+			explicit flat_table(size_t count, const Hash & hash = Hash(), const Eq & eq = Eq(), const Alloc & alloc = Alloc()) : _hash(hash), _eq(eq), _alloc(alloc)
+			{
+				reserve(count);
+			}
+
+			flat_table(const flat_table & table) : _hash(table._hash), _eq(table._eq), _alloc(value_traits::select_on_container_copy_construction(table._alloc))
+			{
+				reserve(table._size);
+
+				for(auto & value : table)
+				{
+					size_t hash = hash_of(Policy::key(value));
+					size_t index = find_free(hash);
+
+					value_traits::construct(_alloc, _slots + index, value);
+					set_ctrl(index, h2(hash));
+					--_growthLeft;
+					++_size;
+				}
+			}
+
+			flat_table(flat_table && table) noexcept : _hash(std::move(table._hash)), _eq(std::move(table._eq)), _alloc(std::move(table._alloc))
+			{
+				steal(table);
+			}
+
+			~flat_table()
+			{
+				destroy();
+			}
+
+			flat_table & operator = (const flat_table & table)
+			{
+				if(this != &table)
+				{
+					flat_table copy(table);
+					swap(copy);
+				}
+
+				return *this;
+			}
+
+			flat_table & operator = (flat_table && table) noexcept
+			{
+				if(this != &table)
+				{
+					destroy();
+
+					_hash = std::move(table._hash);
+					_eq = std::move(table._eq);
+					_alloc = std::move(table._alloc);
+					steal(table);
+				}
+
+				return *this;
+			}
+
+			iterator begin()
+			{
+				if(_capacity == 0)
+					return end();
+
+				auto it = iterator_at(0);
+				it.skip();
+				return it;
+			}
+
+			iterator end()
+			{
+				return iterator_at(_capacity);
+			}
+
+			const_iterator begin() const
+			{
+				return const_cast<flat_table *>(this)->begin();
+			}
+
+			const_iterator end() const
+			{
+				return const_cast<flat_table *>(this)->end();
+			}
+
+			const_iterator cbegin() const
+			{
+				return begin();
+			}
+
+			const_iterator cend() const
+			{
+				return end();
+			}
+
+			bool empty() const
+			{
+				return _size == 0;
+			}
+
+			size_t size() const
+			{
+				return _size;
+			}
+
+			size_t capacity() const
+			{
+				return _capacity;
+			}
+
+			float load_factor() const
+			{
+				return _capacity > 0 ? static_cast<float>(_size) / _capacity : 0.0f;
+			}
+
+			void clear()
+			{
+				if(_capacity == 0)
+					return;
+
+				for(size_t i = 0; i < _capacity; ++i)
+				{
+					if(_ctrl[i] >= 0)
+						value_traits::destroy(_alloc, _slots + i);
+				}
+
+				reset_ctrl();
+				_size = 0;
+			}
+
+			/**
+			 *	Makes room for <count> elements without rehashing
+			 */
+			void reserve(size_t count)
+			{
+				if(count > _size + _growthLeft)
+					resize(capacity_for(count));
+			}
+
+			void rehash(size_t count)
+			{
+				resize(capacity_for(count > _size ? count : _size));
+			}
+
+			template<class ... A>
+			std::pair<iterator, bool> emplace(A && ... args)
+			{
+				typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buffer;
+				auto * value = reinterpret_cast<value_type *>(&buffer);
+				value_traits::construct(_alloc, value, std::forward<A>(args)...);
+
+				std::pair<size_t, bool> r;
+
+				try
+				{
+					r = find_or_prepare(Policy::key(*value));
+
+					if(r.second)
+						construct_at(r.first, Policy::move(*value));
+				}
+				catch(...)
+				{
+					value_traits::destroy(_alloc, value);
+					throw;
+				}
+
+				value_traits::destroy(_alloc, value);
+				return {iterator_at(r.first), r.second};
+			}
+
+			std::pair<iterator, bool> insert(const value_type & value)
+			{
+				auto r = find_or_prepare(Policy::key(value));
+
+				if(r.second)
+					construct_at(r.first, value);
+
+				return {iterator_at(r.first), r.second};
+			}
+
+			std::pair<iterator, bool> insert(value_type && value)
+			{
+				auto r = find_or_prepare(Policy::key(value));
+
+				if(r.second)
+					construct_at(r.first, std::move(value));
+
+				return {iterator_at(r.first), r.second};
+			}
+
+			template<class I>
+			void insert(I first, I last)
+			{
+				for(; first != last; ++first)
+					emplace(*first);
+			}
+
+			void insert(std::initializer_list<value_type> list)
+			{
+				reserve(_size + list.size());
+				insert(list.begin(), list.end());
+			}
+
+			iterator find(const key_type & key)
+			{
+				return find(key, _hash(key));
+			}
+
+			const_iterator find(const key_type & key) const
+			{
+				return const_cast<flat_table *>(this)->find(key);
+			}
+
+			/**
+			 *	Finds the key by its precomputed hash (the value of hasher)
+			 */
+			iterator find(const key_type & key, size_t hash)
+			{
+				size_t index = find_index(key, flat_mix(hash));
+				return index != npos ? iterator_at(index) : end();
+			}
+
+			const_iterator find(const key_type & key, size_t hash) const
+			{
+				return const_cast<flat_table *>(this)->find(key, hash);
+			}
+
+			size_t count(const key_type & key) const
+			{
+				return find_index(key, hash_of(key)) != npos ? 1 : 0;
+			}
+
+			bool contains(const key_type & key) const
+			{
+				return find_index(key, hash_of(key)) != npos;
+			}
+
+			iterator erase(const_iterator pos)
+			{
+				size_t index = static_cast<size_t>(pos._ctrl - _ctrl);
+				erase_at(index);
+
+				auto it = iterator_at(index);
+				it.skip();
+				return it;
+			}
+
+			iterator erase(const_iterator first, const_iterator last)
+			{
+				while(first != last)
+					first = erase(first);
+
+				return iterator_at(static_cast<size_t>(last._ctrl - _ctrl));
+			}
+
+			size_t erase(const key_type & key)
+			{
+				size_t index = find_index(key, hash_of(key));
+
+				if(index == npos)
+					return 0;
+
+				erase_at(index);
+				return 1;
+			}
+
+			void swap(flat_table & table) noexcept
+			{
+				using std::swap;
+
+				swap(_hash, table._hash);
+				swap(_eq, table._eq);
+				swap(_alloc, table._alloc);
+				swap(_ctrl, table._ctrl);
+				swap(_slots, table._slots);
+				swap(_capacity, table._capacity);
+				swap(_size, table._size);
+				swap(_growthLeft, table._growthLeft);
+			}
+
+			hasher hash_function() const
+			{
+				return _hash;
+			}
+
+			key_equal key_eq() const
+			{
+				return _eq;
+			}
+
+			allocator_type get_allocator() const
+			{
+				return allocator_type(_alloc);
+			}
+
+		protected:
+			static const size_t npos = static_cast<size_t>(-1);
+
+			size_t hash_of(const key_type & key) const
+			{
+				return flat_mix(_hash(key));
+			}
+
+			static flat_ctrl h2(size_t hash)
+			{
+				return static_cast<flat_ctrl>(hash & 0x7f);
+			}
+
+			static size_t h1(size_t hash)
+			{
+				return hash >> 7;
+			}
+
+			size_t find_index(const key_type & key, size_t hash) const
+			{
+				if(_capacity == 0)
+					return npos;
+
+				size_t offset = h1(hash) & _capacity;
+
+				for(size_t step = 0; step <= _capacity; step += width)
+				{
+					flat_group g(_ctrl + offset);
+
+					for(auto m = g.match(h2(hash)); m; m.next())
+					{
+						size_t index = (offset + m.lowest()) & _capacity;
+
+						if(_eq(Policy::key(_slots[index]), key))
+							return index;
+					}
+
+					if(g.match_empty())
+						return npos;
+
+					offset = (offset + step + width) & _capacity;
+				}
+
+				return npos;
+			}
+
+			/**
+			 *	Returns the index of the key and false if the key is found,
+			 *	otherwise returns the index of a free slot prepared for the key
+			 *	and true. The slot must be constructed by the caller.
+			 */
+			std::pair<size_t, bool> find_or_prepare(const key_type & key)
+			{
+				size_t hash = hash_of(key);
+				size_t index = find_index(key, hash);
+
+				if(index != npos)
+					return {index, false};
+
+				if(_growthLeft == 0)
+				{
+					grow();
+				}
+
+				index = find_free(hash);
+
+				if(_ctrl[index] == flat_empty)
+					--_growthLeft;
+
+				set_ctrl(index, h2(hash));
+				++_size;
+
+				return {index, true};
+			}
+
+			template<class ... A>
+			void construct_at(size_t index, A && ... args)
+			{
+				try
+				{
+					value_traits::construct(_alloc, _slots + index, std::forward<A>(args)...);
+				}
+				catch(...)
+				{
+					set_ctrl(index, flat_deleted);
+					--_size;
+					throw;
+				}
+			}
+
+			iterator iterator_at(size_t index)
+			{
+				return {_ctrl + index, _slots + index};
+			}
+
+			value_type & value_at(size_t index)
+			{
+				return _slots[index];
+			}
+
+		private:
+			/**
+			 *	Groups which start at any slot must fit into the slots and their
+			 *	clones, so the capacity is never less than the group width - 1.
+			 */
+			static size_t capacity_for(size_t count)
+			{
+				if(count == 0)
+					return 0;
+
+				size_t capacity = width - 1;
+
+				while(growth_of(capacity) < count)
+					capacity = capacity * 2 + 1;
+
+				return capacity;
+			}
+
+			static size_t growth_of(size_t capacity)
+			{
+				return capacity == 7 ? 6 : capacity - capacity / 8;
+			}
+
+			size_t find_free(size_t hash) const
+			{
+				size_t offset = h1(hash) & _capacity;
+
+				for(size_t step = 0;; step += width)
+				{
+					flat_group g(_ctrl + offset);
+					auto m = g.match_empty_or_deleted();
+
+					if(m)
+						return (offset + m.lowest()) & _capacity;
+
+					offset = (offset + step + width) & _capacity;
+				}
+			}
+
+			void set_ctrl(size_t index, flat_ctrl h)
+			{
+				_ctrl[index] = h;
+				_ctrl[((index - cloned) & _capacity) + (cloned & _capacity)] = h;
+			}
+
+			void reset_ctrl()
+			{
+				memset(_ctrl, flat_empty, _capacity + width);
+				_ctrl[_capacity] = flat_sentinel;
+				_growthLeft = growth_of(_capacity);
+			}
+
+			void erase_at(size_t index)
+			{
+				value_traits::destroy(_alloc, _slots + index);
+				set_ctrl(index, flat_deleted);
+				--_size;
+			}
+
+			/**
+			 *	Doubles the capacity, or only drops deleted slots if there are
+			 *	many of them
+			 */
+			void grow()
+			{
+				if(_capacity > width && _size <= growth_of(_capacity) / 2)
+					resize(_capacity);
+				else
+					resize(_capacity == 0 ? width - 1 : _capacity * 2 + 1);
+			}
+
+			static size_t slots_count(size_t capacity)
+			{
+				return capacity + (capacity + width + sizeof(slot_type) - 1) / sizeof(slot_type);
+			}
+
+			void resize(size_t capacity)
+			{
+				auto * oldCtrl = _ctrl;
+				auto * oldSlots = _slots;
+				auto oldCapacity = _capacity;
+
+				if(capacity > 0)
+				{
+					slot_alloc alloc(_alloc);
+					auto * slots = slot_traits::allocate(alloc, slots_count(capacity));
+
+					_slots = reinterpret_cast<value_type *>(slots);
+					_ctrl = reinterpret_cast<flat_ctrl *>(slots + capacity);
+				}
+				else
+				{
+					_slots = nullptr;
+					_ctrl = nullptr;
+				}
+
+				_capacity = capacity;
+
+				if(_capacity > 0)
+					reset_ctrl();
+				else
+					_growthLeft = 0;
+
+				_growthLeft -= _size;
+
+				for(size_t i = 0; i < oldCapacity; ++i)
+				{
+					if(oldCtrl[i] < 0)
+						continue;
+
+					size_t hash = hash_of(Policy::key(oldSlots[i]));
+					size_t index = find_free(hash);
+
+					value_traits::construct(_alloc, _slots + index, Policy::move(oldSlots[i]));
+					value_traits::destroy(_alloc, oldSlots + i);
+					set_ctrl(index, h2(hash));
+				}
+
+				if(oldCapacity > 0)
+				{
+					slot_alloc alloc(_alloc);
+					slot_traits::deallocate(alloc, reinterpret_cast<slot_type *>(oldSlots), slots_count(oldCapacity));
+				}
+			}
+
+			void destroy()
+			{
+				if(_capacity == 0)
+					return;
+
+				clear();
+
+				slot_alloc alloc(_alloc);
+				slot_traits::deallocate(alloc, reinterpret_cast<slot_type *>(_slots), slots_count(_capacity));
+
+				_ctrl = nullptr;
+				_slots = nullptr;
+				_capacity = 0;
+				_growthLeft = 0;
+			}
+
+			void steal(flat_table & table)
+			{
+				_ctrl = table._ctrl;
+				_slots = table._slots;
+				_capacity = table._capacity;
+				_size = table._size;
+				_growthLeft = table._growthLeft;
+
+				table._ctrl = nullptr;
+				table._slots = nullptr;
+				table._capacity = 0;
+				table._size = 0;
+				table._growthLeft = 0;
+			}
+
+			Hash _hash;
+			Eq _eq;
+			value_alloc _alloc;
+
+			flat_ctrl * _ctrl = nullptr;
+			value_type * _slots = nullptr;
+			size_t _capacity = 0;
+			size_t _size = 0;
+			size_t _growthLeft = 0;
+		};
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -9,6 +9,7 @@
 
 #include <core/handle.h>
 #include <container/container.h>
+#include <container/flat_map.h>
 
 #include <map>
 #include <unordered_map>
@@ -38,12 +39,15 @@ namespace asd
 	using std::dictionary;
 	using std::multidictionary;
 	
-	#ifdef USE_STD_UNORDERED_MAP
-		template<class Key, class Val, class Hash = std::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<Key, Val>>>
+	#if defined(USE_STD_UNORDERED_MAP)
+		template<class Key, class Val, class Hash = asd::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<const Key, Val>>>
 		using map = std::unordered_map<Key, Val, Hash, EqualTo, Alloc>;
-	#else
-		template<class Key, class Val, class Hash = std::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<Key, Val>>>
+	#elif defined(USE_HOPSCOTCH_MAP)
+		template<class Key, class Val, class Hash = asd::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<Key, Val>>>
 		using map = tsl::hopscotch_map<Key, Val, Hash, EqualTo, Alloc, 30, true>;
+	#else
+		template<class Key, class Val, class Hash = asd::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<const Key, Val>>>
+		using map = flat_map<Key, Val, Hash, EqualTo, Alloc>;
 	#endif
 	
 	template<class K, class T, class Hasher =  asd::hash<K>, class Eq = asd::equal_to<K>, class Alloc = std::allocator<std::pair<const K, T>>>
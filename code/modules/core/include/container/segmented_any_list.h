@@ -0,0 +1,500 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef SEGMENTED_ANY_LIST_H
+#define SEGMENTED_ANY_LIST_H
+
+//---------------------------------------------------------------------------
+
+#include <container/any_list.h>
+#include <meta/class_id.hpp>
+
+#include <cstddef>
+#include <new>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+    namespace detail
+    {
+        struct any_type_origin {};
+
+        /**
+         *  Dense id of the type among all types stored in segmented lists
+         */
+        template <typename T>
+        const class_id_t any_type_id = relative_class_id<T, any_type_origin>;
+
+        struct any_entry_t
+        {
+            std::int8_t * pointer;
+            std::size_t offset;
+            management::manager_t manage;
+            class_id_t type;
+        };
+
+        /**
+         *  Table of handlers of the functor F indexed by any_type_id of
+         *  Types. One table is built per functor type and set of types.
+         */
+        template <typename F, typename ... Types>
+        class any_jump_table
+        {
+        public:
+            using handler_type = void (*)(F &, void *);
+
+            static const any_jump_table & instance() {
+                static const any_jump_table table;
+                return table;
+            }
+
+            handler_type operator [](class_id_t type) const {
+                return type < m_handlers.size() ? m_handlers[type] : nullptr;
+            }
+
+        private:
+            any_jump_table() {
+                const class_id_t ids[] = {any_type_id<std::remove_const_t<Types>>...};
+                m_handlers.resize(*std::max_element(std::begin(ids), std::end(ids)) + 1, nullptr);
+
+                using swallow = int[];
+                (void)swallow{(m_handlers[any_type_id<std::remove_const_t<Types>>] = &invoke<Types>, 0)...};
+            }
+
+            template <typename T>
+            static void invoke(F & f, void * object) {
+                f(*static_cast<T *>(object));
+            }
+
+            std::vector<handler_type> m_handlers;
+        };
+
+        constexpr std::size_t floor_log2(std::size_t n) {
+            return n > 1 ? floor_log2(n >> 1) + 1 : 0;
+        }
+    }
+
+    /**
+     *  @brief
+     *  Heterogeneous list which never relocates its elements.
+     *
+     *  The first InlineSize bytes are stored inside of the list, next bytes
+     *  are stored in segments taken from the Allocator. Every next segment is
+     *  twice as large as the previous one, so the segment of an offset is
+     *  found by its binary logarithm. Elements are not moved or copied when
+     *  the list grows, pointers to elements and their offsets stay valid
+     *  until the element is removed.
+     *
+     *  clear() keeps the segments, so lists which are refilled every frame
+     *  (e.g. command lists) don't allocate memory after warming up.
+     *
+     *  for_each<Types...>() dispatches elements to the functor through a
+     *  jump table indexed by the type id of the element, elements of other
+     *  types are skipped.
+     *
+     *  InlineSize must be a power of 2. Pointers to the elements of the
+     *  inline buffer are invalidated when the list is moved.
+     */
+    template <std::size_t InlineSize = 256, typename Allocator = std::allocator<std::int8_t>>
+    class segmented_any_list
+    {
+        static_assert(InlineSize >= sizeof(std::max_align_t) && (InlineSize & (InlineSize - 1)) == 0,
+            "InlineSize must be a power of 2 which is not less than sizeof(std::max_align_t)");
+
+        using block_type = std::max_align_t;
+        using allocator_traits = std::allocator_traits<Allocator>;
+        using block_allocator_type = typename allocator_traits::template rebind_alloc<block_type>;
+        using block_allocator_traits = std::allocator_traits<block_allocator_type>;
+        using entry_allocator_type = typename allocator_traits::template rebind_alloc<detail::any_entry_t>;
+        using entry_container_type = std::vector<detail::any_entry_t, entry_allocator_type>;
+
+    public:
+        using size_type = typename entry_container_type::size_type;
+        using allocator_type = Allocator;
+
+        static const std::size_t MAX_SEGMENTS = sizeof(std::size_t) * 8 - detail::floor_log2(InlineSize);
+
+    public:
+        explicit segmented_any_list(const Allocator & allocator = Allocator()) :
+            m_allocator(allocator),
+            m_objects(entry_allocator_type(allocator)) {
+        }
+
+        segmented_any_list(segmented_any_list && that) :
+            m_allocator(that.m_allocator),
+            m_objects(entry_allocator_type(that.m_allocator)) {
+            take(that);
+        }
+
+        segmented_any_list & operator =(segmented_any_list && that) {
+            if(this != &that) {
+                clear();
+                release_segments(0);
+
+                m_allocator = that.m_allocator;
+                take(that);
+            }
+
+            return *this;
+        }
+
+        segmented_any_list(const segmented_any_list & that) :
+            m_allocator(block_allocator_traits::select_on_container_copy_construction(that.m_allocator)),
+            m_objects(entry_allocator_type(m_allocator)) {
+            append(that);
+        }
+
+        segmented_any_list & operator =(const segmented_any_list & that) {
+            if(this != &that) {
+                clear();
+                append(that);
+            }
+
+            return *this;
+        }
+
+        ~segmented_any_list() {
+            destroy_all();
+            release_segments(0);
+        }
+
+        /**
+         *  Allocates segments until the list can hold new_capacity bytes
+         */
+        void reserve(std::size_t new_capacity) {
+            for(std::size_t k = 1; k < MAX_SEGMENTS && segment_begin(k) < new_capacity; ++k) {
+                acquire_segment(k);
+            }
+        }
+
+        /**
+         *  Returns the segments which are placed after the last element
+         */
+        void shrink_to_fit() {
+            release_segments(m_segment);
+            m_objects.shrink_to_fit();
+        }
+
+        template <typename T>
+        void push_back(T && object) {
+            emplace_back<std::decay_t<T>>(std::forward<T>(object));
+        }
+
+        template <typename T, typename ... A>
+        std::decay_t<T> & emplace_back(A && ... args) {
+            using raw_type = std::decay_t<T>;
+
+            const auto segment = m_segment;
+            const auto position = m_position;
+            std::size_t offset;
+            auto creation_place = allocate(sizeof(raw_type), alignof(raw_type), offset);
+
+            try {
+                new(creation_place) raw_type(std::forward<A>(args)...);
+            }
+            catch(...) {
+                m_segment = segment;
+                m_position = position;
+                throw;
+            }
+
+            try {
+                m_objects.push_back({creation_place, offset, &management::manage<raw_type>, detail::any_type_id<raw_type>});
+            }
+            catch(...) {
+                management::destroy<raw_type>(creation_place);
+                m_segment = segment;
+                m_position = position;
+                throw;
+            }
+
+            return *static_cast<raw_type *>(static_cast<void *>(creation_place));
+        }
+
+        void pop_back() {
+            auto & object = m_objects.back();
+            object.manage(management::operation_t::destroy, nullptr, object.pointer);
+
+            m_segment = segment_of(object.offset);
+            m_position = object.offset - segment_begin(m_segment);
+            m_objects.pop_back();
+        }
+
+        void clear() {
+            destroy_all();
+            m_objects.clear();
+            m_segment = 0;
+            m_position = 0;
+        }
+
+        template <typename T>
+        const T & get(size_type index) const {
+            assert(&management::manage<T> == m_objects[index].manage);
+            return *static_cast<const T *>(static_cast<const void *>(m_objects[index].pointer));
+        }
+
+        template <typename T>
+        T & get(size_type index) {
+            assert(&management::manage<T> == m_objects[index].manage);
+            return *static_cast<T *>(static_cast<void *>(m_objects[index].pointer));
+        }
+
+        size_type offset(size_type index) const {
+            return m_objects[index].offset;
+        }
+
+        template <typename T>
+        const T & get_by_offset(size_type offset) const {
+            return *static_cast<const T *>(static_cast<const void *>(address(offset)));
+        }
+
+        template <typename T>
+        T & get_by_offset(size_type offset) {
+            return *static_cast<T *>(static_cast<void *>(address(offset)));
+        }
+
+        /**
+         *  Calls f(T &) for every element of one of Types
+         */
+        template <typename ... Types, typename F>
+        void for_each(F && f) {
+            auto & table = detail::any_jump_table<std::remove_reference_t<F>, Types...>::instance();
+
+            for(auto & object : m_objects) {
+                if(auto handler = table[object.type]) {
+                    handler(f, object.pointer);
+                }
+            }
+        }
+
+        /**
+         *  Calls f(const T &) for every element of one of Types
+         */
+        template <typename ... Types, typename F>
+        void for_each(F && f) const {
+            auto & table = detail::any_jump_table<std::remove_reference_t<F>, const Types...>::instance();
+
+            for(auto & object : m_objects) {
+                if(auto handler = table[object.type]) {
+                    handler(f, object.pointer);
+                }
+            }
+        }
+
+        /**
+         *  Calls f(T &) if the element at the index is one of Types,
+         *  returns false otherwise
+         */
+        template <typename ... Types, typename F>
+        bool visit(size_type index, F && f) {
+            auto & table = detail::any_jump_table<std::remove_reference_t<F>, Types...>::instance();
+            auto & object = m_objects[index];
+
+            if(auto handler = table[object.type]) {
+                handler(f, object.pointer);
+                return true;
+            }
+
+            return false;
+        }
+
+        size_type size() const {
+            return m_objects.size();
+        }
+
+        std::size_t volume() const {
+            return segment_begin(m_segment) + m_position;
+        }
+
+        std::size_t capacity() const {
+            std::size_t capacity = InlineSize;
+
+            for(std::size_t k = 1; k < MAX_SEGMENTS; ++k) {
+                if(m_segments[k] != nullptr) {
+                    capacity += segment_capacity(k);
+                }
+            }
+
+            return capacity;
+        }
+
+        bool empty() const {
+            return m_objects.empty();
+        }
+
+        const std::type_info & type(size_type index) const {
+            return management::type(management::object_info_t{m_objects[index].offset, m_objects[index].manage});
+        }
+
+        class_id_t type_id(size_type index) const {
+            return m_objects[index].type;
+        }
+
+        allocator_type get_allocator() const {
+            return allocator_type(m_allocator);
+        }
+
+    private:
+        static constexpr std::size_t segment_capacity(std::size_t k) {
+            return InlineSize << k;
+        }
+
+        static constexpr std::size_t segment_begin(std::size_t k) {
+            return InlineSize * ((std::size_t{1} << k) - 1);
+        }
+
+        static std::size_t segment_of(std::size_t offset) {
+            std::size_t k = 0;
+
+            for(auto n = offset / InlineSize + 1; n > 1; n >>= 1) {
+                ++k;
+            }
+
+            return k;
+        }
+
+        std::int8_t * address(std::size_t offset) const {
+            auto k = segment_of(offset);
+            return segment(k) + (offset - segment_begin(k));
+        }
+
+        std::int8_t * segment(std::size_t k) const {
+            return k == 0 ? const_cast<std::int8_t *>(m_inline) : m_segments[k];
+        }
+
+        std::int8_t * acquire_segment(std::size_t k) {
+            if(k > 0 && m_segments[k] == nullptr) {
+                auto * blocks = block_allocator_traits::allocate(m_allocator, segment_capacity(k) / sizeof(block_type));
+                m_segments[k] = static_cast<std::int8_t *>(static_cast<void *>(std::addressof(*blocks)));
+            }
+
+            return segment(k);
+        }
+
+        void release_segments(std::size_t last) {
+            for(std::size_t k = std::max<std::size_t>(last + 1, 1); k < MAX_SEGMENTS; ++k) {
+                if(m_segments[k] != nullptr) {
+                    block_allocator_traits::deallocate(m_allocator, static_cast<block_type *>(static_cast<void *>(m_segments[k])), segment_capacity(k) / sizeof(block_type));
+                    m_segments[k] = nullptr;
+                }
+            }
+        }
+
+        /**
+         *  Reserves size bytes aligned by alignment at the end of the list.
+         *  Skips the rest of the current segment if the object doesn't fit.
+         */
+        std::int8_t * allocate(std::size_t size, std::size_t alignment, std::size_t & offset) {
+            while(true) {
+                if(size <= segment_capacity(m_segment) - m_position) {
+                    auto * base = acquire_segment(m_segment);
+                    void * creation_place = base + m_position;
+                    auto space_left = segment_capacity(m_segment) - m_position;
+
+                    if(std::align(alignment, size, creation_place, space_left)) {
+                        auto local = static_cast<std::size_t>(static_cast<std::int8_t *>(creation_place) - base);
+
+                        offset = segment_begin(m_segment) + local;
+                        m_position = local + size;
+
+                        return base + local;
+                    }
+                }
+
+                if(m_segment + 1 >= MAX_SEGMENTS) {
+                    throw std::bad_alloc();
+                }
+
+                ++m_segment;
+                m_position = 0;
+            }
+        }
+
+        void append(const segmented_any_list & that) {
+            for(auto & object : that.m_objects) {
+                const auto segment = m_segment;
+                const auto position = m_position;
+                std::size_t offset;
+                auto creation_place = allocate(management::size_of(object.manage), management::align_of(object.manage), offset);
+
+                try {
+                    object.manage(management::operation_t::copy, object.pointer, creation_place);
+                }
+                catch(...) {
+                    m_segment = segment;
+                    m_position = position;
+                    throw;
+                }
+
+                try {
+                    m_objects.push_back({creation_place, offset, object.manage, object.type});
+                }
+                catch(...) {
+                    object.manage(management::operation_t::destroy, nullptr, creation_place);
+                    m_segment = segment;
+                    m_position = position;
+                    throw;
+                }
+            }
+        }
+
+        /**
+         *  Moves the elements of the inline buffer and takes all other
+         *  segments of that list. Leaves that list empty.
+         */
+        void take(segmented_any_list & that) {
+            auto inline_end = that.m_objects.begin();
+
+            for(; inline_end != that.m_objects.end() && inline_end->offset < InlineSize; ++inline_end) {
+                try {
+                    inline_end->manage(management::operation_t::move, inline_end->pointer, m_inline + inline_end->offset);
+                }
+                catch(...) {
+                    for(auto i = that.m_objects.begin(); i != inline_end; ++i) {
+                        i->manage(management::operation_t::destroy, nullptr, m_inline + i->offset);
+                    }
+
+                    throw;
+                }
+            }
+
+            for(auto i = that.m_objects.begin(); i != inline_end; ++i) {
+                i->manage(management::operation_t::destroy, nullptr, i->pointer);
+                i->pointer = m_inline + i->offset;
+            }
+
+            m_objects = std::move(that.m_objects);
+            that.m_objects.clear();
+
+            for(std::size_t k = 1; k < MAX_SEGMENTS; ++k) {
+                m_segments[k] = that.m_segments[k];
+                that.m_segments[k] = nullptr;
+            }
+
+            m_segment = that.m_segment;
+            m_position = that.m_position;
+            that.m_segment = 0;
+            that.m_position = 0;
+        }
+
+        void destroy_all() {
+            for(auto & object : m_objects) {
+                object.manage(management::operation_t::destroy, nullptr, object.pointer);
+            }
+        }
+
+        block_allocator_type m_allocator;
+        entry_container_type m_objects;
+
+        std::int8_t * m_segments[MAX_SEGMENTS] = {};
+        std::size_t m_segment = 0;
+        std::size_t m_position = 0;
+
+        alignas(std::max_align_t) std::int8_t m_inline[InlineSize];
+    };
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -8,6 +8,7 @@
 //---------------------------------------------------------------------------
 
 #include <core/handle.h>
+#include <container/flat_set.h>
 
 #include <set>
 #include <unordered_set>
@@ -19,8 +20,13 @@ namespace asd
 	template<class T, class Pred = less<T>, class Alloc = std::allocator<T>>
 	using set = std::set<T, Pred, Alloc>;
 
+#ifdef USE_STD_UNORDERED_MAP
 	template<class T, class Hasher = hash<T>, class Eq = equal_to<T>, class Alloc = std::allocator<T>>
 	using unordered_set = std::unordered_set<T, Hasher, Eq, Alloc>;
+#else
+	template<class T, class Hasher = hash<T>, class Eq = equal_to<T>, class Alloc = std::allocator<T>>
+	using unordered_set = flat_set<T, Hasher, Eq, Alloc>;
+#endif
 
 	template<class T, class Pred = less<T>, class Alloc = std::allocator<T>>
 	using multiset = std::multiset<T, Pred, Alloc>;
@@ -53,7 +53,7 @@ namespace asd
 
 	public:
 		template<typename ... A, useif<can_construct<T, A...>::value>>
-		hashed(A &&... args) : T(forward<A>(args)...), _hashValue(asd::hash<hashed>()(static_cast<const T &>(*this))) {}
+		hashed(A &&... args) : T(forward<A>(args)...), _hashValue(asd::hash<T>()(static_cast<const T &>(*this))) {}
 
 		hashed(const hashed & val) : T(val), _hashValue(val._hashValue) {}
 		hashed(hashed && val) : T(forward<hashed>(val)), _hashValue(val._hashValue) {}
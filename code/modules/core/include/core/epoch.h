@@ -0,0 +1,87 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+//---------------------------------------------------------------------------
+
+#include <meta/macro.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	/**
+	 *  @brief
+	 *  Epoch-based reclamation of objects which are read without locks.
+	 *	Readers access shared objects inside of an epoch::guard, writers
+	 *	unlink objects and retire them. Retired objects are destroyed when
+	 *	no thread can see them anymore, i.e. every thread which was inside of
+	 *	a guard at the moment of retirement has left it.
+	 *
+	 *	Entering and leaving guards is wait-free, guards may be nested.
+	 *	Retirement and collection take a lock and are meant for rarely
+	 *	changed data. Objects left on exit are destroyed with the process.
+	 */
+	class epoch
+	{
+	public:
+		struct record;
+
+		class guard
+		{
+			deny_copy(guard);
+
+		public:
+			guard() : _record(enter()) {}
+
+			~guard()
+			{
+				leave(_record);
+			}
+
+		private:
+			record * _record;
+		};
+
+		template<class T>
+		static void retire(const T * object)
+		{
+			retire(object, &destroy<T>);
+		}
+
+		api(core)
+		static void retire(const void * object, void (* destroy)(const void *));
+
+		/**
+		 *  Advances the epoch if possible and destroys retired objects which
+		 *	can't be seen by readers. Returns the count of destroyed objects.
+		 */
+		api(core)
+		static size_t collect();
+
+		/**
+		 *  Count of retired objects which are not destroyed yet
+		 */
+		api(core)
+		static size_t pending();
+
+	private:
+		template<class T>
+		static void destroy(const void * object)
+		{
+			delete static_cast<const T *>(object);
+		}
+
+		api(core)
+		static record * enter();
+
+		api(core)
+		static void leave(record * r);
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
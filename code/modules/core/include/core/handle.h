@@ -132,7 +132,7 @@ namespace asd
         }
         
         size_t refs() const {
-            return pointer()->_refs;
+            return pointer()->_refs.count();
         }
         
         template<typename ... A, selectif(0)<can_construct<T, A...>::value> >
@@ -143,10 +143,10 @@ namespace asd
         
         template<typename ... A, selectif(0)<can_construct<T, A...>::value> >
         static handle create(A && ... args) {
-            T * ptr = new T(std::forward<A>(args)...);
-            --ptr->_refs;
+            handle h;
+            static_cast<base &>(h) = base(new T(std::forward<A>(args)...), false);
             
-            return ptr;
+            return h;
         }
         
         template<typename ... A, selectif(1)<cant_construct<T, A...>::value, is_abstract<T>::value> >
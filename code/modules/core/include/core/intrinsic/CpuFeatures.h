@@ -0,0 +1,121 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+//---------------------------------------------------------------------------
+
+#include <meta/macro.h>
+#include <utility>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	/**
+	 *	@brief
+	 *	Instruction set paths which are chosen at runtime. Each path includes
+	 *	all previous ones:
+	 *	sse2	- SSE2 (the baseline of x86-64)
+	 *	sse4	- SSE4.1
+	 *	avx2	- AVX2, FMA3 and F16C
+	 *	avx512	- AVX-512F and FMA3
+	 */
+	enum class simd_path
+	{
+		sse2,
+		sse4,
+		avx2,
+		avx512
+	};
+
+	/**
+	 *	@brief
+	 *	Instruction sets supported by the processor and the operating system.
+	 *	Features are detected once on the first call of get().
+	 */
+	struct cpu_features
+	{
+		bool sse3 = false;
+		bool ssse3 = false;
+		bool sse41 = false;
+		bool sse42 = false;
+		bool avx = false;
+		bool avx2 = false;
+		bool fma = false;
+		bool f16c = false;
+		bool avx512f = false;
+		bool avx512dq = false;
+		bool avx512vl = false;
+
+		/**
+		 *	The widest path supported by the processor
+		 */
+		simd_path best() const
+		{
+			return
+				avx512f && fma ? simd_path::avx512 :
+				avx2 && fma && f16c ? simd_path::avx2 :
+				sse41 ? simd_path::sse4 :
+				simd_path::sse2;
+		}
+
+		api(core)
+		static const cpu_features & get();
+	};
+
+	/**
+	 *	Path used by runtime-dispatched kernels: the best path of the processor
+	 *	limited by limit_simd_path()
+	 */
+	api(core)
+	simd_path current_simd_path();
+
+	/**
+	 *	Limits paths of runtime-dispatched kernels, e.g. to compare them in
+	 *	benchmarks. Paths which are not supported are never used anyway.
+	 */
+	api(core)
+	void limit_simd_path(simd_path path);
+
+	api(core)
+	const char * simd_path_name(simd_path path);
+
+	/**
+	 *	@brief
+	 *	Set of implementations of the same function compiled for different
+	 *	paths, usually in separate translation units with their own compiler
+	 *	flags. Calls the widest implementation allowed by current_simd_path(),
+	 *	missing (null) implementations fall back to narrower paths, so the
+	 *	sse2 one must always be present.
+	 */
+	template<class F>
+	struct simd_dispatch
+	{
+		constexpr simd_dispatch(F * sse2, F * sse4 = nullptr, F * avx2 = nullptr, F * avx512 = nullptr) : paths {sse2, sse4, avx2, avx512} {}
+
+		F * get() const
+		{
+			for(int i = static_cast<int>(current_simd_path()); i > 0; --i)
+			{
+				if(paths[i] != nullptr)
+					return paths[i];
+			}
+
+			return paths[0];
+		}
+
+		template<class ... A>
+		decltype(auto) operator()(A && ... args) const
+		{
+			return get()(std::forward<A>(args)...);
+		}
+
+		F * paths[4];
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -13,6 +13,11 @@
 #include <meta/bitmask.h>
 #include <cmath>
 
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
 //---------------------------------------------------------------------------
 
 namespace asd
@@ -28,11 +33,11 @@ namespace asd
 
 	namespace internals
 	{
-		template<class T, template<class T> class Constant, class S>
+		template<class T, template<class> class Constant, class S>
 		struct intrinsic_mask {};
 	}
 
-	template<class T, template<class T> class Constant, size_t Mask, int N = 4>
+	template<class T, template<class> class Constant, size_t Mask, int N = 4>
 	struct IntrinsicMask
 	{
 		template<useif<Intrinsic<T, N>::implemented>>
@@ -44,12 +49,8 @@ namespace asd
 
 	template struct api(core) IntrinData<int, 4>;
 	template struct api(core) IntrinData<float, 4>;
-
-#if SIMD_LEVEL >= SIMD_AVX
 	template struct api(core) IntrinData<double, 4>;
 
-#define _mm256_reverse_pd(a) _mm256_permute4x64_pd(a, reverse_shuffle_4)
-
 #define intrinsic_constant(name)				\
 	template<class T>							\
 	struct name									\
@@ -61,22 +62,7 @@ namespace asd
 	template struct api(core) name<int>;		\
 	template struct api(core) name<int64>;		\
 	template struct api(core) name<float>;		\
-	template struct api(core) name<double>;		\
-
-#else
-
-#define intrinsic_constant(name)				\
-	template<class T>							\
-	struct name									\
-	{											\
-		static const T value;					\
-	};											\
-												\
-	template struct api(core) name<byte>;		\
-	template struct api(core) name<int>;		\
-	template struct api(core) name<int64>;		\
-	template struct api(core) name<float>;
-#endif
+	template struct api(core) name<double>;
 
 	intrinsic_constant(IntrinZero);
 	intrinsic_constant(IntrinMax);
@@ -679,11 +665,21 @@ namespace asd
 			return _mm_load_ps(in);
 		}
 
+		static inline type __vectorcall load_unaligned(const float * in)
+		{
+			return _mm_loadu_ps(in);
+		}
+
 		static inline void __vectorcall store(in_type in, float * out)
 		{
 			_mm_store_ps(out, in);
 		}
 
+		static inline void __vectorcall store_unaligned(in_type in, float * out)
+		{
+			_mm_storeu_ps(out, in);
+		}
+
 		static inline void __vectorcall store(in_type in, type & out)
 		{
 			_mm_store_ps(reinterpret_cast<float *>(&out), in);
@@ -729,6 +725,31 @@ namespace asd
 			return sub(a, mul(trunc(div(a, b)), b));
 		}
 
+		/**
+		 *	a * b + c, fused if the translation unit is compiled with FMA.
+		 *	Always inlined as the code depends on compiler flags.
+		 */
+		static forceinline type __vectorcall fmadd(in_type a, in_type b, in_type c)
+		{
+		#ifdef SIMD_FMA
+			return _mm_fmadd_ps(a, b, c);
+		#else
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+		#endif
+		}
+
+		/**
+		 *	c - a * b
+		 */
+		static forceinline type __vectorcall fnmadd(in_type a, in_type b, in_type c)
+		{
+		#ifdef SIMD_FMA
+			return _mm_fnmadd_ps(a, b, c);
+		#else
+			return _mm_sub_ps(c, _mm_mul_ps(a, b));
+		#endif
+		}
+
 		static inline type __vectorcall sqr(in_type a)
 		{
 			return mul(a, a);
@@ -778,6 +799,14 @@ namespace asd
 			return _mm_sqrt_ps(a);
 		}
 
+		/**
+		 *	Approximate 1 / sqrt(a), relative error < 1.5 * 2^-12
+		 */
+		static inline type __vectorcall rsqrt(in_type a)
+		{
+			return _mm_rsqrt_ps(a);
+		}
+
 		static inline type __vectorcall bit_and(in_type a, in_type b)
 		{
 			return _mm_and_ps(a, b);
@@ -808,6 +837,11 @@ namespace asd
 			return _mm_movemask_ps(_mm_cmpeq_ps(a, b)) != 0xf;
 		}
 
+		static inline type __vectorcall cmplt(in_type a, in_type b)
+		{
+			return _mm_cmplt_ps(a, b);
+		}
+
 		static inline type __vectorcall cmple(in_type a, in_type b)
 		{
 			return _mm_cmple_ps(a, b);
@@ -818,6 +852,19 @@ namespace asd
 			return _mm_cmpgt_ps(a, b);
 		}
 
+		/**
+		 *	mask ? a : b, lanes are selected by sign bits of the mask
+		 */
+		static inline type __vectorcall select(in_type a, in_type b, in_type mask)
+		{
+		#if SIMD_LEVEL >= SIMD_SSE4_1
+			return _mm_blendv_ps(b, a, mask);
+		#else
+			type m = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(mask), 31));
+			return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+		#endif
+		}
+
 		static inline type __vectorcall abs(in_type a)
 		{
 			return bit_andnot(signmask, a);
@@ -833,6 +880,35 @@ namespace asd
 			return _mm_cvtepi32_ps(_mm_cvtps_epi32(a));
 		}
 
+		/**
+		 *	a * 2^n for whole numbers n, the result must be normal
+		 */
+		static inline type __vectorcall ldexp(in_type a, in_type n)
+		{
+			return mul(a, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23)));
+		}
+
+		/**
+		 *	Splits positive normal numbers into mantissas in [1, 2) and
+		 *	exponents: a = mantissa * 2^exponent
+		 */
+		static inline type __vectorcall frexp(in_type a, type & exponent)
+		{
+			__m128i bits = _mm_castps_si128(a);
+			exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+			return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+		}
+
+		/**
+		 *	Moves the bit <Bit> of whole numbers of <a> to sign bits, other
+		 *	bits are cleared. Used to pick quadrants after range reduction.
+		 */
+		template<int Bit>
+		static inline type __vectorcall bit_sign(in_type a)
+		{
+			return bit_and(_mm_castsi128_ps(_mm_slli_epi32(_mm_cvtps_epi32(a), 31 - Bit)), signmask);
+		}
+
 		static inline type __vectorcall floor(in_type a)
 		{
 			static auto one = load(1.0f, 1.0f, 1.0f, 1.0f);
@@ -919,238 +995,148 @@ namespace asd
 
 		static const size_t size = sizeof(inner);
 
-		static inline void __vectorcall load(const inner & in, type & out)
+		static inline type __vectorcall load(const type & in)
 		{
-			out = _mm256_load_pd(in);
-		}
-
-		static inline inner __vectorcall load(const inner & in)
-		{
-			return _mm256_load_pd(in);
-		}
-
-		static inline void __vectorcall load(const double & a, const double & b, const double & c, const double & d, type & out)
-		{
-			out = _mm256_set_pd(d, c, b, a);
+			return in;
 		}
 
-		static inline inner __vectorcall load(const double & a, const double & b, const double & c, const double & d)
+		static inline type __vectorcall load(const double & a, const double & b, const double & c, const double & d)
 		{
 			return _mm256_set_pd(d, c, b, a);
 		}
 
-		static inline void __vectorcall load(const __m128d & a, const __m128d & b, type & out)
-		{
-			out = _mm256_insertf128_pd(_mm256_castpd128_pd256(a), b, 1);
-		}
-
-		static inline inner __vectorcall load(const __m128d & a, const __m128d & b)
+		static inline type __vectorcall load(const __m128d & a, const __m128d & b)
 		{
 			return _mm256_insertf128_pd(_mm256_castpd128_pd256(a), b, 1);
 		}
 
-		static inline void __vectorcall load(const double * data, type & out)
-		{
-			out = _mm256_load_pd(data);
-		}
-
-		static inline inner __vectorcall load(const double * data)
+		static inline type __vectorcall load(const double * data)
 		{
 			return _mm256_load_pd(data);
 		}
 
-		static inline void __vectorcall store(const type & in, inner & out)
+		static inline void __vectorcall store(const type & in, double * out)
 		{
 			_mm256_store_pd(out, in);
 		}
 
-		static inline void __vectorcall zero(type & out)
+		static inline void __vectorcall store(const type & in, inner & out)
 		{
-			out = _mm256_setzero_pd();
+			_mm256_store_pd(out.data.data(), in);
 		}
 
-		static inline inner __vectorcall zero()
+		static inline type __vectorcall zero()
 		{
 			return _mm256_setzero_pd();
 		}
 
-		static inline void __vectorcall fill(double val, type & out)
-		{
-			out = _mm256_set1_pd(val);
-		}
-
-		static inline inner __vectorcall fill(double val)
+		static inline type __vectorcall fill(double val)
 		{
 			return _mm256_set1_pd(val);
 		}
 
-		static inline void __vectorcall add(const type & a, const type & b, type & out)
-		{
-			out = _mm256_add_pd(a, b);
-		}
-
-		static inline inner __vectorcall add(const type & a, const type & b)
+		static inline type __vectorcall add(const type & a, const type & b)
 		{
 			return _mm256_add_pd(a, b);
 		}
 
-		static inline void __vectorcall sub(const type & a, const type & b, type & out)
-		{
-			out = _mm256_sub_pd(a, b);
-		}
-
-		static inline inner __vectorcall sub(const type & a, const type & b)
+		static inline type __vectorcall sub(const type & a, const type & b)
 		{
 			return _mm256_sub_pd(a, b);
 		}
 
-		static inline void __vectorcall mul(const type & a, const type & b, type & out)
-		{
-			out = _mm256_mul_pd(a, b);
-		}
-
-		static inline inner __vectorcall mul(const type & a, const type & b)
+		static inline type __vectorcall mul(const type & a, const type & b)
 		{
 			return _mm256_mul_pd(a, b);
 		}
 
-		static inline void __vectorcall div(const type & a, const type & b, type & out)
-		{
-			out = _mm256_div_pd(a, b);
-		}
-
-		static inline inner __vectorcall div(const type & a, const type & b)
+		static inline type __vectorcall div(const type & a, const type & b)
 		{
 			return _mm256_div_pd(a, b);
 		}
 
-		static inline void __vectorcall sqr(const type & a, type & out)
+		static inline type __vectorcall mod(const type & a, const type & b)
 		{
-			out = _mm256_mul_pd(a, a);
-		}
-
-		static inline inner __vectorcall sqr(const type & a)
-		{
-			return {_mm256_mul_pd(a, a)};
+			return sub(a, mul(trunc(div(a, b)), b));
 		}
 
-		static inline void __vectorcall invert(const type & a, type & out)
+		/**
+		 *	a * b + c, fused if the translation unit is compiled with FMA
+		 */
+		static forceinline type __vectorcall fmadd(const type & a, const type & b, const type & c)
 		{
-			out = _mm256_div_pd(_mm256_set_pd(1.0, 1.0, 1.0, 1.0), a);
+		#ifdef SIMD_FMA
+			return _mm256_fmadd_pd(a, b, c);
+		#else
+			return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+		#endif
 		}
 
-		static inline inner __vectorcall invert(const type & a)
+		static inline type __vectorcall sqr(const type & a)
 		{
-			return _mm256_div_pd(_mm256_set_pd(1.0, 1.0, 1.0, 1.0), a);
+			return _mm256_mul_pd(a, a);
 		}
 
-		static inline void __vectorcall min(const type & a, const type & b, type & out)
+		static inline type __vectorcall invert(const type & a)
 		{
-			out = _mm256_min_pd(a, b);
+			return _mm256_div_pd(_mm256_set1_pd(1.0), a);
 		}
 
-		static inline inner __vectorcall min(const type & a, const type & b)
+		static inline type __vectorcall min(const type & a, const type & b)
 		{
 			return _mm256_min_pd(a, b);
 		}
 
-		static inline void __vectorcall max(const type & a, const type & b, type & out)
-		{
-			out = _mm256_max_pd(a, b);
-		}
-
-		static inline inner __vectorcall max(const type & a, const type & b)
+		static inline type __vectorcall max(const type & a, const type & b)
 		{
 			return _mm256_max_pd(a, b);
 		}
 
-		static inline void __vectorcall hadd2(const type & a, const type & b, type & out)
-		{
-			out = _mm256_hadd_pd(a, b);
-		}
-
-		static inline inner __vectorcall hadd2(const type & a, const type & b)
+		static inline type __vectorcall hadd2(const type & a, const type & b)
 		{
 			return _mm256_hadd_pd(a, b);
 		}
 
-		static inline void __vectorcall hadd(const type & a, type & out)
-		{
-			out = _mm256_hadd_pd(a, a);
-		}
-
-		static inline inner __vectorcall hadd(const type & a)
+		static inline type __vectorcall hadd(const type & a)
 		{
 			return _mm256_hadd_pd(a, a);
 		}
 
 		static inline double __vectorcall sum(const type & a)
 		{
-			type v = _mm256_hadd_pd(a, shuffle<2, 3, 2, 3>(a));
-			v = _mm256_hadd_pd(v, v);
-			return _mm_cvtsd_f64(_mm256_castpd256_pd128(v));
-		}
-
-		static inline void __vectorcall fill_sum(const type & a, type & out)
-		{
-			out = _mm256_hadd_pd(shuffle<0, 1, 0, 1>(a), shuffle<2, 3, 2, 3>(a));
-			out = _mm256_hadd_pd(shuffle<0, 1, 0, 1>(out), shuffle<2, 3, 2, 3>(out));
-		}
-
-		static inline inner __vectorcall fill_sum(const type & a)
-		{
-			type out = _mm256_hadd_pd(shuffle<0, 1, 0, 1>(a), shuffle<2, 3, 2, 3>(a));
-			return _mm256_hadd_pd(shuffle<0, 1, 0, 1>(out), shuffle<2, 3, 2, 3>(out));
+			__m128d v = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+			return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
 		}
 
-		static inline void __vectorcall sqrt(const type & a, type & out)
+		static inline type __vectorcall fill_sum(const type & a)
 		{
-			out = _mm256_sqrt_pd(a);
+			type v = _mm256_hadd_pd(a, a);
+			return _mm256_add_pd(v, _mm256_permute2f128_pd(v, v, 0x01));
 		}
 
-		static inline inner __vectorcall sqrt(const type & a)
+		static inline type __vectorcall sqrt(const type & a)
 		{
 			return _mm256_sqrt_pd(a);
 		}
 
-		static inline void __vectorcall bit_and(const type & a, const type & b, type & out)
-		{
-			out = _mm256_and_pd(a, b);
-		}
-
-		static inline inner __vectorcall bit_and(const type & a, const type & b)
+		static inline type __vectorcall bit_and(const type & a, const type & b)
 		{
-			return {_mm256_and_pd(a, b)};
+			return _mm256_and_pd(a, b);
 		}
 
-		static inline void __vectorcall bit_or(const type & a, const type & b, type & out)
+		static inline type __vectorcall bit_or(const type & a, const type & b)
 		{
-			out = _mm256_or_pd(a, b);
+			return _mm256_or_pd(a, b);
 		}
 
-		static inline inner __vectorcall bit_or(const type & a, const type & b)
+		static inline type __vectorcall bit_andnot(const type & a, const type & b)
 		{
-			return {_mm256_or_pd(a, b)};
+			return _mm256_andnot_pd(a, b);
 		}
 
-		static inline void __vectorcall bit_andnot(const type & a, const type & b, type & out)
+		static inline type __vectorcall bit_xor(const type & a, const type & b)
 		{
-			out = _mm256_andnot_pd(a, b);
-		}
-
-		static inline inner __vectorcall bit_andnot(const type & a, const type & b)
-		{
-			return {_mm256_andnot_pd(a, b)};
-		}
-
-		static inline void __vectorcall bit_xor(const type & a, const type & b, type & out)
-		{
-			out = _mm256_xor_pd(a, b);
-		}
-
-		static inline inner __vectorcall bit_xor(const type & a, const type & b)
-		{
-			return {_mm256_xor_pd(a, b)};
+			return _mm256_xor_pd(a, b);
 		}
 
 		static inline bool __vectorcall equal(const type & a, const type & b)
@@ -1163,323 +1149,1120 @@ namespace asd
 			return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OS)) != 0xf;
 		}
 
-		static inline void __vectorcall cmple(const type & a, const type & b, type & out)
-		{
-			out = _mm256_cmp_pd(a, b, _CMP_LE_OS);
-		}
-
-		static inline inner __vectorcall cmple(const type & a, const type & b)
+		static inline type __vectorcall cmple(const type & a, const type & b)
 		{
-			return {_mm256_cmp_pd(a, b, _CMP_LE_OS)};
-		}
-
-		static inline void __vectorcall abs(const type & a, type & out)
-		{
-			out = bit_andnot(signmask, a);
+			return _mm256_cmp_pd(a, b, _CMP_LE_OS);
 		}
 
-		static inline inner __vectorcall abs(const type & a)
+		static inline type __vectorcall cmpgt(const type & a, const type & b)
 		{
-			return {bit_andnot(signmask, a)};
+			return _mm256_cmp_pd(a, b, _CMP_GT_OS);
 		}
 
-		static inline void __vectorcall sign(const type & a, type & out)
+		/**
+		 *	mask ? a : b
+		 */
+		static inline type __vectorcall select(const type & a, const type & b, const type & mask)
 		{
-			out = bit_and(signmask, a);
+			return _mm256_blendv_pd(b, a, mask);
 		}
 
-		static inline inner __vectorcall sign(const type & a)
+		static inline type __vectorcall abs(const type & a)
 		{
-			return {bit_and(signmask, a)};
+			return bit_andnot(signmask, a);
 		}
 
-		static inline void __vectorcall round(const type & a, type & out)
+		static inline type __vectorcall sign(const type & a)
 		{
-			auto v = bit_or(nofrac, sign(a));
-			auto mask = cmple(abs(a), nofrac);
-			out = bit_xor(bit_and(sub(add(a, v), v), mask), bit_andnot(mask, a));
+			return bit_and(signmask, a);
 		}
 
-		static inline inner __vectorcall round(const type & a)
+		static inline type __vectorcall trunc(const type & a)
 		{
-			auto v = bit_or(nofrac, sign(a));
-			auto mask = cmple(abs(a), nofrac);
-			return {bit_xor(bit_and(sub(add(a, v), v), mask), bit_andnot(mask, a))};
+			return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
 		}
 
-		static inline void __vectorcall negate(const type & a, type & out)
+		static inline type __vectorcall floor(const type & a)
 		{
-			out = bit_xor(signmask, a);
+			return _mm256_round_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
 		}
 
-		static inline inner __vectorcall negate(const type & a)
+		static inline type __vectorcall ceil(const type & a)
 		{
-			return {bit_xor(signmask, a)};
+			return _mm256_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
 		}
 
-		static inline void __vectorcall reverse(const type & a, type & out)
+		static inline type __vectorcall round(const type & a)
 		{
-			out = _mm256_reverse_pd(a);
+			return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
 		}
 
-		static inline inner __vectorcall reverse(const type & a)
+		static inline type __vectorcall negate(const type & a)
 		{
-			return _mm256_reverse_pd(a);
+			return bit_xor(signmask, a);
 		}
 
-		template<byte A, byte B, byte C, byte D, useif<
-            (A < 2 && B < 2 && C < 2 && D < 2)
-            >
-        >
-		static inline void __vectorcall blend(const type & a, const type & b, type & out)
+		static inline type __vectorcall reverse(const type & a)
 		{
-			out = _mm256_blend_pd(a, b, mk_mask4(A, B, C, D));
+			return shuffle<3, 2, 1, 0>(a);
 		}
 
 		template<byte A, byte B, byte C, byte D, useif<
-            (A < 2 && B < 2 && C < 2 && D < 2)
-            >
-        >
-		static inline inner __vectorcall blend(const type & a, const type & b)
+			(A < 2 && B < 2 && C < 2 && D < 2)
+			>
+		>
+		static inline type __vectorcall blend(const type & a, const type & b)
 		{
 			return _mm256_blend_pd(a, b, mk_mask4(A, B, C, D));
 		}
 
 		template<byte A, byte B, byte C, byte D, useif<
-            (A < 4 && B < 4 && C < 4 && D < 4)
-            >
-        >
-		static inline void __vectorcall shuffle2(const type & a, const type & b, type & out)
-		{
-			out = blend<0, 0, 1, 1>(_mm256_permute4x64_pd(a, mk_shuffle_4(A, B, C, D)), _mm256_permute4x64_pd(b, mk_shuffle_4(A, B, C, D)));
-		}
-
-		template<byte A, byte B, byte C, byte D, useif<
-            (A < 4 && B < 4 && C < 4 && D < 4)
-            >
-        >
-		static inline inner __vectorcall shuffle2(const type & a, const type & b)
-		{
-			return blend<0, 0, 1, 1>(_mm256_permute4x64_pd(a, mk_shuffle_4(A, B, C, D)), _mm256_permute4x64_pd(b, mk_shuffle_4(A, B, C, D)));
-		}
-
-		template<byte A, byte B, byte C, byte D, useif<
-            (A < 4 && B < 4 && C < 4 && D < 4)
-            >
-        >
-		static inline void __vectorcall shuffle(const type & a, type & out)
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static inline type __vectorcall shuffle2(const type & a, const type & b)
 		{
-			out = _mm256_permute4x64_pd(a, mk_shuffle_4(A, B, C, D));
+			return blend<0, 0, 1, 1>(shuffle<A, B, C, D>(a), shuffle<A, B, C, D>(b));
 		}
 
 		template<byte A, byte B, byte C, byte D, useif<
-            (A < 4 && B < 4 && C < 4 && D < 4)
-            >
-        >
-		static inline inner __vectorcall shuffle(const type & a)
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static inline type __vectorcall shuffle(const type & a)
 		{
+		#if SIMD_LEVEL >= SIMD_AVX2
 			return _mm256_permute4x64_pd(a, mk_shuffle_4(A, B, C, D));
+		#else
+			// AVX1 permutes only inside of 128-bit lanes, so both halves are broadcast first
+			type lo = _mm256_permute2f128_pd(a, a, 0x00);
+			type hi = _mm256_permute2f128_pd(a, a, 0x11);
+
+			return _mm256_blend_pd(
+				_mm256_permute_pd(lo, mk_mask4(A & 1, B & 1, C & 1, D & 1)),
+				_mm256_permute_pd(hi, mk_mask4(A & 1, B & 1, C & 1, D & 1)),
+				mk_mask4(A >> 1, B >> 1, C >> 1, D >> 1)
+			);
+		#endif
 		}
 	};
 
-#endif
+#else
 
 	/**
-	 *	byte intrinsics
+	 *	Double intrinsics, SSE2 fallback. Every vector is a pair of __m128d
+	 *	with the same interface as the AVX version.
 	 */
 	template<>
-	struct Intrinsic<byte, 4>
+	struct Intrinsic<double, 4>
 	{
 		static const bool implemented = true;
 
-		using inner = IntrinData<byte, 4>;
-		using type = typename inner::type;
+		using inner = IntrinData<double, 4>;
+		using type = inner::type;
 
-		static api(core) const inner maximum;
 		static api(core) const inner signmask;
+		static api(core) const inner nofrac;
 
 		static const size_t size = sizeof(inner);
 
-		static inline void load(const inner & in, type & out)
+		static inline type __vectorcall load(const type & in)
 		{
-			out = in;
+			return in;
 		}
 
-		static inline type load(const inner & in)
+		static inline type __vectorcall load(const double & a, const double & b, const double & c, const double & d)
 		{
-			return in;
+			return load(_mm_set_pd(b, a), _mm_set_pd(d, c));
 		}
 
-		static inline void load(const byte & a, const byte & b, const byte & c, const byte & d, type & out)
+		static inline type __vectorcall load(const __m128d & a, const __m128d & b)
 		{
-			out = {d, c, b, a};
+			return {{a, b}};
 		}
 
-		static inline type load(const byte & a, const byte & b, const byte & c, const byte & d)
+		static inline type __vectorcall load(const double * data)
 		{
-			return type {d, c, b, a};
+			return load(_mm_load_pd(data), _mm_load_pd(data + 2));
 		}
 
-		static inline void load(const byte * data, type & out)
+		static inline void __vectorcall store(const type & in, double * out)
 		{
-			out = {data[3], data[2], data[1], data[0]};
+			_mm_store_pd(out, in[0]);
+			_mm_store_pd(out + 2, in[1]);
 		}
 
-		static inline type load(const byte * data)
+		static inline void __vectorcall store(const type & in, inner & out)
 		{
-			return type {data[3], data[2], data[1], data[0]};
+			store(in, out.data.data());
 		}
 
-		static inline void store(const type & in, inner & out)
+		static inline type __vectorcall zero()
 		{
-			out = in;
+			return load(_mm_setzero_pd(), _mm_setzero_pd());
 		}
 
-		static inline void zero(type & out)
+		static inline type __vectorcall fill(double val)
 		{
-			out.i = 0;
+			return load(_mm_set1_pd(val), _mm_set1_pd(val));
 		}
 
-		static inline type zero()
+		static inline type __vectorcall add(const type & a, const type & b)
 		{
-			return type{};
+			return load(_mm_add_pd(a[0], b[0]), _mm_add_pd(a[1], b[1]));
 		}
 
-		static inline void fill(byte val, type & out)
+		static inline type __vectorcall sub(const type & a, const type & b)
 		{
-			out = {val, val, val, val};
+			return load(_mm_sub_pd(a[0], b[0]), _mm_sub_pd(a[1], b[1]));
 		}
 
-		static inline void fill(byte val, inner & out)
+		static inline type __vectorcall mul(const type & a, const type & b)
 		{
-			out = {val, val, val, val};
+			return load(_mm_mul_pd(a[0], b[0]), _mm_mul_pd(a[1], b[1]));
 		}
 
-		static inline inner fill(byte val)
+		static inline type __vectorcall div(const type & a, const type & b)
 		{
-			return type {val, val, val, val};
+			return load(_mm_div_pd(a[0], b[0]), _mm_div_pd(a[1], b[1]));
 		}
 
-		static inline void add(const type & a, const type & b, type & out)
+		static inline type __vectorcall mod(const type & a, const type & b)
 		{
-			out = {byte(a.x + b.x), byte(a.y + b.y), byte(a.z + b.z), byte(a.w + b.w)};
+			return sub(a, mul(trunc(div(a, b)), b));
 		}
 
-		static inline inner add(const type & a, const type & b)
+		/**
+		 *	a * b + c
+		 */
+		static inline type __vectorcall fmadd(const type & a, const type & b, const type & c)
 		{
-			return type {byte(a.x + b.x), byte(a.y + b.y), byte(a.z + b.z), byte(a.w + b.w)};
+			return add(mul(a, b), c);
 		}
 
-		static inline void sub(const type & a, const type & b, type & out)
+		static inline type __vectorcall sqr(const type & a)
 		{
-			out = {byte(a.x - b.x), byte(a.y - b.y), byte(a.z - b.z), byte(a.w - b.w)};
+			return mul(a, a);
 		}
 
-		static inline inner sub(const type & a, const type & b)
+		static inline type __vectorcall invert(const type & a)
 		{
-			return __m32 {byte(a.x - b.x), byte(a.y - b.y), byte(a.z - b.z), byte(a.w - b.w)};
+			return div(fill(1.0), a);
 		}
 
-		static inline void mul(const type & a, const type & b, type & out)
+		static inline type __vectorcall min(const type & a, const type & b)
 		{
-			out = {byte(a.x * b.x), byte(a.y * b.y), byte(a.z * b.z), byte(a.w * b.w)};
+			return load(_mm_min_pd(a[0], b[0]), _mm_min_pd(a[1], b[1]));
 		}
 
-		static inline inner mul(const type & a, const type & b)
+		static inline type __vectorcall max(const type & a, const type & b)
 		{
-			return __m32 {byte(a.x * b.x), byte(a.y * b.y), byte(a.z * b.z), byte(a.w * b.w)};
+			return load(_mm_max_pd(a[0], b[0]), _mm_max_pd(a[1], b[1]));
 		}
 
-		static inline void div(const type & a, const type & b, type & out)
+		static inline type __vectorcall hadd2(const type & a, const type & b)
 		{
-			out = {byte(a.x / b.x), byte(a.y / b.y), byte(a.z / b.z), byte(a.w / b.w)};
+			return load(
+				_mm_add_pd(_mm_unpacklo_pd(a[0], b[0]), _mm_unpackhi_pd(a[0], b[0])),
+				_mm_add_pd(_mm_unpacklo_pd(a[1], b[1]), _mm_unpackhi_pd(a[1], b[1]))
+			);
 		}
 
-		static inline inner div(const type & a, const type & b)
+		static inline type __vectorcall hadd(const type & a)
 		{
-			return __m32 {byte(a.x / b.x), byte(a.y / b.y), byte(a.z / b.z), byte(a.w / b.w)};
+			return hadd2(a, a);
 		}
 
-		static inline void sqr(const type & a, type & out)
+		static inline double __vectorcall sum(const type & a)
 		{
-			out = {byte(a.x * a.x), byte(a.y * a.y), byte(a.z * a.z), byte(a.w * a.w)};
+			__m128d v = _mm_add_pd(a[0], a[1]);
+			return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
 		}
 
-		static inline inner sqr(const type & a)
+		static inline type __vectorcall fill_sum(const type & a)
 		{
-			return __m32 {byte(a.x * a.x), byte(a.y * a.y), byte(a.z * a.z), byte(a.w * a.w)};
+			__m128d v = _mm_add_pd(a[0], a[1]);
+			v = _mm_add_pd(v, _mm_shuffle_pd(v, v, reverse_shuffle_2));
+			return load(v, v);
 		}
 
-		static inline void invert(const type & a, type & out)
+		static inline type __vectorcall sqrt(const type & a)
 		{
-			out.i = 0;
+			return load(_mm_sqrt_pd(a[0]), _mm_sqrt_pd(a[1]));
 		}
 
-		static inline inner invert(const type & a)
+		static inline type __vectorcall bit_and(const type & a, const type & b)
 		{
-			return __m32 {};
+			return load(_mm_and_pd(a[0], b[0]), _mm_and_pd(a[1], b[1]));
 		}
 
-		static inline void min(const type & a, const type & b, type & out)
+		static inline type __vectorcall bit_or(const type & a, const type & b)
 		{
-			out = {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w)};
+			return load(_mm_or_pd(a[0], b[0]), _mm_or_pd(a[1], b[1]));
 		}
 
-		static inline inner min(const type & a, const type & b)
+		static inline type __vectorcall bit_andnot(const type & a, const type & b)
 		{
-			return __m32 {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w)};
+			return load(_mm_andnot_pd(a[0], b[0]), _mm_andnot_pd(a[1], b[1]));
 		}
 
-		static inline void max(const type & a, const type & b, type & out)
+		static inline type __vectorcall bit_xor(const type & a, const type & b)
 		{
-			out = {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w)};
+			return load(_mm_xor_pd(a[0], b[0]), _mm_xor_pd(a[1], b[1]));
 		}
 
-		static inline inner max(const type & a, const type & b)
+		static inline bool __vectorcall equal(const type & a, const type & b)
 		{
-			return __m32 {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w)};
+			return (_mm_movemask_pd(_mm_cmpeq_pd(a[0], b[0])) & _mm_movemask_pd(_mm_cmpeq_pd(a[1], b[1]))) == 0x3;
 		}
 
-		static inline void hadd2(const type & a, const type & b, type & out)
+		static inline bool __vectorcall notequal(const type & a, const type & b)
 		{
-			out = {byte(a.x + a.y), byte(a.z + a.w), byte(b.x + b.y), byte(b.z + b.w)};
+			return !equal(a, b);
 		}
 
-		static inline inner hadd2(const type & a, const type & b)
+		static inline type __vectorcall cmple(const type & a, const type & b)
 		{
-			return __m32 {byte(a.x + a.y), byte(a.z + a.w), byte(b.x + b.y), byte(b.z + b.w)};
+			return load(_mm_cmple_pd(a[0], b[0]), _mm_cmple_pd(a[1], b[1]));
 		}
 
-		static inline void hadd(const type & a, type & out)
+		static inline type __vectorcall cmpgt(const type & a, const type & b)
 		{
-			out = {byte(a.x + a.y), byte(a.z + a.w), 0, 0};
+			return load(_mm_cmpgt_pd(a[0], b[0]), _mm_cmpgt_pd(a[1], b[1]));
 		}
 
-		static inline inner hadd(const type & a)
+		/**
+		 *	mask ? a : b
+		 */
+		static inline type __vectorcall select(const type & a, const type & b, const type & mask)
 		{
-			return __m32 {byte(a.x + a.y), byte(a.z + a.w), 0, 0};
+			return bit_or(bit_and(mask, a), bit_andnot(mask, b));
 		}
 
-		static inline byte sum(const type & a)
+		static inline type __vectorcall abs(const type & a)
 		{
-			return byte(a.x + a.y + a.z + a.w);
+			return bit_andnot(signmask, a);
 		}
 
-		static inline void fill_sum(const type & a, type & out)
+		static inline type __vectorcall sign(const type & a)
 		{
-			byte b = a.x + a.y + a.z + a.w;
-			out = {b, b, b, b};
+			return bit_and(signmask, a);
 		}
 
-		static inline inner fill_sum(const type & a)
+		static inline type __vectorcall trunc(const type & a)
 		{
-			byte b = a.x + a.y + a.z + a.w;
-			return __m32 {b, b, b, b};
+			return load(trunc(a[0]), trunc(a[1]));
 		}
 
-		static inline void sqrt(const type & a, type & out)
+		static inline type __vectorcall floor(const type & a)
 		{
-			out = {byte(std::sqrt(a.x)), byte(std::sqrt(a.y)), byte(std::sqrt(a.z)), byte(std::sqrt(a.w))};
+			auto v = trunc(a);
+			return sub(v, bit_and(cmpgt(v, a), fill(1.0))); // subtract one if truncation is greater than a
+		}
+
+		static inline type __vectorcall ceil(const type & a)
+		{
+			auto v = trunc(a);
+			return add(v, bit_and(cmpgt(a, v), fill(1.0))); // add one if truncation is less than a
+		}
+
+		static inline type __vectorcall round(const type & a)
+		{
+			auto v = bit_or(nofrac, sign(a));
+			auto mask = cmple(abs(a), nofrac);
+			return bit_xor(bit_and(sub(add(a, v), v), mask), bit_andnot(mask, a));
+		}
+
+		static inline type __vectorcall negate(const type & a)
+		{
+			return bit_xor(signmask, a);
+		}
+
+		static inline type __vectorcall reverse(const type & a)
+		{
+			return load(_mm_shuffle_pd(a[1], a[1], reverse_shuffle_2), _mm_shuffle_pd(a[0], a[0], reverse_shuffle_2));
+		}
+
+		template<byte A, byte B, byte C, byte D, useif<
+			(A < 2 && B < 2 && C < 2 && D < 2)
+			>
+		>
+		static inline type __vectorcall blend(const type & a, const type & b)
+		{
+			return load(
+				_mm_shuffle_pd(A == 0 ? a[0] : b[0], B == 0 ? a[0] : b[0], mk_shuffle_2(0, 1)),
+				_mm_shuffle_pd(C == 0 ? a[1] : b[1], D == 0 ? a[1] : b[1], mk_shuffle_2(0, 1))
+			);
+		}
+
+		template<byte A, byte B, byte C, byte D, useif<
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static inline type __vectorcall shuffle2(const type & a, const type & b)
+		{
+			return load(
+				_mm_shuffle_pd(a[A >> 1], a[B >> 1], mk_shuffle_2(A & 1, B & 1)),
+				_mm_shuffle_pd(b[C >> 1], b[D >> 1], mk_shuffle_2(C & 1, D & 1))
+			);
+		}
+
+		template<byte A, byte B, byte C, byte D, useif<
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static inline type __vectorcall shuffle(const type & a)
+		{
+			return load(
+				_mm_shuffle_pd(a[A >> 1], a[B >> 1], mk_shuffle_2(A & 1, B & 1)),
+				_mm_shuffle_pd(a[C >> 1], a[D >> 1], mk_shuffle_2(C & 1, D & 1))
+			);
+		}
+
+	private:
+		// values not less than 2^52 have no fraction, smaller ones are rounded by 2^52 and corrected
+		static inline __m128d __vectorcall trunc(__m128d a)
+		{
+			const __m128d sm = static_cast<type>(signmask)[0];
+			const __m128d nf = static_cast<type>(nofrac)[0];
+
+			__m128d magnitude = _mm_andnot_pd(sm, a);
+			__m128d rounded = _mm_sub_pd(_mm_add_pd(magnitude, nf), nf);
+			rounded = _mm_sub_pd(rounded, _mm_and_pd(_mm_cmpgt_pd(rounded, magnitude), _mm_set1_pd(1.0)));
+
+			__m128d mask = _mm_cmplt_pd(magnitude, nf);
+			return _mm_or_pd(_mm_or_pd(_mm_and_pd(mask, rounded), _mm_andnot_pd(mask, magnitude)), _mm_and_pd(sm, a));
+		}
+	};
+
+#endif
+
+#ifdef __AVX__
+	/**
+	 *	8-wide float intrinsics.
+	 *	Require AVX2 and FMA, so they can be used only in translation units
+	 *	compiled for the avx2 path (see CpuFeatures.h). All functions are
+	 *	always inlined to keep AVX code out of the rest of the binary.
+	 *	They are declared only where AVX is enabled, because passing __m256
+	 *	by value changes the ABI of functions in other translation units.
+	 */
+	template<>
+	struct Intrinsic<float, 8>
+	{
+		static const bool implemented = true;
+
+		using inner = IntrinData<float, 8>;
+		using type = typename inner::type;
+
+		using in_type = type;
+
+		static const size_t size = sizeof(inner);
+
+		static forceinline type __vectorcall load(const float * in)
+		{
+			return _mm256_load_ps(in);
+		}
+
+		static forceinline type __vectorcall load(const float & a, const float & b, const float & c, const float & d, const float & e, const float & f, const float & g, const float & h)
+		{
+			return _mm256_set_ps(h, g, f, e, d, c, b, a);
+		}
+
+		static forceinline type __vectorcall load(__m128 lo, __m128 hi)
+		{
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+		}
+
+		static forceinline type __vectorcall load_unaligned(const float * in)
+		{
+			return _mm256_loadu_ps(in);
+		}
+
+		static forceinline void __vectorcall store(in_type in, float * out)
+		{
+			_mm256_store_ps(out, in);
+		}
+
+		static forceinline void __vectorcall store_unaligned(in_type in, float * out)
+		{
+			_mm256_storeu_ps(out, in);
+		}
+
+		static forceinline __m128 __vectorcall lo(in_type a)
+		{
+			return _mm256_castps256_ps128(a);
+		}
+
+		static forceinline __m128 __vectorcall hi(in_type a)
+		{
+			return _mm256_extractf128_ps(a, 1);
+		}
+
+		static forceinline type __vectorcall zero()
+		{
+			return _mm256_setzero_ps();
+		}
+
+		static forceinline type __vectorcall fill(float val)
+		{
+			return _mm256_set1_ps(val);
+		}
+
+		static forceinline type __vectorcall signmask()
+		{
+			return _mm256_castsi256_ps(_mm256_set1_epi32(0x8000'0000));
+		}
+
+		static forceinline type __vectorcall add(in_type a, in_type b)
+		{
+			return _mm256_add_ps(a, b);
+		}
+
+		static forceinline type __vectorcall sub(in_type a, in_type b)
+		{
+			return _mm256_sub_ps(a, b);
+		}
+
+		static forceinline type __vectorcall mul(in_type a, in_type b)
+		{
+			return _mm256_mul_ps(a, b);
+		}
+
+		static forceinline type __vectorcall div(in_type a, in_type b)
+		{
+			return _mm256_div_ps(a, b);
+		}
+
+		static forceinline type __vectorcall mod(in_type a, in_type b)
+		{
+			return fnmadd(trunc(div(a, b)), b, a);
+		}
+
+		/**
+		 *	a * b + c
+		 */
+		static forceinline type __vectorcall fmadd(in_type a, in_type b, in_type c)
+		{
+			return _mm256_fmadd_ps(a, b, c);
+		}
+
+		/**
+		 *	a * b - c
+		 */
+		static forceinline type __vectorcall fmsub(in_type a, in_type b, in_type c)
+		{
+			return _mm256_fmsub_ps(a, b, c);
+		}
+
+		/**
+		 *	c - a * b
+		 */
+		static forceinline type __vectorcall fnmadd(in_type a, in_type b, in_type c)
+		{
+			return _mm256_fnmadd_ps(a, b, c);
+		}
+
+		static forceinline type __vectorcall sqr(in_type a)
+		{
+			return mul(a, a);
+		}
+
+		static forceinline type __vectorcall invert(in_type a)
+		{
+			type tmp = _mm256_rcp_ps(a);
+			return mul(tmp, fnmadd(a, tmp, fill(2.0f)));
+		}
+
+		static forceinline type __vectorcall min(in_type a, in_type b)
+		{
+			return _mm256_min_ps(a, b);
+		}
+
+		static forceinline type __vectorcall max(in_type a, in_type b)
+		{
+			return _mm256_max_ps(a, b);
+		}
+
+		static forceinline float __vectorcall sum(in_type a)
+		{
+			__m128 v = _mm_add_ps(lo(a), hi(a));
+			v = _mm_hadd_ps(v, v);
+			v = _mm_hadd_ps(v, v);
+			return _mm_cvtss_f32(v);
+		}
+
+		static forceinline type __vectorcall fill_sum(in_type a)
+		{
+			type v = _mm256_add_ps(a, _mm256_permute2f128_ps(a, a, 0x01));
+			v = _mm256_hadd_ps(v, v);
+			return _mm256_hadd_ps(v, v);
+		}
+
+		static forceinline type __vectorcall sqrt(in_type a)
+		{
+			return _mm256_sqrt_ps(a);
+		}
+
+		/**
+		 *	Approximate 1 / sqrt(a), relative error < 1.5 * 2^-12
+		 */
+		static forceinline type __vectorcall rsqrt(in_type a)
+		{
+			return _mm256_rsqrt_ps(a);
+		}
+
+		static forceinline type __vectorcall bit_and(in_type a, in_type b)
+		{
+			return _mm256_and_ps(a, b);
+		}
+
+		static forceinline type __vectorcall bit_or(in_type a, in_type b)
+		{
+			return _mm256_or_ps(a, b);
+		}
+
+		static forceinline type __vectorcall bit_andnot(in_type a, in_type b)
+		{
+			return _mm256_andnot_ps(a, b);
+		}
+
+		static forceinline type __vectorcall bit_xor(in_type a, in_type b)
+		{
+			return _mm256_xor_ps(a, b);
+		}
+
+		static forceinline bool __vectorcall equal(in_type a, in_type b)
+		{
+			return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)) == 0xff;
+		}
+
+		static forceinline bool __vectorcall notequal(in_type a, in_type b)
+		{
+			return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)) != 0xff;
+		}
+
+		static forceinline type __vectorcall cmplt(in_type a, in_type b)
+		{
+			return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+		}
+
+		static forceinline type __vectorcall cmple(in_type a, in_type b)
+		{
+			return _mm256_cmp_ps(a, b, _CMP_LE_OQ);
+		}
+
+		static forceinline type __vectorcall cmpgt(in_type a, in_type b)
+		{
+			return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+		}
+
+		/**
+		 *	mask ? a : b
+		 */
+		static forceinline type __vectorcall select(in_type a, in_type b, in_type mask)
+		{
+			return _mm256_blendv_ps(b, a, mask);
+		}
+
+		static forceinline type __vectorcall abs(in_type a)
+		{
+			return bit_andnot(signmask(), a);
+		}
+
+		static forceinline type __vectorcall sign(in_type a)
+		{
+			return bit_and(signmask(), a);
+		}
+
+		static forceinline type __vectorcall trunc(in_type a)
+		{
+			return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+		}
+
+		/**
+		 *	a * 2^n for whole numbers n, the result must be normal
+		 */
+		static forceinline type __vectorcall ldexp(in_type a, in_type n)
+		{
+			return mul(a, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23)));
+		}
+
+		/**
+		 *	Splits positive normal numbers into mantissas in [1, 2) and
+		 *	exponents: a = mantissa * 2^exponent
+		 */
+		static forceinline type __vectorcall frexp(in_type a, type & exponent)
+		{
+			__m256i bits = _mm256_castps_si256(a);
+			exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+			return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+		}
+
+		/**
+		 *	Moves the bit <Bit> of whole numbers of <a> to sign bits, other
+		 *	bits are cleared. Used to pick quadrants after range reduction.
+		 */
+		template<int Bit>
+		static forceinline type __vectorcall bit_sign(in_type a)
+		{
+			return bit_and(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtps_epi32(a), 31 - Bit)), signmask());
+		}
+
+		static forceinline type __vectorcall floor(in_type a)
+		{
+			return _mm256_round_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+		}
+
+		static forceinline type __vectorcall ceil(in_type a)
+		{
+			return _mm256_round_ps(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+		}
+
+		static forceinline type __vectorcall round(in_type a)
+		{
+			return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		}
+
+		static forceinline type __vectorcall negate(in_type a)
+		{
+			return bit_xor(signmask(), a);
+		}
+
+		static forceinline type __vectorcall reverse(in_type a)
+		{
+			return _mm256_permutevar8x32_ps(a, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		}
+
+		/**
+		 *	Takes element i from <b> if bit i of Mask is set
+		 */
+		template<int Mask, useif<(Mask >= 0 && Mask < 256)>>
+		static forceinline type __vectorcall blend(in_type a, in_type b)
+		{
+			return _mm256_blend_ps(a, b, Mask);
+		}
+
+		/**
+		 *	Shuffles both 128-bit halves in the same way
+		 */
+		template<byte A, byte B, byte C, byte D, useif<
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static forceinline type __vectorcall shuffle2(in_type a, in_type b)
+		{
+			return _mm256_shuffle_ps(a, b, mk_shuffle_4(A, B, C, D));
+		}
+
+		/**
+		 *	Shuffles both 128-bit halves in the same way
+		 */
+		template<byte A, byte B, byte C, byte D, useif<
+			(A < 4 && B < 4 && C < 4 && D < 4)
+			>
+		>
+		static forceinline type __vectorcall shuffle(in_type a)
+		{
+			return _mm256_permute_ps(a, mk_shuffle_4(A, B, C, D));
+		}
+	};
+
+	/**
+	 *	8-wide integer intrinsics.
+	 *	Require AVX2, see Intrinsic<float, 8>.
+	 */
+	template<>
+	struct Intrinsic<int, 8>
+	{
+		static const bool implemented = true;
+
+		using inner = IntrinData<int, 8>;
+		using type = typename inner::type;
+
+		using in_type = type;
+
+		static const size_t size = sizeof(inner);
+
+		static forceinline type __vectorcall load(const int * in)
+		{
+			return _mm256_load_si256(reinterpret_cast<const type *>(in));
+		}
+
+		static forceinline type __vectorcall load(int a, int b, int c, int d, int e, int f, int g, int h)
+		{
+			return _mm256_set_epi32(h, g, f, e, d, c, b, a);
+		}
+
+		static forceinline type __vectorcall load(__m128i lo, __m128i hi)
+		{
+			return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		}
+
+		static forceinline type __vectorcall load_unaligned(const int * in)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const type *>(in));
+		}
+
+		static forceinline void __vectorcall store(in_type in, int * out)
+		{
+			_mm256_store_si256(reinterpret_cast<type *>(out), in);
+		}
+
+		static forceinline void __vectorcall store_unaligned(in_type in, int * out)
+		{
+			_mm256_storeu_si256(reinterpret_cast<type *>(out), in);
+		}
+
+		static forceinline __m128i __vectorcall lo(in_type a)
+		{
+			return _mm256_castsi256_si128(a);
+		}
+
+		static forceinline __m128i __vectorcall hi(in_type a)
+		{
+			return _mm256_extracti128_si256(a, 1);
+		}
+
+		static forceinline type __vectorcall zero()
+		{
+			return _mm256_setzero_si256();
+		}
+
+		static forceinline type __vectorcall fill(int val)
+		{
+			return _mm256_set1_epi32(val);
+		}
+
+		static forceinline type __vectorcall add(in_type a, in_type b)
+		{
+			return _mm256_add_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall sub(in_type a, in_type b)
+		{
+			return _mm256_sub_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall mul(in_type a, in_type b)
+		{
+			return _mm256_mullo_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall sqr(in_type a)
+		{
+			return mul(a, a);
+		}
+
+		static forceinline type __vectorcall min(in_type a, in_type b)
+		{
+			return _mm256_min_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall max(in_type a, in_type b)
+		{
+			return _mm256_max_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall abs(in_type a)
+		{
+			return _mm256_abs_epi32(a);
+		}
+
+		static forceinline type __vectorcall negate(in_type a)
+		{
+			return _mm256_sub_epi32(_mm256_setzero_si256(), a);
+		}
+
+		static forceinline int __vectorcall sum(in_type a)
+		{
+			__m128i v = _mm_add_epi32(lo(a), hi(a));
+			v = _mm_hadd_epi32(v, v);
+			v = _mm_hadd_epi32(v, v);
+			return _mm_cvtsi128_si32(v);
+		}
+
+		static forceinline type __vectorcall bit_and(in_type a, in_type b)
+		{
+			return _mm256_and_si256(a, b);
+		}
+
+		static forceinline type __vectorcall bit_or(in_type a, in_type b)
+		{
+			return _mm256_or_si256(a, b);
+		}
+
+		static forceinline type __vectorcall bit_andnot(in_type a, in_type b)
+		{
+			return _mm256_andnot_si256(a, b);
+		}
+
+		static forceinline type __vectorcall bit_xor(in_type a, in_type b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+
+		template<int I>
+		static forceinline type __vectorcall bit_shr(in_type a)
+		{
+			return _mm256_srai_epi32(a, I);
+		}
+
+		template<int I>
+		static forceinline type __vectorcall bit_shl(in_type a)
+		{
+			return _mm256_slli_epi32(a, I);
+		}
+
+		static forceinline bool __vectorcall equal(in_type a, in_type b)
+		{
+			return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) == -1;
+		}
+
+		static forceinline bool __vectorcall notequal(in_type a, in_type b)
+		{
+			return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1;
+		}
+
+		static forceinline type __vectorcall cmpeq(in_type a, in_type b)
+		{
+			return _mm256_cmpeq_epi32(a, b);
+		}
+
+		static forceinline type __vectorcall cmpgt(in_type a, in_type b)
+		{
+			return _mm256_cmpgt_epi32(a, b);
+		}
+
+		/**
+		 *	mask ? a : b
+		 */
+		static forceinline type __vectorcall select(in_type a, in_type b, in_type mask)
+		{
+			return _mm256_blendv_epi8(b, a, mask);
+		}
+
+		static forceinline type __vectorcall reverse(in_type a)
+		{
+			return _mm256_permutevar8x32_epi32(a, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		}
+
+		/**
+		 *	Takes element i from <b> if bit i of Mask is set
+		 */
+		template<int Mask, useif<(Mask >= 0 && Mask < 256)>>
+		static forceinline type __vectorcall blend(in_type a, in_type b)
+		{
+			return _mm256_blend_epi32(a, b, Mask);
+		}
+
+		/**
+		 *	Shuffles both 128-bit halves in the same way
+		 */
+		template<byte A, byte B, byte C, byte D, useif<(A < 4 && B < 4 && C < 4 && D < 4)>>
+		static forceinline type __vectorcall shuffle(in_type a)
+		{
+			return _mm256_shuffle_epi32(a, mk_shuffle_4(A, B, C, D));
+		}
+	};
+
+#endif
+
+	/**
+	 *	byte intrinsics
+	 */
+	template<>
+	struct Intrinsic<byte, 4>
+	{
+		static const bool implemented = true;
+
+		using inner = IntrinData<byte, 4>;
+		using type = typename inner::type;
+
+		static api(core) const inner maximum;
+		static api(core) const inner signmask;
+
+		static const size_t size = sizeof(inner);
+
+		static inline void load(const inner & in, type & out)
+		{
+			out = in;
+		}
+
+		static inline type load(const inner & in)
+		{
+			return in;
+		}
+
+		static inline void load(const byte & a, const byte & b, const byte & c, const byte & d, type & out)
+		{
+			out = {d, c, b, a};
+		}
+
+		static inline type load(const byte & a, const byte & b, const byte & c, const byte & d)
+		{
+			return type {d, c, b, a};
+		}
+
+		static inline void load(const byte * data, type & out)
+		{
+			out = {data[3], data[2], data[1], data[0]};
+		}
+
+		static inline type load(const byte * data)
+		{
+			return type {data[3], data[2], data[1], data[0]};
+		}
+
+		static inline void store(const type & in, inner & out)
+		{
+			out = in;
+		}
+
+		static inline void zero(type & out)
+		{
+			out.i = 0;
+		}
+
+		static inline type zero()
+		{
+			return type{};
+		}
+
+		static inline void fill(byte val, type & out)
+		{
+			out = {val, val, val, val};
+		}
+
+		static inline void fill(byte val, inner & out)
+		{
+			out = {val, val, val, val};
+		}
+
+		static inline inner fill(byte val)
+		{
+			return type {val, val, val, val};
+		}
+
+		static inline void add(const type & a, const type & b, type & out)
+		{
+			out = {byte(a.x + b.x), byte(a.y + b.y), byte(a.z + b.z), byte(a.w + b.w)};
+		}
+
+		static inline inner add(const type & a, const type & b)
+		{
+			return type {byte(a.x + b.x), byte(a.y + b.y), byte(a.z + b.z), byte(a.w + b.w)};
+		}
+
+		static inline void sub(const type & a, const type & b, type & out)
+		{
+			out = {byte(a.x - b.x), byte(a.y - b.y), byte(a.z - b.z), byte(a.w - b.w)};
+		}
+
+		static inline inner sub(const type & a, const type & b)
+		{
+			return __m32 {byte(a.x - b.x), byte(a.y - b.y), byte(a.z - b.z), byte(a.w - b.w)};
+		}
+
+		static inline void mul(const type & a, const type & b, type & out)
+		{
+			out = {byte(a.x * b.x), byte(a.y * b.y), byte(a.z * b.z), byte(a.w * b.w)};
+		}
+
+		static inline inner mul(const type & a, const type & b)
+		{
+			return __m32 {byte(a.x * b.x), byte(a.y * b.y), byte(a.z * b.z), byte(a.w * b.w)};
+		}
+
+		static inline void div(const type & a, const type & b, type & out)
+		{
+			out = {byte(a.x / b.x), byte(a.y / b.y), byte(a.z / b.z), byte(a.w / b.w)};
+		}
+
+		static inline inner div(const type & a, const type & b)
+		{
+			return __m32 {byte(a.x / b.x), byte(a.y / b.y), byte(a.z / b.z), byte(a.w / b.w)};
+		}
+
+		static inline void sqr(const type & a, type & out)
+		{
+			out = {byte(a.x * a.x), byte(a.y * a.y), byte(a.z * a.z), byte(a.w * a.w)};
+		}
+
+		static inline inner sqr(const type & a)
+		{
+			return __m32 {byte(a.x * a.x), byte(a.y * a.y), byte(a.z * a.z), byte(a.w * a.w)};
+		}
+
+		static inline void invert(const type & a, type & out)
+		{
+			out.i = 0;
+		}
+
+		static inline inner invert(const type & a)
+		{
+			return __m32 {};
+		}
+
+		static inline void min(const type & a, const type & b, type & out)
+		{
+			out = {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w)};
+		}
+
+		static inline inner min(const type & a, const type & b)
+		{
+			return __m32 {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w)};
+		}
+
+		static inline void max(const type & a, const type & b, type & out)
+		{
+			out = {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w)};
+		}
+
+		static inline inner max(const type & a, const type & b)
+		{
+			return __m32 {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w)};
+		}
+
+		static inline void hadd2(const type & a, const type & b, type & out)
+		{
+			out = {byte(a.x + a.y), byte(a.z + a.w), byte(b.x + b.y), byte(b.z + b.w)};
+		}
+
+		static inline inner hadd2(const type & a, const type & b)
+		{
+			return __m32 {byte(a.x + a.y), byte(a.z + a.w), byte(b.x + b.y), byte(b.z + b.w)};
+		}
+
+		static inline void hadd(const type & a, type & out)
+		{
+			out = {byte(a.x + a.y), byte(a.z + a.w), 0, 0};
+		}
+
+		static inline inner hadd(const type & a)
+		{
+			return __m32 {byte(a.x + a.y), byte(a.z + a.w), 0, 0};
+		}
+
+		static inline byte sum(const type & a)
+		{
+			return byte(a.x + a.y + a.z + a.w);
+		}
+
+		static inline void fill_sum(const type & a, type & out)
+		{
+			byte b = a.x + a.y + a.z + a.w;
+			out = {b, b, b, b};
+		}
+
+		static inline inner fill_sum(const type & a)
+		{
+			byte b = a.x + a.y + a.z + a.w;
+			return __m32 {b, b, b, b};
+		}
+
+		static inline void sqrt(const type & a, type & out)
+		{
+			out = {byte(std::sqrt(a.x)), byte(std::sqrt(a.y)), byte(std::sqrt(a.z)), byte(std::sqrt(a.w))};
 		}
 
 		static inline inner sqrt(const type & a)
@@ -1670,7 +2453,7 @@ namespace asd
 
 	namespace internals
 	{
-		template<class T, template<class T> class Constant, bool ... Values>
+		template<class T, template<class> class Constant, bool ... Values>
 		struct intrinsic_mask<T, Constant, std::integer_sequence<bool, Values...>>
 		{
 			static const int size = sizeof...(Values);
@@ -1688,5 +2471,9 @@ namespace asd
 	}
 }
 
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
 //---------------------------------------------------------------------------
 #endif
@@ -7,14 +7,15 @@
 
 //---------------------------------------------------------------------------
 
-#ifdef USE_AVX
 #include <immintrin.h>
-#else
-#include <tmmintrin.h>
-#endif
 
 #include <meta/types.h>
 
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
 //---------------------------------------------------------------------------
 
 namespace asd
@@ -66,31 +67,39 @@ namespace asd
 	};
 
 	template<>
-	struct IntrinsicCvt<__m128d[2], __m128>
+	struct IntrinsicCvt<__m128d, __m128d>
+	{
+		static inline void perform(__m128d in, __m128d & out)
+		{
+			out = in;
+		}
+	};
+
+	template<>
+	struct IntrinsicCvt<__m128dx2, __m128>
 	{
-		static inline void perform(const __m128d (& in)[2], __m128 & out)
+		static inline void perform(const __m128dx2 & in, __m128 & out)
 		{
-			out = _mm_shuffle_ps(_mm_cvtpd_ps(in[0]), _mm_cvtpd_ps(in[1]), mk_shuffle_4(0, 1, 2, 3));
+			out = _mm_movelh_ps(_mm_cvtpd_ps(in[0]), _mm_cvtpd_ps(in[1]));
 		}
 	};
 
 	template<>
-	struct IntrinsicCvt<__m128, __m128d[2]>
+	struct IntrinsicCvt<__m128, __m128dx2>
 	{
-		static inline void perform(__m128 in, __m128d (& out)[2])
+		static inline void perform(__m128 in, __m128dx2 & out)
 		{
 			out[0] = _mm_cvtps_pd(in);
-			out[1] = _mm_cvtps_pd(_mm_shuffle_ps(in, in, mk_shuffle_4(2, 3, 0, 1)));
+			out[1] = _mm_cvtps_pd(_mm_movehl_ps(in, in));
 		}
 	};
 
 	template<>
-	struct IntrinsicCvt<__m128d[2], __m128d[2]>
+	struct IntrinsicCvt<__m128dx2, __m128dx2>
 	{
-		static inline void perform(const __m128d (& in)[2], __m128d (& out)[2])
+		static inline void perform(const __m128dx2 & in, __m128dx2 & out)
 		{
-			out[0] = in[0];
-			out[1] = in[1];
+			out = in;
 		}
 	};
 
@@ -177,8 +186,6 @@ namespace asd
 		return *(reinterpret_cast<const double *>(&in));
 	}
 
-#ifdef USE_AVX
-
 	inline __m128 & _mm256_hi(__m256 & in)
 	{
 		return *(reinterpret_cast<__m128 *>(&in) + 1);
@@ -221,6 +228,15 @@ namespace asd
 
 //---------------------------------------------------------------------------
 
+	template<>
+	struct IntrinsicCvt<__m256i, __m256i>
+	{
+		static inline void perform(const __m256i & in, __m256i & out)
+		{
+			out = in;
+		}
+	};
+
 	template<>
 	struct IntrinsicCvt<__m128, __m256d>
 	{
@@ -273,7 +289,7 @@ namespace asd
 		static inline void perform(const __m256d (&in)[2], __m256 & out)
 		{
 #ifdef MSVC
-			out = _mm256_set_m128(_mm256_cvtpd_ps(in[0]), _mm256_cvtpd_ps(in[1]));
+			out = _mm256_set_m128(_mm256_cvtpd_ps(in[1]), _mm256_cvtpd_ps(in[0]));
 #else
 			_mm256_lo(out) = _mm256_cvtpd_ps(in[0]);
 			_mm256_hi(out) = _mm256_cvtpd_ps(in[1]);
@@ -290,7 +306,6 @@ namespace asd
 			out[1] = in[1];
 		}
 	};
-#endif // USE_AVX
 
 	template<typename A, typename B>
 	inline void intrin_cvt(A && in, B & out)
@@ -307,5 +322,9 @@ namespace asd
 	}
 }
 
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
 //---------------------------------------------------------------------------
 #endif
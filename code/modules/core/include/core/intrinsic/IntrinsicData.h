@@ -23,6 +23,13 @@
 #define SIMD_AVX 	10
 #define SIMD_AVX2 	11
 
+/**
+ *	FMA3 is a separate extension, but MSVC enables it together with AVX2
+ */
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMD_FMA
+#endif
+
 #define SIMD_LEVEL pp_cat(SIMD_, _SIMD_LEVEL)
 
 //---------------------------------------------------------------------------
@@ -50,9 +57,9 @@
 #include <smmintrin.h>
 #endif
 
-#if SIMD_LEVEL >= SIMD_AVX
-#include <x86intrin.h>
-#endif
+// 256-bit types are declared regardless of SIMD_LEVEL so that wider paths
+// can be compiled in separate translation units (see CpuFeatures.h)
+#include <immintrin.h>
 
 #include <memory.h>
 
@@ -61,6 +68,13 @@
 #undef min
 #undef max
 
+#ifdef __GNUC__
+// vector types lose their alignment attributes as template arguments, which
+// is harmless here: IntrinData and the conversions don't rely on them
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
 #if defined(ARCH_X86) && __cplusplus <= 201402L
 #define UNALIGNED_VECTORS
 #endif
@@ -107,6 +121,26 @@ namespace asd
 		};
 	};
 
+	/**
+	 *	Pair of __m128d used in place of __m256d when AVX is not available.
+	 *	Unlike an array it can be passed and returned by value, so vectors
+	 *	can store it as any other intrinsic type.
+	 */
+	struct __m128dx2
+	{
+		__m128d v[2];
+
+		__m128d & operator [] (size_t index)
+		{
+			return v[index];
+		}
+
+		const __m128d & operator [] (size_t index) const
+		{
+			return v[index];
+		}
+	};
+
 	declare_intrin_type(byte,   2, __m16);
 	declare_intrin_type(int,    2, __m64);
 	declare_intrin_type(float,  2, __m64);
@@ -118,7 +152,12 @@ namespace asd
 	
 #if SIMD_LEVEL >= SIMD_AVX
 	declare_intrin_type(double, 4, __m256d);
+#else
+	declare_intrin_type(double, 4, __m128dx2);
 #endif
+
+	declare_intrin_type(int,    8, __m256i);
+	declare_intrin_type(float,  8, __m256);
 	
 	template<class T>
 	struct is_intrin : false_type {};
@@ -134,16 +173,21 @@ namespace asd
 	template<>
 	struct is_intrin<__m128d>	 : true_type {};
 	template<>
-	struct is_intrin<__m128d[2]> : true_type {};
+	struct is_intrin<__m128dx2>  : true_type {};
 
-#if SIMD_LEVEL >= SIMD_AVX
 	template<>
 	struct is_intrin<__m256>	 : true_type {};
 	template<>
 	struct is_intrin<__m256i>	 : true_type {};
 	template<>
 	struct is_intrin<__m256d>	 : true_type {};
-#endif
+
+	// defined in IntrinsicCvt.h, declared here for the converting constructors of IntrinData
+	template<typename A, typename B>
+	inline void intrin_cvt(A && in, B & out);
+
+	template<typename Out, typename In>
+	inline Out intrin_cvt(In && in);
 
 	template<class T, int N>
 	using intrin_t = typename IntrinType<T, N>::type;
@@ -175,7 +219,7 @@ namespace asd
 			intrin_cvt(v, this->v);
 		}
 
-		template<class U, useif<is_intrin<T>::value>>
+		template<class U, useif<is_intrin<U>::value>>
 		IntrinData(const U & v)
 		{
 			intrin_cvt(v, this->v);
@@ -301,7 +345,7 @@ namespace asd
 			intrin_cvt(v, this->v);
 		}
 
-		template<class U, useif<is_intrin<T>::value>>
+		template<class U, useif<is_intrin<U>::value>>
 		IntrinData(const U & v)
 		{
 			intrin_cvt(v, this->v);
@@ -399,14 +443,19 @@ namespace asd
 			return data[index];
 		}
 		
+		// copied instead of cast, __m128dx2 may not alias arrays unlike native intrinsic types
 		operator type () const
 		{
-			return *reinterpret_cast<const type *>(&data);
+			type v;
+			memcpy(&v, &data, sizeof(type));
+			return v;
 		}
 		
-		static inline const array<T, 4> & cast(const type & in)
+		static inline array<T, 4> cast(const type & in)
 		{
-			return *reinterpret_cast<const array<T, 4> *>(&in);
+			array<T, 4> a;
+			memcpy(&a, &in, sizeof(type));
+			return a;
 		}
 
 		template<int I, useif<(I < 4)>>
@@ -418,7 +467,63 @@ namespace asd
 		template<int I, useif<(I < 4)>>
 		static inline void set(type & out, T value)
 		{
-			reinterpret_cast<IntrinData *>(&out)->data[I] = value;
+			memcpy(reinterpret_cast<byte *>(&out) + I * sizeof(T), &value, sizeof(T));
+		}
+	};
+
+	template<typename T>
+	struct alignas(sizeof(intrin_t<T, 8>)) IntrinData<T, 8, 0>
+	{
+		typedef intrin_t<T, 8> type;
+		typedef array<T, 8> inner;
+
+		union
+		{
+			inner data;
+			type v;
+		};
+
+		member_cast(v, type);
+		member_cast(data, inner);
+
+		IntrinData() {}
+		IntrinData(const type & v) : v(v) {}
+		IntrinData(const inner & data) : data(data) {}
+
+		void * operator new (size_t size)
+		{
+			return _mm_malloc(size, sizeof(T) * 8);
+		}
+
+		void operator delete (void * ptr)
+		{
+			_mm_free(ptr);
+		}
+
+		T & operator [] (size_t index)
+		{
+			return data[index];
+		}
+
+		const T & operator [] (size_t index) const
+		{
+			return data[index];
+		}
+
+		T & operator [] (int index)
+		{
+			return data[index];
+		}
+
+		const T & operator [] (int index) const
+		{
+			return data[index];
+		}
+
+		template<int I, useif<(I < 8)>>
+		static inline T get(const IntrinData & in)
+		{
+			return in.data[I];
 		}
 	};
 
@@ -426,5 +531,9 @@ namespace asd
 	using intrin_data = IntrinData<T, N>;
 }
 
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
 //---------------------------------------------------------------------------
 #endif
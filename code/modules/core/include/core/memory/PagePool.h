@@ -8,57 +8,303 @@
 //---------------------------------------------------------------------------
 
 #include "memory.h"
+#include "pool_stats.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
 
 //---------------------------------------------------------------------------
 
 namespace asd
 {
-	template<size_t pageSize>
-	class Page
+	/**
+	 *	@brief
+	 *	Huge pages usage of mapped pages.
+	 *	advise - ask the system to back pages with transparent huge pages.
+	 *	map - map pages from the huge pages reserve (MAP_HUGETLB) when the page
+	 *	size is a multiple of the huge page size, fall back to advise otherwise.
+	 */
+	enum class huge_pages
 	{
-	public:
-		Page(Page * next) : _ptr(malloc(pageSize)), _next(next) {}
-		Page(const Page &) = delete;
-		Page & operator = (const Page &) = delete;
+		off,
+		advise,
+		map
+	};
+
+	const size_t huge_page_size = 0x200000;
+
+	/**
+	 *	Maps the region of <size> bytes aligned to the huge page size (on
+	 *	Windows, to the allocation granularity) and applies the huge pages
+	 *	<mode> to the whole region.
+	 */
+	api(core)
+	void * map_pages(size_t size, huge_pages mode);
+	api(core)
+	void unmap_pages(void * ptr, size_t size);
+	api(core)
+	void decommit_pages(void * ptr, size_t size);
+	api(core)
+	void recommit_pages(void * ptr, size_t size);
+
+	/**
+	 *	@brief
+	 *	Page backend which takes pages from the heap one by one. Pages are
+	 *	never decommitted.
+	 */
+	struct heap_pages
+	{
+		static constexpr size_t region(size_t pageSize)
+		{
+			return pageSize;
+		}
+
+		static void * allocate(size_t size)
+		{
+			return memory<void>::allocate(size);
+		}
+
+		static void release(void * ptr, size_t)
+		{
+			memory<void>::free(ptr);
+		}
+
+		static bool decommit(void *, size_t)
+		{
+			return false;
+		}
+
+		static void recommit(void *, size_t) {}
+	};
+
+	/**
+	 *	@brief
+	 *	Page backend which maps regions of whole huge pages directly from the
+	 *	system (mmap or VirtualAlloc), pages are carved out of these regions.
+	 *	Regions are decommitted as a whole, so their physical memory is
+	 *	returned to the system while the address range stays reserved and huge
+	 *	pages are never split.
+	 */
+	template<huge_pages mode = huge_pages::off>
+	struct mapped_pages
+	{
+		static constexpr size_t region(size_t pageSize)
+		{
+			return (pageSize + huge_page_size - 1) / huge_page_size * huge_page_size;
+		}
+
+		static void * allocate(size_t size)
+		{
+			return map_pages(size, mode);
+		}
+
+		static void release(void * ptr, size_t size)
+		{
+			unmap_pages(ptr, size);
+		}
 
-		~Page()
+		static bool decommit(void * ptr, size_t size)
 		{
-			free(_ptr);
+			decommit_pages(ptr, size);
+			return true;
 		}
 
-		void * _ptr;
-		Page * _next;
+		static void recommit(void * ptr, size_t size)
+		{
+			recommit_pages(ptr, size);
+		}
 	};
 
-	template<size_t pageSize = 0x10000>
+	/**
+	 *	@brief
+	 *	Pool of fixed-size pages. Regions of pages are taken from the <Backend>
+	 *	(heap_pages or mapped_pages). Freed pages become idle and are reused by
+	 *	next allocations, decommit() returns memory of regions which have only
+	 *	idle pages to the system.
+	 *	<Stats> counts pages as blocks and committed pages as pages.
+	 */
+	template<size_t pageSize = 0x10000, class Backend = heap_pages, class Stats = default_pool_stats>
 	class PagePool
 	{
-	public:
-		typedef Page<pageSize> PageType;
+		struct region
+		{
+			byte * base;
+			size_t idle;
+			bool decommitted;
+		};
 
-		PagePool() : _page(nullptr) {}
+	public:
+		PagePool() : _stats(identity<PagePool>(), pageSize) {}
 		PagePool(const PagePool &) = delete;
 		PagePool & operator = (const PagePool &) = delete;
 
 		virtual ~PagePool()
 		{
-			PageType * next;
+			for(auto & r : _regions)
+				Backend::release(r.base, regionSize);
+		}
+
+		void * allocatePage()
+		{
+			if(_idle.empty() && !_decommitted.empty())
+				recommit(regionOf(_decommitted.back()));
+
+			void * page;
 
-			for(PageType * page = _page; page != nullptr; page = next)
+			if(!_idle.empty())
 			{
-				next = page->_next;
-				delete page;
+				page = _idle.back();
+				_idle.pop_back();
+				--regionOf(page).idle;
 			}
+			else
+			{
+				if(_next == _end)
+					reserve();
+
+				page = _next;
+				_next += pageSize;
+				_committed += pageSize;
+				_stats.page_allocated(pageSize);
+			}
+
+			_used += pageSize;
+			_stats.allocated(pageSize);
+
+			return page;
 		}
 
-		void * allocatePage()
+		/**
+		 *	Returns the page to the pool, the page stays committed until
+		 *	decommit() is called.
+		 */
+		void freePage(void * page)
 		{
-			_page = new PageType(_page);
-			return _page->_ptr;
+			_idle.push_back(page);
+			++regionOf(page).idle;
+			_used -= pageSize;
+			_stats.freed();
 		}
 
+		/**
+		 *	Decommits regions which have only idle pages while at least <keep>
+		 *	committed idle pages are left. The region which pages are still
+		 *	carved from is kept. Returns the count of decommitted pages.
+		 */
+		size_t decommit(size_t keep = 0)
+		{
+			size_t count = 0;
+
+			for(auto & r : _regions)
+			{
+				if(r.decommitted || r.idle < regionPages || _idle.size() < keep + regionPages)
+					continue;
+
+				if(!Backend::decommit(r.base, regionPages * pageSize))
+					break;
+
+				r.decommitted = true;
+				move(_idle, _decommitted, r);
+
+				for(size_t i = 0; i < regionPages; ++i)
+					_stats.page_freed(pageSize);
+
+				_committed -= regionPages * pageSize;
+				count += regionPages;
+			}
+
+			return count;
+		}
+
+		/**
+		 *	Bytes of pages which are backed by physical memory (used and idle).
+		 */
+		size_t committed() const
+		{
+			return _committed;
+		}
+
+		/**
+		 *	Bytes of pages which are allocated by the pool users.
+		 */
+		size_t used() const
+		{
+			return _used;
+		}
+
+		/**
+		 *	Bytes of address space held by the pool.
+		 */
+		size_t reserved() const
+		{
+			return _regions.size() * regionSize;
+		}
+
+		const Stats & stats() const
+		{
+			return _stats;
+		}
+
+		static const size_t size = pageSize;
+
 	private:
-		PageType * _page;
+		static const size_t regionSize = Backend::region(pageSize);
+		static const size_t regionPages = regionSize / pageSize;
+
+		void reserve()
+		{
+			auto * base = static_cast<byte *>(Backend::allocate(regionSize));
+
+			if(base == nullptr)
+				throw std::bad_alloc();
+
+			auto it = std::upper_bound(_regions.begin(), _regions.end(), base, [](byte * ptr, const region & r) { return ptr < r.base; });
+			_regions.insert(it, {base, 0, false});
+
+			_next = base;
+			_end = base + regionPages * pageSize;
+		}
+
+		void recommit(region & r)
+		{
+			Backend::recommit(r.base, regionPages * pageSize);
+
+			r.decommitted = false;
+			move(_decommitted, _idle, r);
+
+			for(size_t i = 0; i < regionPages; ++i)
+				_stats.page_allocated(pageSize);
+
+			_committed += regionPages * pageSize;
+		}
+
+		region & regionOf(void * page)
+		{
+			auto it = std::upper_bound(_regions.begin(), _regions.end(), static_cast<byte *>(page), [](byte * ptr, const region & r) { return ptr < r.base; });
+			return *(it - 1);
+		}
+
+		static void move(std::vector<void *> & from, std::vector<void *> & to, const region & r)
+		{
+			auto it = std::partition(from.begin(), from.end(), [&r](void * page) {
+				return page < r.base || page >= r.base + regionSize;
+			});
+
+			to.insert(to.end(), it, from.end());
+			from.erase(it, from.end());
+		}
+
+		std::vector<region> _regions;
+		std::vector<void *> _idle;
+		std::vector<void *> _decommitted;
+
+		byte * _next = nullptr;
+		byte * _end = nullptr;
+
+		size_t _committed = 0;
+		size_t _used = 0;
+		Stats _stats;
 	};
 }
 
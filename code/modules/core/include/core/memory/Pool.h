@@ -8,9 +8,13 @@
 //---------------------------------------------------------------------------
 
 #include "memory.h"
+#include "pool_stats.h"
 
 #include <atomic>
 #include <mutex>
+#include <new>
+
+#include <boost/assert.hpp>
 
 //---------------------------------------------------------------------------
 
@@ -28,33 +32,40 @@ namespace asd
 	 *	<blocksCount> MUST be a power of 2 and MUST NOT be greater than
 	 *	0x10000 because of memory optimization of indices.
 	 *
-	 *	Each pool allocates <blocksCount> * sizeof(<type>) bytes.
-	 *	If there is more memory needed, next pool is allocated automatically.
+	 *	Each page of the pool holds <blocksCount> blocks of sizeof(<type>) bytes.
+	 *	If there is more memory needed, next page is allocated automatically.
+	 *	<Stats> is the stats policy, see pool_stats.
 	 */
-	template<class T, uint blocksCount = 0x1000, class ThreadPolicy = empty>
+	template<class T, uint blocksCount = 0x1000, class ThreadPolicy = empty, class Stats = default_pool_stats>
 	class block_pool
 	{
 		deny_copy(block_pool);
 
+		struct page
+		{
+			page * next;
+		};
+
 	public:
-		block_pool()
+		block_pool() : _stats(identity<block_pool>(), blockSize)
 		{
-			_buffer = memory<T, 8>::allocate(blocksCount);
-			_first = _buffer;
-			_last = _buffer + blocksCount;
-			_free = nullptr;
+			grow();
 		}
 
 		~block_pool()
 		{
-			memory<T, 8>::free(_buffer);
-
-			if(_next != nullptr)
-				delete _next;
+			while(_pages != nullptr)
+			{
+				page * next = _pages->next;
+				memory<void, blockAlignment>::free(_pages);
+				_pages = next;
+			}
 		}
 
 		T * allocate()
 		{
+			_stats.allocated(blockSize);
+
 			if(_free != nullptr)
 			{
 				T * ptr = reinterpret_cast<T *>(_free);
@@ -63,139 +74,467 @@ namespace asd
 				return ptr;
 			}
 
-			if(_first < _last)
-			{
-				T * ptr = reinterpret_cast<T *>(_first);
-				_first = ptr + 1;
-				return ptr;
-			}
+			if(_first == _last)
+				grow();
 
-			return next_alloc();
+			return _first++;
 		}
 
 		void free(void * ptr)
 		{
+			_stats.freed();
+
 			*reinterpret_cast<void **>(ptr) = _free;
 			_free = ptr;
 		}
 
+		const Stats & stats() const
+		{
+			return _stats;
+		}
+
 		static const size_t blockSize = sizeof(T);
 
 	private:
-		T * _buffer;
-		void * _first;
-		void * _last;
-		void * _free;
+		static const size_t blockAlignment = alignof(T) > 8 ? alignof(T) : 8;
+		static const size_t headerSize = asd::align(sizeof(page), blockAlignment);
+		static const size_t pageBytes = headerSize + sizeof(T) * blocksCount;
 
-		block_pool * _next = nullptr;
-
-		T * next_alloc()
+		void grow()
 		{
-			if(_next == nullptr)
-				_next = new block_pool();
+			auto * p = static_cast<page *>(memory<void, blockAlignment>::allocate(pageBytes));
+
+			if(p == nullptr)
+				throw std::bad_alloc();
+
+			p->next = _pages;
+			_pages = p;
+
+			_first = reinterpret_cast<T *>(reinterpret_cast<byte *>(p) + headerSize);
+			_last = _first + blocksCount;
 
-			return _next->allocate();
+			_stats.page_allocated(pageBytes);
 		}
+
+		page * _pages = nullptr;
+		T * _first;
+		T * _last;
+		void * _free = nullptr;
+		Stats _stats;
 	};
 
+	namespace internals
+	{
+		/**
+		 *	@brief
+		 *	Packs a pointer together with a modification counter into one
+		 *	64-bit word, so both can be swapped with a single CAS. The counter
+		 *	is bumped on every successful swap which makes the ABA problem of
+		 *	the lock-free stacks below practically impossible.
+		 *
+		 *	On x64 user-space pointers fit into 47 bits and pooled blocks are
+		 *	at least 8-byte aligned, so 20 bits are left for the tag.
+		 *	On x86 a 32-bit pointer and a 32-bit tag share the word.
+		 */
+		struct tagged_word
+		{
+#ifdef ARCH_X64
+			static const int tagBits = 20;
+
+			static uint64_t pack(void * ptr, uint64_t tag)
+			{
+				return (reinterpret_cast<uint64_t>(ptr) >> 3) | (tag << (64 - tagBits));
+			}
+
+			template<class T>
+			static T * pointer(uint64_t word)
+			{
+				return reinterpret_cast<T *>((word << tagBits) >> (tagBits - 3));
+			}
+#else
+			static const int tagBits = 32;
+
+			static uint64_t pack(void * ptr, uint64_t tag)
+			{
+				return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) | (tag << (64 - tagBits));
+			}
+
+			template<class T>
+			static T * pointer(uint64_t word)
+			{
+				return reinterpret_cast<T *>(static_cast<uintptr_t>(word & 0xffffffff));
+			}
+#endif
+			static uint64_t tag(uint64_t word)
+			{
+				return word >> (64 - tagBits);
+			}
+		};
+
+		/**
+		 *	@brief
+		 *	Pool with per-thread caches addressed by thread_index. Attached
+		 *	pools get flush_cache() calls from exiting threads, so blocks
+		 *	cached by a thread return to the shared free list instead of
+		 *	waiting for a new thread to take its index.
+		 */
+		class thread_cache_owner
+		{
+		public:
+			virtual ~thread_cache_owner() {}
+
+			static void flush_all(uint index)
+			{
+				std::lock_guard<std::mutex> guard(lock());
+
+				for(auto * owner = first(); owner != nullptr; owner = owner->_next)
+					owner->flush_cache(index);
+			}
+
+		protected:
+			// flushes the cache of the exiting thread with the <index>, called by that thread only
+			virtual void flush_cache(uint index) = 0;
+
+			// must be called by a completely constructed pool
+			void attach()
+			{
+				std::lock_guard<std::mutex> guard(lock());
+
+				_next = first();
+
+				if(_next != nullptr)
+					_next->_prev = this;
+
+				first() = this;
+			}
+
+			void detach()
+			{
+				std::lock_guard<std::mutex> guard(lock());
+
+				if(_prev != nullptr)
+					_prev->_next = _next;
+				else
+					first() = _next;
+
+				if(_next != nullptr)
+					_next->_prev = _prev;
+			}
+
+		private:
+			static std::mutex & lock()
+			{
+				static std::mutex mutex;
+				return mutex;
+			}
+
+			static thread_cache_owner *& first()
+			{
+				static thread_cache_owner * owner = nullptr;
+				return owner;
+			}
+
+			thread_cache_owner * _prev = nullptr;
+			thread_cache_owner * _next = nullptr;
+		};
+
+		/**
+		 *	@brief
+		 *	Small per-thread index used to address per-thread caches of pools.
+		 *	Indices are recycled when threads exit, so a cache slot is always
+		 *	owned by at most one live thread. Threads beyond <maxThreads> get
+		 *	<maxThreads> as an index and must work without a cache.
+		 *	Caches of a thread are flushed when it exits.
+		 */
+		class thread_index
+		{
+		public:
+			static const uint maxThreads = 64;
+
+			static uint get()
+			{
+				static thread_local thread_index index;
+				return index._value;
+			}
+
+		private:
+			thread_index() : _value(acquire()) {}
+
+			~thread_index()
+			{
+				if(_value < maxThreads)
+				{
+					thread_cache_owner::flush_all(_value);
+					used().fetch_and(~(uint64_t(1) << _value), std::memory_order_release);
+				}
+			}
+
+			static atomic<uint64_t> & used()
+			{
+				static atomic<uint64_t> bits {0};
+				return bits;
+			}
+
+			static uint acquire()
+			{
+				auto & bits = used();
+				uint64_t value = bits.load(std::memory_order_relaxed);
+
+				while(value != ~uint64_t(0))
+				{
+					uint i = 0;
+
+					while(value & (uint64_t(1) << i))
+						++i;
+
+					if(bits.compare_exchange_weak(value, value | (uint64_t(1) << i), std::memory_order_acquire))
+						return i;
+				}
+
+				return maxThreads;
+			}
+
+			uint _value;
+		};
+	}
+
 	/**
 	 *	@brief
-	 *	Safe and lock-free memory pool.
-	 *	<blocksCount> MUST be a power of 2 and MUST NOT be greater than
-	 *	0x10000 because of memory optimization of indices.
+	 *	Thread-safe lock-free memory pool.
+	 *	<blocksCount> is the number of blocks in one page, it MUST be a power of 2.
 	 *
-	 *	Each pool allocates <blocksCount> * sizeof(<T>) bytes.
-	 *	If there is more memory needed, next pool is allocated automatically.
+	 *	Each thread keeps a small cache of free blocks, so the most of
+	 *	allocations and frees don't touch shared state at all. Caches exchange
+	 *	blocks with the global free list in batches of <batchSize> blocks.
+	 *	The global free list is a stack of batches guarded by a tagged head.
+	 *	New pages are published with a CAS, so several threads may grow the
+	 *	pool at the same time without blocking each other. The cache of a
+	 *	thread is flushed to the global free list when the thread exits.
+	 *
+	 *	Blocks may be freed by any thread, not only by the allocating one.
+	 *	Pages are returned to the system when the pool is destroyed, so the
+	 *	pool must outlive all of its blocks. Blocks sitting in thread caches
+	 *	are counted as freed by <Stats>.
 	 */
-	template<class T, uint blocksCount>
-	class block_pool<T, blocksCount, thread_safe_pool> : protected std::mutex
+	template<class T, uint blocksCount, class Stats>
+	class block_pool<T, blocksCount, thread_safe_pool, Stats> : internals::thread_cache_owner
 	{
 		deny_copy(block_pool);
 
-	public:
-		block_pool()
+		struct node
+		{
+			node * next;			// next block of the same batch
+			atomic<node *> batch;	// next batch, valid in the head of a batch only
+		};
+
+		struct page
 		{
-			_buffer = memory<T>::allocate(blocksCount);
+			page * next;
+		};
+
+		struct alignas(64) cache
+		{
+			node * head = nullptr;
+			uint count = 0;			// never greater than the real amount of cached blocks
+		};
+
+	public:
+		static const size_t blockSize = sizeof(T);
+		static const uint batchSize = blocksCount < 32 ? blocksCount : 32;
 
-			for(register ushort i = 0; i <= lastBlock; ++i)
-				_freeList[i] = i;
+		block_pool() : _stats(identity<block_pool>(), blockSize)
+		{
+			attach();
 		}
 
 		~block_pool()
 		{
-			memory<T>::free(_buffer);
+			detach();
+
+			page * p = _pages.load(std::memory_order_acquire);
 
-			if(_next != nullptr)
-				delete _next;
+			while(p != nullptr)
+			{
+				page * next = p->next;
+				memory<void, blockAlignment>::free(p);
+				p = next;
+			}
 		}
 
 		T * allocate()
 		{
-			if(_count.load() <= 0)
-				return next_alloc();
-
-			int c = --_count;
+			_stats.allocated(blockSize);
+			uint index = internals::thread_index::get();
 
-			if(c <= 0)
+			if(index >= internals::thread_index::maxThreads)
 			{
-				++_count;
-				return next_alloc();
+				node * n = pop_batch();
+
+				if(n == nullptr)
+					n = grow();
+
+				if(n->next != nullptr)
+					push_batches(n->next, n->next);
+
+				return reinterpret_cast<T *>(n);
 			}
 
-			volatile uint & place = _freeList[++_head % blocksCount];
+			cache & c = _caches[index];
+
+			if(c.head == nullptr)
+			{
+				c.head = pop_batch();
 
-			while(place == erased_block);
+				if(c.head == nullptr)
+					c.head = grow();
+			}
 
-			T * ptr = _buffer + place;
-			place = erased_block;
+			node * n = c.head;
+			c.head = n->next;
 
-			return ptr;
+			if(c.count > 0)
+				--c.count;
+
+			return reinterpret_cast<T *>(n);
 		}
 
 		void free(void * ptr)
 		{
-			T * _ptr = reinterpret_cast<T *>(ptr);
+			_stats.freed();
 
-			if(_ptr < _buffer || _ptr > _buffer + lastElement)
-			{
-				if(_next)
-					_next->free(_ptr);
+			node * n = static_cast<node *>(ptr);
+			uint index = internals::thread_index::get();
 
+			if(index >= internals::thread_index::maxThreads)
+			{
+				n->next = nullptr;
+				push_batches(n, n);
 				return;
 			}
 
-			_freeList[++_tail % blocksCount] = static_cast<uint>(_ptr - _buffer);
-			++_count;
+			cache & c = _caches[index];
+
+			n->next = c.head;
+			c.head = n;
+
+			if(++c.count < batchSize * 2)
+				return;
+
+			node * last = n;
+
+			for(uint i = 1; i < batchSize; ++i)
+				last = last->next;
+
+			c.head = last->next;
+			c.count -= batchSize;
+
+			last->next = nullptr;
+			push_batches(n, n);
 		}
 
-		static const size_t blockSize = sizeof(T);
+		const Stats & stats() const
+		{
+			return _stats;
+		}
 
 	private:
-		static const ushort lastBlock = static_cast<ushort>(blocksCount - 1);
-		static const uint lastElement = static_cast<uint>(lastBlock * blockSize);
+		using tagged = internals::tagged_word;
+
+		static const size_t blockAlignment = alignof(T) > alignof(node) ? alignof(T) : alignof(node);
+		static const size_t blockStride = asd::align(sizeof(T) > sizeof(node) ? sizeof(T) : sizeof(node), blockAlignment);
+		static const size_t headerSize = asd::align(sizeof(page), blockAlignment);
+		static const size_t pageBytes = headerSize + blockStride * blocksCount;
+
+		virtual void flush_cache(uint index) override
+		{
+			cache & c = _caches[index];
 
-		T * _buffer;
-		uint _freeList[blocksCount];
-		atomic<ushort> _count = static_cast<ushort>(blocksCount);
-		atomic<ushort> _head = 0;
-		atomic<ushort> _tail = 0;
+			if(c.head == nullptr)
+				return;
 
-		block_pool * _next = nullptr;
+			// the whole cache becomes one batch, batches may be of any length
+			push_batches(c.head, c.head);
+			c.head = nullptr;
+			c.count = 0;
+		}
 
-		T * next_alloc()
+		node * pop_batch()
 		{
-			if(_next == nullptr)
+			uint64_t top = _batches.load(std::memory_order_acquire);
+
+			while(true)
 			{
-				lock();
+				node * n = tagged::pointer<node>(top);
 
-				if(_next == nullptr)
-					_next = new block_pool();
+				if(n == nullptr)
+					return nullptr;
 
-				unlock();
+				uint64_t next = tagged::pack(n->batch.load(std::memory_order_relaxed), tagged::tag(top) + 1);
+
+				if(_batches.compare_exchange_weak(top, next, std::memory_order_acquire))
+					return n;
 			}
+		}
+
+		void push_batches(node * first, node * last)
+		{
+			uint64_t top = _batches.load(std::memory_order_relaxed);
 
-			return _next->allocate();
+			do
+				last->batch.store(tagged::pointer<node>(top), std::memory_order_relaxed);
+			while(!_batches.compare_exchange_weak(top, tagged::pack(first, tagged::tag(top) + 1), std::memory_order_release));
 		}
+
+		/**
+		 *	Allocates a new page, splits it into batches, keeps the first batch
+		 *	for the caller and publishes the rest in the global free list.
+		 */
+		node * grow()
+		{
+			auto * p = static_cast<page *>(memory<void, blockAlignment>::allocate(pageBytes));
+
+			if(p == nullptr)
+				throw std::bad_alloc();
+
+			_stats.page_allocated(pageBytes);
+
+			p->next = _pages.load(std::memory_order_relaxed);
+
+			while(!_pages.compare_exchange_weak(p->next, p, std::memory_order_release));
+
+			byte * blocks = reinterpret_cast<byte *>(p) + headerSize;
+			auto block = [blocks](uint i) {
+				return reinterpret_cast<node *>(blocks + blockStride * i);
+			};
+
+			node * lastHead = nullptr;
+
+			for(uint i = 0; i < blocksCount; i += batchSize)
+			{
+				node * head = block(i);
+
+				for(uint j = i; j < i + batchSize - 1; ++j)
+					block(j)->next = block(j + 1);
+
+				block(i + batchSize - 1)->next = nullptr;
+				new (&head->batch) atomic<node *>(nullptr);
+
+				if(lastHead != nullptr)
+					lastHead->batch.store(head, std::memory_order_relaxed);
+
+				lastHead = head;
+			}
+
+			if(blocksCount > batchSize)
+				push_batches(block(batchSize), lastHead);
+
+			return block(0);
+		}
+
+		atomic<uint64_t> _batches {0};
+		atomic<page *> _pages {nullptr};
+		cache _caches[internals::thread_index::maxThreads];
+		Stats _stats;
 	};
 
 	/**
@@ -204,61 +543,97 @@ namespace asd
 	 *	<blocksCount> MUST be a power of 2 and MUST NOT be greater than
 	 *	0x10000 because of memory optimization of indices.
 	 *
-	 *	Each pool allocates <blocksCount> * sizeof(<type>) bytes.
-	 *	If there is more memory needed, next pool is allocated automatically.
+	 *	Each page holds at least <blocksCount> objects of the <type>.
+	 *	If there is more memory needed, next page is allocated automatically.
 	 *
 	 *	Data isn't erasing while freeing, it is the difference from BlockPool
+	 *
+	 *	Pages are aligned to the power of 2 which is not less than the size
+	 *	of a page of <blocksCount> blocks, so the page of any block is found
+	 *	in O(1) by masking its address. Pages take their whole alignment and
+	 *	hold as many blocks as fit into it (pageBlocks), so the alignment
+	 *	doesn't waste address space.
+	 *	When the count of empty pages exceeds the high watermark, empty pages
+	 *	are returned to the system until the low watermark is reached.
+	 *	Objects of a released page are destroyed.
+	 *	<Stats> is the stats policy, see pool_stats.
 	 */
-	template<class T, uint blocksCount = 0x1000, class ThreadPolicy = empty>
+	template<class T, uint blocksCount = 0x1000, class ThreadPolicy = empty, class Stats = default_pool_stats>
 	class data_pool
 	{
 		deny_copy(data_pool);
 
-		struct page
+		template<uint count>
+		struct basic_page
 		{
-			page(data_pool * pool, page * prev) : _pool(pool), _prev(prev)
+			basic_page(data_pool * pool, basic_page * prev) : _pool(pool), _prev(prev), _buffer(reinterpret_cast<T *>(_data))
 			{
-				_buffer = memory<T>::allocate(blocksCount);
-
 				if(_prev != nullptr)
 					_prev->_next = this;
 			}
 
-			~page()
+			~basic_page()
 			{
 				if(_allocated > 0)
 				{
 					for(auto * ptr = _buffer; ptr < _buffer + _allocated; ++ptr)
 						ptr->~T();
 				}
-
-				memory<T>::free(_buffer);
-
-				if(_prev != nullptr)
-					delete _prev;
 			}
 
 			data_pool * _pool;
-			page * _prev;
-			page * _next = nullptr;
+			basic_page * _prev;
+			basic_page * _next = nullptr;
 
 			T * _buffer;
-			uint _freeList[blocksCount];
+			uint _freeList[count];
 			uint _free = erased_block;
 			uint _acquired = 0;
 			uint _allocated = 0;
+
+			alignas(T) byte _data[sizeof(T) * count];
+		};
+
+		static constexpr size_t alignment(size_t size, size_t value = 1)
+		{
+			return value >= size ? value : alignment(size, value << 1);
+		}
+
+		static const size_t pageAlignment = alignment(sizeof(basic_page<blocksCount>));
+
+		// the greatest count of blocks which fit into the page alignment, starting from an estimation by the block size
+		template<uint count, bool fits = sizeof(basic_page<count>) <= pageAlignment>
+		struct fitting : fitting<count - 1> {};
+
+		template<uint count>
+		struct fitting<count, true>
+		{
+			static const uint value = count;
 		};
 
 	public:
-		data_pool()
+		static const uint pageBlocks = fitting<blocksCount + static_cast<uint>((pageAlignment - sizeof(basic_page<blocksCount>)) / (sizeof(T) + sizeof(uint)))>::value;
+
+	private:
+		using page = basic_page<pageBlocks>;
+
+	public:
+		data_pool() : _stats(identity<data_pool>(), blockSize)
 		{
-			_first = new page(this, nullptr);
+			_first = newPage(nullptr);
 			_current = _first;
 		}
 
 		~data_pool()
 		{
-			delete _current;
+			page * p = _first;
+
+			while(p != nullptr)
+			{
+				page * next = p->_next;
+				deletePage(p);
+				p = next;
+			}
 		}
 
 		T * acquire()
@@ -269,8 +644,12 @@ namespace asd
 			{
 				if(p->_free != erased_block)
 				{
-					++p->_acquired;
+					if(p->_acquired++ == 0)
+						--_emptyPages;
+
 					++_acquired;
+					_stats.allocated(blockSize);
+
 					T * ptr = p->_buffer + p->_free;
 					p->_free = p->_freeList[p->_free];
 
@@ -286,46 +665,41 @@ namespace asd
 		template<class ... A, useif<can_construct<T, A...>::value>>
 		T * create(A &&... args)
 		{
-			if(_current->_allocated >= blocksCount)
+			if(_current == nullptr || _current->_allocated >= pageBlocks)
 			{
-				++_pages;
-				_current = new page(this, _current);
+				_current = newPage(_current);
+
+				if(_first == nullptr)
+					_first = _current;
 			}
 
 			T * ptr = _current->_buffer + _current->_allocated;
-			++_current->_acquired;
+
+			if(_current->_acquired++ == 0)
+				--_emptyPages;
+
 			++_current->_allocated;
 			++_acquired;
 			++_allocated;
+			_stats.allocated(blockSize);
 
 			return new (ptr) T(forward<A>(args)...);
 		}
 
 		void free(T * ptr)
 		{
-			page * p = _current;
+			page * p = pageOf(ptr);
+			BOOST_ASSERT_MSG(p->_pool == this, "The object doesn't belong to this pool!");
 
-			while(p != nullptr)
-			{
-				if(ptr >= p->_buffer && ptr < p->_buffer + blocksCount)
-				{
-					--p->_acquired;
-					--_acquired;
-					/*
-					if(p != _first && p->_acquired == 0 && _acquired < _pages * blocksCount * 2 / 3)
-					{
-						deletePage(p);
-						return;
-					}
-					*/
-					auto offset = static_cast<uint>(ptr - p->_buffer);
-					p->_freeList[offset] = p->_free;
-					p->_free = offset;
-					return;
-				}
+			--_acquired;
+			_stats.freed();
 
-				p = p->_prev;
-			}
+			auto offset = static_cast<uint>(ptr - p->_buffer);
+			p->_freeList[offset] = p->_free;
+			p->_free = offset;
+
+			if(--p->_acquired == 0 && ++_emptyPages > _highWatermark)
+				shrink(_lowWatermark);
 		}
 
 		void freeAll()
@@ -344,7 +718,50 @@ namespace asd
 				p = p->_next;
 			}
 
+			_stats.freed(_acquired);
 			_acquired = 0;
+			_emptyPages = _pages;
+		}
+
+		/**
+		 *	Returns empty pages to the system until there are at most <keep>
+		 *	empty pages left. Returns the count of released pages.
+		 */
+		size_t shrink(size_t keep = 0)
+		{
+			size_t released = 0;
+			page * p = _first;
+
+			while(p != nullptr && _emptyPages > keep)
+			{
+				page * next = p->_next;
+
+				if(p->_acquired == 0)
+				{
+					unlink(p);
+					deletePage(p);
+					++released;
+				}
+
+				p = next;
+			}
+
+			return released;
+		}
+
+		/**
+		 *	Sets the count of empty pages which triggers automatic shrinking
+		 *	(<high>) and the count of empty pages which are kept after it (<low>).
+		 */
+		void watermarks(size_t low, size_t high)
+		{
+			BOOST_ASSERT_MSG(low <= high, "Low watermark must not be greater than the high one!");
+
+			_lowWatermark = low;
+			_highWatermark = high;
+
+			if(_emptyPages > _highWatermark)
+				shrink(_lowWatermark);
 		}
 
 		size_t count() const
@@ -357,48 +774,99 @@ namespace asd
 			return _acquired;
 		}
 
+		size_t pages() const
+		{
+			return _pages;
+		}
+
+		size_t emptyPages() const
+		{
+			return _emptyPages;
+		}
+
+		const Stats & stats() const
+		{
+			return _stats;
+		}
+
 		static const size_t blockSize = sizeof(T);
+		static const size_t pageSize = pageAlignment;
 
 	private:
-		static const ushort lastBlock = static_cast<ushort>(blocksCount - 1);
-		static const uint lastElement = lastBlock * blockSize;
 
-		void deletePage(page * p)
+		static page * pageOf(T * ptr)
 		{
-			--_pages;
-			_allocated -= p->_allocated;
+			return reinterpret_cast<page *>(reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(pageAlignment - 1));
+		}
+
+		page * newPage(page * prev)
+		{
+			void * place = memory<void, pageAlignment>::allocate(pageSize);
+
+			if(place == nullptr)
+				throw std::bad_alloc();
+
+			++_pages;
+			++_emptyPages;
+			_stats.page_allocated(pageSize);
+
+			return new (place) page(this, prev);
+		}
+
+		void unlink(page * p)
+		{
+			if(p == _first)
+				_first = p->_next;
 
 			if(p == _current)
 				_current = p->_prev;
 
-			p->_prev->_next = p->_next;
+			if(p->_prev != nullptr)
+				p->_prev->_next = p->_next;
 
 			if(p->_next != nullptr)
 				p->_next->_prev = p->_prev;
+		}
 
-			p->_prev = nullptr;
-			delete p;
+		void deletePage(page * p)
+		{
+			--_pages;
+			_allocated -= p->_allocated;
+			_acquired -= p->_acquired;
+
+			if(p->_acquired == 0)
+				--_emptyPages;
+
+			_stats.freed(p->_acquired);
+			_stats.page_freed(pageSize);
+
+			p->~page();
+			memory<void, pageAlignment>::free(p);
 		}
 
 		size_t _acquired = 0;
 		size_t _allocated = 0;
-		uint   _pages = 1;
+		size_t _pages = 0;
+		size_t _emptyPages = 0;
+		size_t _lowWatermark = 1;
+		size_t _highWatermark = 4;
 		page * _first = nullptr;
 		page * _current = nullptr;
-		
-		static void clear(uint (& freeList)[blocksCount], uint count)
+		Stats _stats;
+
+		static void clear(uint (& freeList)[pageBlocks], uint count)
 		{
 			static const struct FreeList
 			{
 				FreeList()
 				{
-					for(uint i = 0; i < blocksCount - 1; ++i)
+					for(uint i = 0; i < pageBlocks - 1; ++i)
 						list[i] = i + 1;
 
-					list[blocksCount - 1] = erased_block;
+					list[pageBlocks - 1] = erased_block;
 				}
 
-				uint list[blocksCount];
+				uint list[pageBlocks];
 			} f;
 
 			memory<uint>::move(freeList, f.list, count);
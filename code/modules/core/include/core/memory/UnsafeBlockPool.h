@@ -15,8 +15,8 @@ namespace asd
 {
 #define next_ptr(x, ...) *reinterpret_cast<void * __VA_ARGS__ *>(x)
 
-	template<class id, size_t typeSize = sizeof(id), size_t pageSize = 0x10000, size_t alignment = 8>
-	class UnsafeBlockPool : protected PagePool<pageSize>
+	template<class id, size_t typeSize = sizeof(id), size_t pageSize = 0x10000, size_t alignment = 8, class Backend = heap_pages, class Stats = default_pool_stats>
+	class UnsafeBlockPool : protected PagePool<pageSize, Backend, no_pool_stats>
 	{
 	public:
 		UnsafeBlockPool(const UnsafeBlockPool & pool) = delete;
@@ -26,6 +26,8 @@ namespace asd
 
 		forceinline void * allocate()
 		{
+			_stats.allocated(typeSize);
+
 			if(_head == nullptr)
 				_head = newPage();
 
@@ -37,10 +39,17 @@ namespace asd
 
 		forceinline void free(void * ptr)
 		{
+			_stats.freed();
+
 			next_ptr(ptr) = _head;
 			_head = ptr;
 		}
 
+		const Stats & stats() const
+		{
+			return _stats;
+		}
+
 		static const int blockSize = typeSize;
 
 	private:
@@ -50,8 +59,9 @@ namespace asd
 		template<class T>
 		friend inline T & getsingleton();
 
-		UnsafeBlockPool() : _head(newPage()) {}
+		UnsafeBlockPool() : _stats(identity<UnsafeBlockPool>(), typeSize), _head(newPage()) {}
 
+		Stats _stats;
 		void * _head;
 
 		void * newPage()
@@ -59,10 +69,8 @@ namespace asd
 			static const size_t blockSize = align(typeSize, alignment);
 			static const size_t count = pageSize / blockSize;
 
-			void * head = PagePool<pageSize>::allocatePage();
-
-			if(head == nullptr)
-				throw std::exception("Allocation error!");
+			void * head = PagePool<pageSize, Backend, no_pool_stats>::allocatePage();
+			_stats.page_allocated(pageSize);
 
 			void * ptr = head;
 
@@ -7,12 +7,22 @@
 
 //---------------------------------------------------------------------------
 
+#include <core/memory/magazine.h>
+
+//---------------------------------------------------------------------------
+
 namespace asd
 {
 	template<typename Pool>
 	using pool_t = typename Pool::type;
 
-	template<class Pool>
+	/**
+	 *	@brief
+	 *	Routes allocations of objects of the <Pool> block size to the shared
+	 *	pool instance. Use pool_alloc<Pool, thread_magazines> to put per-thread
+	 *	magazines in front of the pool.
+	 */
+	template<class Pool, class ThreadPolicy = empty>
 	class pool_alloc
 	{
 	public:
@@ -63,6 +73,71 @@ namespace asd
 
 		static void operator delete(void *, void *) throw() {}
 	};
+
+	/**
+	 *	@brief
+	 *	Pool allocator with per-thread magazines (see magazine_depot).
+	 *	Every block carries a magazine_header, so the block size of <Pool> must
+	 *	be equal to magazine_block_size<T> of the allocated type T.
+	 */
+	template<class Pool>
+	class pool_alloc<Pool, thread_magazines>
+	{
+		using depot = magazine_depot<pool_t<Pool>>;
+
+		static bool pooled(size_t size)
+		{
+			return size + sizeof(magazine_header) == pool_t<Pool>::blockSize;
+		}
+
+	public:
+		static inline void * operator new(size_t size)
+		{
+			if(!pooled(size))
+				return ::operator new(size);
+
+			return depot::allocate();
+		}
+
+		static inline void operator delete(void * ptr, size_t size)
+		{
+			if(!pooled(size))
+			{
+				::operator delete(ptr);
+				return;
+			}
+
+			if(ptr != nullptr)
+				depot::free(ptr);
+		}
+
+		static inline void * operator new(size_t size, const nothrow_t & nt) throw()
+		{
+			if(!pooled(size))
+				return ::operator new(size, nt);
+
+			return depot::allocate();
+		}
+
+		static inline void operator delete(void * ptr, size_t size, const nothrow_t & nt) throw()
+		{
+			if(!pooled(size))
+			{
+				::operator delete(ptr, nt);
+				return;
+			}
+
+			if(ptr != nullptr)
+				depot::free(ptr);
+		}
+
+		static inline void * operator new(size_t, void * place) throw()
+		{
+			return place;
+		}
+
+		static void operator delete(void *, void *) throw() {}
+	};
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,328 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef ARENA_H
+#define ARENA_H
+
+//---------------------------------------------------------------------------
+
+#include "memory.h"
+
+#include <new>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <memory_resource>
+#define ASD_HAS_MEMORY_RESOURCE
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	/**
+	 *	@brief
+	 *	Monotonic (bump) allocator for short-living data.
+	 *	Memory is taken from chunks of <chunkSize> bytes, single objects are
+	 *	never freed. Everything allocated after a marker is released in O(1)
+	 *	by rewinding the arena to that marker, reset() releases everything.
+	 *	Chunks are kept for reuse, release() returns them to the system.
+	 *
+	 *	Scopes may be nested: each scope remembers the position of the arena
+	 *	and rewinds it on exit. A scope also makes its arena the current arena
+	 *	of the thread, see arena_alloc.
+	 *
+	 *	In the guarded mode every allocation gets its own pages followed by a
+	 *	protected guard page and all pages are unmapped on rewind. Overruns and
+	 *	accesses after rewind fault immediately. This mode is very slow and is
+	 *	intended for debugging only.
+	 *
+	 *	Destructors of created objects are not called.
+	 */
+	class arena
+	{
+		deny_copy(arena);
+
+		struct chunk
+		{
+			chunk * next;
+			size_t capacity;
+		};
+
+		struct guard
+		{
+			guard * prev;
+			size_t size;
+		};
+
+	public:
+		struct marker
+		{
+			chunk * block;
+			size_t offset;
+			guard * guarded;
+		};
+
+		class scope
+		{
+			deny_copy(scope);
+
+		public:
+			scope(arena & a) : _arena(a), _marker(a.mark()), _previous(current())
+			{
+				current_slot() = &a;
+			}
+
+			~scope()
+			{
+				_arena.rewind(_marker);
+				current_slot() = _previous;
+			}
+
+		private:
+			arena & _arena;
+			marker _marker;
+			arena * _previous;
+		};
+
+		static const size_t defaultChunkSize = 0x10000;
+
+		explicit arena(size_t chunkSize = defaultChunkSize, bool guarded = false) : _chunkSize(chunkSize), _guarded(guarded) {}
+
+		~arena()
+		{
+			rewind({nullptr, 0, nullptr});
+
+			while(_first != nullptr)
+			{
+				chunk * next = _first->next;
+				memory<void>::free(_first);
+				_first = next;
+			}
+		}
+
+		void * allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			BOOST_ASSERT_MSG((alignment & (alignment - 1)) == 0, "Invalid alignment!");
+
+			if(!_guarded && _current != nullptr)
+			{
+				size_t offset = aligned_offset(_current, _offset, alignment);
+
+				if(offset + size <= _current->capacity)
+				{
+					_offset = offset + size;
+					return data(_current) + offset;
+				}
+			}
+
+			return allocate_slow(size, alignment);
+		}
+
+		template<class T, class ... A>
+		T * create(A && ... args)
+		{
+			return new (allocate(sizeof(T), alignof(T))) T(forward<A>(args)...);
+		}
+
+		marker mark() const
+		{
+			return {_current, _offset, _guarded ? _guards : nullptr};
+		}
+
+		void rewind(const marker & m)
+		{
+			if(_guarded)
+			{
+				release_guards(m.guarded);
+				return;
+			}
+
+			_current = m.block != nullptr ? m.block : _first;
+			_offset = m.block != nullptr ? m.offset : 0;
+		}
+
+		void reset()
+		{
+			rewind({nullptr, 0, nullptr});
+		}
+
+		/**
+		 *	Resets the arena and returns all chunks except the first one
+		 *	to the system.
+		 */
+		api(core)
+		void release();
+
+		bool guarded() const
+		{
+			return _guarded;
+		}
+
+		/**
+		 *	Count of bytes reserved by the arena chunks.
+		 */
+		size_t reserved() const
+		{
+			return _reserved;
+		}
+
+		static arena * current()
+		{
+			return current_slot();
+		}
+
+	private:
+		static const size_t chunkHeaderSize = asd::align(sizeof(chunk), alignof(std::max_align_t));
+
+		static byte * data(chunk * c)
+		{
+			return reinterpret_cast<byte *>(c) + chunkHeaderSize;
+		}
+
+		static size_t aligned_offset(chunk * c, size_t offset, size_t alignment)
+		{
+			auto base = reinterpret_cast<uintptr_t>(data(c));
+			return asd::align(base + offset, alignment) - base;
+		}
+
+		api(core)
+		void * allocate_slow(size_t size, size_t alignment);
+
+		api(core)
+		void * allocate_guarded(size_t size, size_t alignment);
+
+		api(core)
+		void release_guards(guard * until);
+
+		api(core)
+		static arena *& current_slot();
+
+		size_t _chunkSize;
+		bool _guarded;
+
+		chunk * _first = nullptr;
+		chunk * _current = nullptr;
+		size_t _offset = 0;
+		size_t _reserved = 0;
+
+		guard * _guards = nullptr;
+	};
+
+	/**
+	 *	@brief
+	 *	Standard allocator which takes memory from an arena.
+	 *	Deallocation does nothing, memory is released by the arena.
+	 *	Example: array_list<int, arena_allocator<int>> list(frame_arena);
+	 */
+	template<class T>
+	struct arena_allocator
+	{
+		template<class>
+		friend struct arena_allocator;
+
+		using value_type = T;
+
+		arena_allocator(arena & a) noexcept : _arena(&a) {}
+
+		template<class U>
+		arena_allocator(const arena_allocator<U> & a) noexcept : _arena(a._arena) {}
+
+		T * allocate(size_t count)
+		{
+			return static_cast<T *>(_arena->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T *, size_t) noexcept {}
+
+		template<class U>
+		bool operator == (const arena_allocator<U> & a) const noexcept
+		{
+			return _arena == a._arena;
+		}
+
+		template<class U>
+		bool operator != (const arena_allocator<U> & a) const noexcept
+		{
+			return _arena != a._arena;
+		}
+
+	private:
+		arena * _arena;
+	};
+
+	/**
+	 *	@brief
+	 *	Class allocation policy (see default_alloc). Objects are allocated from
+	 *	the current arena of the thread (see arena::scope) or from the heap if
+	 *	there is no current arena. Arena-allocated objects must be destroyed
+	 *	before their scope is left.
+	 */
+	struct arena_alloc
+	{
+		static inline void * operator new(size_t size)
+		{
+			arena * a = arena::current();
+			auto * h = static_cast<header *>(a != nullptr ? a->allocate(sizeof(header) + size) : _new(sizeof(header) + size));
+			h->owner = a;
+
+			return h + 1;
+		}
+
+		static inline void operator delete(void * ptr, size_t size)
+		{
+			if(ptr == nullptr)
+				return;
+
+			auto * h = static_cast<header *>(ptr) - 1;
+
+			if(h->owner == nullptr)
+				_delete(h);
+		}
+
+		static inline void * operator new(size_t, void * place) throw()
+		{
+			return place;
+		}
+
+		static inline void operator delete(void *, void *) throw() {}
+
+	private:
+		struct alignas(std::max_align_t) header
+		{
+			arena * owner;
+		};
+	};
+
+#ifdef ASD_HAS_MEMORY_RESOURCE
+	/**
+	 *	@brief
+	 *	std::pmr adapter for arenas, allows to use pmr containers with arenas.
+	 */
+	class arena_resource : public std::pmr::memory_resource
+	{
+	public:
+		arena_resource(arena & a) : _arena(a) {}
+
+	protected:
+		void * do_allocate(size_t size, size_t alignment) override
+		{
+			return _arena.allocate(size, alignment);
+		}
+
+		void do_deallocate(void *, size_t, size_t) override {}
+
+		bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+		{
+			auto * r = dynamic_cast<const arena_resource *>(&other);
+			return r != nullptr && &r->_arena == &_arena;
+		}
+
+	private:
+		arena & _arena;
+	};
+#endif
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,403 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MAGAZINE_H
+#define MAGAZINE_H
+
+//---------------------------------------------------------------------------
+
+#include "Pool.h"
+
+#include <meta/useif.h>
+#include <mutex>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	struct thread_magazines {};
+
+	/**
+	 *	@brief
+	 *	Marks a pool whose magazine depot is never destroyed. Blocks of such
+	 *	pools may be freed by statics and by threads which are still running
+	 *	at exit. The pool itself must never be destroyed too.
+	 */
+	struct persistent_pool {};
+
+	namespace internals
+	{
+		/**
+		 *	@brief
+		 *	Lock-free intrusive stack. Nodes must have an `atomic<Node *> next`
+		 *	field and must not be freed while the stack is in use.
+		 */
+		template<class Node>
+		class tagged_stack
+		{
+		public:
+			void push(Node * n)
+			{
+				uint64_t top = _head.load(std::memory_order_relaxed);
+
+				do
+					n->next.store(tagged_word::pointer<Node>(top), std::memory_order_relaxed);
+				while(!_head.compare_exchange_weak(top, tagged_word::pack(n, tagged_word::tag(top) + 1), std::memory_order_release));
+			}
+
+			Node * pop()
+			{
+				uint64_t top = _head.load(std::memory_order_acquire);
+
+				while(true)
+				{
+					Node * n = tagged_word::pointer<Node>(top);
+
+					if(n == nullptr)
+						return nullptr;
+
+					uint64_t next = tagged_word::pack(n->next.load(std::memory_order_relaxed), tagged_word::tag(top) + 1);
+
+					if(_head.compare_exchange_weak(top, next, std::memory_order_acquire))
+						return n;
+				}
+			}
+
+		private:
+			atomic<uint64_t> _head {0};
+		};
+	}
+
+	/**
+	 *	@brief
+	 *	Fixed-size stack of free blocks. Magazines are passed between threads
+	 *	and the depot as a whole, so the shared state is touched once per
+	 *	<capacity> allocations or frees.
+	 */
+	template<uint capacity>
+	struct magazine
+	{
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		bool full() const
+		{
+			return count == capacity;
+		}
+
+		atomic<magazine *> next {nullptr};
+		uint count = 0;
+		void * blocks[capacity];
+	};
+
+	/**
+	 *	@brief
+	 *	Header which is placed in front of every block handed out by the
+	 *	magazine layer. It remembers the thread cache which owns the block.
+	 */
+	struct alignas(std::max_align_t) magazine_header
+	{
+		void * owner;
+	};
+
+	/**
+	 *	@brief
+	 *	Block size the underlying pool must provide to serve objects of the
+	 *	type T through the magazine layer.
+	 */
+	template<class T>
+	constexpr size_t magazine_block_size = sizeof(magazine_header) + sizeof(T);
+
+	/**
+	 *	@brief
+	 *	Per-thread magazine layer in front of the shared pool <Pool>.
+	 *
+	 *	Every thread owns a cache with two magazines. Allocations and frees of
+	 *	the owner are served from these magazines without synchronization.
+	 *	Full and empty magazines are exchanged with the depot, the shared
+	 *	<Pool> is touched only when the depot runs out of full magazines.
+	 *
+	 *	Blocks freed by a thread which doesn't own them are pushed to the
+	 *	remote-free queue of the owner and are picked up by the owner as soon as
+	 *	its magazines run out. Caches of exited threads are adopted by new
+	 *	threads together with their remote queues. The depot returns all the
+	 *	cached blocks to <Pool> on destruction unless <Pool> is based on
+	 *	persistent_pool, in which case the depot is never destroyed.
+	 *
+	 *	<Pool> must provide static instance(), allocate() and free(void *).
+	 *	Its blocks must be aligned as magazine_header, e.g. blocks of
+	 *	std::aligned_storage_t<magazine_block_size<T>, alignof(magazine_header)>.
+	 *	It is accessed under a lock, so it doesn't have to be thread-safe.
+	 *	<Stats> counts allocations and frees of the layer including
+	 *	cross-thread frees, pages are counted by the stats of <Pool>.
+	 */
+	template<class Pool, uint magazineSize = 32, class Stats = default_pool_stats>
+	class magazine_depot
+	{
+		deny_copy(magazine_depot);
+
+		using magazine_type = magazine<magazineSize>;
+
+	public:
+		class cache
+		{
+			friend class magazine_depot;
+
+		public:
+			void * allocate()
+			{
+				while(true)
+				{
+					if(!_loaded->empty())
+						return _loaded->blocks[--_loaded->count];
+
+					if(!_previous->empty())
+					{
+						std::swap(_loaded, _previous);
+						continue;
+					}
+
+					if(drain_remote())
+						continue;
+
+					auto * m = _depot._full.pop();
+
+					if(m != nullptr)
+					{
+						_depot._empty.push(_previous);
+						_previous = _loaded;
+						_loaded = m;
+						continue;
+					}
+
+					_depot.fill(*_loaded);
+				}
+			}
+
+			void free(void * block)
+			{
+				if(_loaded->full())
+				{
+					if(_previous->empty())
+					{
+						std::swap(_loaded, _previous);
+					}
+					else
+					{
+						_depot._full.push(_previous);
+						_previous = _loaded;
+						_loaded = _depot.empty_magazine();
+					}
+				}
+
+				_loaded->blocks[_loaded->count++] = block;
+			}
+
+			void remote_free(void * block)
+			{
+				void * head = _remote.load(std::memory_order_relaxed);
+
+				do
+					*static_cast<void **>(block) = head;
+				while(!_remote.compare_exchange_weak(head, block, std::memory_order_release));
+			}
+
+		private:
+			cache(magazine_depot & depot) : _depot(depot), _loaded(depot.empty_magazine()), _previous(depot.empty_magazine()) {}
+
+			bool drain_remote()
+			{
+				void * block = _remote.exchange(nullptr, std::memory_order_acquire);
+
+				if(block == nullptr)
+					return false;
+
+				while(block != nullptr)
+				{
+					void * next = *static_cast<void **>(block);
+					free(block);
+					block = next;
+				}
+
+				return true;
+			}
+
+			magazine_depot & _depot;
+			magazine_type * _loaded;
+			magazine_type * _previous;
+
+			atomic<void *> _remote {nullptr};
+			atomic<bool> _abandoned {false};
+			cache * _next = nullptr;
+		};
+
+		template<class P = Pool, skipif<based_on<P, persistent_pool>::value>>
+		static magazine_depot & instance()
+		{
+			static magazine_depot depot;
+			return depot;
+		}
+
+		template<class P = Pool, useif<based_on<P, persistent_pool>::value>>
+		static magazine_depot & instance()
+		{
+			static magazine_depot & depot = *new magazine_depot;
+			return depot;
+		}
+
+		static cache & local()
+		{
+			static thread_local holder h;
+			return *h.owned;
+		}
+
+		static void * allocate()
+		{
+			cache & c = local();
+			auto * header = static_cast<magazine_header *>(c.allocate());
+			header->owner = &c;
+
+			if(Stats::enabled)
+				instance()._stats.allocated(Pool::blockSize);
+
+			return header + 1;
+		}
+
+		static void free(void * ptr)
+		{
+			auto * header = static_cast<magazine_header *>(ptr) - 1;
+			auto * owner = static_cast<cache *>(header->owner);
+			cache & c = local();
+
+			if(Stats::enabled)
+			{
+				auto & stats = instance()._stats;
+				stats.freed();
+
+				if(owner != &c)
+					stats.remote_freed();
+			}
+
+			if(owner == &c)
+				c.free(header);
+			else
+				owner->remote_free(header);
+		}
+
+	private:
+		struct holder
+		{
+			holder() : owned(instance().acquire_cache()) {}
+
+			~holder()
+			{
+				instance().release_cache(*owned);
+			}
+
+			cache * owned;
+		};
+
+		magazine_depot() : _stats(identity<magazine_depot>(), Pool::blockSize)
+		{
+			Pool::instance();
+		}
+
+		~magazine_depot()
+		{
+			cache * c = _caches.load(std::memory_order_acquire);
+
+			while(c != nullptr)
+			{
+				cache * next = c->_next;
+
+				c->drain_remote();
+				release(c->_loaded);
+				release(c->_previous);
+				delete c;
+
+				c = next;
+			}
+
+			while(auto * m = _full.pop())
+				release(m);
+
+			while(auto * m = _empty.pop())
+				delete m;
+		}
+
+		cache * acquire_cache()
+		{
+			for(cache * c = _caches.load(std::memory_order_acquire); c != nullptr; c = c->_next)
+			{
+				bool abandoned = true;
+
+				if(c->_abandoned.load(std::memory_order_relaxed) && c->_abandoned.compare_exchange_strong(abandoned, false, std::memory_order_acquire))
+					return c;
+			}
+
+			cache * c = new cache(*this);
+			c->_next = _caches.load(std::memory_order_relaxed);
+
+			while(!_caches.compare_exchange_weak(c->_next, c, std::memory_order_release));
+
+			return c;
+		}
+
+		void release_cache(cache & c)
+		{
+			c.drain_remote();
+
+			if(!c._loaded->empty())
+			{
+				_full.push(c._loaded);
+				c._loaded = empty_magazine();
+			}
+
+			if(!c._previous->empty())
+			{
+				_full.push(c._previous);
+				c._previous = empty_magazine();
+			}
+
+			c._abandoned.store(true, std::memory_order_release);
+		}
+
+		magazine_type * empty_magazine()
+		{
+			auto * m = _empty.pop();
+			return m != nullptr ? m : new magazine_type;
+		}
+
+		void fill(magazine_type & m)
+		{
+			std::lock_guard<std::mutex> guard(_lock);
+			auto & pool = Pool::instance();
+
+			for(; m.count < magazineSize; ++m.count)
+				m.blocks[m.count] = pool.allocate();
+		}
+
+		void release(magazine_type * m)
+		{
+			std::lock_guard<std::mutex> guard(_lock);
+			auto & pool = Pool::instance();
+
+			for(uint i = 0; i < m->count; ++i)
+				pool.free(m->blocks[i]);
+
+			delete m;
+		}
+
+		internals::tagged_stack<magazine_type> _full;
+		internals::tagged_stack<magazine_type> _empty;
+		atomic<cache *> _caches {nullptr};
+		std::mutex _lock;
+		Stats _stats;
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,228 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef POOL_STATS_H
+#define POOL_STATS_H
+
+//---------------------------------------------------------------------------
+
+#include <meta/types.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/type_index/ctti_type_index.hpp>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	/**
+	 *	@brief
+	 *	Stats policy of pools which records nothing.
+	 */
+	struct no_pool_stats
+	{
+		static const bool enabled = false;
+
+		template<class Pool>
+		no_pool_stats(identity<Pool>, size_t) {}
+
+		void allocated(size_t) {}
+		void freed(size_t = 1) {}
+		void remote_freed() {}
+		void page_allocated(size_t) {}
+		void page_freed(size_t) {}
+	};
+
+	/**
+	 *	@brief
+	 *	Stats policy of pools which counts allocations, frees, live blocks and
+	 *	pages of the pool. Sizes of every <sampleRate>-th allocation are put
+	 *	into the log2 histogram. Counters are relaxed atomics, so the policy
+	 *	may be used by thread-safe pools, but it makes contended pools slower.
+	 *
+	 *	Every instance is registered in the pool_registry while it is alive.
+	 */
+	class pool_stats
+	{
+		friend class pool_registry;
+
+	public:
+		static const bool enabled = true;
+		static const uint sampleRate = 16;
+		static const uint histogramSize = 32;
+
+		struct snapshot
+		{
+			std::string name;
+			size_t blockSize;
+			size_t allocations;
+			size_t frees;
+			size_t remoteFrees;
+			size_t live;
+			size_t peak;
+			size_t pages;
+			size_t pageBytes;
+			size_t histogram[histogramSize];
+
+			/**
+			 *	Part of page memory which is not occupied by live blocks.
+			 */
+			double fragmentation() const
+			{
+				return pageBytes > 0 ? 1.0 - static_cast<double>(live * blockSize) / pageBytes : 0.0;
+			}
+		};
+
+		template<class Pool>
+		pool_stats(identity<Pool>, size_t blockSize) : _name(boost::typeindex::ctti_type_index::type_id<Pool>().pretty_name()), _blockSize(blockSize)
+		{
+			attach();
+		}
+
+		~pool_stats()
+		{
+			detach();
+		}
+
+		pool_stats(const pool_stats &) = delete;
+		pool_stats & operator = (const pool_stats &) = delete;
+
+		void allocated(size_t size)
+		{
+			if(_allocations.fetch_add(1, std::memory_order_relaxed) % sampleRate == 0)
+				_histogram[bucket(size)].fetch_add(1, std::memory_order_relaxed);
+
+			size_t live = _live.fetch_add(1, std::memory_order_relaxed) + 1;
+			size_t peak = _peak.load(std::memory_order_relaxed);
+
+			while(live > peak && !_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+		}
+
+		void freed(size_t count = 1)
+		{
+			_frees.fetch_add(count, std::memory_order_relaxed);
+			_live.fetch_sub(count, std::memory_order_relaxed);
+		}
+
+		/**
+		 *	Counts a free made by a thread which doesn't own the block.
+		 */
+		void remote_freed()
+		{
+			_remoteFrees.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void page_allocated(size_t bytes)
+		{
+			_pages.fetch_add(1, std::memory_order_relaxed);
+			_pageBytes.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		void page_freed(size_t bytes)
+		{
+			_pages.fetch_sub(1, std::memory_order_relaxed);
+			_pageBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		}
+
+		snapshot get() const
+		{
+			snapshot s;
+			s.name = _name;
+			s.blockSize = _blockSize;
+			s.allocations = _allocations.load(std::memory_order_relaxed);
+			s.frees = _frees.load(std::memory_order_relaxed);
+			s.remoteFrees = _remoteFrees.load(std::memory_order_relaxed);
+			s.live = _live.load(std::memory_order_relaxed);
+			s.peak = _peak.load(std::memory_order_relaxed);
+			s.pages = _pages.load(std::memory_order_relaxed);
+			s.pageBytes = _pageBytes.load(std::memory_order_relaxed);
+
+			for(uint i = 0; i < histogramSize; ++i)
+				s.histogram[i] = _histogram[i].load(std::memory_order_relaxed);
+
+			return s;
+		}
+
+	private:
+		static uint bucket(size_t size)
+		{
+			uint b = 0;
+
+			while(b < histogramSize - 1 && (size >> (b + 1)) != 0)
+				++b;
+
+			return b;
+		}
+
+		api(core)
+		void attach();
+		api(core)
+		void detach();
+
+		std::string _name;
+		size_t _blockSize;
+
+		std::atomic<size_t> _allocations {0};
+		std::atomic<size_t> _frees {0};
+		std::atomic<size_t> _remoteFrees {0};
+		std::atomic<size_t> _live {0};
+		std::atomic<size_t> _peak {0};
+		std::atomic<size_t> _pages {0};
+		std::atomic<size_t> _pageBytes {0};
+		std::atomic<size_t> _histogram[histogramSize] {};
+
+		pool_stats * _prev = nullptr;
+		pool_stats * _next = nullptr;
+	};
+
+	/**
+	 *	@brief
+	 *	Registry of all live pools which collect stats.
+	 *	Example: std::cout << pool_registry::text();
+	 */
+	class pool_registry
+	{
+		friend class pool_stats;
+
+	public:
+		api(core)
+		static std::vector<pool_stats::snapshot> snapshots();
+
+		/**
+		 *	Human-readable report of all pools.
+		 */
+		api(core)
+		static std::string text();
+
+		/**
+		 *	JSON array of all pools.
+		 */
+		api(core)
+		static std::string json();
+
+	private:
+		static pool_registry & instance();
+
+		std::mutex _lock;
+		pool_stats * _first = nullptr;
+	};
+
+	/**
+	 *	@brief
+	 *	Stats policy used by pools by default. Define POOL_STATISTICS to make
+	 *	all pools collect stats.
+	 */
+#ifdef POOL_STATISTICS
+	using default_pool_stats = pool_stats;
+#else
+	using default_pool_stats = no_pool_stats;
+#endif
+}
+
+//---------------------------------------------------------------------------
+#endif
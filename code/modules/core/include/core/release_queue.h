@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef RELEASE_QUEUE_H
+#define RELEASE_QUEUE_H
+
+//---------------------------------------------------------------------------
+
+#include <core/addition/singleton.h>
+#include <core/shareable.h>
+
+#include <chrono>
+#include <deque>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	class release_queue;
+
+	template struct api(core) singleton<release_queue, thread_local_model>;
+
+	/**
+	 *  @brief
+	 *  Per-thread queue of objects which have lost their last reference but
+	 *	are not destroyed yet (see deferred). Objects are destroyed by drain()
+	 *	in the order of their release. Objects released by destructors during
+	 *	the drain are queued too, so destruction of large graphs of objects
+	 *	may be spread over several drains.
+	 *
+	 *	thread_loop drains the queue of its thread after each pass over its
+	 *	iterations. Objects left in the queue are destroyed when the thread
+	 *	exits.
+	 */
+	class release_queue : public singleton<release_queue, thread_local_model>
+	{
+		friend singleton<release_queue, thread_local_model>;
+
+		struct entry
+		{
+			const void * object;
+			void (* destroy)(const void *);
+		};
+
+	public:
+		template<class T>
+		static void push(const T * object)
+		{
+			instance()._entries.push_back({object, &destroy<T>});
+		}
+
+		/**
+		 *  Destroys queued objects until the queue is empty or the <budget> is
+		 *	exceeded. At least one object is destroyed if the queue isn't empty.
+		 *	Returns the count of destroyed objects.
+		 */
+		static size_t drain(std::chrono::nanoseconds budget)
+		{
+			auto & entries = instance()._entries;
+			auto deadline = std::chrono::steady_clock::now() + budget;
+			size_t count = 0;
+
+			while(!entries.empty())
+			{
+				pop(entries);
+
+				if(++count % checkPeriod == 0 && std::chrono::steady_clock::now() >= deadline)
+					break;
+			}
+
+			return count;
+		}
+
+		/**
+		 *  Destroys all queued objects including ones which are released
+		 *	during the drain. Returns the count of destroyed objects.
+		 */
+		static size_t drain()
+		{
+			auto & entries = instance()._entries;
+			size_t count = 0;
+
+			for(; !entries.empty(); ++count)
+				pop(entries);
+
+			return count;
+		}
+
+		static size_t pending()
+		{
+			return instance()._entries.size();
+		}
+
+	protected:
+		release_queue() {}
+		release_queue(const release_queue &) = delete;
+
+		~release_queue()
+		{
+			drain();
+		}
+
+		release_queue & operator = (const release_queue &) = delete;
+
+	private:
+		/**
+		 *  Count of objects destroyed between checks of the time budget
+		 */
+		static const size_t checkPeriod = 8;
+
+		template<class T>
+		static void destroy(const void * object)
+		{
+			delete static_cast<const T *>(object);
+		}
+
+		static void pop(std::deque<entry> & entries)
+		{
+			entry e = entries.front();
+			entries.pop_front();
+			e.destroy(e.object);
+		}
+
+		std::deque<entry> _entries;
+	};
+
+	/**
+	 *  @brief
+	 *  Reference counting policy which defers destruction of objects to the
+	 *	release_queue of the thread which has released the last reference.
+	 *	<Refs> is the underlying counting policy.
+	 *	Example: struct widget : shareable<widget, deferred<plain_refs>> {};
+	 */
+	template<class Refs>
+	class deferred : public Refs
+	{
+	public:
+		template<class T>
+		bool release(const T * object)
+		{
+			if(Refs::release(object))
+				release_queue::push(object);
+
+			return false;
+		}
+	};
+
+	/**
+	 *  @brief
+	 *  Biased counters of objects released by other threads are merged by
+	 *	their owners, so objects which turn out to be unreferenced during the
+	 *	merge are deferred to the release_queue of the merging thread.
+	 */
+	template<>
+	class deferred<biased_refs> : public biased_refs
+	{
+	public:
+		template<class T>
+		bool release(const T * object)
+		{
+			if(biased_refs::release(object, &defer<T>))
+				release_queue::push(object);
+
+			return false;
+		}
+
+	private:
+		template<class T>
+		static void defer(const void * object)
+		{
+			release_queue::push(static_cast<const T *>(object));
+		}
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -9,6 +9,8 @@
 
 #include <core/memory/allocator/default_alloc.h>
 
+#include <atomic>
+
 //---------------------------------------------------------------------------
 
 namespace asd
@@ -19,57 +21,263 @@ namespace asd
 		static void free(const T * ptr) {
 			delete ptr;
 		}
-		
+
 		void operator ()(const T * ptr) {
 			delete ptr;
 		}
 	};
-	
+
 	//---------------------------------------------------------------------------
 
+	/**
+	 *  @brief
+	 *  Reference counting policies of shareables. Each policy starts with
+	 *	one reference, release() returns true when the last reference is
+	 *	released and the object must be deleted. Copies of counters start
+	 *	with one reference too, because they belong to new objects.
+	 */
+
+	/**
+	 *  @brief
+	 *  Plain counter. Handles of such objects must not be copied or released
+	 *	by several threads at the same time.
+	 */
+	class plain_refs
+	{
+	public:
+		plain_refs() {}
+		plain_refs(const plain_refs &) {}
+
+		plain_refs & operator = (const plain_refs &) {
+			return *this;
+		}
+
+		void add() {
+			++_value;
+		}
+
+		template<class T>
+		bool release(const T *) {
+			return --_value == 0;
+		}
+
+		size_t count() const {
+			return _value;
+		}
+
+	private:
+		size_t _value = 1;
+	};
+
+	/**
+	 *  @brief
+	 *  Atomic counter, handles may be copied and released by any thread.
+	 */
+	class atomic_refs
+	{
+	public:
+		atomic_refs() {}
+		atomic_refs(const atomic_refs &) {}
+
+		atomic_refs & operator = (const atomic_refs &) {
+			return *this;
+		}
+
+		void add() {
+			_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		template<class T>
+		bool release(const T *) {
+			return _value.fetch_sub(1, std::memory_order_acq_rel) == 1;
+		}
+
+		size_t count() const {
+			return _value.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<size_t> _value {1};
+	};
+
+	/**
+	 *  @brief
+	 *  Biased counter for objects which are mostly handled by the thread
+	 *	which has created them. The owner thread changes its own part of the
+	 *	counter without atomic operations, other threads use the shared
+	 *	atomic part.
+	 *
+	 *	When the shared part becomes negative, the object is queued to the
+	 *	owner thread. The owner merges both parts in collect() and deletes the
+	 *	object if there are no references left. Threads which hold such
+	 *	objects should call biased_refs::collect() periodically (e.g. once per
+	 *	frame), the queue is also collected when the owner thread exits.
+	 *	The owner stops to be an owner when its part drops to zero.
+	 */
+	class biased_refs
+	{
+	public:
+		struct queue;
+
+		biased_refs() : _queue(local()), _owner(_queue) {}
+		biased_refs(const biased_refs &) : biased_refs() {}
+
+		biased_refs & operator = (const biased_refs &) {
+			return *this;
+		}
+
+		void add() {
+			if(_owner.load(std::memory_order_relaxed) == local()) {
+				_biased.store(_biased.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			} else {
+				_shared.fetch_add(one, std::memory_order_relaxed);
+			}
+		}
+
+		template<class T>
+		bool release(const T * object) {
+			return release(object, &destroy<T>);
+		}
+
+		/**
+		 *  Approximate count of references
+		 */
+		size_t count() const {
+			return static_cast<size_t>(static_cast<intptr_t>(_biased.load(std::memory_order_relaxed)) + (_shared.load(std::memory_order_relaxed) >> flagsBits));
+		}
+
+		/**
+		 *  Merges counters of objects queued to the current thread and deletes
+		 *	unreferenced ones
+		 */
+		api(core)
+		static void collect();
+
+	protected:
+		/**
+		 *  The <destroy> function is called instead of the deletion when the
+		 *	object turns out to be unreferenced during the merge of its counter
+		 */
+		template<class T>
+		bool release(const T * object, void (* destroy)(const void *)) {
+			if(_owner.load(std::memory_order_relaxed) == local()) {
+				auto biased = _biased.load(std::memory_order_relaxed) - 1;
+				_biased.store(biased, std::memory_order_relaxed);
+
+				return biased == 0 && unbias();
+			}
+
+			intptr_t old = _shared.load(std::memory_order_relaxed);
+			intptr_t value;
+
+			do {
+				value = old - one;
+
+				if(!(old & merged) && value < 0) {
+					value |= queued;
+				}
+			} while(!_shared.compare_exchange_weak(old, value, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+			if(value & merged) {
+				return value == merged;
+			}
+
+			if((value & queued) && !(old & queued)) {
+				enqueue(object, destroy);
+			}
+
+			return false;
+		}
+
+	private:
+		static const int flagsBits = 2;
+		static const intptr_t merged = 1;
+		static const intptr_t queued = 2;
+		static const intptr_t one = intptr_t(1) << flagsBits;
+
+		template<class T>
+		static void destroy(const void * object) {
+			delete static_cast<const T *>(object);
+		}
+
+		api(core)
+		static queue * local();
+
+		api(core)
+		bool unbias();
+
+		api(core)
+		void enqueue(const void * object, void (* destroy)(const void *));
+
+		api(core)
+		void merge();
+
+		queue * const _queue;
+		std::atomic<queue *> _owner;
+		std::atomic<size_t> _biased {1};
+		std::atomic<intptr_t> _shared {0};
+
+		const void * _object = nullptr;
+		void (* _destroy)(const void *) = nullptr;
+		biased_refs * _next = nullptr;
+	};
+
 //#define ATOMIC_REFERENCES
 
 #ifdef ATOMIC_REFERENCES
-	using ref_counter_t = atomic<size_t>;
+	using default_refs = atomic_refs;
 #else
-	using ref_counter_t = size_t;
+	using default_refs = plain_refs;
 #endif
-	
+
 	/**
 	 *  @brief
 	 *  The shareable class is used to store the reference counter which can be
 	 *	accessed by the handle class.
 	 *
 	 *	A shareable object is an object of a class T which inherits the shareable
-	 *	class. Such thing allows to create handles to shareables. 
+	 *	class. Such thing allows to create handles to shareables.
 	 *	Create shareable classes when you know that objects of these classes will
 	 *	be handled.
 	 *
-	 *	The template parameter T is used to ensure that `delete` will call the 
+	 *	The template parameter T is used to ensure that `delete` will call the
 	 *	destructor of the class T, which may be virtual
+	 *
+	 *	The template parameter Refs is the reference counting policy:
+	 *	plain_refs, atomic_refs or biased_refs. By default it is atomic_refs if
+	 *	ATOMIC_REFERENCES is defined and plain_refs otherwise.
 	 */
-	template<class T>
+	template<class T, class Refs = default_refs>
 	struct shareable : public default_alloc
 	{
 		template<class>
 		friend class handle;
-		
+
 		friend forceinline void intrusive_ptr_add_ref(const T * s) {
-			++s->_refs;
+			s->_refs.add();
 		}
-		
+
 		friend forceinline void intrusive_ptr_release(const T * s) {
-			if(--s->_refs == 0) {
+			if(s->_refs.release(s)) {
 				delete s;
 			}
 		}
-	
+
 	protected:
-		mutable ref_counter_t _refs = 1;
+		mutable Refs _refs;
 	};
 
+	namespace internals
+	{
+		template<class T, class Refs>
+		true_type is_shareable0(const shareable<T, Refs> *);
+
+		template<class T>
+		false_type is_shareable0(...);
+	}
+
 	template<class T>
-	struct is_shareable : is_base_of<shareable<T>, T> {};
+	struct is_shareable : decltype(internals::is_shareable0<T>(static_cast<T *>(nullptr))) {};
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,181 @@
+//---------------------------------------------------------------------------
+
+#include <core/epoch.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	struct epoch::record
+	{
+		std::atomic<uint64_t> epoch {0};	// epoch seen by the outermost guard, 0 outside of guards
+		std::atomic<bool> used {true};
+		uint depth = 0;
+		record * next = nullptr;
+	};
+
+	namespace
+	{
+		struct retired
+		{
+			const void * object;
+			void (* destroy)(const void *);
+			uint64_t epoch;
+		};
+
+		struct domain
+		{
+			~domain()
+			{
+				for(auto & r : retired)
+					r.destroy(r.object);
+			}
+
+			// epochs start from 1, so 0 marks threads outside of guards
+			std::atomic<uint64_t> global {1};
+			std::atomic<epoch::record *> records {nullptr};
+
+			std::mutex mutex;
+			std::deque<asd::retired> retired;
+		};
+
+		domain & instance()
+		{
+			static domain d;
+			return d;
+		}
+
+		/**
+		 *	Records of exited threads are reused by new ones, they are never
+		 *	freed, because collect() may traverse them at any moment
+		 */
+		epoch::record * acquire_record()
+		{
+			auto & d = instance();
+
+			for(auto * r = d.records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+			{
+				bool used = false;
+
+				if(!r->used.load(std::memory_order_relaxed) && r->used.compare_exchange_strong(used, true, std::memory_order_acquire))
+					return r;
+			}
+
+			auto * r = new epoch::record;
+			r->next = d.records.load(std::memory_order_relaxed);
+
+			while(!d.records.compare_exchange_weak(r->next, r, std::memory_order_release));
+
+			return r;
+		}
+
+		epoch::record * local_record()
+		{
+			struct holder
+			{
+				~holder()
+				{
+					r->used.store(false, std::memory_order_release);
+				}
+
+				epoch::record * r = acquire_record();
+			};
+
+			static thread_local holder h;
+			return h.r;
+		}
+
+		// all threads inside of guards must have seen the current epoch
+		bool advance(domain & d)
+		{
+			uint64_t current = d.global.load(std::memory_order_seq_cst);
+
+			for(auto * r = d.records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+			{
+				uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+
+				if(e != 0 && e != current)
+					return false;
+			}
+
+			return d.global.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst);
+		}
+	}
+
+	epoch::record * epoch::enter()
+	{
+		auto * r = local_record();
+
+		if(r->depth++ == 0)
+		{
+			auto & d = instance();
+			r->epoch.store(d.global.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+
+		return r;
+	}
+
+	void epoch::leave(record * r)
+	{
+		if(--r->depth == 0)
+			r->epoch.store(0, std::memory_order_release);
+	}
+
+	void epoch::retire(const void * object, void (* destroy)(const void *))
+	{
+		auto & d = instance();
+
+		{
+			std::lock_guard<std::mutex> lock(d.mutex);
+			d.retired.push_back({object, destroy, d.global.load(std::memory_order_seq_cst)});
+		}
+
+		collect();
+	}
+
+	size_t epoch::collect()
+	{
+		auto & d = instance();
+		std::deque<asd::retired> expired;
+
+		{
+			std::lock_guard<std::mutex> lock(d.mutex);
+
+			if(d.retired.empty())
+				return 0;
+
+			if(advance(d))
+				advance(d);
+
+			// readers which have seen an object have left their guards two epochs later
+			uint64_t safe = d.global.load(std::memory_order_seq_cst);
+
+			while(!d.retired.empty() && d.retired.front().epoch + 2 <= safe)
+			{
+				expired.push_back(d.retired.front());
+				d.retired.pop_front();
+			}
+		}
+
+		// destructors may retire other objects
+		for(auto & r : expired)
+			r.destroy(r.object);
+
+		return expired.size();
+	}
+
+	size_t epoch::pending()
+	{
+		auto & d = instance();
+		std::lock_guard<std::mutex> lock(d.mutex);
+
+		return d.retired.size();
+	}
+}
+
+//---------------------------------------------------------------------------
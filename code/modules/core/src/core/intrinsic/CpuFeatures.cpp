@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------
+
+#include <core/intrinsic/CpuFeatures.h>
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	static void cpuid(int leaf, int subleaf, uint32_t (& regs)[4])
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuidex(r, leaf, subleaf);
+
+		for(int i = 0; i < 4; ++i)
+			regs[i] = static_cast<uint32_t>(r[i]);
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	// state components enabled by the OS (XCR0)
+	static uint64_t xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t a, d;
+		__asm__ volatile ("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+		return (static_cast<uint64_t>(d) << 32) | a;
+#endif
+	}
+
+	static cpu_features detect()
+	{
+		cpu_features f;
+		uint32_t regs[4];
+
+		cpuid(0, 0, regs);
+		uint32_t maxLeaf = regs[0];
+
+		if(maxLeaf < 1)
+			return f;
+
+		cpuid(1, 0, regs);
+
+		f.sse3  = (regs[2] & (1u << 0)) != 0;
+		f.ssse3 = (regs[2] & (1u << 9)) != 0;
+		f.sse41 = (regs[2] & (1u << 19)) != 0;
+		f.sse42 = (regs[2] & (1u << 20)) != 0;
+
+		bool fma = (regs[2] & (1u << 12)) != 0;
+		bool f16c = (regs[2] & (1u << 29)) != 0;
+		bool osxsave = (regs[2] & (1u << 27)) != 0;
+		bool avx = (regs[2] & (1u << 28)) != 0;
+
+		// the OS must save ymm (and zmm) registers on context switches
+		uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+		bool ymm = (xcr0 & 0x06) == 0x06;
+		bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+		f.avx = avx && ymm;
+		f.fma = fma && f.avx;
+		f.f16c = f16c && f.avx;
+
+		if(maxLeaf >= 7)
+		{
+			cpuid(7, 0, regs);
+
+			f.avx2 = f.avx && (regs[1] & (1u << 5)) != 0;
+			f.avx512f = zmm && (regs[1] & (1u << 16)) != 0;
+			f.avx512dq = f.avx512f && (regs[1] & (1u << 17)) != 0;
+			f.avx512vl = f.avx512f && (regs[1] & (1u << 31)) != 0;
+		}
+
+		return f;
+	}
+
+	const cpu_features & cpu_features::get()
+	{
+		static const cpu_features features = detect();
+		return features;
+	}
+
+	static std::atomic<int> pathLimit {static_cast<int>(simd_path::avx512)};
+
+	simd_path current_simd_path()
+	{
+		auto best = static_cast<int>(cpu_features::get().best());
+		auto limit = pathLimit.load(std::memory_order_relaxed);
+
+		return static_cast<simd_path>(best < limit ? best : limit);
+	}
+
+	void limit_simd_path(simd_path path)
+	{
+		pathLimit.store(static_cast<int>(path), std::memory_order_relaxed);
+	}
+
+	const char * simd_path_name(simd_path path)
+	{
+		switch(path)
+		{
+			case simd_path::sse2:
+				return "sse2";
+			case simd_path::sse4:
+				return "sse4";
+			case simd_path::avx2:
+				return "avx2";
+			case simd_path::avx512:
+				return "avx512";
+		}
+
+		return "unknown";
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+
+#include <core/memory/PagePool.h>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	void * map_pages(size_t size, huge_pages mode)
+	{
+#ifdef WIN32
+		(void)mode;
+		return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	#ifdef MAP_HUGETLB
+		// huge pages are aligned by the system
+		if(mode == huge_pages::map && size % huge_page_size == 0)
+		{
+			void * ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+			if(ptr != MAP_FAILED)
+				return ptr;
+		}
+	#endif
+
+		// maps one huge page more and unmaps the unaligned head and tail
+		size_t span = size + huge_page_size;
+		void * ptr = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(ptr == MAP_FAILED)
+			return nullptr;
+
+		auto * mapped = static_cast<byte *>(ptr);
+		auto * base = reinterpret_cast<byte *>((reinterpret_cast<uintptr_t>(mapped) + huge_page_size - 1) & ~static_cast<uintptr_t>(huge_page_size - 1));
+		size_t head = static_cast<size_t>(base - mapped);
+
+		if(head > 0)
+			munmap(mapped, head);
+
+		munmap(base + size, span - head - size);
+
+	#ifdef MADV_HUGEPAGE
+		if(mode != huge_pages::off)
+			madvise(base, size, MADV_HUGEPAGE);
+	#endif
+
+		return base;
+#endif
+	}
+
+	void unmap_pages(void * ptr, size_t size)
+	{
+#ifdef WIN32
+		VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+		munmap(ptr, size);
+#endif
+	}
+
+	void decommit_pages(void * ptr, size_t size)
+	{
+#ifdef WIN32
+		VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+		madvise(ptr, size, MADV_DONTNEED);
+#endif
+	}
+
+	void recommit_pages(void * ptr, size_t size)
+	{
+#ifdef WIN32
+		VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
+#else
+		// pages which were released by MADV_DONTNEED are faulted in on the first access
+		(void)ptr;
+		(void)size;
+#endif
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,149 @@
+//---------------------------------------------------------------------------
+
+#include <core/memory/arena.h>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	static size_t system_page_size()
+	{
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	void arena::release()
+	{
+		reset();
+
+		if(_first == nullptr)
+			return;
+
+		chunk * c = _first->next;
+
+		while(c != nullptr)
+		{
+			chunk * next = c->next;
+			_reserved -= c->capacity;
+			memory<void>::free(c);
+			c = next;
+		}
+
+		_first->next = nullptr;
+	}
+
+	void * arena::allocate_slow(size_t size, size_t alignment)
+	{
+		if(_guarded)
+			return allocate_guarded(size, alignment);
+
+		while(_current != nullptr && _current->next != nullptr)
+		{
+			_current = _current->next;
+			size_t offset = aligned_offset(_current, 0, alignment);
+
+			if(offset + size <= _current->capacity)
+			{
+				_offset = offset + size;
+				return data(_current) + offset;
+			}
+		}
+
+		size_t capacity = std::max(_chunkSize, size + alignment);
+		auto * c = static_cast<chunk *>(memory<void>::allocate(chunkHeaderSize + capacity));
+
+		if(c == nullptr)
+			throw std::bad_alloc();
+
+		c->capacity = capacity;
+		_reserved += capacity;
+
+		if(_current == nullptr)
+		{
+			c->next = _first;
+			_first = c;
+		}
+		else
+		{
+			c->next = _current->next;
+			_current->next = c;
+		}
+
+		_current = c;
+
+		size_t offset = aligned_offset(c, 0, alignment);
+		_offset = offset + size;
+
+		return data(c) + offset;
+	}
+
+	void * arena::allocate_guarded(size_t size, size_t alignment)
+	{
+		static const size_t page = system_page_size();
+
+		size_t accessible = asd::align(sizeof(guard) + size + alignment, page);
+		size_t total = accessible + page;
+
+#ifdef WIN32
+		auto * base = static_cast<byte *>(VirtualAlloc(nullptr, total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+		if(base == nullptr)
+			throw std::bad_alloc();
+
+		DWORD old;
+		VirtualProtect(base + accessible, page, PAGE_NOACCESS, &old);
+#else
+		void * mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(mapping == MAP_FAILED)
+			throw std::bad_alloc();
+
+		auto * base = static_cast<byte *>(mapping);
+		mprotect(base + accessible, page, PROT_NONE);
+#endif
+		auto * g = reinterpret_cast<guard *>(base);
+		g->prev = _guards;
+		g->size = total;
+		_guards = g;
+		_reserved += total;
+
+		auto end = reinterpret_cast<uintptr_t>(base + accessible);
+		return reinterpret_cast<void *>((end - size) & ~static_cast<uintptr_t>(alignment - 1));
+	}
+
+	void arena::release_guards(guard * until)
+	{
+		while(_guards != nullptr && _guards != until)
+		{
+			guard * prev = _guards->prev;
+			_reserved -= _guards->size;
+#ifdef WIN32
+			VirtualFree(_guards, 0, MEM_RELEASE);
+#else
+			munmap(_guards, _guards->size);
+#endif
+			_guards = prev;
+		}
+	}
+
+	arena *& arena::current_slot()
+	{
+		static thread_local arena * slot = nullptr;
+		return slot;
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,148 @@
+//---------------------------------------------------------------------------
+
+#include <core/memory/pool_stats.h>
+
+#include <iomanip>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	void pool_stats::attach()
+	{
+		auto & r = pool_registry::instance();
+		std::lock_guard<std::mutex> guard(r._lock);
+
+		_next = r._first;
+
+		if(_next != nullptr)
+			_next->_prev = this;
+
+		r._first = this;
+	}
+
+	void pool_stats::detach()
+	{
+		auto & r = pool_registry::instance();
+		std::lock_guard<std::mutex> guard(r._lock);
+
+		if(_prev != nullptr)
+			_prev->_next = _next;
+		else
+			r._first = _next;
+
+		if(_next != nullptr)
+			_next->_prev = _prev;
+	}
+
+	pool_registry & pool_registry::instance()
+	{
+		static pool_registry registry;
+		return registry;
+	}
+
+	std::vector<pool_stats::snapshot> pool_registry::snapshots()
+	{
+		auto & r = instance();
+		std::lock_guard<std::mutex> guard(r._lock);
+		std::vector<pool_stats::snapshot> list;
+
+		for(auto * s = r._first; s != nullptr; s = s->_next)
+			list.push_back(s->get());
+
+		return list;
+	}
+
+	std::string pool_registry::text()
+	{
+		std::ostringstream out;
+
+		for(auto & s : snapshots())
+		{
+			out << s.name << '\n'
+				<< "  block size: " << s.blockSize
+				<< ", allocations: " << s.allocations
+				<< ", frees: " << s.frees
+				<< ", remote frees: " << s.remoteFrees << '\n'
+				<< "  live: " << s.live
+				<< ", peak: " << s.peak
+				<< ", pages: " << s.pages
+				<< " (" << s.pageBytes << " bytes)"
+				<< ", fragmentation: " << std::fixed << std::setprecision(1) << s.fragmentation() * 100 << "%\n"
+				<< "  sizes:";
+
+			for(uint i = 0; i < pool_stats::histogramSize; ++i)
+			{
+				if(s.histogram[i] > 0)
+					out << ' ' << (size_t(1) << i) << ".." << (size_t(2) << i) - 1 << ": " << s.histogram[i];
+			}
+
+			out << '\n';
+		}
+
+		return out.str();
+	}
+
+	static void write_json_string(std::ostream & out, const std::string & str)
+	{
+		out << '"';
+
+		for(char c : str)
+		{
+			switch(c)
+			{
+				case '"':
+					out << "\\\"";
+					break;
+				case '\\':
+					out << "\\\\";
+					break;
+				default:
+					out << c;
+			}
+		}
+
+		out << '"';
+	}
+
+	std::string pool_registry::json()
+	{
+		std::ostringstream out;
+		bool first = true;
+
+		out << '[';
+
+		for(auto & s : snapshots())
+		{
+			if(!first)
+				out << ',';
+
+			first = false;
+
+			out << "{\"name\":";
+			write_json_string(out, s.name);
+			out << ",\"blockSize\":" << s.blockSize
+				<< ",\"allocations\":" << s.allocations
+				<< ",\"frees\":" << s.frees
+				<< ",\"remoteFrees\":" << s.remoteFrees
+				<< ",\"live\":" << s.live
+				<< ",\"peak\":" << s.peak
+				<< ",\"pages\":" << s.pages
+				<< ",\"pageBytes\":" << s.pageBytes
+				<< ",\"fragmentation\":" << s.fragmentation()
+				<< ",\"sampleRate\":" << pool_stats::sampleRate
+				<< ",\"histogram\":[";
+
+			for(uint i = 0; i < pool_stats::histogramSize; ++i)
+				out << (i > 0 ? "," : "") << s.histogram[i];
+
+			out << "]}";
+		}
+
+		out << ']';
+		return out.str();
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+//---------------------------------------------------------------------------
+
+#include <core/shareable.h>
+#include <core/release_queue.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	struct biased_refs::queue
+	{
+		std::atomic<biased_refs *> head {nullptr};
+	};
+
+	/**
+	 *	Head of the queue of an exited thread
+	 */
+	static biased_refs * const closed = reinterpret_cast<biased_refs *>(uintptr_t(1));
+
+	void biased_refs::collect()
+	{
+		auto * r = local()->head.exchange(nullptr, std::memory_order_acquire);
+
+		while(r != nullptr)
+		{
+			auto * next = r->_next;
+			r->merge();
+			r = next;
+		}
+	}
+
+	biased_refs::queue * biased_refs::local()
+	{
+		// Queues are never freed: objects may refer to the queue of their
+		// owner after the owner has exited
+		struct holder
+		{
+			// the release queue of the thread is created first, so it is destroyed
+			// after the holder and receives deferred objects merged on exit
+			holder()
+			{
+				release_queue::pending();
+			}
+
+			~holder()
+			{
+				auto * r = q->head.exchange(closed, std::memory_order_acq_rel);
+
+				while(r != nullptr)
+				{
+					auto * next = r->_next;
+					r->merge();
+					r = next;
+				}
+			}
+
+			queue * q = new queue;
+		};
+
+		static thread_local holder h;
+		return h.q;
+	}
+
+	bool biased_refs::unbias()
+	{
+		_owner.store(nullptr, std::memory_order_relaxed);
+		return (_shared.fetch_or(merged, std::memory_order_acq_rel) | merged) == merged;
+	}
+
+	void biased_refs::enqueue(const void * object, void (* destroy)(const void *))
+	{
+		_object = object;
+		_destroy = destroy;
+
+		biased_refs * head = _queue->head.load(std::memory_order_acquire);
+
+		do
+		{
+			if(head == closed)
+			{
+				merge();
+				return;
+			}
+
+			_next = head;
+		}
+		while(!_queue->head.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_acquire));
+	}
+
+	void biased_refs::merge()
+	{
+		auto biased = static_cast<intptr_t>(_biased.load(std::memory_order_relaxed));
+		_biased.store(0, std::memory_order_relaxed);
+		_owner.store(nullptr, std::memory_order_relaxed);
+
+		intptr_t old = _shared.load(std::memory_order_relaxed);
+		intptr_t value;
+
+		do
+			value = ((old + biased * one) | merged) & ~queued;
+		while(!_shared.compare_exchange_weak(old, value, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+		if(value == merged)
+			_destroy(_object);
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -12,7 +12,7 @@
 #include <meta/class_id.h>
 #include <container/map.h>
 #include <container/array_list.h>
-#include <container/any_list.h>
+#include <container/segmented_any_list.h>
 #include <boost/poly_collection/base_collection.hpp>
 #include <boost/optional.hpp>
 
@@ -64,7 +64,7 @@ namespace asd
             }
 
             map<class_id_t, size_t> _offsets;
-            any_list _components;
+            segmented_any_list<> _components;
         };
         
         template <class Gfx>
@@ -15,6 +15,7 @@
 #include <graphics/color.h>
 #include <math/vector.h>
 #include <math/matrix.h>
+#include <math/small.h>
 
 //---------------------------------------------------------------------------
 
@@ -98,6 +99,12 @@ namespace asd
             template <class T>
             struct uniform_raw<math::matrix<T>> : std::identity<std::array<std::array<T, 4>, 4>> {};
 
+            template <class T, int N>
+            struct uniform_raw<math::small::vec<T, N>> : std::identity<std::array<T, N>> {};
+
+            template <class T, int R, int C>
+            struct uniform_raw<math::small::mat<T, R, C>> : std::identity<std::array<std::array<T, C>, R>> {};
+
             class block
             {
             public:
@@ -17,6 +17,10 @@
 
 namespace asd
 {
+	// The lanes and coalescing declared by message_queueing apply only to messages
+	// posted through a mailbox. ui_space gets input by send() from its window
+	// procedure, so it still handles every move until input is posted.
+
 //---------------------------------------------------------------------------
 
 	// Some key was pressed when this widget was in focus
@@ -29,6 +33,8 @@ namespace asd
 		(bool, isAdditional)
 	);
 
+	message_queueing(KeyDownMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Some char-key was pressed when this widget was in focus
@@ -41,6 +47,8 @@ namespace asd
 		(bool, isAdditional)
 	);
 
+	message_queueing(CharMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Some key was released when this Widget was in focus
@@ -53,6 +61,8 @@ namespace asd
 		(bool, isAdditional)
 	);
 
+	message_queueing(KeyUpMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Mouse state is updating over this widget
@@ -63,6 +73,8 @@ namespace asd
 		(int, y)
 	);
 
+	message_queueing(MouseUpdateMessage, normal, keep_latest);
+
 //---------------------------------------------------------------------------
 
 	// Some mouse button was pressed over this widget
@@ -75,6 +87,8 @@ namespace asd
 		(int, flags)
 	);
 
+	message_queueing(MouseDownMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Mouse is moving over this widget
@@ -85,6 +99,8 @@ namespace asd
 		(int, y)
 	);
 
+	message_queueing(MouseMoveMessage, normal, keep_latest);
+
 //---------------------------------------------------------------------------
 
 	// Some mouse button was released over this widget
@@ -97,6 +113,8 @@ namespace asd
 		(int, flags)
 	);
 
+	message_queueing(MouseUpMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Some mouse button was clicked over this widget
@@ -109,6 +127,8 @@ namespace asd
 		(int, flags)
 	);
 
+	message_queueing(MouseClickMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Some mouse button was double-clicked over this widget
@@ -121,6 +141,8 @@ namespace asd
 		(int, flags)
 	);
 
+	message_queueing(MouseDblClickMessage, urgent, keep_all);
+
 //---------------------------------------------------------------------------
 
 	// Mouse wheel was moved when this widget was in focus
@@ -273,6 +295,8 @@ namespace asd
 		(int, id)
 	);
 
+	message_queueing(HotkeyMessage, urgent, keep_all);
+
 	// UI-space has changed its position
 	message_class
 	(
@@ -281,6 +305,8 @@ namespace asd
 		(int, y)
 	);
 
+	message_queueing(UIMoveMessage, normal, keep_latest);
+
 	// UI-space has changed its size
 	message_class
 	(
@@ -289,6 +315,8 @@ namespace asd
 		(int, height)
 	);
 
+	message_queueing(UIResizeMessage, normal, keep_latest);
+
 	// UI-space has changed its fullscreen state
 	message_class
 	(
@@ -0,0 +1,342 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_APPROX_H
+#define MATH_APPROX_H
+
+//---------------------------------------------------------------------------
+
+#include <math/math.h>
+#include <core/intrinsic/Intrinsic.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Vectorised approximations of transcendental functions with accuracy
+		 *	tiers (see math::accuracy) for __m128 (Intrinsic<float, 4>) and
+		 *	__m256 (Intrinsic<float, 8>, only in translation units compiled
+		 *	with AVX2, see CpuFeatures.h).
+		 *
+		 *	Float overloads evaluate a single lane, double overloads call the
+		 *	standard library. All functions are always inlined, so the linker
+		 *	never merges copies compiled for different instruction sets.
+		 *
+		 *	Limits:
+		 *	sin, cos, sincos	- |x| < 8192 for the precise tier, the error grows
+		 *						  with |x| in other tiers
+		 *	exp					- arguments are clamped to [-87.3, 88.3]
+		 *	log					- x must be positive and normal
+		 *	acos				- x in [-1, 1]
+		 */
+		namespace approx
+		{
+			namespace internals
+			{
+				template<class V>
+				using intrinsic = Intrinsic<float, sizeof(V) / sizeof(float)>;
+
+				template<class V>
+				using is_packed = bool_type<std::is_same<V, __m128>::value || std::is_same<V, __m256>::value>;
+
+				// c0 + x * (c1 + x * (c2 + ...))
+				template<class I>
+				inline forceinline typename I::type horner(typename I::type, float c) {
+					return I::fill(c);
+				}
+
+				template<class I, class ... C>
+				inline forceinline typename I::type horner(typename I::type x, float c, C ... cs) {
+					return I::fmadd(horner<I>(x, cs...), x, I::fill(c));
+				}
+
+				/**
+				 *	Reduces x to r in [-pi/4, pi/4], x = n * pi/2 + r, and evaluates
+				 *	sin(r) and cos(r)
+				 */
+				template<accuracy A, class I>
+				inline forceinline typename I::type reduce_quadrant(typename I::type x, typename I::type & sine, typename I::type & cosine) {
+					auto n = I::round(I::mul(x, I::fill(0.636619772f)));
+					typename I::type r;
+
+					if(A == accuracy::fast) {
+						r = I::fnmadd(n, I::fill(1.57079637f), x);
+					} else if(A == accuracy::medium) {
+						r = I::fnmadd(n, I::fill(1.5703125f), x);
+						r = I::fnmadd(n, I::fill(4.83826794e-4f), r);
+					} else {
+						r = I::fnmadd(n, I::fill(1.5703125f), x);
+						r = I::fnmadd(n, I::fill(4.83751297e-4f), r);
+						r = I::fnmadd(n, I::fill(7.54978995e-8f), r);
+					}
+
+					auto z = I::mul(r, r);
+
+					if(A == accuracy::fast) {
+						sine = I::fmadd(I::mul(r, z), horner<I>(z, -1.66666667e-1f, 8.33333333e-3f), r);
+						cosine = horner<I>(z, 1.0f, -0.5f, 4.16666667e-2f, -1.38888889e-3f);
+					} else {
+						sine = I::fmadd(I::mul(r, z), horner<I>(z, -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f), r);
+						cosine = I::fmadd(I::mul(z, z), horner<I>(z, 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f), I::fnmadd(z, I::fill(0.5f), I::fill(1.0f)));
+					}
+
+					return n;
+				}
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline void sincos(V x, V & s, V & c) {
+				using I = internals::intrinsic<V>;
+
+				V sp, cp;
+				auto n = internals::reduce_quadrant<A, I>(x, sp, cp);
+				auto odd = I::template bit_sign<0>(n);
+
+				s = I::bit_xor(I::select(cp, sp, odd), I::template bit_sign<1>(n));
+				c = I::bit_xor(I::select(sp, cp, odd), I::template bit_sign<1>(I::add(n, I::fill(1.0f))));
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V sin(V x) {
+				using I = internals::intrinsic<V>;
+
+				V sp, cp;
+				auto n = internals::reduce_quadrant<A, I>(x, sp, cp);
+				return I::bit_xor(I::select(cp, sp, I::template bit_sign<0>(n)), I::template bit_sign<1>(n));
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V cos(V x) {
+				using I = internals::intrinsic<V>;
+
+				V sp, cp;
+				auto n = internals::reduce_quadrant<A, I>(x, sp, cp);
+				return I::bit_xor(I::select(sp, cp, I::template bit_sign<0>(n)), I::template bit_sign<1>(I::add(n, I::fill(1.0f))));
+			}
+
+			/**
+			 *	Angle of the vector [x, y] in [-pi, pi]
+			 */
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V atan2(V y, V x) {
+				using I = internals::intrinsic<V>;
+
+				auto ax = I::abs(x);
+				auto ay = I::abs(y);
+				auto high = I::max(ax, ay);
+				auto t = I::bit_andnot(I::cmple(high, I::zero()), I::div(I::min(ax, ay), high)); // tangent in [0, 1]
+				auto z = I::mul(t, t);
+
+				V r;
+
+				if(A == accuracy::fast) {
+					r = I::mul(t, internals::horner<I>(z, 0.9998660f, -0.3302995f, 0.1801410f, -0.0851330f, 0.0208351f));
+				} else {
+					// atan(t) = pi/4 + atan((t - 1) / (t + 1)) for t > tan(pi/8)
+					auto big = I::cmpgt(t, I::fill(0.414213562f));
+					t = I::select(I::div(I::sub(t, I::fill(1.0f)), I::add(t, I::fill(1.0f))), t, big);
+					z = I::mul(t, t);
+					r = I::add(I::bit_and(big, I::fill(0.785398163f)), I::fmadd(I::mul(t, z), internals::horner<I>(z, -3.33329491539e-1f, 1.99777106478e-1f, -1.38776856032e-1f, 8.05374449538e-2f), t));
+				}
+
+				r = I::select(I::sub(I::fill(1.57079633f), r), r, I::cmpgt(ay, ax));
+				r = I::select(I::sub(I::fill(3.14159265f), r), r, x); // by the sign of x
+				return I::bit_xor(r, I::sign(y));
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V exp(V x) {
+				using I = internals::intrinsic<V>;
+
+				x = I::min(I::max(x, I::fill(-87.3f)), I::fill(88.3f));
+
+				auto n = I::round(I::mul(x, I::fill(1.44269504f)));
+
+				if(A == accuracy::fast) {
+					auto r = I::fnmadd(n, I::fill(0.693147181f), x);
+					return I::ldexp(internals::horner<I>(r, 1.0f, 1.0f, 0.5f, 1.66666667e-1f, 4.16666667e-2f), n);
+				}
+
+				auto r = I::fnmadd(n, I::fill(0.693359375f), x);
+				r = I::fnmadd(n, I::fill(-2.12194440e-4f), r);
+
+				auto p = A == accuracy::medium ?
+					internals::horner<I>(r, 0.5f, 1.66666667e-1f, 4.16666667e-2f, 8.33333333e-3f) :
+					internals::horner<I>(r, 5.0000001201e-1f, 1.6666665459e-1f, 4.1665795894e-2f, 8.3334519073e-3f, 1.3981999507e-3f, 1.9875691500e-4f);
+
+				return I::ldexp(I::fmadd(p, I::mul(r, r), I::add(r, I::fill(1.0f))), n);
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V log(V x) {
+				using I = internals::intrinsic<V>;
+
+				V e;
+				auto m = I::frexp(x, e);
+
+				// mantissa in [sqrt(1/2), sqrt(2))
+				auto big = I::cmpgt(m, I::fill(1.41421356f));
+				m = I::select(I::mul(m, I::fill(0.5f)), m, big);
+				e = I::add(e, I::bit_and(big, I::fill(1.0f)));
+
+				auto f = I::sub(m, I::fill(1.0f));
+
+				if(A != accuracy::precise) {
+					// log(1 + f) = 2 atanh(s), s = f / (2 + f)
+					auto s = I::div(f, I::add(f, I::fill(2.0f)));
+					auto z = I::mul(s, s);
+					auto p = A == accuracy::fast ?
+						internals::horner<I>(z, 2.0f, 6.66666667e-1f) :
+						internals::horner<I>(z, 2.0f, 6.66666667e-1f, 4.0e-1f, 2.85714286e-1f, 2.22222222e-1f);
+
+					return I::fmadd(e, I::fill(0.693147181f), I::mul(s, p));
+				}
+
+				auto z = I::mul(f, f);
+				auto p = internals::horner<I>(f, 3.3333331174e-1f, -2.4999993993e-1f, 2.0000714765e-1f, -1.6668057665e-1f, 1.4249322787e-1f, -1.2420140846e-1f, 1.1676998740e-1f, -1.1514610310e-1f, 7.0376836292e-2f);
+				auto y = I::mul(I::mul(f, z), p);
+
+				y = I::fmadd(e, I::fill(-2.12194440e-4f), y);
+				y = I::fnmadd(z, I::fill(0.5f), y);
+
+				return I::fmadd(e, I::fill(0.693359375f), I::add(f, y));
+			}
+
+			/**
+			 *	1 / sqrt(x): the hardware estimate refined by a Newton step (fast
+			 *	and medium) or calculated exactly (precise). The estimate alone
+			 *	has errors up to 3.7e-4, which doesn't fit the fast tier.
+			 */
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V rsqrt(V x) {
+				using I = internals::intrinsic<V>;
+
+				if(A == accuracy::precise) {
+					return I::div(I::fill(1.0f), I::sqrt(x));
+				}
+
+				auto y = I::rsqrt(x);
+
+				return I::mul(y, I::fnmadd(I::mul(I::mul(x, I::fill(0.5f)), y), y, I::fill(1.5f)));
+			}
+
+			template<accuracy A = accuracy::medium, class V, useif<internals::is_packed<V>::value>>
+			inline forceinline V acos(V x) {
+				using I = internals::intrinsic<V>;
+
+				auto a = I::abs(x);
+				V r;
+
+				if(A == accuracy::fast) { // Abramowitz & Stegun 4.4.45
+					r = I::mul(I::sqrt(I::sub(I::fill(1.0f), a)), internals::horner<I>(a, 1.5707288f, -0.2121144f, 0.0742610f, -0.0187293f));
+				} else if(A == accuracy::medium) { // Abramowitz & Stegun 4.4.46
+					r = I::mul(I::sqrt(I::sub(I::fill(1.0f), a)), internals::horner<I>(a, 1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f, 0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f));
+				} else {
+					// acos(a) = 2 asin(sqrt((1 - a) / 2)) for a > 1/2, pi/2 - asin(a) otherwise
+					auto big = I::cmpgt(a, I::fill(0.5f));
+					auto z = I::select(I::mul(I::fill(0.5f), I::sub(I::fill(1.0f), a)), I::mul(a, a), big);
+					auto s = I::select(I::sqrt(z), a, big);
+					auto p = I::fmadd(I::mul(s, z), internals::horner<I>(z, 1.6666752422e-1f, 7.4953002686e-2f, 4.5470025998e-2f, 2.4181311049e-2f, 4.2163199048e-2f), s);
+
+					r = I::select(I::add(p, p), I::sub(I::fill(1.57079633f), p), big);
+				}
+
+				return I::select(I::sub(I::fill(3.14159265f), r), r, x); // by the sign of x
+			}
+
+//---------------------------------------------------------------------------
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline void sincos(float x, float & s, float & c) {
+				__m128 vs, vc;
+				sincos<A>(_mm_set_ss(x), vs, vc);
+				s = _mm_cvtss_f32(vs);
+				c = _mm_cvtss_f32(vc);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float sin(float x) {
+				return _mm_cvtss_f32(sin<A>(_mm_set_ss(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float cos(float x) {
+				return _mm_cvtss_f32(cos<A>(_mm_set_ss(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float atan2(float y, float x) {
+				return _mm_cvtss_f32(atan2<A>(_mm_set_ss(y), _mm_set_ss(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float exp(float x) {
+				return _mm_cvtss_f32(exp<A>(_mm_set_ss(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float log(float x) {
+				return _mm_cvtss_f32(log<A>(_mm_set1_ps(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float rsqrt(float x) {
+				return _mm_cvtss_f32(rsqrt<A>(_mm_set1_ps(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline forceinline float acos(float x) {
+				return _mm_cvtss_f32(acos<A>(_mm_set_ss(x)));
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline void sincos(double x, double & s, double & c) {
+				s = std::sin(x);
+				c = std::cos(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double sin(double x) {
+				return std::sin(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double cos(double x) {
+				return std::cos(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double atan2(double y, double x) {
+				return std::atan2(y, x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double exp(double x) {
+				return std::exp(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double log(double x) {
+				return std::log(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double rsqrt(double x) {
+				return 1.0 / std::sqrt(x);
+			}
+
+			template<accuracy A = accuracy::medium>
+			inline double acos(double x) {
+				return std::acos(x);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
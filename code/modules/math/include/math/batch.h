@@ -0,0 +1,167 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_BATCH_H
+#define MATH_BATCH_H
+
+//---------------------------------------------------------------------------
+
+#include <math/matrix.h>
+#include <math/quaternion.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Structure-of-arrays view of <size> 3-component vectors.
+		 *	Arrays don't need any special alignment.
+		 */
+		template<class T>
+		struct soa3
+		{
+			soa3(T * x, T * y, T * z, size_t size) : x(x), y(y), z(z), size(size) {}
+
+			template<class U, useif<std::is_same<const U, T>::value>>
+			soa3(const soa3<U> & s) : x(s.x), y(s.y), z(s.z), size(s.size) {}
+
+			T * x;
+			T * y;
+			T * z;
+			size_t size;
+		};
+
+		/**
+		 *	@brief
+		 *	Structure-of-arrays view of <size> 4-component vectors or quaternions.
+		 */
+		template<class T>
+		struct soa4
+		{
+			soa4(T * x, T * y, T * z, T * w, size_t size) : x(x), y(y), z(z), w(w), size(size) {}
+
+			template<class U, useif<std::is_same<const U, T>::value>>
+			soa4(const soa4<U> & s) : x(s.x), y(s.y), z(s.z), w(s.w), size(s.size) {}
+
+			T * x;
+			T * y;
+			T * z;
+			T * w;
+			size_t size;
+		};
+
+		/**
+		 *	@brief
+		 *	Batch operations over arrays of vectors and quaternions.
+		 *	Every function processes 4, 8 or 16 elements at a time depending on
+		 *	the instruction set chosen at runtime (SSE4.1, AVX2 + FMA or
+		 *	AVX-512, see current_simd_path()), remaining elements are processed
+		 *	one by one.
+		 *
+		 *	All elements of input views are processed, outputs must have at
+		 *	least the same size. Outputs may be the same arrays as inputs.
+		 */
+		namespace batch
+		{
+			/**
+			 *	out = m * [x, y, z, 1]
+			 */
+			api(math)
+			void transform_points(const fmat & m, const soa3<const float> & in, const soa3<float> & out);
+
+			/**
+			 *	out = m * [x, y, z, 0]
+			 */
+			api(math)
+			void transform_directions(const fmat & m, const soa3<const float> & in, const soa3<float> & out);
+
+			/**
+			 *	Rotates all vectors by the quaternion <q>, the same as q.apply_to(v)
+			 */
+			api(math)
+			void rotate(const fquat & q, const soa3<const float> & in, const soa3<float> & out);
+
+			/**
+			 *	Rotates each vector by the corresponding quaternion of <q>
+			 */
+			api(math)
+			void rotate(const soa4<const float> & q, const soa3<const float> & in, const soa3<float> & out);
+
+			/**
+			 *	Rotates all quaternions by <q>, the same as in[i].rotate_by(q)
+			 */
+			api(math)
+			void rotate_by(const fquat & q, const soa4<const float> & in, const soa4<float> & out);
+
+			api(math)
+			void normalize(const soa3<const float> & in, const soa3<float> & out);
+
+			api(math)
+			void dot(const soa3<const float> & a, const soa3<const float> & b, float * out);
+
+			api(math)
+			void cross(const soa3<const float> & a, const soa3<const float> & b, const soa3<float> & out);
+
+			api(math)
+			void lerp(const soa3<const float> & a, const soa3<const float> & b, float t, const soa3<float> & out);
+
+			/**
+			 *	Spherical interpolation of unit quaternions by the shortest arc
+			 */
+			api(math)
+			void slerp(const soa4<const float> & a, const soa4<const float> & b, float t, const soa4<float> & out);
+
+			/**
+			 *	out[i] = a[i] * b[i] for arrays of <count> matrices
+			 */
+			api(math)
+			void multiply(const fmat * a, const fmat * b, fmat * out, size_t count);
+
+			/**
+			 *	out[i] = m[i].inverse()
+			 */
+			api(math)
+			void inverse(const fmat * m, fmat * out, size_t count);
+
+			/**
+			 *	out[i] = m[i].inverse().transposition(), e.g. to transform normals
+			 */
+			api(math)
+			void inverse_transpose(const fmat * m, fmat * out, size_t count);
+
+			/**
+			 *	out[i] = m[i].affine_inverse(), matrices must be affine (the last
+			 *	row is [0, 0, 0, 1])
+			 */
+			api(math)
+			void affine_inverse(const fmat * m, fmat * out, size_t count);
+
+			/**
+			 *	Parent of roots of hierarchies
+			 */
+			const uint32_t no_parent = 0xFFFFFFFF;
+
+			/**
+			 *	Computes world matrices of all nodes of transform hierarchies:
+			 *	world[i] = local[i] * world[parents[i]], world[i] = local[i] for
+			 *	roots. Parents must precede their children (parents[i] < i), e.g.
+			 *	nodes are in depth-first or breadth-first order.
+			 *
+			 *	Large hierarchies are split into chunks of contiguous nodes which
+			 *	are processed by <threads> threads (all hardware threads if 0),
+			 *	each chunk waits only for chunks containing parents of its nodes.
+			 *	Threads are started by the first call and wait for next ones,
+			 *	hierarchies of one chunk are processed by the calling thread.
+			 */
+			api(math)
+			void flatten(const fmat * local, const uint32_t * parents, fmat * world, size_t count, unsigned threads = 0);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -7,7 +7,9 @@
 
 //---------------------------------------------------------------------------
 
-#include <math/vector.h>
+#include <math/matrix.h>
+
+#include <limits>
 
 //---------------------------------------------------------------------------
 
@@ -15,16 +17,90 @@ namespace asd
 {
 	namespace math
 	{
+		/**
+		 *	@brief
+		 *	Axis-aligned box. Points on its faces belong to it. Like other
+		 *	bounding volumes (sphere, oriented_box, capsule, ray) it ignores
+		 *	w components of points.
+		 */
 		template<class T>
 		class box
 		{
 		public:
+			box() : min(vector_constants<T>::zero), max(vector_constants<T>::zero) {}
+			
+			box(const vector<T> & min, const vector<T> & max) : min(min), max(max) {}
+			
 			vector<T> min, max;
 			
-			bool contains(const vector<T> & point) {
-				return point > min && point < max;
+			static box around(const vector<T> & center, const vector<T> & extent) {
+				return {center - extent, center + extent};
+			}
+			
+			/**
+			 *	Box which contains nothing (min > max), merging anything into it
+			 *	gives the bounds of that thing
+			 */
+			static box empty() {
+				return {vector<T>(std::numeric_limits<T>::max()), vector<T>(std::numeric_limits<T>::lowest())};
+			}
+			
+			vector<T> center() const {
+				return (min + max).clear_w() * T(0.5);
+			}
+			
+			// half of the size
+			vector<T> extent() const {
+				return (max - min).clear_w() * T(0.5);
+			}
+			
+			bool contains(const vector<T> & point) const {
+				return
+					point.x >= min.x && point.x <= max.x &&
+					point.y >= min.y && point.y <= max.y &&
+					point.z >= min.z && point.z <= max.z;
+			}
+			
+			bool intersects(const box & b) const {
+				return
+					b.min.x <= max.x && b.max.x >= min.x &&
+					b.min.y <= max.y && b.max.y >= min.y &&
+					b.min.z <= max.z && b.max.z >= min.z;
+			}
+			
+			vector<T> closest_point(const vector<T> & point) const {
+				return point.clamp(min, max);
+			}
+			
+			T square_distance(const vector<T> & point) const {
+				return (closest_point(point) - point).clear_w().magnitudeSq();
+			}
+			
+			box & merge(const vector<T> & point) {
+				min = vector<T>::minimum(min, point);
+				max = vector<T>::maximum(max, point);
+				return *this;
+			}
+			
+			box & merge(const box & b) {
+				min = vector<T>::minimum(min, b.min);
+				max = vector<T>::maximum(max, b.max);
+				return *this;
+			}
+			
+			/**
+			 *	Bounds of the box transformed by the affine matrix <m> (see
+			 *	matrix::transform_point): the center is transformed and the
+			 *	extent is projected on absolute values of rows
+			 */
+			box transformed(const matrix<T> & m) const {
+				auto e = extent();
+				return around(m.transform_point(center()), {dot(abs(m[0]), e), dot(abs(m[1]), e), dot(abs(m[2]), e)});
 			}
 		};
+		
+		using fbox = box<float>;
+		using dbox = box<double>;
 	}
 }
 
@@ -0,0 +1,139 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_CAPSULE_H
+#define MATH_CAPSULE_H
+
+//---------------------------------------------------------------------------
+
+#include <math/sphere.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Points within the <radius> from the segment [a, b]
+		 */
+		template<class T>
+		class capsule
+		{
+		public:
+			capsule() : a(vector_constants<T>::zero), b(vector_constants<T>::zero), radius(0) {}
+
+			capsule(const vector<T> & a, const vector<T> & b, T radius) : a(a), b(b), radius(radius) {}
+
+			vector<T> a, b;
+			T radius;
+
+			// the closest point of the segment
+			vector<T> closest_axis_point(const vector<T> & point) const {
+				auto d = (b - a).clear_w();
+				T l = d.magnitudeSq();
+				T t = l > 0 ? std::min(std::max(dot(point - a, d) / l, T(0)), T(1)) : T(0);
+
+				return a + d * t;
+			}
+
+			vector<T> closest_point(const vector<T> & point) const {
+				return sphere<T>(closest_axis_point(point), radius).closest_point(point);
+			}
+
+			bool contains(const vector<T> & point) const {
+				return (closest_axis_point(point) - point).clear_w().magnitudeSq() <= radius * radius;
+			}
+
+			bool intersects(const sphere<T> & s) const {
+				T r = radius + s.radius;
+				return (closest_axis_point(s.center) - s.center).clear_w().magnitudeSq() <= r * r;
+			}
+
+			bool intersects(const capsule & c) const {
+				vector<T> p, q;
+				closest_axis_points(c, p, q);
+
+				T r = radius + c.radius;
+				return (p - q).clear_w().magnitudeSq() <= r * r;
+			}
+
+			/**
+			 *	Closest points <p> of this segment and <q> of the segment of <c>
+			 *	(Ericson, Real-Time Collision Detection, 5.1.9)
+			 */
+			void closest_axis_points(const capsule & c, vector<T> & p, vector<T> & q) const {
+				const T eps = constants<T>::eps;
+
+				auto d1 = (b - a).clear_w();
+				auto d2 = (c.b - c.a).clear_w();
+				auto r = (a - c.a).clear_w();
+
+				T l1 = d1.magnitudeSq();
+				T l2 = d2.magnitudeSq();
+				T f = dot(d2, r);
+				T s, t;
+
+				if(l1 <= eps && l2 <= eps) {
+					p = a;
+					q = c.a;
+					return;
+				}
+
+				if(l1 <= eps) {
+					s = 0;
+					t = clamp01(f / l2);
+				} else {
+					T e = dot(d1, r);
+
+					if(l2 <= eps) {
+						t = 0;
+						s = clamp01(-e / l1);
+					} else {
+						T k = dot(d1, d2);
+						T denominator = l1 * l2 - k * k;
+
+						s = denominator != 0 ? clamp01((k * f - e * l2) / denominator) : T(0);
+						t = (k * s + f) / l2;
+
+						if(t < 0) {
+							t = 0;
+							s = clamp01(-e / l1);
+						} else if(t > 1) {
+							t = 1;
+							s = clamp01((k - e) / l1);
+						}
+					}
+				}
+
+				p = a + d1 * s;
+				q = c.a + d2 * t;
+			}
+
+			box<T> bounds() const {
+				return box<T>(a, a).merge(b).merge(sphere<T>(a, radius).bounds()).merge(sphere<T>(b, radius).bounds());
+			}
+
+			/**
+			 *	The capsule transformed by the affine matrix <m>, the radius is
+			 *	scaled by the greatest scale of <m>
+			 */
+			capsule transformed(const matrix<T> & m) const {
+				return {m.transform_point(a.clear_w()), m.transform_point(b.clear_w()), radius * sphere<T>::max_scale(m)};
+			}
+
+		private:
+			static T clamp01(T v) {
+				return std::min(std::max(v, T(0)), T(1));
+			}
+		};
+
+		using fcapsule = capsule<float>;
+		using dcapsule = capsule<double>;
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
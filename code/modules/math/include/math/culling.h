@@ -0,0 +1,54 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_CULLING_H
+#define MATH_CULLING_H
+
+//---------------------------------------------------------------------------
+
+#include <math/frustum.h>
+#include <math/batch.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Frustum culling of bounding volumes stored as structures of arrays.
+		 *	Volumes are tested 4, 8 or 16 at a time like in math::batch, indices
+		 *	of visible volumes are written to <visible> in ascending order and
+		 *	their count is returned. <visible> must have room for all volumes.
+		 *
+		 *	<coherency> is optional and holds a byte per volume (zero-initialized
+		 *	at first) with the plane which culled it last time. This plane is
+		 *	tested first on the next call, so objects which stay off-screen are
+		 *	usually rejected by a single test.
+		 *
+		 *	Only planes of the <planes> mask are tested, e.g. the ones which are
+		 *	left after testing the bounds of the whole group with
+		 *	frustum::intersects(box, mask).
+		 */
+		namespace culling
+		{
+			/**
+			 *	Spheres are given as [x, y, z, radius], infinite radius makes a
+			 *	sphere always visible
+			 */
+			api(math)
+			size_t spheres(const ffrustum & f, const soa4<const float> & spheres, uint32_t * visible, byte * coherency = nullptr, unsigned planes = ffrustum::all_planes);
+
+			/**
+			 *	Axis-aligned boxes are given by their centers and extents
+			 */
+			api(math)
+			size_t boxes(const ffrustum & f, const soa3<const float> & centers, const soa3<const float> & extents, uint32_t * visible, byte * coherency = nullptr, unsigned planes = ffrustum::all_planes);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -8,6 +8,8 @@
 //---------------------------------------------------------------------------
 
 #include "plane.h"
+#include "box.h"
+#include "matrix.h"
 
 //---------------------------------------------------------------------------
 
@@ -15,23 +17,104 @@ namespace asd
 {
 	namespace math
 	{
+		/**
+		 *	@brief
+		 *	View frustum as 6 planes with normals pointing inside:
+		 *	left, right, bottom, top, near, far.
+		 *	Sets of planes are represented by bit masks (plane i is 1 << i).
+		 */
 		template<class T>
 		class frustum
 		{
 		public:
+			static const unsigned all_planes = 0x3F;
+
+			/**
+			 *	Extracts planes from the view-projection matrix <vp>, i.e. from
+			 *	rows of clip = vp * [x, y, z, 1] (see matrix::transform_point).
+			 *	The near plane is taken at z = -w, so projections with the [0, 1]
+			 *	depth range are culled conservatively.
+			 */
 			frustum(const matrix<T> & vp) {
-				auto m = vp.transposition();
-				auto & p = *_planes;
-				
 				for(int i = 0; i < 3; ++i) {
-					(p[i * 2 + 0] = m[i] + m[3]).normalize();
-					(p[i * 2 + 1] = m[i] - m[3]).normalize();
+					_planes[i * 2 + 0] = plane<T>(vp[3] + vp[i]);
+					_planes[i * 2 + 1] = plane<T>(vp[3] - vp[i]);
+				}
+
+				for(auto & p : _planes) {
+					p.normalize();
+				}
+			}
+
+			const array<plane<T>, 6> & planes() const {
+				return _planes;
+			}
+
+			const plane<T> & operator [](int index) const {
+				return _planes[index];
+			}
+
+			bool contains(const vector<T> & point) const {
+				for(auto & p : _planes) {
+					if(p.advance(point) < 0) {
+						return false;
+					}
 				}
+
+				return true;
 			}
-		
+
+			bool intersects(const vector<T> & center, T radius) const {
+				for(auto & p : _planes) {
+					if(p.advance(center) < -radius) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			bool intersects(const box<T> & b) const {
+				unsigned mask = all_planes;
+				return intersects(b, mask);
+			}
+
+			/**
+			 *	Tests the box against planes of <mask> and removes planes which
+			 *	have the whole box inside from it, so boxes contained in this
+			 *	one need to be tested only against remaining planes.
+			 */
+			bool intersects(const box<T> & b, unsigned & mask) const {
+				auto center = b.center();
+				auto extent = b.extent();
+
+				for(int i = 0; i < 6; ++i) {
+					if((mask & (1 << i)) == 0) {
+						continue;
+					}
+
+					auto & p = _planes[i];
+					T d = p.advance(center);
+					T r = dot(abs(p.normal()), extent); // projection of the extent on the normal
+
+					if(d + r < 0) {
+						return false;
+					}
+
+					if(d - r >= 0) {
+						mask &= ~(1u << i);
+					}
+				}
+
+				return true;
+			}
+
 		protected:
-			aligned_array<plane<T>, 6> _planes[6]; // left, right, bottom, top, near, far
+			array<plane<T>, 6> _planes; // left, right, bottom, top, near, far
 		};
+
+		using ffrustum = frustum<float>;
+		using dfrustum = frustum<double>;
 	}
 }
 
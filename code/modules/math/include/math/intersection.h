@@ -0,0 +1,58 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_INTERSECTION_H
+#define MATH_INTERSECTION_H
+
+//---------------------------------------------------------------------------
+
+#include <math/ray.h>
+#include <math/capsule.h>
+#include <math/batch.h>
+
+#include <limits>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Packet queries of one volume against many volumes stored as
+		 *	structures of arrays, e.g. for picking and broadphase. Volumes are
+		 *	tested 4, 8 or 16 at a time like in math::batch, indices of hit
+		 *	volumes are written to <hits> in ascending order and their count is
+		 *	returned. <hits> must have room for all volumes.
+		 */
+		namespace intersection
+		{
+			/**
+			 *	Boxes are given by their min and max corners. Distances to hit
+			 *	boxes are written to <distances> (if it isn't null) in the order of
+			 *	<hits> and must have room for all boxes. Boxes farther than
+			 *	<max_distance> are missed. Rays parallel to faces of a box which
+			 *	start exactly on their planes may either hit or miss it.
+			 */
+			api(math)
+			size_t ray_boxes(const fray & r, const soa3<const float> & min, const soa3<const float> & max, uint32_t * hits, float * distances = nullptr, float max_distance = std::numeric_limits<float>::infinity());
+
+			/**
+			 *	Boxes are given by their min and max corners
+			 */
+			api(math)
+			size_t box_boxes(const fbox & b, const soa3<const float> & min, const soa3<const float> & max, uint32_t * hits);
+
+			/**
+			 *	Spheres are given as [x, y, z, radius]
+			 */
+			api(math)
+			size_t sphere_spheres(const fsphere & s, const soa4<const float> & spheres, uint32_t * hits);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -243,6 +243,21 @@ namespace asd
 			}
 		};
 		
+		/**
+		 *	Accuracy tiers of approximations of transcendental functions (see approx.h):
+		 *	fast	- low degree polynomials, errors below 1e-4
+		 *			  for moderate arguments, for values which only drive visuals
+		 *	medium	- errors below 5e-6, the default
+		 *	precise	- errors within about 2 ulp, exact range reductions
+		 *	Errors are absolute for results below 1 and relative otherwise.
+		 */
+		enum class accuracy
+		{
+			fast,
+			medium,
+			precise
+		};
+		
 		template<class T>
 		inline T sin(T angle) {
 			return std::sin(angle);
@@ -72,6 +72,9 @@ namespace asd
 			
 			matrix(const row_type & x, const row_type & y, const row_type & z) : x{x}, y{y}, z{z}, w{vector_constants<T>::positive_w} {}
 			
+			template <class U, class I, class S, useif<!is_same<T, U>::value>>
+			explicit matrix(const matrix<U, I, S> & m) : x{m.x}, y{m.y}, z{m.z}, w{m.w} {}
+			
 			matrix(const T(& m)[16]) :
 				x(m[0x0], m[0x1], m[0x2], m[0x3]),
 				y(m[0x4], m[0x5], m[0x6], m[0x7]),
@@ -229,7 +232,18 @@ namespace asd
 				return mat;
 			}
 			
+			/**
+			 *	Inverse of an affine matrix (the last row is [0, 0, 0, 1]),
+			 *	e.g. of a transform, which is much cheaper than inverse()
+			 */
+			matrix affine_inverse() const {
+				matrix mat;
+				get_affine_inverse(mat);
+				return mat;
+			}
+			
 			inline void get_inverse(matrix & mat) const;
+			inline void get_affine_inverse(matrix & mat) const;
 			inline void get_transposition(matrix & mat) const;
 			
 			inline vector_type transform_point(const vector_type & b) const;
@@ -396,6 +410,24 @@ namespace asd
 			m[3] *= det;
 		}
 		
+		template <class T, class I, class S>
+		inline void matrix<T, I, S>::get_affine_inverse(matrix<T, I, S> & m) const {
+			auto a0 = v[0].clear_w();
+			auto a1 = v[1].clear_w();
+			auto a2 = v[2].clear_w();
+			
+			// columns of the inverted 3x3 part
+			vector<T> c[3] = {a1.cross(a2), a2.cross(a0), a0.cross(a1)};
+			
+			auto det = a0.dot(c[0]).invert();
+			c[0] *= det;
+			c[1] *= det;
+			c[2] *= det;
+			
+			matrix tmp {c[0], c[1], c[2], vector_constants<T>::positive_w - (c[0] * m03 + c[1] * m13 + c[2] * m23)};
+			tmp.get_transposition(m);
+		}
+		
 		template <class T, class I, class S>
 		inline void matrix<T, I, S>::get_transposition(matrix<T, I, S> & mat) const {
 			auto v0 = rows[0].template shuffle<0, 1, 0, 1>(rows[1]);
@@ -632,7 +664,8 @@ namespace asd
 		
 		template <class T, class I, class S>
 		inline matrix<T, I, S> matrix<T, I, S>::perspective(T fov, T aspect, T z0, T z1) {
-			const T f = 1 / std::tan(radians(fov) / 2);
+			const auto sc = trigon(radians(fov) / 2);
+			const T f = sc.y / sc.x;
 			const T z = z1 / (z1 - z0);
 			const vector<T, I, S> v = {f * aspect, f, z, -z0 * z};
 			
@@ -646,7 +679,8 @@ namespace asd
 		
 		template <class T, class I, class S>
 		inline matrix<T, I, S> matrix<T, I, S>::perspective_tr(T fov, T aspect, T z0, T z1) {
-			const T f = 1 / std::tan(radians(fov) / 2);
+			const auto sc = trigon(radians(fov) / 2);
+			const T f = sc.y / sc.x;
 			const T z = z1 / (z1 - z0);
 			const vector<T, I, S> v = {f * aspect, f, z, -z0 * z};
 			
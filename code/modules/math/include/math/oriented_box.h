@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_ORIENTED_BOX_H
+#define MATH_ORIENTED_BOX_H
+
+//---------------------------------------------------------------------------
+
+#include <math/sphere.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Box with the <center>, orthonormal <axes> and half-sizes along
+		 *	them in <extent>. Points on its faces belong to it.
+		 */
+		template<class T>
+		class oriented_box
+		{
+		public:
+			oriented_box() : oriented_box(box<T>()) {}
+
+			oriented_box(const vector<T> & center, const array<vector<T>, 3> & axes, const vector<T> & extent) : center(center), axes(axes), extent(extent) {}
+
+			oriented_box(const box<T> & b) : center(b.center()), axes({vector_constants<T>::positive_x, vector_constants<T>::positive_y, vector_constants<T>::positive_z}), extent(b.extent()) {}
+
+			/**
+			 *	The box <b> transformed by the affine matrix <m>. Axes remain
+			 *	orthogonal if <m> has no shear, i.e. non-uniform scaling is
+			 *	applied before rotation.
+			 */
+			oriented_box(const box<T> & b, const matrix<T> & m) : oriented_box(oriented_box(b).transformed(m)) {}
+
+			vector<T> center;
+			array<vector<T>, 3> axes;
+			vector<T> extent;
+
+			// offset of the point in the coordinates of axes
+			vector<T> local(const vector<T> & point) const {
+				auto d = (point - center).clear_w();
+				return {dot(d, axes[0]), dot(d, axes[1]), dot(d, axes[2])};
+			}
+
+			bool contains(const vector<T> & point) const {
+				auto l = abs(local(point));
+				return l.x <= extent.x && l.y <= extent.y && l.z <= extent.z;
+			}
+
+			vector<T> closest_point(const vector<T> & point) const {
+				auto l = local(point).clamp(-extent, extent);
+				return center + axes[0] * l.x + axes[1] * l.y + axes[2] * l.z;
+			}
+
+			bool intersects(const sphere<T> & s) const {
+				return (closest_point(s.center) - s.center).clear_w().magnitudeSq() <= s.radius * s.radius;
+			}
+
+			bool intersects(const box<T> & b) const {
+				return intersects(oriented_box(b));
+			}
+
+			/**
+			 *	Separating axis test: axes of both boxes and their cross
+			 *	products (Gottschalk's OBBTree test)
+			 */
+			bool intersects(const oriented_box & b) const {
+				const T eps = constants<T>::eps;
+
+				T r[3][3], ar[3][3];
+
+				for(int i = 0; i < 3; ++i) {
+					for(int j = 0; j < 3; ++j) {
+						r[i][j] = dot(axes[i], b.axes[j]);
+						ar[i][j] = std::abs(r[i][j]) + eps; // cross products of parallel axes are zero
+					}
+				}
+
+				auto t = local(b.center);
+
+				for(int i = 0; i < 3; ++i) {
+					if(std::abs(t[i]) > extent[i] + b.extent[0] * ar[i][0] + b.extent[1] * ar[i][1] + b.extent[2] * ar[i][2]) {
+						return false;
+					}
+				}
+
+				for(int j = 0; j < 3; ++j) {
+					if(std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > extent[0] * ar[0][j] + extent[1] * ar[1][j] + extent[2] * ar[2][j] + b.extent[j]) {
+						return false;
+					}
+				}
+
+				for(int i = 0; i < 3; ++i) {
+					int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+
+					for(int j = 0; j < 3; ++j) {
+						int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+						T ra = extent[i1] * ar[i2][j] + extent[i2] * ar[i1][j];
+						T rb = b.extent[j1] * ar[i][j2] + b.extent[j2] * ar[i][j1];
+
+						if(std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb) {
+							return false;
+						}
+					}
+				}
+
+				return true;
+			}
+
+			box<T> bounds() const {
+				auto e = abs(axes[0]) * extent.x + abs(axes[1]) * extent.y + abs(axes[2]) * extent.z;
+				return box<T>::around(center, e.clear_w());
+			}
+
+			oriented_box transformed(const matrix<T> & m) const {
+				oriented_box b;
+				b.center = m.transform_point(center.clear_w());
+
+				for(int i = 0; i < 3; ++i) {
+					auto a = m.transform_direction(axes[i]);
+					T l = a.magnitude();
+
+					b.axes[i] = a / l;
+					b.extent[i] = extent[i] * l;
+				}
+
+				return b;
+			}
+		};
+
+		using foriented_box = oriented_box<float>;
+		using doriented_box = oriented_box<double>;
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
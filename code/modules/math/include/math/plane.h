@@ -27,7 +27,7 @@ namespace asd
 		class plane
 		{
 		public:
-			plane() : equation(vector<T>::positive_z) {}
+			plane() : equation(vector_constants<T>::positive_z) {}
 			
 			plane(const plane & plane) : equation(plane.equation) {}
 			
@@ -41,7 +41,7 @@ namespace asd
 			
 			plane(const vector<T> & a, const vector<T> & b, const vector<T> & c) : equation(cross(b - a, c - a)) {
 				equation.normalize();
-				equation.w = dot(a, equation);
+				equation.w = -dot(a, normal());
 			}
 			
 			plane & operator =(const plane & plane) {
@@ -55,7 +55,7 @@ namespace asd
 			}
 			
 			vector<T> normal() const {
-				return equation.xyz;
+				return equation.clear_w();
 			}
 			
 			T offset() const {
@@ -63,7 +63,7 @@ namespace asd
 			}
 			
 			T advance(const vector<T> & v) const {
-				return dot(v, equation.xyz) + equation.w;
+				return dot(v, normal()) + equation.w;
 			}
 			
 			T distance(const vector<T> & v) const {
@@ -71,24 +71,20 @@ namespace asd
 			}
 			
 			void normalize() {
-				auto m = magnitude(equation.xyz);
-				
-				equation.xyz /= m;
-				equation.w *= m;
+				equation /= magnitude(normal());
 			}
 			
 			vector<T> reflect(const vector<T> & position) const {
-				auto n = normal();
-				return position - vector<T>::two * (dot(position, n) + offset()) * n;
+				return position - normal() * (2 * advance(position));
 			}
 			
 			vector<T> mirror(const vector<T> & direction) const {
 				auto n = normal();
-				return direction - vector<T>::two * dot(direction, n) * n;
+				return direction - n * (2 * dot(direction, n));
 			}
 			
-			void rotate(const quaternion<T> & quat) const {
-				equation.xyz = quat.apply_to(equation.xyz);
+			void rotate(const quaternion<T> & quat) {
+				equation = quat.apply_to(normal()).template blend<0, 0, 0, 1>(equation);
 			}
 			
 			plane_side classify(const vector<T> & p) const {
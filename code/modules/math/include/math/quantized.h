@@ -0,0 +1,299 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_QUANTIZED_H
+#define MATH_QUANTIZED_H
+
+//---------------------------------------------------------------------------
+
+#include <math/quaternion.h>
+
+#include <cstdint>
+#include <cstring>
+
+//---------------------------------------------------------------------------
+
+/**
+ *	Compact storage formats of vectors, rotations and positions for large sets
+ *	of instances, snapshots and replication. All of them are plain structures
+ *	of integers without padding, so arrays of them may be copied or sent as
+ *	bytes (byte order is the one of the machine).
+ *
+ *	Values are encoded one by one and decoded either one by one or by batch
+ *	functions which are dispatched like math::batch ones.
+ */
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	IEEE 754 binary16 with rounding to nearest even, infinities and
+		 *	NaNs are kept, too large values become infinities
+		 */
+		inline uint16_t to_half(float value)
+		{
+			uint32_t f;
+			std::memcpy(&f, &value, sizeof(f));
+
+			uint32_t sign = f & 0x80000000;
+			uint32_t h;
+			f ^= sign;
+
+			if(f >= 0x47800000) // 65536, the exponent overflows
+			{
+				h = f > 0x7F800000 ? 0x7E00 : 0x7C00;
+			}
+			else if(f < 0x38800000) // 2^-14, denormals: adding 0.5 aligns the mantissa and rounds it
+			{
+				float d;
+				std::memcpy(&d, &f, sizeof(d));
+				d += 0.5f;
+				std::memcpy(&h, &d, sizeof(h));
+				h -= 0x3F000000;
+			}
+			else
+			{
+				f += 0xC8000FFF + ((f >> 13) & 1); // rebias the exponent and round to nearest even
+				h = f >> 13;
+			}
+
+			return static_cast<uint16_t>(h | (sign >> 16));
+		}
+
+		inline float from_half(uint16_t value)
+		{
+			const uint32_t shifted_exp = 0x7C00 << 13;
+
+			uint32_t o = (value & 0x7FFFu) << 13;
+			uint32_t exp = o & shifted_exp;
+			o += (127 - 15) << 23;
+
+			float f;
+
+			if(exp == shifted_exp) // infinities and NaNs
+			{
+				o += (128 - 16) << 23;
+				std::memcpy(&f, &o, sizeof(f));
+			}
+			else if(exp == 0) // denormals are renormalized by the float subtraction
+			{
+				o += 1 << 23;
+				std::memcpy(&f, &o, sizeof(f));
+				f -= 6.103515625e-05f; // 2^-14
+			}
+			else
+			{
+				std::memcpy(&f, &o, sizeof(f));
+			}
+
+			return (value & 0x8000) != 0 ? -f : f;
+		}
+
+		/**
+		 *	@brief
+		 *	4 half-precision components, 8 bytes instead of 16. Precision is
+		 *	11 significant bits, e.g. 1 mm at 1 m or 0.5 m at 1 km.
+		 */
+		struct half_vector
+		{
+			half_vector() {}
+
+			half_vector(const fvec & v) : x(to_half(v.x)), y(to_half(v.y)), z(to_half(v.z)), w(to_half(v.w)) {}
+
+			fvec decode() const {
+				return {from_half(x), from_half(y), from_half(z), from_half(w)};
+			}
+
+			uint16_t x = 0, y = 0, z = 0, w = 0;
+		};
+
+		namespace internals
+		{
+			/**
+			 *	Smallest three encoding of unit quaternions: the largest
+			 *	component is dropped and restored from the others, which lie in
+			 *	[-1/sqrt(2), 1/sqrt(2)]. q and -q are the same rotation, so the
+			 *	sign is chosen to make the largest component positive.
+			 */
+			template<uint32_t Max>
+			struct smallest_three
+			{
+				static constexpr float range = 0.70710678f;
+
+				static uint32_t encode(const fquat & q, uint32_t (& fields)[3])
+				{
+					uint32_t largest = 0;
+
+					for(uint32_t i = 1; i < 4; ++i)
+					{
+						if(std::abs(q.elements[i]) > std::abs(q.elements[largest]))
+							largest = i;
+					}
+
+					float sign = q.elements[largest] < 0.0f ? -1.0f : 1.0f;
+
+					for(uint32_t i = 0, k = 0; i < 4; ++i)
+					{
+						if(i == largest)
+							continue;
+
+						float f = (q.elements[i] * sign + range) * (Max / (2 * range)) + 0.5f;
+						fields[k++] = f <= 0.0f ? 0 : f >= Max ? Max : static_cast<uint32_t>(f);
+					}
+
+					return largest;
+				}
+
+				static fquat decode(uint32_t largest, const uint32_t (& fields)[3])
+				{
+					float c[3];
+					float sum = 1.0f;
+
+					for(int k = 0; k < 3; ++k)
+					{
+						c[k] = fields[k] * (2 * range / Max) - range;
+						sum -= c[k] * c[k];
+					}
+
+					fquat q;
+
+					for(uint32_t i = 0, k = 0; i < 4; ++i)
+						q.elements[i] = i == largest ? std::sqrt(std::max(sum, 0.0f)) : c[k++];
+
+					return q;
+				}
+			};
+		}
+
+		/**
+		 *	@brief
+		 *	Unit quaternion in 32 bits: the index of the largest component in
+		 *	2 upper bits and the other components in 10 bits each. The error of
+		 *	angles is below 0.3 degree.
+		 */
+		struct quaternion32
+		{
+			using format = internals::smallest_three<0x3FF>;
+
+			quaternion32() : quaternion32(fquat::identity) {}
+
+			quaternion32(const fquat & q) {
+				uint32_t f[3];
+				bits = format::encode(q, f) << 30 | f[0] << 20 | f[1] << 10 | f[2];
+			}
+
+			fquat decode() const {
+				uint32_t f[3] = {(bits >> 20) & 0x3FF, (bits >> 10) & 0x3FF, bits & 0x3FF};
+				return format::decode(bits >> 30, f);
+			}
+
+			uint32_t bits;
+		};
+
+		/**
+		 *	@brief
+		 *	Unit quaternion in 48 bits: the other components take 15 bits each,
+		 *	upper bits of two first words hold the index of the largest one.
+		 *	The error of angles is below 0.01 degree.
+		 */
+		struct quaternion48
+		{
+			using format = internals::smallest_three<0x7FFF>;
+
+			quaternion48() : quaternion48(fquat::identity) {}
+
+			quaternion48(const fquat & q) {
+				uint32_t f[3];
+				uint32_t largest = format::encode(q, f);
+
+				bits[0] = static_cast<uint16_t>(f[0] | (largest & 1) << 15);
+				bits[1] = static_cast<uint16_t>(f[1] | (largest >> 1) << 15);
+				bits[2] = static_cast<uint16_t>(f[2]);
+			}
+
+			fquat decode() const {
+				uint32_t f[3] = {bits[0] & 0x7FFFu, bits[1] & 0x7FFFu, bits[2] & 0x7FFFu};
+				return format::decode((bits[0] >> 15) | (bits[1] >> 15) << 1, f);
+			}
+
+			uint16_t bits[3];
+		};
+
+		/**
+		 *	@brief
+		 *	Position inside of a fixed_cell as 16-bit fixed-point offsets from
+		 *	its origin, 6 bytes instead of 16
+		 */
+		struct fixed_position
+		{
+			int16_t x = 0, y = 0, z = 0;
+		};
+
+		/**
+		 *	@brief
+		 *	Cube with the center <origin> and the half-size <extent> whose
+		 *	positions are stored as fixed_position. The precision is
+		 *	extent / 32767 everywhere in the cell, e.g. 1 mm in a cell of 64 m,
+		 *	unlike floats which lose precision far from the origin of the world.
+		 */
+		struct fixed_cell
+		{
+			fixed_cell(const fvec & origin, float extent) : origin(origin), extent(extent) {}
+
+			/**
+			 *	Positions outside of the cell are clamped to its bounds
+			 */
+			fixed_position encode(const fvec & position) const {
+				auto d = (position - origin) * (32767.0f / extent);
+
+				fixed_position p;
+				p.x = quantize(d.x);
+				p.y = quantize(d.y);
+				p.z = quantize(d.z);
+
+				return p;
+			}
+
+			/**
+			 *	The w component is the one of the origin
+			 */
+			fvec decode(const fixed_position & p) const {
+				return origin + fvec(float(p.x), float(p.y), float(p.z)) * (extent / 32767.0f);
+			}
+
+			fvec origin;
+			float extent;
+
+		private:
+			static int16_t quantize(float v) {
+				return static_cast<int16_t>(v >= 32767.0f ? 32767 : v <= -32767.0f ? -32767 : std::lround(v));
+			}
+		};
+
+		namespace batch
+		{
+			/**
+			 *	out[i] = in[i].decode()
+			 */
+			api(math)
+			void decode(const half_vector * in, fvec * out, size_t count);
+
+			api(math)
+			void decode(const quaternion32 * in, fquat * out, size_t count);
+
+			api(math)
+			void decode(const quaternion48 * in, fquat * out, size_t count);
+
+			/**
+			 *	out[i] = cell.decode(in[i])
+			 */
+			api(math)
+			void decode(const fixed_cell & cell, const fixed_position * in, fvec * out, size_t count);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -54,9 +54,7 @@ namespace asd
             
             quaternion(T x, T y, T z, T w) : v{x, y, z, w} {}
             
-            quaternion(T pitch, T yaw, T roll) {
-                from_euler({pitch, yaw, roll});
-            }
+            quaternion(T pitch, T yaw, T roll) : quaternion(from_euler({pitch, yaw, roll})) {}
             
             quaternion(const VectorType & from, const VectorType & to) {
                 from_vectors(from, to);
@@ -251,6 +249,25 @@ namespace asd
                             template negate<0, 1, 0, 1>() * y.template shuffle<0, 2, 0, 0>() * r.template shuffle<0, 0, 2, 0>();
             }
             
+            /**
+             *  Spherical interpolation of unit quaternions by the shortest arc,
+             *  close quaternions are interpolated linearly and normalized
+             */
+            static quaternion slerp(const quaternion & a, const quaternion & b, T t) {
+                T cosine = a.v.dot(b.v).x;
+                T sign = cosine < 0 ? T(-1) : T(1);
+                cosine *= sign;
+                
+                if(cosine > T(0.9995)) {
+                    return quaternion(a.v + (b.v * sign - a.v) * t).normalize();
+                }
+                
+                T theta = approx::acos(cosine);
+                auto s = sin(VectorType{theta, (1 - t) * theta, t * theta, 0}); // [sin(theta), sin((1 - t) * theta), sin(t * theta), 0]
+                
+                return quaternion((a.v * s.y + b.v * (s.z * sign)) / s.x);
+            }
+            
             // 'from' and 'to' are unit vectors
             static quaternion from_vectors(const VectorType & from, const VectorType & to) {
                 auto d = from.dot(to);
@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_RAY_H
+#define MATH_RAY_H
+
+//---------------------------------------------------------------------------
+
+#include <math/oriented_box.h>
+#include <math/plane.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Half-line from the <origin> along the <direction> (its w component
+		 *	must be 0). Distances of hits are measured in lengths of the
+		 *	direction, so they are real distances for unit directions.
+		 *
+		 *	intersects() returns the distance to the first point of the volume
+		 *	on the ray, which is 0 if the origin is inside.
+		 */
+		template<class T>
+		class ray
+		{
+		public:
+			ray() : origin(vector_constants<T>::zero), direction(vector_constants<T>::forward) {}
+
+			ray(const vector<T> & origin, const vector<T> & direction) : origin(origin), direction(direction.clear_w()) {}
+
+			vector<T> origin;
+			vector<T> direction;
+
+			vector<T> point_at(T distance) const {
+				return origin + direction * distance;
+			}
+
+			vector<T> closest_point(const vector<T> & point) const {
+				return point_at(std::max(dot(point - origin, direction) / direction.magnitudeSq(), T(0)));
+			}
+
+			template<class V>
+			bool intersects(const V & volume) const {
+				T distance;
+				return intersects(volume, distance);
+			}
+
+			// slab test
+			bool intersects(const box<T> & b, T & distance) const {
+				return slabs(b.min - origin, b.max - origin, direction, distance);
+			}
+
+			bool intersects(const oriented_box<T> & b, T & distance) const {
+				auto o = b.local(origin);
+				vector<T> d = {dot(direction, b.axes[0]), dot(direction, b.axes[1]), dot(direction, b.axes[2])};
+
+				return slabs(-b.extent - o, b.extent - o, d, distance);
+			}
+
+			bool intersects(const sphere<T> & s, T & distance) const {
+				auto m = (origin - s.center).clear_w();
+				T a = direction.magnitudeSq();
+				T k = dot(m, direction);
+				T c = m.magnitudeSq() - s.radius * s.radius;
+
+				if(c <= 0) {
+					distance = 0;
+					return true;
+				}
+
+				T discriminant = k * k - a * c;
+
+				if(k > 0 || discriminant < 0) {
+					return false;
+				}
+
+				distance = (-k - std::sqrt(discriminant)) / a;
+				return true;
+			}
+
+			/**
+			 *	Hits planes from both sides
+			 */
+			bool intersects(const plane<T> & p, T & distance) const {
+				T d = dot(p.normal(), direction);
+				T t = -p.advance(origin);
+
+				if(d == 0) {
+					distance = 0;
+					return t == 0;
+				}
+
+				distance = t / d;
+				return distance >= 0;
+			}
+
+			ray transformed(const matrix<T> & m) const {
+				return {m.transform_point(origin.clear_w()), m.transform_direction(direction)};
+			}
+
+		private:
+			// [min, max] are bounds relative to the origin
+			static bool slabs(const vector<T> & min, const vector<T> & max, const vector<T> & d, T & distance) {
+				T near = 0;
+				T far = std::numeric_limits<T>::max();
+
+				for(int i = 0; i < 3; ++i) {
+					if(d[i] == 0) {
+						if(min[i] > 0 || max[i] < 0) {
+							return false;
+						}
+
+						continue;
+					}
+
+					T t1 = min[i] / d[i];
+					T t2 = max[i] / d[i];
+
+					near = std::max(near, std::min(t1, t2));
+					far = std::min(far, std::max(t1, t2));
+
+					if(near > far) {
+						return false;
+					}
+				}
+
+				distance = near;
+				return true;
+			}
+		};
+
+		using fray = ray<float>;
+		using dray = ray<double>;
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,504 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_SMALL_H
+#define MATH_SMALL_H
+
+//---------------------------------------------------------------------------
+
+#include <math/matrix.h>
+#include <math/point.h>
+
+//---------------------------------------------------------------------------
+
+/**
+ *	Fixed-size vectors and matrices of any size up to 4 (vec<T, N> and
+ *	mat<T, R, C>) for 2D maths, 3x3 normal matrices and other small
+ *	transforms which don't need the 4-lane SIMD types.
+ *
+ *	All operations are constexpr (except the ones with square roots), so
+ *	constants are computed by the compiler. Elements are stored without
+ *	padding in the layout of GPU uniforms (gfx3d::uniform::f32v3, f32m3
+ *	etc.) and are converted to them without copying. Sizes which fill a
+ *	SIMD register (4 floats, 2 or 4 doubles) are aligned to it, so loops
+ *	over their elements are vectorized with aligned loads.
+ */
+
+namespace asd
+{
+	namespace math
+	{
+		namespace small
+		{
+			/**
+			 *	Alignment of <N> elements of <T>: the one of a SIMD register if
+			 *	they fill it exactly, the one of <T> otherwise
+			 */
+			template<class T, int N>
+			struct alignment : std::integral_constant<size_t, (N * sizeof(T) == 16 || N * sizeof(T) == 32) ? N * sizeof(T) : alignof(T)> {};
+
+			template<class T, int N>
+			struct alignas(alignment<T, N>::value) vec
+			{
+				static_assert(N >= 2 && N <= 4, "Small vectors have from 2 to 4 components");
+
+				union
+				{
+					T e[N];
+					array<T, N> a;
+				};
+
+				member_cast(a, array<T, N>);
+
+				constexpr vec() : e{} {}
+
+				template<class ... A, useif<sizeof...(A) == N>>
+				constexpr vec(A ... values) : e{static_cast<T>(values)...} {}
+
+				static constexpr vec filled(T value) {
+					vec v;
+
+					for(int i = 0; i < N; ++i) {
+						v.e[i] = value;
+					}
+
+					return v;
+				}
+
+				constexpr T operator [](int i) const {
+					return e[i];
+				}
+
+				constexpr T & operator [](int i) {
+					return e[i];
+				}
+
+				constexpr vec & operator += (const vec & v) {
+					for(int i = 0; i < N; ++i) {
+						e[i] += v.e[i];
+					}
+
+					return *this;
+				}
+
+				constexpr vec & operator -= (const vec & v) {
+					for(int i = 0; i < N; ++i) {
+						e[i] -= v.e[i];
+					}
+
+					return *this;
+				}
+
+				constexpr vec & operator *= (T k) {
+					for(int i = 0; i < N; ++i) {
+						e[i] *= k;
+					}
+
+					return *this;
+				}
+
+				constexpr vec & operator /= (T k) {
+					for(int i = 0; i < N; ++i) {
+						e[i] /= k;
+					}
+
+					return *this;
+				}
+
+				constexpr T magnitude_sq() const {
+					return dot(*this, *this);
+				}
+
+				T magnitude() const {
+					return std::sqrt(magnitude_sq());
+				}
+
+				vec normalized() const {
+					return *this / magnitude();
+				}
+			};
+
+			template<class T, int N>
+			constexpr vec<T, N> operator + (vec<T, N> a, const vec<T, N> & b) {
+				return a += b;
+			}
+
+			template<class T, int N>
+			constexpr vec<T, N> operator - (vec<T, N> a, const vec<T, N> & b) {
+				return a -= b;
+			}
+
+			template<class T, int N>
+			constexpr vec<T, N> operator - (const vec<T, N> & a) {
+				return vec<T, N>() - a;
+			}
+
+			template<class T, int N>
+			constexpr vec<T, N> operator * (vec<T, N> a, T k) {
+				return a *= k;
+			}
+
+			template<class T, int N>
+			constexpr vec<T, N> operator * (T k, vec<T, N> a) {
+				return a *= k;
+			}
+
+			template<class T, int N>
+			constexpr vec<T, N> operator / (vec<T, N> a, T k) {
+				return a /= k;
+			}
+
+			template<class T, int N>
+			constexpr bool operator == (const vec<T, N> & a, const vec<T, N> & b) {
+				for(int i = 0; i < N; ++i) {
+					if(a.e[i] != b.e[i]) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			template<class T, int N>
+			constexpr bool operator != (const vec<T, N> & a, const vec<T, N> & b) {
+				return !(a == b);
+			}
+
+			template<class T, int N>
+			constexpr T dot(const vec<T, N> & a, const vec<T, N> & b) {
+				T s = 0;
+
+				for(int i = 0; i < N; ++i) {
+					s += a.e[i] * b.e[i];
+				}
+
+				return s;
+			}
+
+			template<class T>
+			constexpr vec<T, 3> cross(const vec<T, 3> & a, const vec<T, 3> & b) {
+				return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+			}
+
+			/**
+			 *	@brief
+			 *	Matrix of <R> rows and <C> columns stored by rows. Like
+			 *	math::matrix, it transforms column vectors (m * v, rows are
+			 *	equations) and a * b applies <a> first, i.e. it's the
+			 *	mathematical product b·a.
+			 */
+			template<class T, int R, int C>
+			struct mat
+			{
+				static_assert(R >= 2 && R <= 4 && C >= 2 && C <= 4, "Small matrices have from 2 to 4 rows and columns");
+
+				using row_type = vec<T, C>;
+
+				union
+				{
+					row_type rows[R];
+					array<array<T, C>, R> a;
+				};
+
+				member_cast(a, array<array<T, C>, R>);
+
+				constexpr mat() : rows{} {}
+
+				/**
+				 *	Elements by rows
+				 */
+				template<class ... A, useif<sizeof...(A) == R * C>>
+				constexpr mat(A ... values) : rows{} {
+					const T e[] = {static_cast<T>(values)...};
+
+					for(int i = 0; i < R; ++i) {
+						for(int j = 0; j < C; ++j) {
+							rows[i][j] = e[i * C + j];
+						}
+					}
+				}
+
+				static constexpr mat identity() {
+					mat m;
+
+					for(int i = 0; i < R && i < C; ++i) {
+						m.rows[i][i] = 1;
+					}
+
+					return m;
+				}
+
+				constexpr const row_type & operator [](int i) const {
+					return rows[i];
+				}
+
+				constexpr row_type & operator [](int i) {
+					return rows[i];
+				}
+
+				constexpr T operator ()(int row, int column) const {
+					return rows[row][column];
+				}
+
+				constexpr mat<T, C, R> transposition() const {
+					mat<T, C, R> m;
+
+					for(int i = 0; i < R; ++i) {
+						for(int j = 0; j < C; ++j) {
+							m.rows[j][i] = rows[i][j];
+						}
+					}
+
+					return m;
+				}
+
+				/**
+				 *	m * v, v is a column vector
+				 */
+				constexpr vec<T, R> transform(const vec<T, C> & v) const {
+					vec<T, R> r;
+
+					for(int i = 0; i < R; ++i) {
+						r[i] = dot(rows[i], v);
+					}
+
+					return r;
+				}
+
+				/**
+				 *	m * [v, 1] for affine matrices, e.g. 3x3 for 2D points
+				 */
+				constexpr vec<T, C - 1> transform_point(const vec<T, C - 1> & v) const {
+					vec<T, C - 1> r;
+
+					for(int i = 0; i < C - 1; ++i) {
+						r[i] = rows[i][C - 1];
+
+						for(int j = 0; j < C - 1; ++j) {
+							r[i] += rows[i][j] * v[j];
+						}
+					}
+
+					return r;
+				}
+
+				/**
+				 *	m * [v, 0] for affine matrices
+				 */
+				constexpr vec<T, C - 1> transform_direction(const vec<T, C - 1> & v) const {
+					vec<T, C - 1> r;
+
+					for(int i = 0; i < C - 1; ++i) {
+						for(int j = 0; j < C - 1; ++j) {
+							r[i] += rows[i][j] * v[j];
+						}
+					}
+
+					return r;
+				}
+			};
+
+			template<class T, int N>
+			constexpr mat<T, N, N> operator * (const mat<T, N, N> & a, const mat<T, N, N> & b) {
+				mat<T, N, N> m;
+
+				for(int i = 0; i < N; ++i) {
+					for(int j = 0; j < N; ++j) {
+						for(int k = 0; k < N; ++k) {
+							m[i][j] += b[i][k] * a[k][j];
+						}
+					}
+				}
+
+				return m;
+			}
+
+			template<class T, int R, int C>
+			constexpr bool operator == (const mat<T, R, C> & a, const mat<T, R, C> & b) {
+				for(int i = 0; i < R; ++i) {
+					if(a[i] != b[i]) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			template<class T, int R, int C>
+			constexpr bool operator != (const mat<T, R, C> & a, const mat<T, R, C> & b) {
+				return !(a == b);
+			}
+
+			template<class T>
+			constexpr T determinant(const mat<T, 2, 2> & m) {
+				return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+			}
+
+			template<class T>
+			constexpr T determinant(const mat<T, 3, 3> & m) {
+				return dot(m[0], cross(m[1], m[2]));
+			}
+
+			template<class T>
+			constexpr mat<T, 2, 2> inverse(const mat<T, 2, 2> & m) {
+				T k = 1 / determinant(m);
+				return {m(1, 1) * k, -m(0, 1) * k, -m(1, 0) * k, m(0, 0) * k};
+			}
+
+			/**
+			 *	Cross products of rows are columns of the inverse
+			 */
+			template<class T>
+			constexpr mat<T, 3, 3> inverse_transposition(const mat<T, 3, 3> & m) {
+				mat<T, 3, 3> r;
+
+				r[0] = cross(m[1], m[2]);
+				r[1] = cross(m[2], m[0]);
+				r[2] = cross(m[0], m[1]);
+
+				return r * (1 / dot(m[0], r[0]));
+			}
+
+			template<class T>
+			constexpr mat<T, 3, 3> inverse(const mat<T, 3, 3> & m) {
+				return inverse_transposition(m).transposition();
+			}
+
+			template<class T, int R, int C>
+			constexpr mat<T, R, C> operator * (mat<T, R, C> m, T k) {
+				for(int i = 0; i < R; ++i) {
+					m[i] *= k;
+				}
+
+				return m;
+			}
+
+			//---------------------------------------------------------------------------
+
+			/**
+			 *	2D affine transforms as 3x3 matrices, e.g. for UI layout
+			 */
+			template<class T>
+			constexpr mat<T, 3, 3> translation(const vec<T, 2> & offset) {
+				return {
+					1, 0, offset[0],
+					0, 1, offset[1],
+					0, 0, 1
+				};
+			}
+
+			template<class T>
+			constexpr mat<T, 3, 3> scaling(const vec<T, 2> & scale) {
+				return {
+					scale[0], 0, 0,
+					0, scale[1], 0,
+					0, 0, 1
+				};
+			}
+
+			template<class T>
+			mat<T, 3, 3> rotation(T angle) {
+				T s = std::sin(angle), c = std::cos(angle);
+
+				return {
+					c, -s, 0,
+					s, c, 0,
+					0, 0, 1
+				};
+			}
+
+			//---------------------------------------------------------------------------
+
+			template<class T>
+			constexpr vec<T, 2> from(const point<T> & p) {
+				return {p.x, p.y};
+			}
+
+			template<class T>
+			point<T> to_point(const vec<T, 2> & v) {
+				return {v[0], v[1]};
+			}
+
+			template<class T>
+			vec<T, 3> from(const vector<T> & v) {
+				return {v.x, v.y, v.z};
+			}
+
+			template<class T>
+			vector<T> to_vector(const vec<T, 3> & v) {
+				return {v[0], v[1], v[2]};
+			}
+
+			template<class T>
+			vector<T> to_vector(const vec<T, 4> & v) {
+				return {v[0], v[1], v[2], v[3]};
+			}
+
+			/**
+			 *	The upper left 3x3 part of the matrix, i.e. its rotation and
+			 *	scale
+			 */
+			template<class T>
+			mat<T, 3, 3> linear(const matrix<T> & m) {
+				return {
+					m(0, 0), m(0, 1), m(0, 2),
+					m(1, 0), m(1, 1), m(1, 2),
+					m(2, 0), m(2, 1), m(2, 2)
+				};
+			}
+
+			/**
+			 *	3x3 matrix which transforms normals of a model transformed by
+			 *	the affine matrix <m>, cheaper than the 4x4 matrix
+			 */
+			template<class T>
+			mat<T, 3, 3> normal_matrix(const matrix<T> & m) {
+				return inverse_transposition(linear(m));
+			}
+
+			template<class T>
+			mat<T, 4, 4> from(const matrix<T> & m) {
+				mat<T, 4, 4> r;
+
+				for(int i = 0; i < 4; ++i) {
+					for(int j = 0; j < 4; ++j) {
+						r[i][j] = m(i, j);
+					}
+				}
+
+				return r;
+			}
+
+			template<class T>
+			matrix<T> to_matrix(const mat<T, 4, 4> & m) {
+				matrix<T> r;
+
+				for(int i = 0; i < 4; ++i) {
+					for(int j = 0; j < 4; ++j) {
+						r(i, j) = m(i, j);
+					}
+				}
+
+				return r;
+			}
+		}
+
+		using fvec2 = small::vec<float, 2>;
+		using fvec3 = small::vec<float, 3>;
+		using fvec4 = small::vec<float, 4>;
+		using dvec2 = small::vec<double, 2>;
+		using dvec3 = small::vec<double, 3>;
+		using dvec4 = small::vec<double, 4>;
+
+		using fmat2 = small::mat<float, 2, 2>;
+		using fmat3 = small::mat<float, 3, 3>;
+		using fmat4 = small::mat<float, 4, 4>;
+		using dmat2 = small::mat<double, 2, 2>;
+		using dmat3 = small::mat<double, 3, 3>;
+		using dmat4 = small::mat<double, 4, 4>;
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,103 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_SPHERE_H
+#define MATH_SPHERE_H
+
+//---------------------------------------------------------------------------
+
+#include <math/box.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		/**
+		 *	@brief
+		 *	Ball with the <center> and the <radius>. Points on its surface
+		 *	belong to it.
+		 */
+		template<class T>
+		class sphere
+		{
+		public:
+			sphere() : center(vector_constants<T>::zero), radius(0) {}
+
+			sphere(const vector<T> & center, T radius) : center(center), radius(radius) {}
+
+			vector<T> center;
+			T radius;
+
+			bool contains(const vector<T> & point) const {
+				return (point - center).clear_w().magnitudeSq() <= radius * radius;
+			}
+
+			bool intersects(const sphere & s) const {
+				T r = radius + s.radius;
+				return (s.center - center).clear_w().magnitudeSq() <= r * r;
+			}
+
+			bool intersects(const box<T> & b) const {
+				return b.square_distance(center) <= radius * radius;
+			}
+
+			vector<T> closest_point(const vector<T> & point) const {
+				auto d = (point - center).clear_w();
+				T l = d.magnitude();
+				return l <= radius ? point : center + d * (radius / l);
+			}
+
+			box<T> bounds() const {
+				return box<T>::around(center, vector<T>(radius, radius, radius));
+			}
+
+			/**
+			 *	The smallest sphere containing both spheres
+			 */
+			sphere & merge(const sphere & s) {
+				auto d = (s.center - center).clear_w();
+				T l = d.magnitude();
+
+				if(l + s.radius <= radius) {
+					return *this;
+				}
+
+				if(l + radius <= s.radius) {
+					return *this = s;
+				}
+
+				T r = (l + radius + s.radius) * T(0.5);
+				center += d * ((r - radius) / l);
+				radius = r;
+
+				return *this;
+			}
+
+			sphere & merge(const vector<T> & point) {
+				return merge(sphere(point, 0));
+			}
+
+			/**
+			 *	Bounds of the sphere transformed by the affine matrix <m>, the
+			 *	radius is scaled by the greatest scale of <m>
+			 */
+			sphere transformed(const matrix<T> & m) const {
+				return {m.transform_point(center.clear_w()), radius * max_scale(m)};
+			}
+
+			// the longest image of unit axes
+			static T max_scale(const matrix<T> & m) {
+				return std::sqrt((sqr(m[0]) + sqr(m[1]) + sqr(m[2])).max());
+			}
+		};
+
+		using fsphere = sphere<float>;
+		using dsphere = sphere<double>;
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
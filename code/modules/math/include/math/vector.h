@@ -9,12 +9,22 @@
 
 #include <core/intrinsic/Intrinsic.h>
 #include <math/math.h>
+#include <math/approx.h>
 #include <core/String.h>
 #include <core/memory/aligned.h>
 #include <iostream>
 
 //---------------------------------------------------------------------------
 
+/**
+ *	vector<double>, matrix<double> and quaternion<double> are implemented on
+ *	Intrinsic<double, 4> (AVX or a pair of SSE2 registers), so space::scalar
+ *	can be switched to double with VECTOR_DOUBLE_PRECISION
+ */
+#define DOUBLE_VECTOR_IMPLEMENTED
+
+//---------------------------------------------------------------------------
+
 namespace asd
 {
 	namespace math
@@ -291,28 +301,28 @@ namespace asd
 			}
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(const vector<U, I, S> & v) : base_type(intrin_cvt<intrin_type>(v)) {}
+			vector(const vector<U, I, S> & v) : base_type(convert(v)) {}
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(const vector<U, I, S> & v, T a)      : base_type(intrin_cvt<intrin_type>(v)) { this->w = a; }
+			vector(const vector<U, I, S> & v, T a)      : base_type(convert(v)) { this->w = a; }
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(const vector<U, I, S> & v, T a, T b) : base_type(intrin_cvt<intrin_type>(v)) {
+			vector(const vector<U, I, S> & v, T a, T b) : base_type(convert(v)) {
 				this->z = a;
 				this->w = b;
 			}
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(T a, const vector<U, I, S> & v)      : base_type(intrin_cvt<intrin_type>(Implementation::template shuffle<3, 0, 1, 2>(v))) { this->x = a; }
+			vector(T a, const vector<U, I, S> & v)      : base_type(Implementation::template shuffle<3, 0, 1, 2>(convert(v))) { this->x = a; }
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(T a, T b, const vector<U, I, S> & v) : base_type(intrin_cvt<intrin_type>(Implementation::template shuffle<2, 3, 0, 1>(v))) {
+			vector(T a, T b, const vector<U, I, S> & v) : base_type(Implementation::template shuffle<2, 3, 0, 1>(convert(v))) {
 				this->x = a;
 				this->y = b;
 			}
 			
 			template <class U, class I, class S, useif<!is_same<T, U>::value>>
-			vector(T a, const vector<U, I, S> & v, T b) : base_type(intrin_cvt<intrin_type>(Implementation::template shuffle<3, 0, 1, 2>(v))) {
+			vector(T a, const vector<U, I, S> & v, T b) : base_type(Implementation::template shuffle<3, 0, 1, 2>(convert(v))) {
 				this->x = a;
 				this->w = b;
 			}
@@ -774,7 +784,13 @@ namespace asd
 			static int compare(const vector & v1, const vector & v2) {
 				return static_cast<int>(Implementation::sum(Implementation::sub(v1, v2)));
 			}
-			
+		
+		private:
+			// converts intrinsics of other element type, e.g. float to double
+			template <class U, class I, class S>
+			static intrin_type convert(const vector<U, I, S> & v) {
+				return intrin_cvt<intrin_type>(static_cast<typename I::type>(v));
+			}
 		};
 		
 		template <class T>
@@ -866,24 +882,21 @@ namespace asd
 		using byte_vector = vector<byte>;
 		using int_vector = vector<int>;
 		using float_vector = vector<float>;
+		using double_vector = vector<double>;
 		
 		using bytev = byte_vector;
 		using intv = int_vector;
 		using floatv = float_vector;
+		using doublev = double_vector;
 		
 		using bvec = vector<byte>;
 		using ivec = vector<int>;
 		using fvec = vector<float>;
+		using dvec = vector<double>;
 		
 		template <class T, class I = Intrinsic<T, 4>>
 		using aligned_vec = vector<T, I, AlignedVectorStorage<T, I>>;
 
-#ifdef USE_AVX
-		using DoubleVector = vector<double>;
-		using doublev = DoubleVector;
-		using dvec = vector<double>;
-#endif
-
 //---------------------------------------------------------------------------
 		
 		template <class T, class I, class S>
@@ -960,7 +973,28 @@ namespace asd
 			return c;
 		}
 		
-		template <class T, class I1, class S1, class I2, class S2>
+		// float vectors use approx::sin, approx::cos and approx::sincos of the medium tier
+		
+		template <class T, class I1, class S1, class I2, class S2, selectif(0)<std::is_same<T, float>::value>>
+		inline void sin(const vector<T, I1, S1> & angle, vector<T, I2, S2> & s) {
+			s = approx::sin(static_cast<typename I1::type>(angle));
+		}
+		
+		template <class T, class I1, class S1, class I2, class S2, selectif(0)<std::is_same<T, float>::value>>
+		inline void cos(const vector<T, I1, S1> & angle, vector<T, I2, S2> & c) {
+			c = approx::cos(static_cast<typename I1::type>(angle));
+		}
+		
+		template <class T, class I1, class S1, class I2, class S2, class I3, class S3, selectif(0)<std::is_same<T, float>::value>>
+		inline void sincos(const vector<T, I1, S1> & angle, vector<T, I2, S2> & s, vector<T, I3, S3> & c) {
+			typename I1::type vs, vc;
+			approx::sincos(static_cast<typename I1::type>(angle), vs, vc);
+			
+			s = vs;
+			c = vc;
+		}
+		
+		template <class T, class I1, class S1, class I2, class S2, selectif(1)<!std::is_same<T, float>::value>>
 		inline void sin(const vector<T, I1, S1> & angle, vector<T, I2, S2> & s) {
 			using Intrin = I1;
 			
@@ -981,7 +1015,7 @@ namespace asd
 								)))));
 		}
 		
-		template <class T, class I1, class S1, class I2, class S2>
+		template <class T, class I1, class S1, class I2, class S2, selectif(1)<!std::is_same<T, float>::value>>
 		inline void cos(const vector<T, I1, S1> & angle, vector<T, I2, S2> & c) {
 			using Intrin = I1;
 			
@@ -1001,7 +1035,7 @@ namespace asd
 								))))));
 		}
 		
-		template <class T, class I1, class S1, class I2, class S2, class I3, class S3>
+		template <class T, class I1, class S1, class I2, class S2, class I3, class S3, selectif(1)<!std::is_same<T, float>::value>>
 		inline void sincos(const vector<T, I1, S1> & angle, vector<T, I2, S2> & s, vector<T, I3, S3> & c) {
 			using Intrin = I1;
 			
@@ -1043,12 +1077,6 @@ namespace asd
 			return sin(aligned_vec<T>{angle, angle + constants<T>::half_pi, -angle, 0});
 		}
 
-#ifdef USE_AVX
-		using DoubleVectorMath = VectorMath<double>;
-		using DoubleVectorCfs = VectorCfs<double>;
-		using DoubleVectorConstants = VectorConstants<double>;
-#endif
-
 //---------------------------------------------------------------------------
 		
 		inline aligned_vec<float> vec() {
@@ -1062,23 +1090,18 @@ namespace asd
 		inline aligned_vec<float> vec(float x, float y, float z, float w) {
 			return {x, y, z, w};
 		}
-
-#ifdef USE_AVX
-		inline aligned_vec<double> vecd()
-		{
+		
+		inline aligned_vec<double> vecd() {
 			return vector_constants<double>::zero;
 		}
-	
-		inline aligned_vec<double> vecd(double x, double y, double z)
-		{
+		
+		inline aligned_vec<double> vecd(double x, double y, double z) {
 			return {x, y, z, 1};
 		}
-	
-		inline aligned_vec<double> vecd(double x, double y, double z, double w)
-		{
+		
+		inline aligned_vec<double> vecd(double x, double y, double z, double w) {
 			return {x, y, z, w};
 		}
-#endif
 		
 		template <typename T, class I1, class S1, class I2, class S2>
 		inline aligned_vec<T, I1> operator +(const vector<T, I1, S1> & v1, const vector<T, I2, S2> & v2) {
@@ -1209,13 +1232,10 @@ namespace asd
 	inline math::vector<float> operator "" _v(long double v) {
 		return {static_cast<float>(v)};
 	}
-
-#ifdef USE_AVX
-	inline DoubleVector operator "" _vd(long double v)
-	{
+	
+	inline math::vector<double> operator "" _vd(long double v) {
 		return {static_cast<double>(v)};
 	}
-#endif
 	
 	template <class T, class I, class S>
 	inline void print(String & s, const math::vector<T, I, S> & v) {
@@ -1231,19 +1251,16 @@ namespace asd
 			IntrinData<float, 4>::get<3>(v), ")"
 		);
 	}
-
-#ifdef USE_AVX
-	inline void print(String & s, const intrin_t<double, 4> & v)
-	{
+	
+	inline void print(String & s, const intrin_t<double, 4> & v) {
 		s << String::assemble(
 			"(",
 			IntrinData<double, 4>::get<0>(v), ", ",
 			IntrinData<double, 4>::get<1>(v), ", ",
 			IntrinData<double, 4>::get<2>(v), ", ",
 			IntrinData<double, 4>::get<3>(v), ")"
-			);
+		);
 	}
-#endif
 }
 
 //---------------------------------------------------------------------------
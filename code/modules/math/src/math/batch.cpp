@@ -0,0 +1,314 @@
+//---------------------------------------------------------------------------
+
+#include <math/batch.h>
+#include <core/intrinsic/CpuFeatures.h>
+#include <container/array_list.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <emmintrin.h>
+
+#include "batch_kernels.h"
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		namespace internals
+		{
+			namespace
+			{
+				/**
+				 *	Rows of matrices for the scalar path, SSE2 is always available
+				 */
+				struct sse2_rows
+				{
+					using type = __m128;
+
+					static const size_t matrices = 1;
+
+					static type fill(float a) { return _mm_set1_ps(a); }
+
+					static type add(type a, type b) { return _mm_add_ps(a, b); }
+					static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+					static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+					static type div(type a, type b) { return _mm_div_ps(a, b); }
+					static type fmadd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+					static type fnmadd(type a, type b, type c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+
+					static type load_lanes(const float * const * m, size_t offset) { return _mm_loadu_ps(m[0] + offset); }
+					static void store_lanes(float * const * m, size_t offset, type a, size_t) { _mm_storeu_ps(m[0] + offset, a); }
+					static type fill_lanes(const float * row) { return _mm_loadu_ps(row); }
+
+					template<int x, int y, int z, int w>
+					static type shuffle(type a, type b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x)); }
+				};
+			}
+
+			const batch_kernels & scalar_batch_kernels()
+			{
+				static const batch_kernels kernels = make_batch_kernels<scalar_pack, sse2_rows>();
+				return kernels;
+			}
+		}
+
+		namespace batch
+		{
+			static const simd_dispatch<const internals::batch_kernels & ()> kernels {
+				internals::scalar_batch_kernels,
+				internals::sse4_batch_kernels,
+				internals::avx2_batch_kernels,
+				internals::avx512_batch_kernels
+			};
+
+			void transform_points(const fmat & m, const soa3<const float> & in, const soa3<float> & out)
+			{
+				kernels().transform_points(m.m.data(), in.x, in.y, in.z, out.x, out.y, out.z, in.size);
+			}
+
+			void transform_directions(const fmat & m, const soa3<const float> & in, const soa3<float> & out)
+			{
+				kernels().transform_directions(m.m.data(), in.x, in.y, in.z, out.x, out.y, out.z, in.size);
+			}
+
+			void rotate(const fquat & q, const soa3<const float> & in, const soa3<float> & out)
+			{
+				kernels().rotate(q.q.data(), in.x, in.y, in.z, out.x, out.y, out.z, in.size);
+			}
+
+			void rotate(const soa4<const float> & q, const soa3<const float> & in, const soa3<float> & out)
+			{
+				kernels().rotate_each(q.x, q.y, q.z, q.w, in.x, in.y, in.z, out.x, out.y, out.z, in.size);
+			}
+
+			void rotate_by(const fquat & q, const soa4<const float> & in, const soa4<float> & out)
+			{
+				const float * qi[] = {in.x, in.y, in.z, in.w};
+				float * qo[] = {out.x, out.y, out.z, out.w};
+
+				kernels().rotate_by(q.q.data(), qi, qo, in.size);
+			}
+
+			void normalize(const soa3<const float> & in, const soa3<float> & out)
+			{
+				kernels().normalize(in.x, in.y, in.z, out.x, out.y, out.z, in.size);
+			}
+
+			void dot(const soa3<const float> & a, const soa3<const float> & b, float * out)
+			{
+				kernels().dot(a.x, a.y, a.z, b.x, b.y, b.z, out, a.size);
+			}
+
+			void cross(const soa3<const float> & a, const soa3<const float> & b, const soa3<float> & out)
+			{
+				kernels().cross(a.x, a.y, a.z, b.x, b.y, b.z, out.x, out.y, out.z, a.size);
+			}
+
+			void lerp(const soa3<const float> & a, const soa3<const float> & b, float t, const soa3<float> & out)
+			{
+				kernels().lerp(a.x, a.y, a.z, b.x, b.y, b.z, t, out.x, out.y, out.z, a.size);
+			}
+
+			void slerp(const soa4<const float> & a, const soa4<const float> & b, float t, const soa4<float> & out)
+			{
+				const float * qa[] = {a.x, a.y, a.z, a.w};
+				const float * qb[] = {b.x, b.y, b.z, b.w};
+				float * qo[] = {out.x, out.y, out.z, out.w};
+
+				kernels().slerp(qa, qb, t, qo, a.size);
+			}
+
+			static_assert(sizeof(fmat) % sizeof(float) == 0, "Matrices of arrays must be a whole number of floats apart");
+			static_assert(no_parent == internals::no_parent, "Kernels must use the same parent of roots");
+
+			// elements don't start at the beginning of a matrix because of its empty base class
+			static const size_t stride = sizeof(fmat) / sizeof(float);
+
+			static const float * data(const fmat * m)
+			{
+				return m != nullptr ? m->m.data() : nullptr;
+			}
+
+			static float * data(fmat * m)
+			{
+				return m != nullptr ? m->m.data() : nullptr;
+			}
+
+			void multiply(const fmat * a, const fmat * b, fmat * out, size_t count)
+			{
+				kernels().multiply(data(a), data(b), data(out), stride, count);
+			}
+
+			void inverse(const fmat * m, fmat * out, size_t count)
+			{
+				kernels().inverse(data(m), data(out), stride, count);
+			}
+
+			void inverse_transpose(const fmat * m, fmat * out, size_t count)
+			{
+				kernels().inverse_transpose(data(m), data(out), stride, count);
+			}
+
+			void affine_inverse(const fmat * m, fmat * out, size_t count)
+			{
+				kernels().affine_inverse(data(m), data(out), stride, count);
+			}
+
+			/**
+			 *	Threads of flatten. They are started by the first call which needs
+			 *	them and wait for next calls, calls are processed one at a time.
+			 */
+			class flatten_workers
+			{
+			public:
+				static flatten_workers & instance()
+				{
+					static flatten_workers workers;
+					return workers;
+				}
+
+				~flatten_workers()
+				{
+					{
+						std::lock_guard<std::mutex> lock(_mutex);
+						_stop = true;
+					}
+
+					_wake.notify_all();
+
+					for(auto & t : _threads)
+						t.join();
+				}
+
+				/**
+				 *	Calls <job> in <threads> threads including the calling one
+				 */
+				void run(unsigned threads, const std::function<void()> & job)
+				{
+					std::lock_guard<std::mutex> call(_call);
+					std::unique_lock<std::mutex> lock(_mutex);
+
+					while(_threads.size() < threads - 1)
+					{
+						auto index = static_cast<unsigned>(_threads.size());
+						auto generation = _generation;
+
+						_threads.emplace_back([this, index, generation]() { work(index, generation); });
+					}
+
+					_job = &job;
+					_workers = threads - 1;
+					_pending = _workers;
+					++_generation;
+
+					lock.unlock();
+					_wake.notify_all();
+
+					job();
+
+					lock.lock();
+					_finished.wait(lock, [this]() { return _pending == 0; });
+				}
+
+			private:
+				flatten_workers() {}
+
+				void work(unsigned index, size_t generation)
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+
+					while(true)
+					{
+						_wake.wait(lock, [&]() { return _stop || _generation != generation; });
+
+						if(_stop)
+							return;
+
+						generation = _generation;
+
+						if(index >= _workers)
+							continue;
+
+						lock.unlock();
+						(*_job)();
+						lock.lock();
+
+						if(--_pending == 0)
+							_finished.notify_one();
+					}
+				}
+
+				std::mutex _call;
+				std::mutex _mutex;
+				std::condition_variable _wake;
+				std::condition_variable _finished;
+				array_list<std::thread> _threads;
+				const std::function<void()> * _job = nullptr;
+				size_t _generation = 0;
+				unsigned _workers = 0;
+				unsigned _pending = 0;
+				bool _stop = false;
+			};
+
+			void flatten(const fmat * local, const uint32_t * parents, fmat * world, size_t count, unsigned threads)
+			{
+				static const size_t chunk = 2048;
+
+				auto & k = kernels();
+				size_t chunks = (count + chunk - 1) / chunk;
+
+				if(threads == 0)
+					threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+				if(threads > chunks)
+					threads = static_cast<unsigned>(chunks);
+
+				if(threads <= 1)
+				{
+					k.flatten(data(local), parents, data(world), stride, 0, count);
+					return;
+				}
+
+				// chunks are taken in order, so a chunk waits only for chunks which are already being processed
+				std::unique_ptr<std::atomic<bool>[]> done(new std::atomic<bool>[chunks]);
+				std::atomic<size_t> next {0};
+
+				for(size_t c = 0; c < chunks; ++c)
+					done[c].store(false, std::memory_order_relaxed);
+
+				std::function<void()> process = [&]() {
+					for(size_t c = next++; c < chunks; c = next++)
+					{
+						size_t begin = c * chunk;
+						size_t end = std::min(begin + chunk, count);
+
+						for(size_t i = begin; i < end; ++i)
+						{
+							auto p = parents[i];
+
+							if(p == no_parent || p >= begin)
+								continue;
+
+							while(!done[p / chunk].load(std::memory_order_acquire))
+								std::this_thread::yield();
+						}
+
+						k.flatten(data(local), parents, data(world), stride, begin, end);
+						done[c].store(true, std::memory_order_release);
+					}
+				};
+
+				flatten_workers::instance().run(threads, process);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,113 @@
+//---------------------------------------------------------------------------
+
+#include "batch_kernels.h"
+
+#include <immintrin.h>
+
+//---------------------------------------------------------------------------
+
+// Compiled with AVX2, FMA and F16C enabled, see CMakeLists.txt
+
+namespace asd
+{
+	namespace math
+	{
+		namespace internals
+		{
+			namespace
+			{
+				struct avx2_pack
+				{
+					using type = __m256;
+					using mask = __m256;
+
+					static const size_t width = 8;
+
+					static type load(const float * p) { return _mm256_loadu_ps(p); }
+					static void store(float * p, type a) { _mm256_storeu_ps(p, a); }
+					static type fill(float a) { return _mm256_set1_ps(a); }
+
+					static type add(type a, type b) { return _mm256_add_ps(a, b); }
+					static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+					static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+					static type div(type a, type b) { return _mm256_div_ps(a, b); }
+					static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+					static type fnmadd(type a, type b, type c) { return _mm256_fnmadd_ps(a, b, c); }
+					static type min(type a, type b) { return _mm256_min_ps(a, b); }
+					static type max(type a, type b) { return _mm256_max_ps(a, b); }
+					static type sqrt(type a) { return _mm256_sqrt_ps(a); }
+
+					static mask less(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+					static type select(mask m, type a, type b) { return _mm256_blendv_ps(b, a, m); }
+					static unsigned bits(mask m) { return _mm256_movemask_ps(m); }
+
+					// rows j and j + 4 share the register, so 4x4 blocks are transposed in both lanes
+					static void load_rows(const float * const * rows, type * out)
+					{
+						for(int j = 0; j < 4; ++j)
+							out[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(rows[j])), _mm_loadu_ps(rows[j + 4]), 1);
+
+						transpose(out);
+					}
+
+					static void store_rows(float * const * rows, const type * in)
+					{
+						type r[] = {in[0], in[1], in[2], in[3]};
+						transpose(r);
+
+						for(int j = 0; j < 4; ++j)
+						{
+							_mm_storeu_ps(rows[j], _mm256_castps256_ps128(r[j]));
+							_mm_storeu_ps(rows[j + 4], _mm256_extractf128_ps(r[j], 1));
+						}
+					}
+
+					// every 4 lanes hold a row of one matrix, see matrix kernels in batch_kernels.h
+					static const size_t matrices = 2;
+
+					static type load_lanes(const float * const * m, size_t offset)
+					{
+						return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m[0] + offset)), _mm_loadu_ps(m[1] + offset), 1);
+					}
+
+					static void store_lanes(float * const * m, size_t offset, type a, size_t count)
+					{
+						_mm_storeu_ps(m[0] + offset, _mm256_castps256_ps128(a));
+
+						if(count > 1)
+							_mm_storeu_ps(m[1] + offset, _mm256_extractf128_ps(a, 1));
+					}
+
+					static type fill_lanes(const float * row) { return _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(row)); }
+
+					template<int x, int y, int z, int w>
+					static type shuffle(type a, type b) { return _mm256_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x)); }
+
+					static type from_int(const int32_t * p) { return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))); }
+					static type load_half(const uint16_t * p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+
+					static void transpose(type * r)
+					{
+						auto t0 = _mm256_unpacklo_ps(r[0], r[1]);
+						auto t1 = _mm256_unpackhi_ps(r[0], r[1]);
+						auto t2 = _mm256_unpacklo_ps(r[2], r[3]);
+						auto t3 = _mm256_unpackhi_ps(r[2], r[3]);
+
+						r[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+						r[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+						r[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+						r[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+					}
+				};
+			}
+
+			const batch_kernels & avx2_batch_kernels()
+			{
+				static const batch_kernels kernels = make_batch_kernels<avx2_pack>();
+				return kernels;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+//---------------------------------------------------------------------------
+
+#include "batch_kernels.h"
+
+#include <immintrin.h>
+
+//---------------------------------------------------------------------------
+
+// Compiled with AVX-512F enabled, see CMakeLists.txt
+
+namespace asd
+{
+	namespace math
+	{
+		namespace internals
+		{
+			namespace
+			{
+				struct avx512_pack
+				{
+					using type = __m512;
+					using mask = __mmask16;
+
+					static const size_t width = 16;
+
+					static type load(const float * p) { return _mm512_loadu_ps(p); }
+					static void store(float * p, type a) { _mm512_storeu_ps(p, a); }
+					static type fill(float a) { return _mm512_set1_ps(a); }
+
+					static type add(type a, type b) { return _mm512_add_ps(a, b); }
+					static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+					static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+					static type div(type a, type b) { return _mm512_div_ps(a, b); }
+					static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+					static type fnmadd(type a, type b, type c) { return _mm512_fnmadd_ps(a, b, c); }
+					static type min(type a, type b) { return _mm512_min_ps(a, b); }
+					static type max(type a, type b) { return _mm512_max_ps(a, b); }
+					static type sqrt(type a) { return _mm512_sqrt_ps(a); }
+
+					static mask less(type a, type b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+					static type select(mask m, type a, type b) { return _mm512_mask_blend_ps(m, b, a); }
+					static unsigned bits(mask m) { return m; }
+
+					// rows j, j + 4, j + 8 and j + 12 share the register, so 4x4 blocks are transposed in all lanes
+					static void load_rows(const float * const * rows, type * out)
+					{
+						for(int j = 0; j < 4; ++j)
+						{
+							out[j] = _mm512_castps128_ps512(_mm_loadu_ps(rows[j]));
+							out[j] = _mm512_insertf32x4(out[j], _mm_loadu_ps(rows[j + 4]), 1);
+							out[j] = _mm512_insertf32x4(out[j], _mm_loadu_ps(rows[j + 8]), 2);
+							out[j] = _mm512_insertf32x4(out[j], _mm_loadu_ps(rows[j + 12]), 3);
+						}
+
+						transpose(out);
+					}
+
+					static void store_rows(float * const * rows, const type * in)
+					{
+						type r[] = {in[0], in[1], in[2], in[3]};
+						transpose(r);
+
+						for(int j = 0; j < 4; ++j)
+						{
+							_mm_storeu_ps(rows[j], _mm512_castps512_ps128(r[j]));
+							_mm_storeu_ps(rows[j + 4], _mm512_extractf32x4_ps(r[j], 1));
+							_mm_storeu_ps(rows[j + 8], _mm512_extractf32x4_ps(r[j], 2));
+							_mm_storeu_ps(rows[j + 12], _mm512_extractf32x4_ps(r[j], 3));
+						}
+					}
+
+					// every 4 lanes hold a row of one matrix, see matrix kernels in batch_kernels.h
+					static const size_t matrices = 4;
+
+					static type load_lanes(const float * const * m, size_t offset)
+					{
+						auto a = _mm512_castps128_ps512(_mm_loadu_ps(m[0] + offset));
+						a = _mm512_insertf32x4(a, _mm_loadu_ps(m[1] + offset), 1);
+						a = _mm512_insertf32x4(a, _mm_loadu_ps(m[2] + offset), 2);
+						return _mm512_insertf32x4(a, _mm_loadu_ps(m[3] + offset), 3);
+					}
+
+					static void store_lanes(float * const * m, size_t offset, type a, size_t count)
+					{
+						_mm_storeu_ps(m[0] + offset, _mm512_castps512_ps128(a));
+
+						if(count > 1)
+							_mm_storeu_ps(m[1] + offset, _mm512_extractf32x4_ps(a, 1));
+
+						if(count > 2)
+							_mm_storeu_ps(m[2] + offset, _mm512_extractf32x4_ps(a, 2));
+
+						if(count > 3)
+							_mm_storeu_ps(m[3] + offset, _mm512_extractf32x4_ps(a, 3));
+					}
+
+					static type fill_lanes(const float * row) { return _mm512_broadcast_f32x4(_mm_loadu_ps(row)); }
+
+					template<int x, int y, int z, int w>
+					static type shuffle(type a, type b) { return _mm512_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x)); }
+
+					static type from_int(const int32_t * p) { return _mm512_cvtepi32_ps(_mm512_loadu_si512(p)); }
+					static type load_half(const uint16_t * p) { return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))); }
+
+					static void transpose(type * r)
+					{
+						auto t0 = _mm512_unpacklo_ps(r[0], r[1]);
+						auto t1 = _mm512_unpackhi_ps(r[0], r[1]);
+						auto t2 = _mm512_unpacklo_ps(r[2], r[3]);
+						auto t3 = _mm512_unpackhi_ps(r[2], r[3]);
+
+						r[0] = _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+						r[1] = _mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+						r[2] = _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+						r[3] = _mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+					}
+				};
+			}
+
+			const batch_kernels & avx512_batch_kernels()
+			{
+				static const batch_kernels kernels = make_batch_kernels<avx512_pack>();
+				return kernels;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,1083 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MATH_BATCH_KERNELS_H
+#define MATH_BATCH_KERNELS_H
+
+//---------------------------------------------------------------------------
+
+/**
+ *	Kernels of batch math. This header is included by translation units
+ *	which are compiled for different instruction sets (batch_sse4.cpp,
+ *	batch_avx2.cpp, batch_avx512.cpp), so everything defined here has
+ *	internal linkage and only standard headers are included: the linker must
+ *	never pick an AVX-512 copy of an inline function for the SSE path.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		namespace internals
+		{
+			/**
+			 *	Table of kernels compiled for one instruction set
+			 */
+			struct batch_kernels
+			{
+				void (* transform_points)(const float * m, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count);
+				void (* transform_directions)(const float * m, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count);
+				void (* rotate)(const float * q, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count);
+				void (* rotate_each)(const float * qx, const float * qy, const float * qz, const float * qw, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count);
+				void (* rotate_by)(const float * q, const float * const * in, float * const * out, size_t count);
+				void (* normalize)(const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count);
+				void (* dot)(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * out, size_t count);
+				void (* cross)(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * ox, float * oy, float * oz, size_t count);
+				void (* lerp)(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float t, float * ox, float * oy, float * oz, size_t count);
+				void (* slerp)(const float * const * a, const float * const * b, float t, float * const * out, size_t count);
+				size_t (* cull_spheres)(const float * planes, unsigned mask, const float * x, const float * y, const float * z, const float * r, unsigned char * coherency, uint32_t * visible, size_t count);
+				size_t (* cull_boxes)(const float * planes, unsigned mask, const float * x, const float * y, const float * z, const float * ex, const float * ey, const float * ez, unsigned char * coherency, uint32_t * visible, size_t count);
+				void (* multiply)(const float * a, const float * b, float * out, size_t stride, size_t count);
+				void (* inverse)(const float * m, float * out, size_t stride, size_t count);
+				void (* inverse_transpose)(const float * m, float * out, size_t stride, size_t count);
+				void (* affine_inverse)(const float * m, float * out, size_t stride, size_t count);
+				void (* flatten)(const float * local, const uint32_t * parents, float * world, size_t stride, size_t begin, size_t end);
+				void (* decode_halves)(const uint16_t * in, float * out, size_t count);
+				void (* decode_quaternions32)(const uint32_t * in, float * out, size_t stride, size_t count);
+				void (* decode_quaternions48)(const uint16_t * in, float * out, size_t stride, size_t count);
+				void (* decode_positions)(const float * origin, float scale, const int16_t * in, float * out, size_t stride, size_t count);
+				size_t (* ray_boxes)(const float * origin, const float * inverse, float max_distance, const float * x0, const float * y0, const float * z0, const float * x1, const float * y1, const float * z1, uint32_t * hits, float * distances, size_t count);
+				size_t (* box_boxes)(const float * min, const float * max, const float * x0, const float * y0, const float * z0, const float * x1, const float * y1, const float * z1, uint32_t * hits, size_t count);
+				size_t (* sphere_spheres)(const float * sphere, const float * x, const float * y, const float * z, const float * r, uint32_t * hits, size_t count);
+			};
+
+			/**
+			 *	Parent of roots of hierarchies, see batch::no_parent
+			 */
+			const uint32_t no_parent = 0xFFFFFFFF;
+
+			const batch_kernels & scalar_batch_kernels();
+			const batch_kernels & sse4_batch_kernels();
+			const batch_kernels & avx2_batch_kernels();
+			const batch_kernels & avx512_batch_kernels();
+
+			namespace
+			{
+				// the same as math::from_half, which can't be used here
+				inline float half_to_float(uint16_t value)
+				{
+					const uint32_t shifted_exp = 0x7C00 << 13;
+
+					uint32_t o = (value & 0x7FFFu) << 13;
+					uint32_t exp = o & shifted_exp;
+					o += (127 - 15) << 23;
+
+					if(exp == shifted_exp)
+						o += (128 - 16) << 23;
+					else if(exp == 0)
+						o += 1 << 23;
+
+					float f;
+					std::memcpy(&f, &o, sizeof(f));
+
+					if(exp == 0)
+						f -= 6.103515625e-05f;
+
+					return (value & 0x8000) != 0 ? -f : f;
+				}
+
+				/**
+				 *	One-lane pack used for tails of arrays
+				 */
+				struct scalar_pack
+				{
+					using type = float;
+					using mask = bool;
+
+					static const size_t width = 1;
+
+					static type load(const float * p) { return *p; }
+					static void store(float * p, type a) { *p = a; }
+					static type fill(float a) { return a; }
+
+					static type add(type a, type b) { return a + b; }
+					static type sub(type a, type b) { return a - b; }
+					static type mul(type a, type b) { return a * b; }
+					static type div(type a, type b) { return a / b; }
+					static type fmadd(type a, type b, type c) { return a * b + c; }
+					static type fnmadd(type a, type b, type c) { return c - a * b; }
+					static type min(type a, type b) { return a < b ? a : b; }
+					static type max(type a, type b) { return a > b ? a : b; }
+					static type sqrt(type a) { return std::sqrt(a); }
+
+					static mask less(type a, type b) { return a < b; }
+					static type select(mask m, type a, type b) { return m ? a : b; }
+					static unsigned bits(mask m) { return m ? 1 : 0; }
+
+					// rows of 4 floats, one per lane, are transposed: out[c] holds c-th elements of all rows
+					static void load_rows(const float * const * rows, type * out) { for(int c = 0; c < 4; ++c) out[c] = rows[0][c]; }
+					static void store_rows(float * const * rows, const type * in) { for(int c = 0; c < 4; ++c) rows[0][c] = in[c]; }
+
+					static type from_int(const int32_t * p) { return static_cast<float>(*p); }
+					static type load_half(const uint16_t * p) { return half_to_float(*p); }
+				};
+
+				/**
+				 *	Calls body(Pack(), i) for every full pack of <count> elements
+				 *	and body(scalar_pack(), i) for the rest
+				 */
+				template<class Pack, class F>
+				inline void for_each_pack(size_t count, F && body)
+				{
+					size_t i = 0;
+
+					for(; i + Pack::width <= count; i += Pack::width)
+						body(Pack(), i);
+
+					for(; i < count; ++i)
+						body(scalar_pack(), i);
+				}
+
+				template<class P>
+				inline void cross3(typename P::type ax, typename P::type ay, typename P::type az, typename P::type bx, typename P::type by, typename P::type bz, typename P::type & ox, typename P::type & oy, typename P::type & oz)
+				{
+					ox = P::fnmadd(az, by, P::mul(ay, bz));
+					oy = P::fnmadd(ax, bz, P::mul(az, bx));
+					oz = P::fnmadd(ay, bx, P::mul(ax, by));
+				}
+
+				/**
+				 *	sin(x) for x in [0, pi/2], error < 1e-7
+				 */
+				template<class P>
+				inline typename P::type sin_quadrant(typename P::type x)
+				{
+					auto x2 = P::mul(x, x);
+					auto r = P::fill(-2.5052108e-8f);
+					r = P::fmadd(r, x2, P::fill(2.7557319e-6f));
+					r = P::fmadd(r, x2, P::fill(-1.9841270e-4f));
+					r = P::fmadd(r, x2, P::fill(8.3333333e-3f));
+					r = P::fmadd(r, x2, P::fill(-1.6666667e-1f));
+					r = P::fmadd(r, x2, P::fill(1.0f));
+
+					return P::mul(r, x);
+				}
+
+				/**
+				 *	acos(x) for x in [0, 1], error < 1e-7 (Abramowitz & Stegun 4.4.46)
+				 */
+				template<class P>
+				inline typename P::type acos_positive(typename P::type x)
+				{
+					auto r = P::fill(-0.0012624911f);
+					r = P::fmadd(r, x, P::fill(0.0066700901f));
+					r = P::fmadd(r, x, P::fill(-0.0170881256f));
+					r = P::fmadd(r, x, P::fill(0.0308918810f));
+					r = P::fmadd(r, x, P::fill(-0.0501743046f));
+					r = P::fmadd(r, x, P::fill(0.0889789874f));
+					r = P::fmadd(r, x, P::fill(-0.2145988016f));
+					r = P::fmadd(r, x, P::fill(1.5707963050f));
+
+					return P::mul(r, P::sqrt(P::sub(P::fill(1.0f), x)));
+				}
+
+				template<class Pack>
+				void transform_points(const float * m, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto vx = P::load(x + i);
+						auto vy = P::load(y + i);
+						auto vz = P::load(z + i);
+
+						P::store(ox + i, P::fmadd(P::fill(m[0]), vx, P::fmadd(P::fill(m[1]), vy, P::fmadd(P::fill(m[2]), vz, P::fill(m[3])))));
+						P::store(oy + i, P::fmadd(P::fill(m[4]), vx, P::fmadd(P::fill(m[5]), vy, P::fmadd(P::fill(m[6]), vz, P::fill(m[7])))));
+						P::store(oz + i, P::fmadd(P::fill(m[8]), vx, P::fmadd(P::fill(m[9]), vy, P::fmadd(P::fill(m[10]), vz, P::fill(m[11])))));
+					});
+				}
+
+				template<class Pack>
+				void transform_directions(const float * m, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto vx = P::load(x + i);
+						auto vy = P::load(y + i);
+						auto vz = P::load(z + i);
+
+						P::store(ox + i, P::fmadd(P::fill(m[0]), vx, P::fmadd(P::fill(m[1]), vy, P::mul(P::fill(m[2]), vz))));
+						P::store(oy + i, P::fmadd(P::fill(m[4]), vx, P::fmadd(P::fill(m[5]), vy, P::mul(P::fill(m[6]), vz))));
+						P::store(oz + i, P::fmadd(P::fill(m[8]), vx, P::fmadd(P::fill(m[9]), vy, P::mul(P::fill(m[10]), vz))));
+					});
+				}
+
+				// v + 2w * (q x v) + 2q x (q x v), the same as quaternion::apply_to
+				template<class P>
+				inline void rotate_one(typename P::type qx, typename P::type qy, typename P::type qz, typename P::type qw, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t i)
+				{
+					auto vx = P::load(x + i);
+					auto vy = P::load(y + i);
+					auto vz = P::load(z + i);
+
+					typename P::type tx, ty, tz, cx, cy, cz;
+					cross3<P>(qx, qy, qz, vx, vy, vz, tx, ty, tz);
+
+					auto two = P::fill(2.0f);
+					tx = P::mul(tx, two);
+					ty = P::mul(ty, two);
+					tz = P::mul(tz, two);
+
+					cross3<P>(qx, qy, qz, tx, ty, tz, cx, cy, cz);
+
+					P::store(ox + i, P::add(P::fmadd(qw, tx, vx), cx));
+					P::store(oy + i, P::add(P::fmadd(qw, ty, vy), cy));
+					P::store(oz + i, P::add(P::fmadd(qw, tz, vz), cz));
+				}
+
+				template<class Pack>
+				void rotate(const float * q, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+						rotate_one<P>(P::fill(q[0]), P::fill(q[1]), P::fill(q[2]), P::fill(q[3]), x, y, z, ox, oy, oz, i);
+					});
+				}
+
+				template<class Pack>
+				void rotate_each(const float * qx, const float * qy, const float * qz, const float * qw, const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+						rotate_one<P>(P::load(qx + i), P::load(qy + i), P::load(qz + i), P::load(qw + i), x, y, z, ox, oy, oz, i);
+					});
+				}
+
+				// q * r, the same as r.rotate_by(q)
+				template<class Pack>
+				void rotate_by(const float * q, const float * const * in, float * const * out, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto qx = P::fill(q[0]);
+						auto qy = P::fill(q[1]);
+						auto qz = P::fill(q[2]);
+						auto qw = P::fill(q[3]);
+
+						auto x = P::load(in[0] + i);
+						auto y = P::load(in[1] + i);
+						auto z = P::load(in[2] + i);
+						auto w = P::load(in[3] + i);
+
+						P::store(out[0] + i, P::fnmadd(qz, y, P::fmadd(qy, z, P::fmadd(qx, w, P::mul(qw, x)))));
+						P::store(out[1] + i, P::fnmadd(qx, z, P::fmadd(qz, x, P::fmadd(qy, w, P::mul(qw, y)))));
+						P::store(out[2] + i, P::fnmadd(qy, x, P::fmadd(qx, y, P::fmadd(qz, w, P::mul(qw, z)))));
+						P::store(out[3] + i, P::fnmadd(qz, z, P::fnmadd(qy, y, P::fnmadd(qx, x, P::mul(qw, w)))));
+					});
+				}
+
+				template<class Pack>
+				void normalize(const float * x, const float * y, const float * z, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto vx = P::load(x + i);
+						auto vy = P::load(y + i);
+						auto vz = P::load(z + i);
+
+						auto k = P::div(P::fill(1.0f), P::sqrt(P::fmadd(vx, vx, P::fmadd(vy, vy, P::mul(vz, vz)))));
+
+						P::store(ox + i, P::mul(vx, k));
+						P::store(oy + i, P::mul(vy, k));
+						P::store(oz + i, P::mul(vz, k));
+					});
+				}
+
+				template<class Pack>
+				void dot(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * out, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+						P::store(out + i, P::fmadd(P::load(ax + i), P::load(bx + i), P::fmadd(P::load(ay + i), P::load(by + i), P::mul(P::load(az + i), P::load(bz + i)))));
+					});
+				}
+
+				template<class Pack>
+				void cross(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						typename P::type cx, cy, cz;
+						cross3<P>(P::load(ax + i), P::load(ay + i), P::load(az + i), P::load(bx + i), P::load(by + i), P::load(bz + i), cx, cy, cz);
+
+						P::store(ox + i, cx);
+						P::store(oy + i, cy);
+						P::store(oz + i, cz);
+					});
+				}
+
+				template<class Pack>
+				void lerp(const float * ax, const float * ay, const float * az, const float * bx, const float * by, const float * bz, float t, float * ox, float * oy, float * oz, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto k = P::fill(t);
+						auto vx = P::load(ax + i);
+						auto vy = P::load(ay + i);
+						auto vz = P::load(az + i);
+
+						P::store(ox + i, P::fmadd(P::sub(P::load(bx + i), vx), k, vx));
+						P::store(oy + i, P::fmadd(P::sub(P::load(by + i), vy), k, vy));
+						P::store(oz + i, P::fmadd(P::sub(P::load(bz + i), vz), k, vz));
+					});
+				}
+
+				/**
+				 *	Spherical interpolation of unit quaternions by the shortest arc,
+				 *	falls back to normalized lerp for close quaternions.
+				 */
+				template<class Pack>
+				void slerp(const float * const * a, const float * const * b, float t, float * const * out, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						typename P::type qa[4], qb[4];
+
+						for(int c = 0; c < 4; ++c)
+						{
+							qa[c] = P::load(a[c] + i);
+							qb[c] = P::load(b[c] + i);
+						}
+
+						auto cosine = P::fmadd(qa[0], qb[0], P::fmadd(qa[1], qb[1], P::fmadd(qa[2], qb[2], P::mul(qa[3], qb[3]))));
+						auto sign = P::select(P::less(cosine, P::fill(0.0f)), P::fill(-1.0f), P::fill(1.0f));
+						cosine = P::min(P::mul(cosine, sign), P::fill(1.0f));
+
+						auto kt = P::fill(t);
+						auto ks = P::fill(1.0f - t);
+
+						auto theta = acos_positive<P>(cosine);
+						auto inv = P::div(P::fill(1.0f), sin_quadrant<P>(theta));
+						auto linear = P::less(P::fill(0.9995f), cosine);
+
+						auto wa = P::select(linear, ks, P::mul(sin_quadrant<P>(P::mul(ks, theta)), inv));
+						auto wb = P::mul(P::select(linear, kt, P::mul(sin_quadrant<P>(P::mul(kt, theta)), inv)), sign);
+
+						typename P::type r[4];
+
+						for(int c = 0; c < 4; ++c)
+							r[c] = P::fmadd(qa[c], wa, P::mul(qb[c], wb));
+
+						auto k = P::div(P::fill(1.0f), P::sqrt(P::fmadd(r[0], r[0], P::fmadd(r[1], r[1], P::fmadd(r[2], r[2], P::mul(r[3], r[3]))))));
+
+						for(int c = 0; c < 4; ++c)
+							P::store(out[c] + i, P::mul(r[c], k));
+					});
+				}
+
+				/**
+				 *	Appends indices of lanes of the pack at <i> which are set in
+				 *	<lanes> to <out> without branches and returns their count
+				 */
+				template<class P>
+				inline size_t append_indices(unsigned lanes, size_t i, uint32_t * out)
+				{
+					size_t n = 0;
+
+					for(size_t j = 0; j < P::width; ++j)
+					{
+						out[n] = static_cast<uint32_t>(i + j);
+						n += (lanes >> j) & 1;
+					}
+
+					return n;
+				}
+
+				/**
+				 *	Culling of volumes of the pack at <i> by planes of <mask>.
+				 *	<distance>(plane) returns the signed distance from the plane to
+				 *	the farthest point of each volume, volumes with negative
+				 *	distances are outside. Planes are tested starting from the one
+				 *	which culled the first volume of the pack last time (plane
+				 *	coherency), testing stops once all volumes are outside.
+				 *	Indices of visible volumes are appended to <visible>.
+				 */
+				template<class P, class F>
+				inline size_t cull_pack(const float * planes, unsigned mask, unsigned char * coherency, uint32_t * visible, size_t i, F && distance)
+				{
+					const unsigned all = (1u << P::width) - 1;
+
+					unsigned first = coherency != nullptr ? coherency[i] : 0;
+					unsigned outside = 0;
+
+					for(unsigned k = 0; k < 6; ++k)
+					{
+						unsigned index = first + k < 6 ? first + k : first + k - 6;
+
+						if((mask & (1u << index)) == 0)
+							continue;
+
+						outside |= P::bits(P::less(distance(planes + index * 4), P::fill(0.0f)));
+
+						if(outside == all)
+						{
+							if(coherency != nullptr)
+							{
+								for(size_t j = 0; j < P::width; ++j)
+									coherency[i + j] = static_cast<unsigned char>(index);
+							}
+
+							return 0;
+						}
+					}
+
+					return append_indices<P>(~outside & all, i, visible);
+				}
+
+				template<class Pack>
+				size_t cull_spheres(const float * planes, unsigned mask, const float * x, const float * y, const float * z, const float * r, unsigned char * coherency, uint32_t * visible, size_t count)
+				{
+					size_t n = 0;
+
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto vx = P::load(x + i);
+						auto vy = P::load(y + i);
+						auto vz = P::load(z + i);
+						auto vr = P::load(r + i);
+
+						n += cull_pack<P>(planes, mask, coherency, visible + n, i, [&](const float * plane) {
+							return P::fmadd(P::fill(plane[0]), vx, P::fmadd(P::fill(plane[1]), vy, P::fmadd(P::fill(plane[2]), vz, P::add(P::fill(plane[3]), vr))));
+						});
+					});
+
+					return n;
+				}
+
+				/**
+				 *	Boxes are given by centers and extents (half-sizes), the extent
+				 *	projected on the normal of a plane is |n.x| ex + |n.y| ey + |n.z| ez
+				 */
+				template<class Pack>
+				size_t cull_boxes(const float * planes, unsigned mask, const float * x, const float * y, const float * z, const float * ex, const float * ey, const float * ez, unsigned char * coherency, uint32_t * visible, size_t count)
+				{
+					size_t n = 0;
+
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto vx = P::load(x + i);
+						auto vy = P::load(y + i);
+						auto vz = P::load(z + i);
+						auto vex = P::load(ex + i);
+						auto vey = P::load(ey + i);
+						auto vez = P::load(ez + i);
+
+						n += cull_pack<P>(planes, mask, coherency, visible + n, i, [&](const float * plane) {
+							auto d = P::fmadd(P::fill(plane[0]), vx, P::fmadd(P::fill(plane[1]), vy, P::fmadd(P::fill(plane[2]), vz, P::fill(plane[3]))));
+							return P::fmadd(P::fill(std::abs(plane[0])), vex, P::fmadd(P::fill(std::abs(plane[1])), vey, P::fmadd(P::fill(std::abs(plane[2])), vez, d)));
+						});
+					});
+
+					return n;
+				}
+
+				/**
+				 *	Slab test of one ray against many boxes given by their min and
+				 *	max corners. <inverse> holds reciprocals of components of the
+				 *	direction, rays parallel to faces give infinities there. Entry
+				 *	distances (0 for boxes containing the origin) are written for
+				 *	hits if <distances> isn't null.
+				 */
+				template<class Pack>
+				size_t ray_boxes(const float * origin, const float * inverse, float max_distance, const float * x0, const float * y0, const float * z0, const float * x1, const float * y1, const float * z1, uint32_t * hits, float * distances, size_t count)
+				{
+					const float * lo[] = {x0, y0, z0};
+					const float * hi[] = {x1, y1, z1};
+
+					size_t n = 0;
+
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto near = P::fill(0.0f);
+						auto far = P::fill(max_distance);
+
+						for(int c = 0; c < 3; ++c)
+						{
+							auto o = P::fill(origin[c]);
+							auto k = P::fill(inverse[c]);
+
+							auto t0 = P::mul(P::sub(P::load(lo[c] + i), o), k);
+							auto t1 = P::mul(P::sub(P::load(hi[c] + i), o), k);
+
+							// rays parallel to a face which start exactly on its plane get NaNs (0 * infinity) and may go either way
+							near = P::max(P::min(t0, t1), near);
+							far = P::min(P::max(t0, t1), far);
+						}
+
+						const unsigned all = (1u << P::width) - 1;
+						auto lanes = ~P::bits(P::less(far, near)) & all;
+
+						if(distances != nullptr)
+						{
+							float d[P::width];
+							P::store(d, near);
+
+							for(size_t j = 0, k = n; j < P::width; ++j)
+							{
+								distances[k] = d[j];
+								k += (lanes >> j) & 1;
+							}
+						}
+
+						n += append_indices<P>(lanes, i, hits + n);
+					});
+
+					return n;
+				}
+
+				/**
+				 *	Overlaps of the box [min, max] with many boxes given by their
+				 *	min and max corners
+				 */
+				template<class Pack>
+				size_t box_boxes(const float * min, const float * max, const float * x0, const float * y0, const float * z0, const float * x1, const float * y1, const float * z1, uint32_t * hits, size_t count)
+				{
+					const float * lo[] = {x0, y0, z0};
+					const float * hi[] = {x1, y1, z1};
+
+					size_t n = 0;
+
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						unsigned separated = 0;
+
+						for(int c = 0; c < 3; ++c)
+						{
+							separated |= P::bits(P::less(P::fill(max[c]), P::load(lo[c] + i)));
+							separated |= P::bits(P::less(P::load(hi[c] + i), P::fill(min[c])));
+						}
+
+						const unsigned all = (1u << P::width) - 1;
+						n += append_indices<P>(~separated & all, i, hits + n);
+					});
+
+					return n;
+				}
+
+				/**
+				 *	Overlaps of the sphere [x, y, z, radius] with many spheres
+				 */
+				template<class Pack>
+				size_t sphere_spheres(const float * sphere, const float * x, const float * y, const float * z, const float * r, uint32_t * hits, size_t count)
+				{
+					size_t n = 0;
+
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						auto dx = P::sub(P::load(x + i), P::fill(sphere[0]));
+						auto dy = P::sub(P::load(y + i), P::fill(sphere[1]));
+						auto dz = P::sub(P::load(z + i), P::fill(sphere[2]));
+						auto rr = P::add(P::load(r + i), P::fill(sphere[3]));
+
+						auto distance = P::fmadd(dx, dx, P::fmadd(dy, dy, P::mul(dz, dz)));
+						auto lanes = ~P::bits(P::less(P::mul(rr, rr), distance)) & ((1u << P::width) - 1);
+
+						n += append_indices<P>(lanes, i, hits + n);
+					});
+
+					return n;
+				}
+
+				/**
+				 *	Matrix kernels don't transpose matrices: every 4 lanes of a pack
+				 *	hold a row of one matrix, so a pack holds rows of P::matrices
+				 *	matrices and the kernels are the same as the ones of math::matrix.
+				 *	Groups of matrices are given by their addresses <m>, the last
+				 *	group of an array repeats its last matrix.
+				 */
+				template<class P, class T>
+				inline void matrix_group(T * m, size_t stride, size_t n, T ** out)
+				{
+					for(size_t j = 0; j < P::matrices; ++j)
+						out[j] = m + (j < n ? j : n - 1) * stride;
+				}
+
+				template<class P>
+				inline void load_matrices(const float * const * m, typename P::type * out)
+				{
+					out[0] = P::load_lanes(m, 0);
+					out[1] = P::load_lanes(m, 4);
+					out[2] = P::load_lanes(m, 8);
+					out[3] = P::load_lanes(m, 12);
+				}
+
+				/**
+				 *	Stores rows of the first <n> matrices of the group
+				 */
+				template<class P>
+				inline void store_matrices(float * const * m, const typename P::type * in, size_t n)
+				{
+					P::store_lanes(m, 0, in[0], n);
+					P::store_lanes(m, 4, in[1], n);
+					P::store_lanes(m, 8, in[2], n);
+					P::store_lanes(m, 12, in[3], n);
+				}
+
+				/**
+				 *	Calls body(i, n) for groups of n matrices starting at i
+				 */
+				template<class P, class F>
+				inline void for_each_group(size_t count, F && body)
+				{
+					for(size_t i = 0; i < count; i += P::matrices)
+						body(i, count - i < P::matrices ? count - i : P::matrices);
+				}
+
+				template<int Axis, class P>
+				inline typename P::type spread(typename P::type a)
+				{
+					return P::template shuffle<Axis, Axis, Axis, Axis>(a, a);
+				}
+
+				// dot products of rows in all lanes of them
+				template<class P>
+				inline typename P::type dot4(typename P::type a, typename P::type b)
+				{
+					auto d = P::mul(a, b);
+					d = P::add(d, P::template shuffle<1, 0, 3, 2>(d, d));
+					return P::add(d, P::template shuffle<2, 3, 0, 1>(d, d));
+				}
+
+				template<class P>
+				inline typename P::type cross4(typename P::type a, typename P::type b)
+				{
+					return P::fnmadd(P::template shuffle<2, 0, 1, 3>(a, a), P::template shuffle<1, 2, 0, 3>(b, b), P::mul(P::template shuffle<1, 2, 0, 3>(a, a), P::template shuffle<2, 0, 1, 3>(b, b)));
+				}
+
+				// row of a * b
+				template<class P>
+				inline typename P::type multiply_row(const typename P::type * a, typename P::type b)
+				{
+					return P::fmadd(a[0], spread<0, P>(b), P::fmadd(a[1], spread<1, P>(b), P::fmadd(a[2], spread<2, P>(b), P::mul(a[3], spread<3, P>(b)))));
+				}
+
+				/**
+				 *	out = a * b, the same as math::operator *(matrix, matrix)
+				 */
+				template<class P>
+				inline void multiply_matrices(const typename P::type * a, const typename P::type * b, typename P::type * out)
+				{
+					out[0] = multiply_row<P>(a, b[0]);
+					out[1] = multiply_row<P>(a, b[1]);
+					out[2] = multiply_row<P>(a, b[2]);
+					out[3] = multiply_row<P>(a, b[3]);
+				}
+
+				// a.shuffle<1, 0, 3, 2>() - a.shuffle<3, 2, 1, 0>()
+				template<class P>
+				inline typename P::type cross_pairs(typename P::type a)
+				{
+					return P::sub(P::template shuffle<1, 0, 3, 2>(a, a), P::template shuffle<3, 2, 1, 0>(a, a));
+				}
+
+				/**
+				 *	The same as math::matrix::get_inverse. Rows of the transposed
+				 *	matrix are its columns, so the inverse transposition is computed
+				 *	without transpositions.
+				 */
+				template<class P, bool Transposed>
+				inline void invert_matrices(const typename P::type * v, typename P::type * m)
+				{
+					typename P::type r[4], temp;
+
+					if(Transposed)
+					{
+						r[0] = v[0];
+						r[1] = P::template shuffle<2, 3, 0, 1>(v[1], v[1]);
+						r[2] = v[2];
+						r[3] = P::template shuffle<2, 3, 0, 1>(v[3], v[3]);
+					}
+					else
+					{
+						temp = P::template shuffle<0, 1, 0, 1>(v[0], v[1]);
+						r[1] = P::template shuffle<0, 1, 0, 1>(v[2], v[3]);
+						r[0] = P::template shuffle<0, 2, 0, 2>(temp, r[1]);
+						r[1] = P::template shuffle<1, 3, 1, 3>(r[1], temp);
+						temp = P::template shuffle<2, 3, 2, 3>(v[0], v[1]);
+						r[3] = P::template shuffle<2, 3, 2, 3>(v[2], v[3]);
+						r[2] = P::template shuffle<0, 2, 0, 2>(temp, r[3]);
+						r[3] = P::template shuffle<1, 3, 1, 3>(r[3], temp);
+					}
+
+					auto zero = P::fill(0.0f);
+
+					temp = cross_pairs<P>(P::mul(r[2], r[3]));
+					m[0] = P::fnmadd(r[1], temp, zero);
+					m[1] = P::fnmadd(r[0], temp, zero);
+					m[1] = P::template shuffle<2, 3, 0, 1>(m[1], m[1]);
+
+					temp = cross_pairs<P>(P::mul(r[1], r[2]));
+					m[0] = P::fmadd(r[3], temp, m[0]);
+					m[3] = P::mul(r[0], temp);
+					m[3] = P::template shuffle<2, 3, 0, 1>(m[3], m[3]);
+
+					temp = cross_pairs<P>(P::mul(P::template shuffle<2, 3, 0, 1>(r[1], r[1]), r[3]));
+					r[2] = P::template shuffle<2, 3, 0, 1>(r[2], r[2]);
+					m[0] = P::fmadd(r[2], temp, m[0]);
+					m[2] = P::mul(r[0], temp);
+					m[2] = P::template shuffle<2, 3, 0, 1>(m[2], m[2]);
+
+					temp = cross_pairs<P>(P::mul(r[0], r[1]));
+					m[2] = P::fnmadd(r[3], temp, m[2]);
+					m[3] = P::fmadd(r[2], temp, m[3]);
+
+					temp = cross_pairs<P>(P::mul(r[0], r[3]));
+					m[1] = P::fnmadd(r[2], temp, m[1]);
+					m[2] = P::fmadd(r[1], temp, m[2]);
+
+					temp = cross_pairs<P>(P::mul(r[0], r[2]));
+					m[1] = P::fmadd(r[3], temp, m[1]);
+					m[3] = P::fnmadd(r[1], temp, m[3]);
+
+					auto k = P::div(P::fill(1.0f), dot4<P>(r[0], m[0]));
+
+					m[0] = P::mul(m[0], k);
+					m[1] = P::mul(m[1], k);
+					m[2] = P::mul(m[2], k);
+					m[3] = P::mul(m[3], k);
+				}
+
+				template<class P>
+				inline void transpose_matrices(const typename P::type * m, typename P::type * out)
+				{
+					auto v0 = P::template shuffle<0, 1, 0, 1>(m[0], m[1]);
+					auto v1 = P::template shuffle<2, 3, 2, 3>(m[0], m[1]);
+					auto v2 = P::template shuffle<0, 1, 0, 1>(m[2], m[3]);
+					auto v3 = P::template shuffle<2, 3, 2, 3>(m[2], m[3]);
+
+					out[0] = P::template shuffle<0, 2, 0, 2>(v0, v2);
+					out[1] = P::template shuffle<1, 3, 1, 3>(v0, v2);
+					out[2] = P::template shuffle<0, 2, 0, 2>(v1, v3);
+					out[3] = P::template shuffle<1, 3, 1, 3>(v1, v3);
+				}
+
+				template<class Pack>
+				void multiply(const float * a, const float * b, float * out, size_t stride, size_t count)
+				{
+					using P = Pack;
+
+					for_each_group<P>(count, [&](size_t i, size_t n) {
+						const float * ga[P::matrices], * gb[P::matrices];
+						float * go[P::matrices];
+
+						matrix_group<P>(a + i * stride, stride, n, ga);
+						matrix_group<P>(b + i * stride, stride, n, gb);
+						matrix_group<P>(out + i * stride, stride, n, go);
+
+						typename P::type ma[4], mb[4], r[4];
+						load_matrices<P>(ga, ma);
+						load_matrices<P>(gb, mb);
+						multiply_matrices<P>(ma, mb, r);
+						store_matrices<P>(go, r, n);
+					});
+				}
+
+				template<class Pack, bool Transposed>
+				void inverse(const float * m, float * out, size_t stride, size_t count)
+				{
+					using P = Pack;
+
+					for_each_group<P>(count, [&](size_t i, size_t n) {
+						const float * gm[P::matrices];
+						float * go[P::matrices];
+
+						matrix_group<P>(m + i * stride, stride, n, gm);
+						matrix_group<P>(out + i * stride, stride, n, go);
+
+						typename P::type a[4], r[4];
+						load_matrices<P>(gm, a);
+						invert_matrices<P, Transposed>(a, r);
+						store_matrices<P>(go, r, n);
+					});
+				}
+
+				/**
+				 *	The same as math::matrix::get_affine_inverse: the last row is
+				 *	[0, 0, 0, 1], columns of the inverted 3x3 part are cross products
+				 *	of its rows
+				 */
+				template<class Pack>
+				void affine_inverse(const float * m, float * out, size_t stride, size_t count)
+				{
+					using P = Pack;
+
+					static const float xyz[4] = {1, 1, 1, 0};
+					static const float w[4] = {0, 0, 0, 1};
+
+					auto clear_w = P::fill_lanes(xyz);
+					auto positive_w = P::fill_lanes(w);
+
+					for_each_group<P>(count, [&](size_t i, size_t n) {
+						const float * gm[P::matrices];
+						float * go[P::matrices];
+
+						matrix_group<P>(m + i * stride, stride, n, gm);
+						matrix_group<P>(out + i * stride, stride, n, go);
+
+						typename P::type a[4], c[4];
+						load_matrices<P>(gm, a);
+
+						auto a0 = P::mul(a[0], clear_w);
+						auto a1 = P::mul(a[1], clear_w);
+						auto a2 = P::mul(a[2], clear_w);
+
+						c[0] = cross4<P>(a1, a2);
+						c[1] = cross4<P>(a2, a0);
+						c[2] = cross4<P>(a0, a1);
+
+						auto k = P::div(P::fill(1.0f), dot4<P>(a0, c[0]));
+
+						c[0] = P::mul(c[0], k);
+						c[1] = P::mul(c[1], k);
+						c[2] = P::mul(c[2], k);
+
+						c[3] = P::fnmadd(c[0], spread<3, P>(a[0]), P::fnmadd(c[1], spread<3, P>(a[1]), P::fnmadd(c[2], spread<3, P>(a[2]), positive_w)));
+
+						typename P::type r[4];
+						transpose_matrices<P>(c, r);
+						store_matrices<P>(go, r, n);
+					});
+				}
+
+				/**
+				 *	world[i] = local[i] * world[parents[i]] for nodes in [begin, end),
+				 *	world matrices of parents outside of the range must be computed
+				 *	already. A group of nodes ends before the first node whose parent
+				 *	is in the group.
+				 */
+				template<class Pack>
+				void flatten(const float * local, const uint32_t * parents, float * world, size_t stride, size_t begin, size_t end)
+				{
+					using P = Pack;
+
+					static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+					for(size_t i = begin; i < end;)
+					{
+						size_t n = 1;
+
+						while(n < P::matrices && i + n < end && (parents[i + n] == no_parent || parents[i + n] < i))
+							++n;
+
+						const float * gl[P::matrices], * gp[P::matrices];
+						float * gw[P::matrices];
+
+						matrix_group<P>(local + i * stride, stride, n, gl);
+						matrix_group<P>(world + i * stride, stride, n, gw);
+
+						for(size_t j = 0; j < P::matrices; ++j)
+						{
+							auto p = parents[i + (j < n ? j : n - 1)];
+							gp[j] = p == no_parent ? identity : world + p * stride;
+						}
+
+						typename P::type ml[4], mp[4], r[4];
+						load_matrices<P>(gl, ml);
+						load_matrices<P>(gp, mp);
+						multiply_matrices<P>(ml, mp, r);
+						store_matrices<P>(gw, r, n);
+
+						i += n;
+					}
+				}
+
+				template<class Pack>
+				void decode_halves(const uint16_t * in, float * out, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+						P::store(out + i, P::load_half(in + i));
+					});
+				}
+
+				/**
+				 *	Restores unit quaternions from fields of the smallest three
+				 *	encoding (see math::quaternion32): fields[0] is the index of
+				 *	the largest component, others are quantized to [0, max].
+				 *	Quaternions are stored at <out> with <stride>.
+				 */
+				template<class P>
+				inline void decode_smallest_three(const int32_t (& fields)[4][P::width], float max, float * out, size_t stride)
+				{
+					const float range = 0.70710678f;
+
+					auto k = P::fill(2 * range / max);
+					auto offset = P::fill(-range);
+
+					auto a = P::fmadd(P::from_int(fields[1]), k, offset);
+					auto b = P::fmadd(P::from_int(fields[2]), k, offset);
+					auto c = P::fmadd(P::from_int(fields[3]), k, offset);
+
+					auto s = P::fnmadd(a, a, P::fnmadd(b, b, P::fnmadd(c, c, P::fill(1.0f))));
+					auto largest = P::sqrt(P::select(P::less(s, P::fill(0.0f)), P::fill(0.0f), s));
+
+					// components before the largest one are shifted
+					auto index = P::from_int(fields[0]);
+					auto m0 = P::less(index, P::fill(0.5f));
+					auto m1 = P::less(index, P::fill(1.5f));
+					auto m2 = P::less(index, P::fill(2.5f));
+
+					typename P::type q[] = {
+						P::select(m0, largest, a),
+						P::select(m0, a, P::select(m1, largest, b)),
+						P::select(m1, b, P::select(m2, largest, c)),
+						P::select(m2, c, largest)
+					};
+
+					float * rows[P::width];
+
+					for(size_t j = 0; j < P::width; ++j)
+						rows[j] = out + j * stride;
+
+					P::store_rows(rows, q);
+				}
+
+				template<class Pack>
+				void decode_quaternions32(const uint32_t * in, float * out, size_t stride, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						int32_t fields[4][P::width];
+
+						for(size_t j = 0; j < P::width; ++j)
+						{
+							auto bits = in[i + j];
+
+							fields[0][j] = bits >> 30;
+							fields[1][j] = (bits >> 20) & 0x3FF;
+							fields[2][j] = (bits >> 10) & 0x3FF;
+							fields[3][j] = bits & 0x3FF;
+						}
+
+						decode_smallest_three<P>(fields, 0x3FF, out + i * stride, stride);
+					});
+				}
+
+				template<class Pack>
+				void decode_quaternions48(const uint16_t * in, float * out, size_t stride, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						int32_t fields[4][P::width];
+
+						for(size_t j = 0; j < P::width; ++j)
+						{
+							auto * bits = in + (i + j) * 3;
+
+							fields[0][j] = (bits[0] >> 15) | (bits[1] >> 15) << 1;
+							fields[1][j] = bits[0] & 0x7FFF;
+							fields[2][j] = bits[1] & 0x7FFF;
+							fields[3][j] = bits[2] & 0x7FFF;
+						}
+
+						decode_smallest_three<P>(fields, 0x7FFF, out + i * stride, stride);
+					});
+				}
+
+				/**
+				 *	out = origin + [x, y, z, 0] * scale, <origin> has 4 components
+				 */
+				template<class Pack>
+				void decode_positions(const float * origin, float scale, const int16_t * in, float * out, size_t stride, size_t count)
+				{
+					for_each_pack<Pack>(count, [&](auto p, size_t i) {
+						using P = decltype(p);
+
+						int32_t fields[3][P::width];
+
+						for(size_t j = 0; j < P::width; ++j)
+						{
+							for(int c = 0; c < 3; ++c)
+								fields[c][j] = in[(i + j) * 3 + c];
+						}
+
+						auto k = P::fill(scale);
+
+						typename P::type v[] = {
+							P::fmadd(P::from_int(fields[0]), k, P::fill(origin[0])),
+							P::fmadd(P::from_int(fields[1]), k, P::fill(origin[1])),
+							P::fmadd(P::from_int(fields[2]), k, P::fill(origin[2])),
+							P::fill(origin[3])
+						};
+
+						float * rows[P::width];
+
+						for(size_t j = 0; j < P::width; ++j)
+							rows[j] = out + (i + j) * stride;
+
+						P::store_rows(rows, v);
+					});
+				}
+
+				/**
+				 *	Matrix kernels use packs of <Rows>, which must hold whole rows
+				 *	of matrices
+				 */
+				template<class Pack, class Rows = Pack>
+				batch_kernels make_batch_kernels()
+				{
+					return {
+						&transform_points<Pack>,
+						&transform_directions<Pack>,
+						&rotate<Pack>,
+						&rotate_each<Pack>,
+						&rotate_by<Pack>,
+						&normalize<Pack>,
+						&dot<Pack>,
+						&cross<Pack>,
+						&lerp<Pack>,
+						&slerp<Pack>,
+						&cull_spheres<Pack>,
+						&cull_boxes<Pack>,
+						&multiply<Rows>,
+						&inverse<Rows, false>,
+						&inverse<Rows, true>,
+						&affine_inverse<Rows>,
+						&flatten<Rows>,
+						&decode_halves<Pack>,
+						&decode_quaternions32<Pack>,
+						&decode_quaternions48<Pack>,
+						&decode_positions<Pack>,
+						&ray_boxes<Pack>,
+						&box_boxes<Pack>,
+						&sphere_spheres<Pack>
+					};
+				}
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,102 @@
+//---------------------------------------------------------------------------
+
+#include "batch_kernels.h"
+
+#include <smmintrin.h>
+
+//---------------------------------------------------------------------------
+
+// Compiled with SSE4.1 enabled, see CMakeLists.txt
+
+namespace asd
+{
+	namespace math
+	{
+		namespace internals
+		{
+			namespace
+			{
+				struct sse4_pack
+				{
+					using type = __m128;
+					using mask = __m128;
+
+					static const size_t width = 4;
+
+					static type load(const float * p) { return _mm_loadu_ps(p); }
+					static void store(float * p, type a) { _mm_storeu_ps(p, a); }
+					static type fill(float a) { return _mm_set1_ps(a); }
+
+					static type add(type a, type b) { return _mm_add_ps(a, b); }
+					static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+					static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+					static type div(type a, type b) { return _mm_div_ps(a, b); }
+					static type fmadd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+					static type fnmadd(type a, type b, type c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+					static type min(type a, type b) { return _mm_min_ps(a, b); }
+					static type max(type a, type b) { return _mm_max_ps(a, b); }
+					static type sqrt(type a) { return _mm_sqrt_ps(a); }
+
+					static mask less(type a, type b) { return _mm_cmplt_ps(a, b); }
+					static type select(mask m, type a, type b) { return _mm_blendv_ps(b, a, m); }
+					static unsigned bits(mask m) { return _mm_movemask_ps(m); }
+
+					static void load_rows(const float * const * rows, type * out)
+					{
+						for(int j = 0; j < 4; ++j)
+							out[j] = _mm_loadu_ps(rows[j]);
+
+						_MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+					}
+
+					static void store_rows(float * const * rows, const type * in)
+					{
+						type r[] = {in[0], in[1], in[2], in[3]};
+						_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+
+						for(int j = 0; j < 4; ++j)
+							_mm_storeu_ps(rows[j], r[j]);
+					}
+
+					// every 4 lanes hold a row of one matrix, see matrix kernels in batch_kernels.h
+					static const size_t matrices = 1;
+
+					static type load_lanes(const float * const * m, size_t offset) { return _mm_loadu_ps(m[0] + offset); }
+					static void store_lanes(float * const * m, size_t offset, type a, size_t) { _mm_storeu_ps(m[0] + offset, a); }
+					static type fill_lanes(const float * row) { return _mm_loadu_ps(row); }
+
+					template<int x, int y, int z, int w>
+					static type shuffle(type a, type b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x)); }
+
+					static type from_int(const int32_t * p) { return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+
+					// there is no F16C, so it's half_to_float for 4 lanes
+					static type load_half(const uint16_t * p)
+					{
+						auto h = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+						auto shifted_exp = _mm_set1_epi32(0x7C00 << 13);
+
+						auto o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+						auto exp = _mm_and_si128(o, shifted_exp);
+						auto denormal = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+
+						o = _mm_add_epi32(o, _mm_set1_epi32((127 - 15) << 23));
+						o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exp, shifted_exp), _mm_set1_epi32((128 - 16) << 23)));
+						o = _mm_add_epi32(o, _mm_and_si128(denormal, _mm_set1_epi32(1 << 23)));
+
+						auto f = _mm_sub_ps(_mm_castsi128_ps(o), _mm_and_ps(_mm_castsi128_ps(denormal), _mm_set1_ps(6.103515625e-05f)));
+						return _mm_or_ps(f, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16)));
+					}
+				};
+			}
+
+			const batch_kernels & sse4_batch_kernels()
+			{
+				static const batch_kernels kernels = make_batch_kernels<sse4_pack>();
+				return kernels;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+//---------------------------------------------------------------------------
+
+#include <math/culling.h>
+#include <core/intrinsic/CpuFeatures.h>
+
+#include "batch_kernels.h"
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		namespace culling
+		{
+			static const simd_dispatch<const internals::batch_kernels & ()> kernels {
+				internals::scalar_batch_kernels,
+				internals::sse4_batch_kernels,
+				internals::avx2_batch_kernels,
+				internals::avx512_batch_kernels
+			};
+
+			// planes as [nx, ny, nz, d] * 6
+			static array<float, 24> plane_data(const ffrustum & f)
+			{
+				array<float, 24> data;
+
+				for(int i = 0; i < 6; ++i)
+				{
+					auto & e = f[i].equation;
+
+					data[i * 4 + 0] = e.x;
+					data[i * 4 + 1] = e.y;
+					data[i * 4 + 2] = e.z;
+					data[i * 4 + 3] = e.w;
+				}
+
+				return data;
+			}
+
+			size_t spheres(const ffrustum & f, const soa4<const float> & spheres, uint32_t * visible, byte * coherency, unsigned planes)
+			{
+				auto data = plane_data(f);
+				return kernels().cull_spheres(data.data(), planes, spheres.x, spheres.y, spheres.z, spheres.w, coherency, visible, spheres.size);
+			}
+
+			size_t boxes(const ffrustum & f, const soa3<const float> & centers, const soa3<const float> & extents, uint32_t * visible, byte * coherency, unsigned planes)
+			{
+				auto data = plane_data(f);
+				return kernels().cull_boxes(data.data(), planes, centers.x, centers.y, centers.z, extents.x, extents.y, extents.z, coherency, visible, centers.size);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+//---------------------------------------------------------------------------
+
+#include <math/intersection.h>
+#include <core/intrinsic/CpuFeatures.h>
+
+#include "batch_kernels.h"
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		namespace intersection
+		{
+			static const simd_dispatch<const internals::batch_kernels & ()> kernels {
+				internals::scalar_batch_kernels,
+				internals::sse4_batch_kernels,
+				internals::avx2_batch_kernels,
+				internals::avx512_batch_kernels
+			};
+
+			size_t ray_boxes(const fray & r, const soa3<const float> & min, const soa3<const float> & max, uint32_t * hits, float * distances, float max_distance)
+			{
+				const float origin[] = {r.origin.x, r.origin.y, r.origin.z};
+				const float inverse[] = {1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z};
+
+				return kernels().ray_boxes(origin, inverse, max_distance, min.x, min.y, min.z, max.x, max.y, max.z, hits, distances, min.size);
+			}
+
+			size_t box_boxes(const fbox & b, const soa3<const float> & min, const soa3<const float> & max, uint32_t * hits)
+			{
+				const float lo[] = {b.min.x, b.min.y, b.min.z};
+				const float hi[] = {b.max.x, b.max.y, b.max.z};
+
+				return kernels().box_boxes(lo, hi, min.x, min.y, min.z, max.x, max.y, max.z, hits, min.size);
+			}
+
+			size_t sphere_spheres(const fsphere & s, const soa4<const float> & spheres, uint32_t * hits)
+			{
+				const float sphere[] = {s.center.x, s.center.y, s.center.z, s.radius};
+				return kernels().sphere_spheres(sphere, spheres.x, spheres.y, spheres.z, spheres.w, hits, spheres.size);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -141,52 +141,46 @@ namespace asd
 		template<> const int_vector  vector_constants<int>::two_xyz = {2, 2, 2, 0};
 		template<> const int_vector  vector_constants<int>::minus_one = {-1, -1, -1, -1};
 
-#ifdef USE_AVX
-		template struct vector<double>;
-		template struct matrix<double>;
-		template struct Matrix2x2<double>;
-	
-		template<> const DoubleVector vector<double>::positive_x = { 1,  0,  0,  0 };
-		template<> const DoubleVector vector<double>::positive_y = { 0,  1,  0,  0 };
-		template<> const DoubleVector vector<double>::positive_z = { 0,  0,  1,  0 };
-		template<> const DoubleVector vector<double>::positive_w = { 0,  0,  0,  1 };
-		template<> const DoubleVector vector<double>::negative_x = {-1,  0,  0,  0 };
-		template<> const DoubleVector vector<double>::negative_y = { 0, -1,  0,  0 };
-		template<> const DoubleVector vector<double>::negative_z = { 0,  0, -1,  0 };
-		template<> const DoubleVector vector<double>::negative_w = { 0,  0,  0, -1 };
-	
-		template<> const DoubleVector & vector<double>::right   = positive_x;
-		template<> const DoubleVector & vector<double>::up      = positive_y;
-		template<> const DoubleVector & vector<double>::forward = positive_z;
-	
-		template<> const DoubleVector & vector<double>::left    = negative_x;
-		template<> const DoubleVector & vector<double>::down    = negative_y;
-		template<> const DoubleVector & vector<double>::back    = negative_z;
-	
-	
-		template<> const DoubleVector & vector<double>::identity= zero;
-	
-		template<> const DoubleVector vector<double>::zero	    = { 0,  0,  0,  0 };
-		template<> const DoubleVector vector<double>::one		= { 1,  1,  1,  1 };
-		template<> const DoubleVector vector<double>::two		= { 2,  2,  2,  2 };
-		template<> const DoubleVector vector<double>::one_xyz	= { 1,  1,  1,  0 };
-		template<> const DoubleVector vector<double>::two_xyz	= { 2,  2,  2,  0 };
-		template<> const DoubleVector vector<double>::minus_one  = {-1, -1, -1, -1 };
-	
-		template<> const DoubleVector vector<double>::half	    = {.5, .5, .5, .5 };
-	
-		template struct constants<vector<double>>;
-	
-#define implement_vector_constants(constant)																													\
-	template<> const float_vector  FloatVectorConstants ::constant = { FloatMath::constant,  FloatMath::constant,  FloatMath::constant,  FloatMath::constant  };	\
-	template<> const DoubleVector DoubleVectorConstants::constant = { DoubleMath::constant, DoubleMath::constant, DoubleMath::constant, DoubleMath::constant }	\
-
-#else
+		template
+		struct vector<double>;
+		template
+		struct matrix<double>;
+		
+		template<> const double_vector  vector_constants<double>::positive_x = {1, 0, 0, 0};
+		template<> const double_vector  vector_constants<double>::positive_y = {0, 1, 0, 0};
+		template<> const double_vector  vector_constants<double>::positive_z = {0, 0, 1, 0};
+		template<> const double_vector  vector_constants<double>::positive_w = {0, 0, 0, 1};
+		template<> const double_vector  vector_constants<double>::negative_x = {-1, 0, 0, 0};
+		template<> const double_vector  vector_constants<double>::negative_y = {0, -1, 0, 0};
+		template<> const double_vector  vector_constants<double>::negative_z = {0, 0, -1, 0};
+		template<> const double_vector  vector_constants<double>::negative_w = {0, 0, 0, -1};
+		
+		template<> const double_vector & vector_constants<double>::right = positive_x;
+		template<> const double_vector & vector_constants<double>::up = positive_y;
+		template<> const double_vector & vector_constants<double>::forward = positive_z;
+		
+		template<> const double_vector & vector_constants<double>::left = negative_x;
+		template<> const double_vector & vector_constants<double>::down = negative_y;
+		template<> const double_vector & vector_constants<double>::back = negative_z;
+		
+		template<> const double_vector & vector_constants<double>::identity = zero;
+		
+		template<> const double_vector  vector_constants<double>::zero = {0, 0, 0, 0};
+		template<> const double_vector  vector_constants<double>::one = {1, 1, 1, 1};
+		template<> const double_vector  vector_constants<double>::two = {2, 2, 2, 2};
+		template<> const double_vector  vector_constants<double>::one_xyz = {1, 1, 1, 0};
+		template<> const double_vector  vector_constants<double>::two_xyz = {2, 2, 2, 0};
+		template<> const double_vector  vector_constants<double>::minus_one = {-1, -1, -1, -1};
+		
+		template<> const double_vector  vector_constants<double>::half = {.5, .5, .5, .5};
+		
+		template
+		struct constants<vector<double>>;
 
 #define implement_vector_constants(constant)                                                                                                                    \
     template<> const floatv  constants<floatv> ::constant = { constants<float>::constant,  constants<float>::constant,  constants<float>::constant,  constants<float>::constant  };    \
+    template<> const doublev constants<doublev>::constant = { constants<double>::constant, constants<double>::constant, constants<double>::constant, constants<double>::constant }; \
 
-#endif
 		implement_vector_constants(one);
 		implement_vector_constants(pi);
 		implement_vector_constants(pi2);
@@ -216,18 +210,12 @@ namespace asd
 		
 		implement_vector_coefs(sin, float);
 		implement_vector_coefs(cos, float);
-
-#ifdef USE_AVX
 		implement_vector_coefs(sin, double);
 		implement_vector_coefs(cos, double);
-#endif
 
 #undef implement_vector_coefs
 		
 		template<> const quaternion<float> quaternion<float>::identity{};
-
-#ifdef USE_AVX
-		template<> const quaternion<double> quaternion<double>::identity;
-#endif
+		template<> const quaternion<double> quaternion<double>::identity{};
 	}
 }
@@ -0,0 +1,60 @@
+//---------------------------------------------------------------------------
+
+#include <math/quantized.h>
+#include <core/intrinsic/CpuFeatures.h>
+
+#include "batch_kernels.h"
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace math
+	{
+		static_assert(sizeof(half_vector) == 8, "Half vectors must have no padding");
+		static_assert(sizeof(quaternion32) == 4, "Quaternions must have no padding");
+		static_assert(sizeof(quaternion48) == 6, "Quaternions must have no padding");
+		static_assert(sizeof(fixed_position) == 6, "Positions must have no padding");
+		static_assert(sizeof(fvec) == 4 * sizeof(float), "Halves are decoded to arrays of vectors as to arrays of floats");
+
+		namespace batch
+		{
+			static const simd_dispatch<const internals::batch_kernels & ()> kernels {
+				internals::scalar_batch_kernels,
+				internals::sse4_batch_kernels,
+				internals::avx2_batch_kernels,
+				internals::avx512_batch_kernels
+			};
+
+			// elements of quaternions don't start at their beginning, see math::batch::multiply
+			static const size_t quaternion_stride = sizeof(fquat) / sizeof(float);
+
+			static float * data(fquat * q)
+			{
+				return q != nullptr ? q->q.data() : nullptr;
+			}
+
+			void decode(const half_vector * in, fvec * out, size_t count)
+			{
+				kernels().decode_halves(reinterpret_cast<const uint16_t *>(in), reinterpret_cast<float *>(out), count * 4);
+			}
+
+			void decode(const quaternion32 * in, fquat * out, size_t count)
+			{
+				kernels().decode_quaternions32(reinterpret_cast<const uint32_t *>(in), data(out), quaternion_stride, count);
+			}
+
+			void decode(const quaternion48 * in, fquat * out, size_t count)
+			{
+				kernels().decode_quaternions48(reinterpret_cast<const uint16_t *>(in), data(out), quaternion_stride, count);
+			}
+
+			void decode(const fixed_cell & cell, const fixed_position * in, fvec * out, size_t count)
+			{
+				kernels().decode_positions(&cell.origin.x, cell.extent / 32767.0f, reinterpret_cast<const int16_t *>(in), reinterpret_cast<float *>(out), 4, count);
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
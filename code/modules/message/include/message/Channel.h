@@ -10,6 +10,7 @@
 #include <meta/class_id.h>
 
 #include "MessageConnector.h"
+#include "trace.h"
 
 //---------------------------------------------------------------------------
 
@@ -56,9 +57,7 @@ namespace asd
 		}
 
 		static size_t addTo(Dst & dest, Receiver<Dst, Msg> && rcvr) {
-			size_t id = rcvr.id;
-			requireFrom(dest).push_back(forward<Receiver<Dst, Msg>>(rcvr));
-			return id;
+			return requireFrom(dest).push_back(forward<Receiver<Dst, Msg>>(rcvr));
 		}
 	};
 
@@ -84,11 +83,13 @@ namespace asd
 		using Transmitter = MessageTransmitter<ReaderDst, Msg>;
 
 		static forceinline handle<Msg> & transmit(handle<Msg> & message, Dst & dest) {
+			if(message_tracing::enabled()) {
+				return trace(message, dest);
+			}
+
 			Broadcaster::broadcast(message, dest);
 			
-			auto & r = Connector::globalReceivers();
-
-			for(auto & receiver : r) {
+			for(auto & receiver : Connector::globalReceivers().snapshot()) {
 				receiver.callback(message, dest);
 			}
 			
@@ -96,6 +97,37 @@ namespace asd
 
 			return message;
 		}
+
+		// the same transmission, which measures every receiver
+		static handle<Msg> & trace(handle<Msg> & message, Dst & dest) {
+			auto & stats = message_stats::of<Msg>();
+			message_tracing::log(stats, &dest, static_cast<const asd::contents<Msg> *>(message.pointer()));
+
+			size_t receivers = 0;
+
+			auto call = [&](auto & receiver) {
+				uint64_t start = message_tracing::now();
+				receiver.callback(message, dest);
+				stats.received(message_tracing::now() - start);
+				++receivers;
+			};
+
+			Broadcaster::broadcast(message, dest, call);
+
+			for(auto & receiver : Connector::globalReceivers().snapshot()) {
+				call(receiver);
+			}
+
+			if(has_reader<Dst, Msg>::value) {
+				uint64_t start = message_tracing::now();
+				Transmitter::transmit(message, dest);
+				stats.received(message_tracing::now() - start);
+				++receivers;
+			}
+
+			stats.dispatched(receivers);
+			return message;
+		}
 	};
 
 //---------------------------------------------------------------------------
@@ -107,11 +139,22 @@ namespace asd
 			auto * local = Receivers<Dst, Msg>::seek(dest);
 
 			if(local != nullptr) {
-				for(auto & receiver : *local) {
+				for(auto & receiver : local->snapshot()) {
 					receiver.callback(message, dest);
 				}
 			}
 		}
+
+		template<class F>
+		static forceinline void broadcast(handle<Msg> &, Dst & dest, F & call) {
+			auto * local = Receivers<Dst, Msg>::seek(dest);
+
+			if(local != nullptr) {
+				for(auto & receiver : local->snapshot()) {
+					call(receiver);
+				}
+			}
+		}
 	};
 
 	template<typename Msg>
@@ -119,6 +162,9 @@ namespace asd
 	{
 		template<class Dst>
 		static void broadcast(handle<Msg> &, Dst &) {}
+
+		template<class Dst, class F>
+		static void broadcast(handle<Msg> &, Dst &, F &) {}
 	};
 
 //---------------------------------------------------------------------------
@@ -45,6 +45,59 @@ namespace asd
 
 	template<class Dst, typename Msg>
 	using message_dst_t = typename DestGetter<Dst, Msg>::type;
+
+	/**
+	 *	@brief
+	 *	Lanes of queued messages (see mailbox). Messages of higher lanes are
+	 *	delivered first, so e.g. key presses never wait behind mouse moves.
+	 */
+	enum class message_lane
+	{
+		urgent,
+		normal,
+		background
+	};
+
+	static const int message_lanes_count = 3;
+
+	/**
+	 *	@brief
+	 *	keep_latest makes the mailbox deliver only the latest of the queued
+	 *	messages of a class per destination in each drained batch
+	 */
+	enum class message_coalescing
+	{
+		keep_all,
+		keep_latest
+	};
+
+	template<class Msg>
+	struct message_traits
+	{
+		static const message_lane lane = message_lane::normal;
+		static const message_coalescing coalescing = message_coalescing::keep_all;
+	};
+
+	/**
+	 *	@brief
+	 *	Declares queueing of the message class, must follow the message_class
+	 *	declaration. Example:
+	 *	message_class
+	 *	(
+	 *		MouseMoveMessage,
+	 *		(int,	x)
+	 *		(int,	y)
+	 *	);
+	 *
+	 *	message_queueing(MouseMoveMessage, normal, keep_latest);
+	 */
+#define message_queueing(Msg, Lane, Coalescing)											\
+	template<>																			\
+	struct message_traits<Msg>															\
+	{																					\
+		static const message_lane lane = message_lane::Lane;							\
+		static const message_coalescing coalescing = message_coalescing::Coalescing;	\
+	}
 }
 
 //---------------------------------------------------------------------------
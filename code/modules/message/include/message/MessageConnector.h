@@ -8,7 +8,11 @@
 //---------------------------------------------------------------------------
 
 #include <container/array_list.h>
+#include <core/epoch.h>
 #include <forward_list>
+#include <mutex>
+
+#include <boost/iterator/indirect_iterator.hpp>
 
 #include "message.h"
 #include "Channel.hpp"
@@ -22,8 +26,123 @@ namespace asd
 
 //---------------------------------------------------------------------------
 
+	/**
+	 *  @brief
+	 *  List of receivers which is published as immutable snapshots.
+	 *	Dispatch iterates the snapshot which was current when it has started,
+	 *	so receivers may be connected and disconnected during dispatch and
+	 *	from other threads. Changes copy the list under a lock and replace
+	 *	the snapshot atomically, old snapshots are reclaimed by epoch.
+	 */
 	template<class Dst, class Msg>
-	using ReceiversList = array_list<Receiver<Dst, Msg>>;
+	class ReceiversList
+	{
+		deny_copy(ReceiversList);
+
+		using Rcvr = Receiver<Dst, Msg>;
+		using items = array_list<handle<Rcvr>>;
+
+	public:
+		/**
+		 *  @brief
+		 *  Receivers of the list at the moment of the creation of the view.
+		 *	The view must not leave the thread which has created it.
+		 */
+		class view
+		{
+			deny_copy(view);
+
+		public:
+			using iterator = boost::indirect_iterator<const handle<Rcvr> *, Rcvr>;
+
+			view(const ReceiversList & list) : _items(list._items.load(std::memory_order_acquire)) {}
+
+			iterator begin() const {
+				return _items != nullptr ? _items->data() : nullptr;
+			}
+
+			iterator end() const {
+				return _items != nullptr ? _items->data() + _items->size() : nullptr;
+			}
+
+			size_t size() const {
+				return _items != nullptr ? _items->size() : 0;
+			}
+
+		private:
+			epoch::guard _guard;
+			const items * _items;
+		};
+
+		ReceiversList() {}
+
+		~ReceiversList() {
+			delete _items.load(std::memory_order_relaxed);
+		}
+
+		view snapshot() const {
+			return {*this};
+		}
+
+		template<class ... A>
+		size_t emplace_back(A && ... args) {
+			auto receiver = handle<Rcvr>::create(forward<A>(args)...);
+			size_t id = receiver->id;
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto * current = _items.load(std::memory_order_relaxed);
+			auto * next = current != nullptr ? new items(*current) : new items;
+
+			next->push_back(std::move(receiver));
+			publish(next);
+
+			return id;
+		}
+
+		size_t push_back(Rcvr && receiver) {
+			return emplace_back(forward<Rcvr>(receiver));
+		}
+
+		void remove(size_t id) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto * current = _items.load(std::memory_order_relaxed);
+
+			if(current == nullptr) {
+				return;
+			}
+
+			auto * next = new items;
+			next->reserve(current->size());
+
+			for(auto & r : *current) {
+				if(r->id != id) {
+					next->push_back(r);
+				}
+			}
+
+			publish(next);
+		}
+
+		size_t size() const {
+			return snapshot().size();
+		}
+
+		bool empty() const {
+			return size() == 0;
+		}
+
+	private:
+		void publish(items * next) {
+			auto * previous = _items.exchange(next, std::memory_order_acq_rel);
+
+			if(previous != nullptr) {
+				epoch::retire(previous);
+			}
+		}
+
+		std::atomic<items *> _items {nullptr};
+		std::mutex _mutex;
+	};
 
 //---------------------------------------------------------------------------
 	
@@ -150,17 +269,11 @@ namespace asd
 		using Rcvr = Receiver<Dst, Msg>;
 
 		static size_t connect(Rcvr && receiver) {
-			size_t id = receiver.id;
-			globalReceivers().push_back(forward<Rcvr>(receiver));
-			return id;
+			return globalReceivers().push_back(forward<Rcvr>(receiver));
 		}
 
 		static void disconnect(size_t id) {
-			auto & r = globalReceivers();
-
-			r.erase(std::remove_if(r.begin(), r.end(), [id](Rcvr & rcvr) {
-				return rcvr.id == id;
-			}), r.end());
+			globalReceivers().remove(id);
 		}
 
 		static forceinline ReceiversWrapper<Dst, Msg> receivers() {
@@ -199,13 +312,9 @@ namespace asd
 		static void disconnect(Dst & dest, size_t id) {
 			auto * local = Receivers<Dst, Msg>::seek(dest);
 
-			if(local == nullptr || local->empty()) {
-				return;
+			if(local != nullptr) {
+				local->remove(id);
 			}
-
-			local->erase(std::remove_if(local->begin(), local->end(), [id](Rcvr & rcvr) {
-				return rcvr.id == id;
-			}), local->end());
 		}
 	};
 }
@@ -0,0 +1,462 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+//---------------------------------------------------------------------------
+
+#include <core/Exception.h>
+#include <container/array_list.h>
+#include <container/flat_map.h>
+#include "Connect.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace internals
+	{
+		struct alignas(std::max_align_t) mailbox_node
+		{
+			std::atomic<mailbox_node *> next {nullptr};
+			void (* process)(mailbox_node *, bool dispatch) = nullptr;
+			const void * target = nullptr;
+			uint64_t sequence = 0;
+			message_lane lane = message_lane::normal;
+			bool coalesced = false;
+		};
+
+		// intrusive MPSC queue by Dmitry Vyukov
+		class mailbox_queue
+		{
+			deny_copy(mailbox_queue);
+
+			using node = mailbox_node;
+
+		public:
+			mailbox_queue() {}
+
+			void push(node * n) {
+				n->next.store(nullptr, std::memory_order_relaxed);
+				node * prev = _head.exchange(n, std::memory_order_acq_rel);
+				prev->next.store(n, std::memory_order_release);
+			}
+
+			// returns nullptr if the queue is empty or a sender is in the middle of push()
+			node * pop() {
+				node * tail = _tail;
+				node * next = tail->next.load(std::memory_order_acquire);
+
+				if(tail == &_stub) {
+					if(next == nullptr) {
+						return nullptr;
+					}
+
+					_tail = next;
+					tail = next;
+					next = next->next.load(std::memory_order_acquire);
+				}
+
+				if(next != nullptr) {
+					_tail = next;
+					return tail;
+				}
+
+				if(tail != _head.load(std::memory_order_acquire)) {
+					return nullptr;
+				}
+
+				push(&_stub);
+				next = tail->next.load(std::memory_order_acquire);
+
+				if(next != nullptr) {
+					_tail = next;
+					return tail;
+				}
+
+				return nullptr;
+			}
+
+		private:
+			node _stub;
+			std::atomic<node *> _head {&_stub};
+			node * _tail = &_stub;
+		};
+
+		// messages are stamped while the tracing is enabled to measure their latency
+		inline uint64_t traced_post() {
+			return message_tracing::enabled() ? message_tracing::now() : 0;
+		}
+
+		template<class Msg>
+		void traced(uint64_t posted) {
+			if(posted != 0 && message_tracing::enabled()) {
+				message_stats::of<Msg>().delivered(message_tracing::now() - posted);
+			}
+		}
+
+		template<class Dst, class Msg>
+		struct posted_message : mailbox_node, pool_alloc<message_pool<posted_message<Dst, Msg>>, thread_magazines>
+		{
+			posted_message(handle<Msg> && message, Dst & dest) : message(std::move(message)), dest(dest) {
+				process = &deliver;
+				target = &dest;
+				lane = message_traits<Msg>::lane;
+				coalesced = message_traits<Msg>::coalescing == message_coalescing::keep_latest;
+			}
+
+			static void deliver(mailbox_node * node, bool dispatch) {
+				auto * p = static_cast<posted_message *>(node);
+
+				if(dispatch) {
+					Channel<Dst, Msg>::transmit(p->message, p->dest);
+					traced<Msg>(p->posted);
+				}
+
+				delete p;
+			}
+
+			handle<Msg> message;
+			Dst & dest;
+			uint64_t posted = traced_post();
+		};
+
+		template<class Dst, class Msg>
+		struct requested_message : mailbox_node
+		{
+			// requests are never coalesced, each of them waits for its own delivery
+			requested_message(handle<Msg> && message, Dst & dest) : message(std::move(message)), dest(dest) {
+				process = &deliver;
+				target = &dest;
+				lane = message_traits<Msg>::lane;
+			}
+
+			static void deliver(mailbox_node * node, bool dispatch) {
+				auto * p = static_cast<requested_message *>(node);
+
+				if(dispatch) {
+					Channel<Dst, Msg>::transmit(p->message, p->dest);
+					traced<Msg>(p->posted);
+					p->promise.set_value(std::move(p->message));
+				}
+
+				delete p;
+			}
+
+			handle<Msg> message;
+			Dst & dest;
+			uint64_t posted = traced_post();
+			std::promise<handle<Msg>> promise;
+		};
+	}
+
+	/**
+	 *	@brief
+	 *	Lock-free queue of messages which are sent from any threads and are
+	 *	delivered by the thread which owns the mailbox. Messages are delivered
+	 *	through their channels in the order of posting for each sender thread.
+	 *
+	 *	The owner thread delivers messages by drain(), e.g. from its
+	 *	thread_loop:
+	 *		thread_loop::add([&box]() { box.drain(64); });
+	 *	or from a flow::context which posts a drain to its io context.
+	 *
+	 *	Each message class is queued to the lane declared by message_queueing.
+	 *	drain() delivers urgent messages of a batch first, then normal and
+	 *	background ones, but messages which were posted to the same
+	 *	destination before an urgent one are delivered right before it, so
+	 *	e.g. a button press is never handled at a stale mouse position.
+	 *	Messages of keep_latest classes are coalesced in each drained batch:
+	 *	only the latest of them is delivered to each destination between its
+	 *	urgent messages, e.g. a destination which gets mouse moves through a
+	 *	mailbox handles one move per batch instead of each of them.
+	 *
+	 *	The <capacity> limits the count of pending messages, posts to a full
+	 *	mailbox are refused, so slow owners put back-pressure on senders.
+	 *	Destinations must outlive messages which are posted to them.
+	 *	Messages which are left in the mailbox on its destruction are
+	 *	discarded, futures of such requests get broken promises.
+	 */
+	class mailbox
+	{
+		deny_copy(mailbox);
+
+		using node = internals::mailbox_node;
+
+	public:
+		static const size_t unlimited = std::numeric_limits<size_t>::max();
+
+		explicit mailbox(size_t capacity = unlimited) : _capacity(capacity) {}
+
+		~mailbox() {
+			for(int i = 0; i < message_lanes_count; ++i) {
+				if(_ahead[i] != nullptr) {
+					_ahead[i]->process(_ahead[i], false);
+				}
+
+				while(auto * n = _lanes[i].pop()) {
+					n->process(n, false);
+				}
+			}
+		}
+
+		/**
+		 *	Creates the message on the calling thread and queues it to the
+		 *	<dest>. Returns false if the mailbox is full.
+		 */
+		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
+		bool post(const subject * source, Dst & dest, F && ... fields) {
+			if(!reserve()) {
+				return false;
+			}
+
+			push(new internals::posted_message<Dst, Msg>(handle<Msg>::create(source, forward<F>(fields)...), dest));
+			return true;
+		}
+
+		/**
+		 *	Queues the existing message. Returns false if the mailbox is full.
+		 */
+		template<class Dst, class Msg>
+		bool post(const handle<Msg> & message, Dst & dest) {
+			if(!reserve()) {
+				return false;
+			}
+
+			push(new internals::posted_message<Dst, Msg>(handle<Msg>(message), dest));
+			return true;
+		}
+
+		/**
+		 *	Queues the message and returns the future which gets the message
+		 *	after its delivery, e.g. to read its result. If the mailbox is full,
+		 *	the future holds an exception.
+		 */
+		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
+		std::future<handle<Msg>> request(const subject * source, Dst & dest, F && ... fields) {
+			if(!reserve()) {
+				std::promise<handle<Msg>> refused;
+				refused.set_exception(std::make_exception_ptr(Exception("Mailbox is full")));
+
+				return refused.get_future();
+			}
+
+			auto * r = new internals::requested_message<Dst, Msg>(handle<Msg>::create(source, forward<F>(fields)...), dest);
+			auto future = r->promise.get_future();
+			push(r);
+
+			return future;
+		}
+
+		/**
+		 *	Takes a batch of up to <limit> queued messages in the order of
+		 *	posting, coalesces it and delivers it. Must be called by the owner
+		 *	thread only and not from message handlers. Returns the count of
+		 *	delivered messages.
+		 */
+		size_t drain(size_t limit = unlimited) {
+			size_t taken = take(limit);
+
+			if(taken == 0) {
+				return 0;
+			}
+
+			_pending.fetch_sub(taken, std::memory_order_relaxed);
+			coalesce();
+
+			size_t count = 0;
+
+			// urgent messages go first, each one after the earlier messages to its destination
+			if(link()) {
+				for(size_t i = 0; i < _batch.size(); ++i) {
+					auto * n = _batch[i];
+
+					if(n == nullptr || n->lane != message_lane::urgent) {
+						continue;
+					}
+
+					auto & first = _first[n->target];
+
+					for(; first != i; first = _next[first]) {
+						count += deliver(_batch[first]);
+					}
+
+					first = _next[i];
+					count += deliver(_batch[i]);
+				}
+			}
+
+			for(auto lane : {message_lane::normal, message_lane::background}) {
+				for(auto & n : _batch) {
+					if(n != nullptr && n->lane == lane) {
+						count += deliver(n);
+					}
+				}
+			}
+
+			_batch.clear();
+
+			if(count < taken) {
+				_coalesced.fetch_add(taken - count, std::memory_order_relaxed);
+			}
+
+			return count;
+		}
+
+		/**
+		 *	Approximate count of queued messages
+		 */
+		size_t pending() const {
+			return _pending.load(std::memory_order_relaxed);
+		}
+
+		size_t capacity() const {
+			return _capacity;
+		}
+
+		/**
+		 *	Count of refused posts and requests
+		 */
+		size_t refused() const {
+			return _refused.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 *	Count of messages which were dropped in favour of later ones
+		 */
+		size_t coalesced() const {
+			return _coalesced.load(std::memory_order_relaxed);
+		}
+
+	private:
+		bool reserve() {
+			if(_pending.fetch_add(1, std::memory_order_relaxed) >= _capacity) {
+				_pending.fetch_sub(1, std::memory_order_relaxed);
+				_refused.fetch_add(1, std::memory_order_relaxed);
+
+				return false;
+			}
+
+			return true;
+		}
+
+		void push(node * n) {
+			n->sequence = _sequence.fetch_add(1, std::memory_order_relaxed);
+			_lanes[static_cast<int>(n->lane)].push(n);
+		}
+
+		// merges the heads of the lanes by their sequence, the next head of each lane is kept until it is taken
+		size_t take(size_t limit) {
+			size_t taken = 0;
+
+			for(; taken < limit; ++taken) {
+				int first = -1;
+
+				for(int i = 0; i < message_lanes_count; ++i) {
+					if(_ahead[i] == nullptr) {
+						_ahead[i] = _lanes[i].pop();
+					}
+
+					if(_ahead[i] != nullptr && (first < 0 || _ahead[i]->sequence < _ahead[first]->sequence)) {
+						first = i;
+					}
+				}
+
+				if(first < 0) {
+					break;
+				}
+
+				_batch.push_back(_ahead[first]);
+				_ahead[first] = nullptr;
+			}
+
+			return taken;
+		}
+
+		static size_t deliver(node *& n) {
+			n->process(n, true);
+			n = nullptr;
+
+			return 1;
+		}
+
+		// walks the batch backwards and discards coalesced messages which are followed by the same ones, but not across urgent messages to their destinations
+		void coalesce() {
+			for(auto i = _batch.rbegin(); i != _batch.rend(); ++i) {
+				auto * n = *i;
+
+				if(n->lane == message_lane::urgent) {
+					_latest.erase(std::remove_if(_latest.begin(), _latest.end(), [n](const latest & key) { return key.second == n->target; }), _latest.end());
+				}
+
+				if(!n->coalesced) {
+					continue;
+				}
+
+				auto key = std::make_pair(n->process, n->target);
+
+				if(std::find(_latest.begin(), _latest.end(), key) == _latest.end()) {
+					_latest.push_back(key);
+					continue;
+				}
+
+				n->process(n, false);
+				*i = nullptr;
+			}
+
+			_latest.clear();
+		}
+
+		// chains the messages of the batch to each destination in the order of posting, returns false if there are no urgent messages to order
+		bool link() {
+			if(std::none_of(_batch.begin(), _batch.end(), [](node * n) { return n != nullptr && n->lane == message_lane::urgent; })) {
+				return false;
+			}
+
+			_first.clear();
+			_next.resize(_batch.size());
+
+			for(size_t i = _batch.size(); i-- > 0;) {
+				auto * n = _batch[i];
+
+				if(n == nullptr) {
+					continue;
+				}
+
+				auto r = _first.insert({n->target, i});
+				_next[i] = r.second ? _batch.size() : r.first->second;
+				r.first->second = i;
+			}
+
+			return true;
+		}
+
+		using latest = std::pair<void (*)(node *, bool), const void *>;
+
+		internals::mailbox_queue _lanes[message_lanes_count];
+		std::atomic<uint64_t> _sequence {0};
+
+		// owned by the draining thread, the batch and the keys are kept to reuse their storage
+		node * _ahead[message_lanes_count] = {};
+		array_list<node *> _batch;
+		array_list<latest> _latest;
+		flat_map<const void *, size_t> _first;
+		array_list<size_t> _next;
+
+		size_t _capacity;
+		std::atomic<size_t> _pending {0};
+		std::atomic<size_t> _refused {0};
+		std::atomic<size_t> _coalesced {0};
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -10,6 +10,8 @@
 #include "MessageClass.h"
 #include <function/method.h>
 #include <core/handle.h>
+#include <core/memory/allocator/pool_alloc.h>
+#include <core/Exception.h>
 
 //---------------------------------------------------------------------------
 
@@ -20,27 +22,168 @@ namespace asd
 	template<class, typename>
 	struct Channel;
 	
+	namespace internals
+	{
+		template<class Msg>
+		class scoped_message;
+		
+		/**
+		 *  @brief
+		 *  Atomic counter of messages. Scoped messages are never deleted by
+		 *	their handles, they are destroyed by the sender.
+		 */
+		class message_refs : public atomic_refs
+		{
+		public:
+			template<class T>
+			bool release(const T * object) {
+				return atomic_refs::release(object) && !_scoped;
+			}
+			
+			bool scoped() const {
+				return _scoped;
+			}
+			
+			void scope() {
+				_scoped = true;
+			}
+			
+		private:
+			bool _scoped = false;
+		};
+		
+		// blocks keep the alignment of magazine headers, messages are aligned the same way
+		template<class T>
+		struct message_pool
+		{
+			struct type : block_pool<std::aligned_storage_t<magazine_block_size<T>, alignof(magazine_header)>, 0x100>, persistent_pool
+			{
+				// pools and their depots are never destroyed, so messages held by statics or by running threads may be freed at exit
+				static type & instance() {
+					static type & pool = *new type;
+					return pool;
+				}
+			};
+		};
+	}
+	
+	/**
+	 *  @brief
+	 *  Allocation policy of messages of the type T (see default_alloc).
+	 *	Each message type has its own pool with per-thread magazines in front
+	 *	of it, so sending doesn't touch the heap. Specialize it to change the
+	 *	storage of some messages, e.g. with heap_message_alloc.
+	 */
+	template<class T>
+	struct message_alloc
+	{
+		using type = pool_alloc<internals::message_pool<T>, thread_magazines>;
+	};
+	
+	/**
+	 *  @brief
+	 *  Allocation policy which keeps messages on the heap. Messages are
+	 *	already based on default_alloc, so it adds no allocator of its own.
+	 */
+	struct heap_message_alloc {};
+	
 	/**
 	 *  @brief
 	 *  Basic class for all messages
 	 */
-	struct message : shareable<message>
+	struct message : shareable<message, internals::message_refs>
 	{
+		template<class Msg>
+		friend class internals::scoped_message;
+		
 		const subject * source;
 		int result = 0;
 		
 		message(const subject * source) : source(source) {}
 		message(const message &) = delete;
+		
+		virtual ~message() {}
+		
+		/**
+		 *  Scoped messages live until the end of their dispatch, see
+		 *	subject::send_scoped and keep()
+		 */
+		bool scoped() const {
+			return _refs.scoped();
+		}
 	};
 	
 	namespace internals
 	{
 		template<class T>
-		struct message : asd::message, asd::contents<T>
+		struct alignas(std::max_align_t) message : asd::message, asd::contents<T>, message_alloc<T>::type
 		{
+			using alloc = std::conditional_t<std::is_same<typename message_alloc<T>::type, heap_message_alloc>::value, default_alloc, typename message_alloc<T>::type>;
+			
+			using alloc::operator new;
+			using alloc::operator delete;
+			
 			template<class ... A, useif<can_construct_contents<T, A...>::value>>
 			message(const subject * source, A &&... args) : asd::message(source), asd::contents<T>(forward<A>(args)...) {}
+			
+			message(const subject * source, asd::contents<T> && contents) : asd::message(source), asd::contents<T>(std::move(contents)) {}
 		};
+		
+		/**
+		 *  @brief
+		 *  Storage of a scoped message in the frame of its sender
+		 */
+		template<class Msg>
+		class scoped_message
+		{
+			deny_copy(scoped_message);
+			
+		public:
+			template<class ... A>
+			scoped_message(A && ... args) : _message(new (&_storage) Msg(forward<A>(args)...)) {
+				_message->_refs.scope();
+				_handle = _message;
+			}
+			
+			~scoped_message() {
+				// a retained handle would point to the frame of the sender, which can't be fixed up after the dispatch
+				if(_message->_refs.count() != (_handle.pointer() == _message ? 2 : 1)) {
+					viewException(std::logic_error("Scoped message was retained without keep()"));
+					std::terminate();
+				}
+				
+				_handle = nullptr;
+				_message->~Msg();
+			}
+			
+			handle<Msg> & get() {
+				return _handle;
+			}
+			
+		private:
+			std::aligned_storage_t<sizeof(Msg), alignof(Msg)> _storage;
+			Msg * _message;
+			handle<Msg> _handle;
+		};
+	}
+	
+	/**
+	 *  @brief
+	 *  Returns the handle which may be stored after the dispatch of the
+	 *	message. Scoped messages are moved to the heap and <msg> is replaced
+	 *	by the moved one, so the following receivers and the sender see it too.
+	 *	A scoped message stored without keep() terminates the program at the
+	 *	end of its dispatch.
+	 */
+	template<class Msg>
+	handle<Msg> keep(handle<Msg> & msg) {
+		if(msg.pointer() != nullptr && msg->scoped()) {
+			auto kept = handle<Msg>::create(msg->source, std::move(static_cast<asd::contents<Msg> &>(*msg)));
+			kept->result = msg->result;
+			msg = kept;
+		}
+		
+		return msg;
 	}
 	
 	template<class T>
@@ -54,18 +197,28 @@ namespace asd
 	template<class Dst, typename Msg>
 	using msg_callback = function<void(handle<Msg> &, Dst &)>;
 	
+	namespace internals
+	{
+		/**
+		 *  Unique id of a new receiver, ids are never 0
+		 */
+		api(message)
+		size_t next_receiver_id();
+	}
+	
 	/**
 	 *  @brief
-	 *  Wrapper for message callback
+	 *  Wrapper for message callback. Receivers are shared by snapshots of
+	 *	receiver lists, which are released by any thread.
 	 */
 	template<class Dst, typename Msg>
-	class Receiver : public auto_id, public shareable<Receiver<Dst, Msg>>
+	class Receiver : public auto_id, public shareable<Receiver<Dst, Msg>, atomic_refs>
 	{
 		deny_copy(Receiver);
 		typedef msg_callback<Dst, Msg> Callback;
 	
 	public:
-		Receiver(const Callback & callback) : callback(callback), id(reinterpret_cast<size_t>(reinterpret_cast<const void *>(callback.template target<void(*)(handle<Msg> &, Dst &)>()))) {}
+		Receiver(const Callback & callback) : callback(callback), id(internals::next_receiver_id()) {}
 		Receiver(Receiver && receiver) : callback(std::move(receiver.callback)), id(receiver.id) {}
 		
 		Receiver & operator = (Receiver && receiver)
@@ -13,6 +13,7 @@
 #include <core/addition/named.h>
 #include <container/set.h>
 #include "Connect.h"
+#include "mailbox.h"
 
 //---------------------------------------------------------------------------
 
@@ -62,7 +63,7 @@ namespace asd
 		
 		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
 		handle<Msg> send(Dst & dest, F && ... fields) const {
-			handle<Msg> msg(this, forward<F>(fields)...);
+			auto msg = handle<Msg>::create(this, forward<F>(fields)...);
 			return Channel<Dst, Msg>::transmit(msg, dest);
 		}
 		
@@ -72,10 +73,35 @@ namespace asd
 				throw Exception("Destination should be not null!");
 			}
 			
-			handle<Msg> msg(this, forward<F>(fields)...);
+			auto msg = handle<Msg>::create(this, forward<F>(fields)...);
 			return Channel<Dst, Msg>::transmit(msg, *dest);
 		}
 		
+		/**
+		 *	Sends the message which is stored in the frame of the caller and
+		 *	returns its result. Receivers which store the message must
+		 *	take it with keep(), which moves it to the heap.
+		 */
+		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
+		int send_scoped(Dst & dest, F && ... fields) const {
+			internals::scoped_message<Msg> msg(this, forward<F>(fields)...);
+			return Channel<Dst, Msg>::transmit(msg.get(), dest)->result;
+		}
+		
+		/**
+		 *	Queues the message to the mailbox of the thread which owns the
+		 *	<dest>, see mailbox::post
+		 */
+		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
+		bool post(mailbox & box, Dst & dest, F && ... fields) const {
+			return box.post<Msg>(this, dest, forward<F>(fields)...);
+		}
+		
+		template<class Msg, class Dst, class ... F, useif<can_construct<Msg, const subject *, F ...>::value>>
+		std::future<handle<Msg>> request(mailbox & box, Dst & dest, F && ... fields) const {
+			return box.request<Msg>(this, dest, forward<F>(fields)...);
+		}
+		
 		template<class Dst, class Msg>
 		handle<Msg> & resend(handle<Msg> & message, Dst & dest) const {
 			auto * src = message->source;
@@ -114,10 +140,16 @@ namespace asd
 	
 	template<class Msg, class Dst, class ... F, useif<can_construct<Msg, subject *, F ...>::value>>
 	handle<Msg> send(Dst & dest, F && ... fields) {
-		handle<Msg> msg(subject::universe(), forward<F>(fields)...);
+		auto msg = handle<Msg>::create(subject::universe(), forward<F>(fields)...);
 		return Channel<Dst, Msg>::transmit(msg, dest);
 	}
 	
+	template<class Msg, class Dst, class ... F, useif<can_construct<Msg, subject *, F ...>::value>>
+	int send_scoped(Dst & dest, F && ... fields) {
+		internals::scoped_message<Msg> msg(subject::universe(), forward<F>(fields)...);
+		return Channel<Dst, Msg>::transmit(msg.get(), dest)->result;
+	}
+	
 	template<class Dst, class Msg>
 	handle<Msg> & resend(handle<Msg> & message, Dst & dest) {
 		auto * src = message->source;
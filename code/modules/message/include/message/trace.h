@@ -0,0 +1,468 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef MESSAGE_TRACE_H
+#define MESSAGE_TRACE_H
+
+//---------------------------------------------------------------------------
+
+#include "message.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/type_index/ctti_type_index.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	/**
+	 *	@brief
+	 *	HDR-style histogram of durations in nanoseconds. Values are put into
+	 *	log2 ranges which are split into 32 linear buckets each, so any value
+	 *	is kept with relative error under 1/32 from nanoseconds to centuries.
+	 *	Counters are relaxed atomics, the histogram may be filled by several
+	 *	threads at once.
+	 */
+	class latency_histogram
+	{
+	public:
+		static const int precision = 6;
+		static const uint half = 1u << (precision - 1);
+		static const uint bucketsCount = (64 - precision) * half + (1u << precision);
+
+		struct summary
+		{
+			uint64_t count;
+			uint64_t min;
+			uint64_t mean;
+			uint64_t p50;
+			uint64_t p90;
+			uint64_t p99;
+			uint64_t max;
+		};
+
+		latency_histogram() {}
+		latency_histogram(const latency_histogram &) = delete;
+
+		void record(uint64_t value) {
+			_buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+			_count.fetch_add(1, std::memory_order_relaxed);
+			_sum.fetch_add(value, std::memory_order_relaxed);
+
+			uint64_t min = _min.load(std::memory_order_relaxed);
+			uint64_t max = _max.load(std::memory_order_relaxed);
+
+			while(value < min && !_min.compare_exchange_weak(min, value, std::memory_order_relaxed));
+			while(value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+		}
+
+		uint64_t count() const {
+			return _count.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 *	The highest value which is equivalent to the value at the
+		 *	<percentile> (0..100), i.e. it is never underestimated
+		 */
+		uint64_t percentile(double percentile) const {
+			uint64_t total = count();
+
+			if(total == 0) {
+				return 0;
+			}
+
+			uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * total + 0.5));
+			uint64_t seen = 0;
+
+			for(uint i = 0; i < bucketsCount; ++i) {
+				seen += _buckets[i].load(std::memory_order_relaxed);
+
+				if(seen >= rank) {
+					return std::min(highest(i), _max.load(std::memory_order_relaxed));
+				}
+			}
+
+			return _max.load(std::memory_order_relaxed);
+		}
+
+		summary get() const {
+			uint64_t count = this->count();
+
+			return {
+				count,
+				count > 0 ? _min.load(std::memory_order_relaxed) : 0,
+				count > 0 ? _sum.load(std::memory_order_relaxed) / count : 0,
+				percentile(50.0),
+				percentile(90.0),
+				percentile(99.0),
+				_max.load(std::memory_order_relaxed)
+			};
+		}
+
+		void reset() {
+			for(auto & b : _buckets) {
+				b.store(0, std::memory_order_relaxed);
+			}
+
+			_count.store(0, std::memory_order_relaxed);
+			_sum.store(0, std::memory_order_relaxed);
+			_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+			_max.store(0, std::memory_order_relaxed);
+		}
+
+		static uint bucket(uint64_t value) {
+			if(value < (1u << precision)) {
+				return static_cast<uint>(value);
+			}
+
+			uint magnitude = msb(value);
+			uint shift = magnitude - precision + 1;
+
+			return shift * half + static_cast<uint>(value >> shift);
+		}
+
+		static uint64_t highest(uint bucket) {
+			if(bucket < (1u << precision)) {
+				return bucket;
+			}
+
+			uint shift = bucket / half - 1;
+			uint64_t lowest = static_cast<uint64_t>(bucket % half + half) << shift;
+
+			return lowest + ((uint64_t(1) << shift) - 1);
+		}
+
+	private:
+		static uint msb(uint64_t value) {
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return index;
+#else
+			return 63 - __builtin_clzll(value);
+#endif
+		}
+
+		std::atomic<uint64_t> _buckets[bucketsCount] {};
+		std::atomic<uint64_t> _count {0};
+		std::atomic<uint64_t> _sum {0};
+		std::atomic<uint64_t> _min {std::numeric_limits<uint64_t>::max()};
+		std::atomic<uint64_t> _max {0};
+	};
+
+	/**
+	 *	@brief
+	 *	Trace of messages of one type: counts of dispatches and of called
+	 *	receivers, time spent in each receiver and the latency of queued
+	 *	delivery, i.e. the time from mailbox::post to the end of dispatch.
+	 *
+	 *	Every instance is registered in the message_tracing while it is alive.
+	 */
+	class message_stats
+	{
+		friend class message_tracing;
+
+	public:
+		struct snapshot
+		{
+			std::string name;
+			size_t dispatches;
+			size_t receivers;
+			latency_histogram::summary receiverTime;
+			latency_histogram::summary latency;
+		};
+
+		template<class Msg>
+		static message_stats & of() {
+			static message_stats stats(
+				boost::typeindex::ctti_type_index::type_id<Msg>().pretty_name(),
+				std::is_trivially_copyable<internals::contents<Msg>>::value ? sizeof(internals::contents<Msg>) : 0
+			);
+
+			return stats;
+		}
+
+		message_stats(const message_stats &) = delete;
+
+		~message_stats() {
+			detach();
+		}
+
+		void dispatched(size_t receivers) {
+			_dispatches.fetch_add(1, std::memory_order_relaxed);
+			_receivers.fetch_add(receivers, std::memory_order_relaxed);
+		}
+
+		void received(uint64_t time) {
+			_receiverTime.record(time);
+		}
+
+		void delivered(uint64_t latency) {
+			_latency.record(latency);
+		}
+
+		snapshot get() const {
+			return {
+				_name,
+				_dispatches.load(std::memory_order_relaxed),
+				_receivers.load(std::memory_order_relaxed),
+				_receiverTime.get(),
+				_latency.get()
+			};
+		}
+
+		const std::string & name() const {
+			return _name;
+		}
+
+		/**
+		 *	Size of recorded contents, messages with contents which are not
+		 *	trivially copyable are recorded without them and can't be replayed
+		 */
+		size_t payload() const {
+			return _payload;
+		}
+
+		void reset() {
+			_dispatches.store(0, std::memory_order_relaxed);
+			_receivers.store(0, std::memory_order_relaxed);
+			_receiverTime.reset();
+			_latency.reset();
+		}
+
+	private:
+		message_stats(const std::string & name, size_t payload) : _name(name), _payload(payload) {
+			attach();
+		}
+
+		api(message)
+		void attach();
+		api(message)
+		void detach();
+
+		std::string _name;
+		size_t _payload;
+
+		std::atomic<size_t> _dispatches {0};
+		std::atomic<size_t> _receivers {0};
+		latency_histogram _receiverTime;
+		latency_histogram _latency;
+
+		// id of the type in the current log, guarded by the lock of message_tracing
+		uint _session = 0;
+		uint _logId = 0;
+
+		message_stats * _prev = nullptr;
+		message_stats * _next = nullptr;
+	};
+
+	/**
+	 *	@brief
+	 *	Opt-in tracing of messages. Channels check one relaxed flag per
+	 *	transmission while the tracing is disabled. When it is enabled, every
+	 *	transmission is measured and counted in the message_stats of its type,
+	 *	and messages which are posted to mailboxes are stamped to measure
+	 *	their latency.
+	 *
+	 *	record() additionally writes every transmitted message to a compact
+	 *	binary log which can be replayed by the message_player:
+	 *		header:		"asdtrace", uint32 version
+	 *		type:		'T', uint32 id, uint32 payload size, uint16 name size, name
+	 *		message:	'M', uint64 ns from the start, uint32 type id, uint32 destination id, payload
+	 *	Numbers are written in the native byte order. Destinations get ids in
+	 *	the order of their first messages, track() assigns them beforehand.
+	 *
+	 *	Example:
+	 *		std::ofstream log("session.trace", std::ios::binary);
+	 *		message_tracing::record(log);
+	 *		...
+	 *		message_tracing::disable();
+	 *		std::cout << message_tracing::text();
+	 */
+	class message_tracing
+	{
+		friend class message_stats;
+
+	public:
+		static bool enabled() {
+			return _enabled.load(std::memory_order_relaxed);
+		}
+
+		static uint64_t now() {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		api(message)
+		static void enable();
+
+		/**
+		 *	Stops the tracing and the recording, flushes the log
+		 */
+		api(message)
+		static void disable();
+
+		/**
+		 *	Enables the tracing and starts a new log in the <stream>. The stream
+		 *	must live until the recording is stopped.
+		 */
+		api(message)
+		static void record(std::ostream & stream);
+
+		api(message)
+		static void stop_recording();
+
+		/**
+		 *	Id of the <dest> in the current log
+		 */
+		api(message)
+		static uint track(const void * dest);
+
+		/**
+		 *	Writes the message to the log if it is being recorded
+		 */
+		api(message)
+		static void log(message_stats & stats, const void * dest, const void * contents);
+
+		api(message)
+		static std::vector<message_stats::snapshot> snapshots();
+
+		/**
+		 *	Human-readable report of all traced types
+		 */
+		api(message)
+		static std::string text();
+
+		api(message)
+		static void reset();
+
+	private:
+		static message_tracing & instance();
+
+		api(message)
+		static std::atomic<bool> _enabled;
+
+		std::mutex _lock;
+		message_stats * _first = nullptr;
+
+		std::ostream * _stream = nullptr;
+		uint64_t _start = 0;
+		uint _session = 0;
+		uint _types = 0;
+		std::unordered_map<const void *, uint> _dests;
+	};
+
+	/**
+	 *	@brief
+	 *	Replays a log written by message_tracing::record. Messages are
+	 *	re-created with recorded contents and are transmitted synchronously
+	 *	in the recorded order to the routed destinations, so a headless
+	 *	graph of subjects gets the same stream on every run regardless of the
+	 *	recorded timing. Replayed messages are sent by the subject::universe.
+	 *
+	 *	Example:
+	 *		std::ifstream log("session.trace", std::ios::binary);
+	 *		message_player player(log);
+	 *		player.route<MouseMoveMessage>(0, space);
+	 *		player.route<KeyDownMessage>(space);
+	 *		player.play();
+	 */
+	class message_player
+	{
+		deny_copy(message_player);
+
+	public:
+		/**
+		 *	Throws an Exception if the <stream> doesn't contain a log
+		 */
+		api(message)
+		explicit message_player(std::istream & stream);
+
+		/**
+		 *	Replays messages of the type Msg which were sent to the
+		 *	destination with the recorded id <dest> to the <target>
+		 */
+		template<class Msg, class Dst>
+		void route(uint dest, Dst & target) {
+			route_type<Msg>().dests[dest] = replayer<Msg>(target);
+		}
+
+		/**
+		 *	Replays all messages of the type Msg to the <target>
+		 */
+		template<class Msg, class Dst>
+		void route(Dst & target) {
+			route_type<Msg>().any = replayer<Msg>(target);
+		}
+
+		/**
+		 *	Transmits all messages from the log. Returns the count of
+		 *	transmitted messages, messages without routes are skipped. Throws
+		 *	an Exception if the log is corrupted or the layout of a routed
+		 *	message differs from the recorded one.
+		 */
+		api(message)
+		size_t play();
+
+		size_t skipped() const {
+			return _skipped;
+		}
+
+	private:
+		using replay = std::function<void(const void * contents)>;
+
+		struct routes
+		{
+			size_t payload;
+			replay any;
+			std::unordered_map<uint, replay> dests;
+		};
+
+		template<class Msg>
+		routes & route_type() {
+			static_assert(std::is_trivially_copyable<internals::contents<Msg>>::value, "Only messages with trivially copyable contents can be replayed");
+
+			auto & r = _routes[boost::typeindex::ctti_type_index::type_id<Msg>().pretty_name()];
+			r.payload = sizeof(internals::contents<Msg>);
+
+			return r;
+		}
+
+		template<class Msg, class Dst>
+		static replay replayer(Dst & target) {
+			return [&target](const void * data) {
+				asd::contents<Msg> contents;
+				std::memcpy(static_cast<internals::contents<Msg> *>(&contents), data, sizeof(internals::contents<Msg>));
+
+				auto msg = handle<Msg>::create(source(), std::move(contents));
+				Channel<Dst, Msg>::transmit(msg, target);
+			};
+		}
+
+		api(message)
+		static const subject * source();
+
+		std::istream & _stream;
+		std::unordered_map<std::string, routes> _routes;
+		size_t _skipped = 0;
+	};
+}
+
+//---------------------------------------------------------------------------
+#endif
@@ -2,10 +2,20 @@
 
 #include <message/subject.h>
 
+#include <atomic>
+
 //---------------------------------------------------------------------------
 
 namespace asd
 {
+	namespace internals
+	{
+		size_t next_receiver_id()
+		{
+			static std::atomic<size_t> last {0};
+			return last.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+	}
 }
 
 //---------------------------------------------------------------------------
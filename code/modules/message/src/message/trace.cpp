@@ -0,0 +1,311 @@
+//---------------------------------------------------------------------------
+
+#include <message/trace.h>
+#include <message/subject.h>
+
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	namespace
+	{
+		const char logMagic[8] = {'a', 's', 'd', 't', 'r', 'a', 'c', 'e'};
+		const uint32_t logVersion = 1;
+
+		const char typeRecord = 'T';
+		const char messageRecord = 'M';
+
+		// checked before the lock, so traced transmissions don't contend while nothing is recorded
+		std::atomic<bool> recording {false};
+
+		template<class T>
+		void write(std::ostream & out, const T & value)
+		{
+			out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+
+		template<class T>
+		bool read(std::istream & in, T & value)
+		{
+			return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+		}
+
+		void corrupted()
+		{
+			throw Exception("Message log is corrupted");
+		}
+
+		void print(std::ostream & out, const char * title, const latency_histogram::summary & s)
+		{
+			out << "  " << title << ": " << s.count;
+
+			if(s.count > 0)
+				out << ", min " << s.min << " ns, mean " << s.mean << " ns, p50 " << s.p50 << " ns, p90 " << s.p90 << " ns, p99 " << s.p99 << " ns, max " << s.max << " ns";
+
+			out << '\n';
+		}
+	}
+
+	std::atomic<bool> message_tracing::_enabled {false};
+
+	void message_stats::attach()
+	{
+		auto & t = message_tracing::instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		_next = t._first;
+
+		if(_next != nullptr)
+			_next->_prev = this;
+
+		t._first = this;
+	}
+
+	void message_stats::detach()
+	{
+		auto & t = message_tracing::instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		if(_prev != nullptr)
+			_prev->_next = _next;
+		else
+			t._first = _next;
+
+		if(_next != nullptr)
+			_next->_prev = _prev;
+	}
+
+	message_tracing & message_tracing::instance()
+	{
+		static message_tracing tracing;
+		return tracing;
+	}
+
+	void message_tracing::enable()
+	{
+		_enabled.store(true, std::memory_order_relaxed);
+	}
+
+	void message_tracing::disable()
+	{
+		_enabled.store(false, std::memory_order_relaxed);
+		stop_recording();
+	}
+
+	void message_tracing::record(std::ostream & stream)
+	{
+		auto & t = instance();
+
+		{
+			std::lock_guard<std::mutex> guard(t._lock);
+
+			if(t._stream != nullptr)
+				t._stream->flush();
+
+			t._stream = &stream;
+			t._start = now();
+			t._types = 0;
+			t._dests.clear();
+			++t._session;
+
+			stream.write(logMagic, sizeof(logMagic));
+			write(stream, logVersion);
+
+			recording.store(true, std::memory_order_relaxed);
+		}
+
+		enable();
+	}
+
+	void message_tracing::stop_recording()
+	{
+		auto & t = instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		recording.store(false, std::memory_order_relaxed);
+
+		if(t._stream != nullptr)
+			t._stream->flush();
+
+		t._stream = nullptr;
+	}
+
+	uint message_tracing::track(const void * dest)
+	{
+		auto & t = instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		return t._dests.emplace(dest, static_cast<uint>(t._dests.size())).first->second;
+	}
+
+	void message_tracing::log(message_stats & stats, const void * dest, const void * contents)
+	{
+		if(!recording.load(std::memory_order_relaxed))
+			return;
+
+		auto & t = instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		if(t._stream == nullptr)
+			return;
+
+		auto & out = *t._stream;
+
+		if(stats._session != t._session)
+		{
+			stats._session = t._session;
+			stats._logId = t._types++;
+
+			write(out, typeRecord);
+			write(out, static_cast<uint32_t>(stats._logId));
+			write(out, static_cast<uint32_t>(stats._payload));
+			write(out, static_cast<uint16_t>(stats._name.size()));
+			out.write(stats._name.data(), stats._name.size());
+		}
+
+		uint id = t._dests.emplace(dest, static_cast<uint>(t._dests.size())).first->second;
+
+		write(out, messageRecord);
+		write(out, static_cast<uint64_t>(now() - t._start));
+		write(out, static_cast<uint32_t>(stats._logId));
+		write(out, static_cast<uint32_t>(id));
+		out.write(static_cast<const char *>(contents), stats._payload);
+	}
+
+	std::vector<message_stats::snapshot> message_tracing::snapshots()
+	{
+		auto & t = instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+		std::vector<message_stats::snapshot> list;
+
+		for(auto * s = t._first; s != nullptr; s = s->_next)
+			list.push_back(s->get());
+
+		return list;
+	}
+
+	std::string message_tracing::text()
+	{
+		std::ostringstream out;
+
+		for(auto & s : snapshots())
+		{
+			out << s.name << '\n'
+				<< "  dispatches: " << s.dispatches
+				<< ", receivers: " << s.receivers
+				<< " (" << std::fixed << std::setprecision(1) << (s.dispatches > 0 ? static_cast<double>(s.receivers) / s.dispatches : 0.0) << " per dispatch)\n";
+
+			print(out, "receiver calls", s.receiverTime);
+			print(out, "queued deliveries", s.latency);
+		}
+
+		return out.str();
+	}
+
+	void message_tracing::reset()
+	{
+		auto & t = instance();
+		std::lock_guard<std::mutex> guard(t._lock);
+
+		for(auto * s = t._first; s != nullptr; s = s->_next)
+			s->reset();
+	}
+
+	message_player::message_player(std::istream & stream) : _stream(stream)
+	{
+		char magic[sizeof(logMagic)];
+		uint32_t version = 0;
+
+		if(!_stream.read(magic, sizeof(magic)) || std::memcmp(magic, logMagic, sizeof(magic)) != 0 || !read(_stream, version))
+			throw Exception("Stream doesn't contain a message log");
+
+		if(version != logVersion)
+			throw Exception("Unsupported version of the message log: ", version);
+	}
+
+	size_t message_player::play()
+	{
+		struct type
+		{
+			size_t payload;
+			routes * target;
+		};
+
+		std::vector<type> types;
+		std::vector<char> buffer;
+		size_t count = 0;
+		char tag;
+
+		while(read(_stream, tag))
+		{
+			if(tag == typeRecord)
+			{
+				uint32_t id, payload;
+				uint16_t length;
+
+				if(!read(_stream, id) || !read(_stream, payload) || !read(_stream, length) || id != types.size())
+					corrupted();
+
+				std::string name(length, '\0');
+
+				if(!_stream.read(&name[0], length))
+					corrupted();
+
+				auto r = _routes.find(name);
+				auto * target = r != _routes.end() ? &r->second : nullptr;
+
+				if(target != nullptr && payload != 0 && target->payload != payload)
+					throw Exception(name, " has another layout in the message log");
+
+				types.push_back({payload, target});
+				continue;
+			}
+
+			if(tag != messageRecord)
+				corrupted();
+
+			uint64_t time;
+			uint32_t id, dest;
+
+			if(!read(_stream, time) || !read(_stream, id) || !read(_stream, dest) || id >= types.size())
+				corrupted();
+
+			auto & t = types[id];
+			buffer.resize(t.payload);
+
+			if(t.payload > 0 && !_stream.read(buffer.data(), t.payload))
+				corrupted();
+
+			const replay * r = nullptr;
+
+			if(t.target != nullptr && t.payload > 0)
+			{
+				auto d = t.target->dests.find(dest);
+				r = d != t.target->dests.end() ? &d->second : (t.target->any ? &t.target->any : nullptr);
+			}
+
+			if(r == nullptr)
+			{
+				++_skipped;
+				continue;
+			}
+
+			(*r)(buffer.data());
+			++count;
+		}
+
+		return count;
+	}
+
+	const subject * message_player::source()
+	{
+		return subject::universe();
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -10,6 +10,8 @@
 #include "adapt.h"
 #include "cast.h"
 
+#include <functional>
+
 //---------------------------------------------------------------------------
 
 namespace asd
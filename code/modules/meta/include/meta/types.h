@@ -108,7 +108,8 @@ namespace asd
      *  @brief
      *  Can be used as clear function argument (empty instead of void)
      */
-    struct empty {} static _;
+    struct empty {};
+    static constexpr empty _ {};
 
 //---------------------------------------------------------------------------
 
@@ -9,6 +9,8 @@
 
 #include <chrono>
 
+#include <math/culling.h>
+
 #include "camera.h"
 
 //---------------------------------------------------------------------------
@@ -20,6 +22,7 @@ namespace asd
         using namespace std::chrono_literals;
 
         class drawable;
+        class drawable_set;
         class container;
 
         class component
@@ -48,31 +51,89 @@ namespace asd
         public:
             api(scene)
             drawable(container & scene, bool transparent = false);
-            virtual ~drawable() {}
+
+            api(scene)
+            virtual ~drawable();
 
             bool transparent() const {
                 return _transparent;
             }
 
+            /**
+             *  Sets the bounding sphere in world space which is used for frustum
+             *  culling. Drawables without bounds are never culled.
+             */
+            api(scene)
+            void set_bounds(const space::vector & center, space::scalar radius);
+
             virtual void draw(const math::int_rect & viewport, float zoom) const = 0;
 
         protected:
+            friend class drawable_set;
+
+            container & _scene;
             bool _transparent = false;
+            size_t _index = 0;
+        };
+
+        /**
+         *  @brief
+         *  Drawables with their bounding spheres stored as structure of arrays,
+         *  so the whole set is culled in one pass of math::culling.
+         *  Drawables are drawn in the order of the set. Unordered sets remove
+         *  drawables by swapping with the last one, ordered sets shift the
+         *  following ones, e.g. to keep the blending order of transparent ones.
+         */
+        class drawable_set
+        {
+        public:
+            explicit drawable_set(bool ordered = false) : _ordered(ordered) {}
+
+            api(scene)
+            void insert(drawable & d);
+
+            api(scene)
+            void erase(drawable & d);
+
+            api(scene)
+            void set_bounds(const drawable & d, const space::vector & center, space::scalar radius);
+
+            /**
+             *  Draws drawables which intersect the <frustum> or all of them if
+             *  there is no frustum
+             */
+            api(scene)
+            void draw(const boost::optional<math::ffrustum> & frustum, const math::int_rect & viewport) const;
+
+            size_t size() const {
+                return _drawables.size();
+            }
+
+        protected:
+            bool _ordered;
+            array_list<drawable *> _drawables;
+            array_list<float> _x, _y, _z, _radius;
+            mutable array_list<uint32_t> _visible;
+            mutable array_list<byte> _coherency; // plane which culled the drawable last time, see math::culling
         };
 
+        /**
+         *  @brief
+         *  Objects, drawables and the update timer refer to their container,
+         *  so containers are neither copied nor moved.
+         */
         class container : private boost::noncopyable
         {
         public:
             api(scene)
             container(gfx::context & gfx, flow::context & flow);
 
-            api(scene)
-            container(container &&) noexcept;
+            container(container &&) = delete;
 
             api(scene)
             virtual ~container();
 
-            container & operator = (container &&) noexcept;
+            container & operator = (container &&) = delete;
 
             api(scene)
             gfx::context & graphics() const;
@@ -94,10 +155,25 @@ namespace asd
                 return static_cast<Obj &>(**_objects.emplace(_objects.end(), make::unique<Obj>(*this, forward<A>(args)...)));
             }
 
+            /**
+             *  Inverse of the affine <model> matrix
+             */
             api(scene)
             matrix normal_matrix(const matrix & model) const;
 
+            /**
+             *  Inverses of <count> affine <models> at once, see math::batch
+             */
+            api(scene)
+            void normal_matrices(const matrix * models, matrix * out, size_t count) const;
+
         protected:
+            friend class drawable;
+
+            drawable_set & drawables(bool transparent) {
+                return transparent ? _transparent : _opaque;
+            }
+
             api(scene)
             virtual void draw(const math::int_rect & viewport) const;
 
@@ -108,16 +184,17 @@ namespace asd
             boost::optional<scene::camera &> _camera = boost::none;
             math::uint_size _viewport;
 
+            // drawables of objects erase themselves from the sets, so the sets are destroyed after objects
+            drawable_set _opaque;
+            drawable_set _transparent {true};
             array_list<unique<object>> _objects;
-            array_list<std::reference_wrapper<drawable>> _opaque;
-            array_list<std::reference_wrapper<drawable>> _transparent;
             flow::tick_timer _timer;
             array_list<std::reference_wrapper<uniform::object>> _uniforms;
         };
 
         class provider
         {
-            map<string, container> _scenes;
+            map<string, unique<container>> _scenes;
         };
     }
 }
@@ -90,7 +90,7 @@ namespace asd
             }
             }
 
-            _projection_data.set<true>(0, _projection_matrix);
+            _projection_data.set<true>(0, math::fmat(_projection_matrix));
         }
 
         void camera::set_view_range(scalar range) {
@@ -114,7 +114,7 @@ namespace asd
         }
 
         void camera::setPitch(scalar value) {
-            _angles[0] = math::clamp(value, -math::constants<float>::half_pi, math::constants<float>::half_pi);
+            _angles[0] = math::clamp(value, -math::constants<scalar>::half_pi, math::constants<scalar>::half_pi);
             _pitch = { vector_constants::right, _angles[0] };
 
             _rotation = _roll * _yaw * _pitch;
@@ -135,7 +135,7 @@ namespace asd
         }
 
         void camera::setAngles(scalar pitch, scalar yaw, scalar roll) {
-            _angles[0] = math::clamp(pitch, -math::constants<float>::pi * 0.49_x, math::constants<float>::pi * 0.49_x);
+            _angles[0] = math::clamp(pitch, -math::constants<scalar>::pi * 0.49_x, math::constants<scalar>::pi * 0.49_x);
             _angles[1] = math::normalize_angle(yaw);
             _angles[2] = roll;
 
@@ -164,7 +164,7 @@ namespace asd
 
         void camera::update_view() {
             _view_matrix = matrix::look_to(_position, _rotation.forward(), _rotation.up());
-            _view_data.set<true>(0, _view_matrix);
+            _view_data.set<true>(0, math::fmat(_view_matrix));
         }
     }
 }
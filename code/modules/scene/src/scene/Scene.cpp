@@ -3,13 +3,94 @@
 #include <scene/scene.h>
 #include <scene/camera.h>
 
+#include <math/batch.h>
+
 //---------------------------------------------------------------------------
 
 namespace asd
 {
     namespace scene
     {
-        drawable::drawable(container & scene, bool transparent) : _transparent(transparent) {}
+        drawable::drawable(container & scene, bool transparent) : _scene(scene), _transparent(transparent) {
+            _scene.drawables(_transparent).insert(*this);
+        }
+
+        drawable::~drawable() {
+            _scene.drawables(_transparent).erase(*this);
+        }
+
+        void drawable::set_bounds(const space::vector & center, space::scalar radius) {
+            _scene.drawables(_transparent).set_bounds(*this, center, radius);
+        }
+
+        void drawable_set::insert(drawable & d) {
+            d._index = _drawables.size();
+
+            _drawables.push_back(&d);
+            _x.push_back(0.0f);
+            _y.push_back(0.0f);
+            _z.push_back(0.0f);
+            _radius.push_back(std::numeric_limits<float>::infinity());
+            _coherency.push_back(0);
+        }
+
+        void drawable_set::erase(drawable & d) {
+            auto i = d._index;
+
+            if (_ordered) {
+                _drawables.erase(_drawables.begin() + i);
+
+                for (auto * a : {&_x, &_y, &_z, &_radius}) {
+                    a->erase(a->begin() + i);
+                }
+
+                _coherency.erase(_coherency.begin() + i);
+
+                for (auto j = i; j < _drawables.size(); ++j) {
+                    _drawables[j]->_index = j;
+                }
+
+                return;
+            }
+
+            _drawables[i] = _drawables.back();
+            _drawables[i]->_index = i;
+            _drawables.pop_back();
+
+            for (auto * a : {&_x, &_y, &_z, &_radius}) {
+                (*a)[i] = a->back();
+                a->pop_back();
+            }
+
+            _coherency[i] = _coherency.back();
+            _coherency.pop_back();
+        }
+
+        void drawable_set::set_bounds(const drawable & d, const space::vector & center, space::scalar radius) {
+            auto i = d._index;
+
+            _x[i] = static_cast<float>(center.x);
+            _y[i] = static_cast<float>(center.y);
+            _z[i] = static_cast<float>(center.z);
+            _radius[i] = static_cast<float>(radius);
+        }
+
+        void drawable_set::draw(const boost::optional<math::ffrustum> & frustum, const math::int_rect & viewport) const {
+            if (!frustum) {
+                for (auto * drawable : _drawables) {
+                    drawable->draw(viewport, 1.0f);
+                }
+
+                return;
+            }
+
+            _visible.resize(_drawables.size());
+            auto count = math::culling::spheres(*frustum, {_x.data(), _y.data(), _z.data(), _radius.data(), _x.size()}, _visible.data(), _coherency.data());
+
+            for (size_t i = 0; i < count; ++i) {
+                _drawables[_visible[i]]->draw(viewport, 1.0f);
+            }
+        }
 
         container::container(gfx::context & gfx, flow::context & flow) : _gfx(gfx), _timer(flow, 100ms) {
             _timer.bind(make_method(this, update));
@@ -23,27 +104,6 @@ namespace asd
             _uniforms << uniforms.register_uniform("Projection", { uniform::scheme::create<uniform::f32m4>("projection") });
         }
 
-        container::container(container && scene) noexcept :
-            _gfx(scene._gfx),
-            _camera(std::move(scene._camera)),
-            _objects(std::move(scene._objects)),
-            _opaque(std::move(scene._opaque)),
-            _transparent(std::move(scene._transparent)),
-            _timer(std::move(scene._timer)),
-            _uniforms(std::move(scene._uniforms))
-        {}
-
-        container & container::operator = (container && scene) noexcept {
-            std::swap(_camera, scene._camera);
-            std::swap(_objects, scene._objects);
-            std::swap(_opaque, scene._opaque);
-            std::swap(_transparent, scene._transparent);
-            std::swap(_timer, scene._timer);
-            std::swap(_uniforms, scene._uniforms);
-
-            return *this;
-        }
-
         container::~container() {}
 
         gfx::context & container::graphics() const {
@@ -71,17 +131,32 @@ namespace asd
                 uniform.get().update();
             }
 
-            for (auto & drawable : _opaque) {
-                drawable.get().draw(viewport, 1.0f);
-            }
+            boost::optional<math::ffrustum> frustum;
 
-            for (auto & drawable : _transparent) {
-                drawable.get().draw(viewport, 1.0f);
+            if (_camera) {
+                frustum.emplace(math::fmat(_camera->view_matrix() * _camera->projection_matrix()));
             }
+
+            _opaque.draw(frustum, viewport);
+            _transparent.draw(frustum, viewport);
         }
 
         matrix container::normal_matrix(const matrix & model) const {
-            return /*_camera != nullptr ? _camera->normal_matrix(model) : */model.inverse();
+            return /*_camera != nullptr ? _camera->normal_matrix(model) : */model.affine_inverse();
+        }
+
+        static void affine_inverse(const math::fmat * models, math::fmat * out, size_t count) {
+            math::batch::affine_inverse(models, out, count);
+        }
+
+        static void affine_inverse(const math::dmat * models, math::dmat * out, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                models[i].get_affine_inverse(out[i]);
+            }
+        }
+
+        void container::normal_matrices(const matrix * models, matrix * out, size_t count) const {
+            affine_inverse(models, out, count);
         }
 
         void container::update(ticks_t ticks) {
@@ -77,35 +77,35 @@ namespace asd
             
             virtual void rotate(const quaternion & rot) {}
             
-            void move(float x, float y, float z) {
+            void move(scalar x, scalar y, scalar z) {
                 move({x, y, z});
             }
             
-            void move_x(float x) {
+            void move_x(scalar x) {
                 move({x, 0, 0});
             }
             
-            void move_y(float y) {
+            void move_y(scalar y) {
                 move({0, y, 0});
             }
             
-            void move_z(float z) {
+            void move_z(scalar z) {
                 move({0, 0, z});
             }
             
-            void rotate(const vector & axis, float angle) {
+            void rotate(const vector & axis, scalar angle) {
                 rotate({axis, angle});
             }
             
-            void rotate_x(float angle) {
+            void rotate_x(scalar angle) {
                 rotate(vector_constants::positive_x, angle);
             }
             
-            void rotate_y(float angle) {
+            void rotate_y(scalar angle) {
                 rotate(vector_constants::positive_y, angle);
             }
             
-            void rotate_z(float angle) {
+            void rotate_z(scalar angle) {
                 rotate(vector_constants::positive_z, angle);
             }
         };
@@ -0,0 +1,417 @@
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+
+//---------------------------------------------------------------------------
+
+#include <space/spatial.h>
+#include <math/batch.h>
+#include <container/array_list.h>
+#include <core/Exception.h>
+
+#include <cstdint>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+    namespace space
+    {
+        /**
+         *  @brief
+         *  Stable reference to a transform of the transform_store. Handles of
+         *  removed transforms become invalid even if their slots are reused.
+         */
+        struct transform_handle
+        {
+            static const uint32_t none = 0xFFFFFFFF;
+
+            bool operator == (const transform_handle & h) const {
+                return slot == h.slot && generation == h.generation;
+            }
+
+            bool operator != (const transform_handle & h) const {
+                return !operator == (h);
+            }
+
+            uint32_t slot = none;
+            uint32_t generation = 0;
+        };
+
+        namespace internals
+        {
+            /**
+             *  Column of scalars per component, w is not stored
+             */
+            template<int N>
+            struct soa_columns
+            {
+                void push_back(const scalar (& v)[N]) {
+                    for(int k = 0; k < N; ++k) {
+                        data[k].push_back(v[k]);
+                    }
+                }
+
+                void replace_with_last(size_t index) {
+                    for(int k = 0; k < N; ++k) {
+                        data[k][index] = data[k].back();
+                        data[k].pop_back();
+                    }
+                }
+
+                void reserve(size_t count) {
+                    for(auto & c : data) {
+                        c.reserve(count);
+                    }
+                }
+
+                array_list<scalar> data[N];
+            };
+        }
+
+        /**
+         *  @brief
+         *  Positions, rotations, scales and velocities of many objects in
+         *  dense arrays of components (structure of arrays), so operations
+         *  over all of them are vectorized loops or math::batch kernels
+         *  instead of virtual calls of space::spatial for every object.
+         *
+         *  Transforms are referenced by handles, dense indices of transforms
+         *  change when others are removed (the last one takes the place of
+         *  the removed one). Columns are available through positions(),
+         *  rotations(), etc. for math::batch functions, their indices are
+         *  dense indices, see index_of().
+         */
+        class transform_store
+        {
+            deny_copy(transform_store);
+
+        public:
+            transform_store() {}
+
+            size_t size() const {
+                return _owners.size();
+            }
+
+            void reserve(size_t count) {
+                _positions.reserve(count);
+                _rotations.reserve(count);
+                _scales.reserve(count);
+                _velocities.reserve(count);
+                _owners.reserve(count);
+            }
+
+            transform_handle create(const vector & position = vector_constants::zero, const quaternion & rotation = quaternion::identity, const vector & scale = vector_constants::one) {
+                transform_handle h;
+
+                if(_free != transform_handle::none) {
+                    h.slot = _free;
+                    _free = _slots[h.slot].index;
+                } else {
+                    h.slot = static_cast<uint32_t>(_slots.size());
+                    _slots.push_back({});
+                }
+
+                auto & s = _slots[h.slot];
+                s.index = static_cast<uint32_t>(size());
+                h.generation = s.generation;
+
+                _positions.push_back({position.x, position.y, position.z});
+                _rotations.push_back({rotation.x, rotation.y, rotation.z, rotation.w});
+                _scales.push_back({scale.x, scale.y, scale.z});
+                _velocities.push_back({0, 0, 0});
+                _owners.push_back(h.slot);
+
+                return h;
+            }
+
+            void destroy(const transform_handle & h) {
+                auto index = index_of(h);
+
+                _positions.replace_with_last(index);
+                _rotations.replace_with_last(index);
+                _scales.replace_with_last(index);
+                _velocities.replace_with_last(index);
+
+                _owners[index] = _owners.back();
+                _owners.pop_back();
+
+                if(index < size()) {
+                    _slots[_owners[index]].index = static_cast<uint32_t>(index);
+                }
+
+                auto & s = _slots[h.slot];
+                ++s.generation;
+                s.index = _free;
+                _free = h.slot;
+            }
+
+            bool contains(const transform_handle & h) const {
+                return h.slot < _slots.size() && _slots[h.slot].generation == h.generation;
+            }
+
+            /**
+             *  Current dense index of the transform
+             */
+            size_t index_of(const transform_handle & h) const {
+                if(!contains(h)) {
+                    throw Exception("Transform handle is invalid or the transform was destroyed");
+                }
+
+                return _slots[h.slot].index;
+            }
+
+            transform_handle handle_of(size_t index) const {
+                transform_handle h;
+                h.slot = _owners[index];
+                h.generation = _slots[h.slot].generation;
+                return h;
+            }
+
+            /**
+             *  Positions are points, their w component is 1
+             */
+            vector position(size_t index) const {
+                return get(_positions, index, 1);
+            }
+
+            quaternion rotation(size_t index) const {
+                auto & c = _rotations.data;
+                return {c[0][index], c[1][index], c[2][index], c[3][index]};
+            }
+
+            vector scale(size_t index) const {
+                return get(_scales, index, 0);
+            }
+
+            vector velocity(size_t index) const {
+                return get(_velocities, index, 0);
+            }
+
+            void set_position(size_t index, const vector & v) {
+                set(_positions, index, v);
+            }
+
+            void set_rotation(size_t index, const quaternion & q) {
+                auto & c = _rotations.data;
+
+                c[0][index] = q.x;
+                c[1][index] = q.y;
+                c[2][index] = q.z;
+                c[3][index] = q.w;
+            }
+
+            void set_scale(size_t index, const vector & v) {
+                set(_scales, index, v);
+            }
+
+            void set_velocity(size_t index, const vector & v) {
+                set(_velocities, index, v);
+            }
+
+            /**
+             *  Moves all transforms by the same offset in world space
+             */
+            void move_all(const vector & offset) {
+                const scalar o[] = {offset.x, offset.y, offset.z};
+
+                for(int k = 0; k < 3; ++k) {
+                    auto * p = _positions.data[k].data();
+                    auto n = size();
+
+                    for(size_t i = 0; i < n; ++i) {
+                        p[i] += o[k];
+                    }
+                }
+            }
+
+            /**
+             *  Rotates all transforms by <q> as quaternion::rotate_by does,
+             *  i.e. rotation = q * rotation
+             */
+            void rotate_all(const quaternion & q) {
+                rotate(q, rotations());
+            }
+
+            /**
+             *  position += velocity * dt for all transforms
+             */
+            void integrate(scalar dt) {
+                for(int k = 0; k < 3; ++k) {
+                    auto * p = _positions.data[k].data();
+                    auto * v = _velocities.data[k].data();
+                    auto n = size();
+
+                    for(size_t i = 0; i < n; ++i) {
+                        p[i] += v[i] * dt;
+                    }
+                }
+            }
+
+            math::soa3<scalar> positions() {
+                return columns(_positions);
+            }
+
+            math::soa3<const scalar> positions() const {
+                return columns(_positions);
+            }
+
+            math::soa4<scalar> rotations() {
+                auto & c = _rotations.data;
+                return {c[0].data(), c[1].data(), c[2].data(), c[3].data(), size()};
+            }
+
+            math::soa4<const scalar> rotations() const {
+                auto & c = _rotations.data;
+                return {c[0].data(), c[1].data(), c[2].data(), c[3].data(), size()};
+            }
+
+            math::soa3<scalar> scales() {
+                return columns(_scales);
+            }
+
+            math::soa3<const scalar> scales() const {
+                return columns(_scales);
+            }
+
+            math::soa3<scalar> velocities() {
+                return columns(_velocities);
+            }
+
+            math::soa3<const scalar> velocities() const {
+                return columns(_velocities);
+            }
+
+        protected:
+            using columns3 = internals::soa_columns<3>;
+            using columns4 = internals::soa_columns<4>;
+
+            // dense index of the transform, or the next free slot if it was destroyed
+            struct slot
+            {
+                uint32_t index = 0;
+                uint32_t generation = 0;
+            };
+
+            static vector get(const columns3 & c, size_t index, scalar w) {
+                return {c.data[0][index], c.data[1][index], c.data[2][index], w};
+            }
+
+            static void set(columns3 & c, size_t index, const vector & v) {
+                c.data[0][index] = v.x;
+                c.data[1][index] = v.y;
+                c.data[2][index] = v.z;
+            }
+
+            // float rotations are composed by the SIMD kernels of math::batch
+            static void rotate(const math::fquat & q, const math::soa4<float> & r) {
+                math::batch::rotate_by(q, r, r);
+            }
+
+            // math::batch has no double kernels, the loop is left to the compiler
+            static void rotate(const math::dquat & q, const math::soa4<double> & r) {
+                for(size_t i = 0; i < r.size; ++i) {
+                    double rx = q.w * r.x[i] + q.x * r.w[i] + q.y * r.z[i] - q.z * r.y[i];
+                    double ry = q.w * r.y[i] + q.y * r.w[i] + q.z * r.x[i] - q.x * r.z[i];
+                    double rz = q.w * r.z[i] + q.z * r.w[i] + q.x * r.y[i] - q.y * r.x[i];
+                    double rw = q.w * r.w[i] - q.x * r.x[i] - q.y * r.y[i] - q.z * r.z[i];
+
+                    r.x[i] = rx;
+                    r.y[i] = ry;
+                    r.z[i] = rz;
+                    r.w[i] = rw;
+                }
+            }
+
+            math::soa3<scalar> columns(columns3 & c) {
+                return {c.data[0].data(), c.data[1].data(), c.data[2].data(), size()};
+            }
+
+            math::soa3<const scalar> columns(const columns3 & c) const {
+                return {c.data[0].data(), c.data[1].data(), c.data[2].data(), size()};
+            }
+
+            columns3 _positions;
+            columns4 _rotations;
+            columns3 _scales;
+            columns3 _velocities;
+
+            array_list<uint32_t> _owners; // slots of transforms by dense indices
+            array_list<slot> _slots;
+            uint32_t _free = transform_handle::none;
+        };
+
+        /**
+         *  @brief
+         *  space::spatial interface of a transform of the transform_store
+         *  which behaves as space::oriented (move() is relative to the
+         *  rotation). Doesn't own the transform.
+         */
+        class stored_transform : public spatial
+        {
+        public:
+            stored_transform(transform_store & store, const transform_handle & handle) : _store(store), _handle(handle) {}
+
+            virtual ~stored_transform() {}
+
+            transform_store & store() const {
+                return _store;
+            }
+
+            const transform_handle & handle() const {
+                return _handle;
+            }
+
+            virtual vector position() const override {
+                return _store.position(index());
+            }
+
+            virtual vector direction() const override {
+                return rotation().forward();
+            }
+
+            virtual quaternion rotation() const override {
+                return _store.rotation(index());
+            }
+
+            virtual void set_position(const vector & pos) override {
+                _store.set_position(index(), pos);
+            }
+
+            virtual void set_direction(const vector & dir) override {
+                set_rotation({vector_constants::forward, dir});
+            }
+
+            virtual void set_rotation(const quaternion & rot) override {
+                _store.set_rotation(index(), rot);
+            }
+
+            virtual void move(const vector & offset) override {
+                auto i = index();
+                _store.set_position(i, _store.position(i) + _store.rotation(i).apply_to(offset));
+            }
+
+            virtual void rotate(const quaternion & rot) override {
+                auto i = index();
+                _store.set_rotation(i, _store.rotation(i).rotate_by(rot));
+            }
+
+            using spatial::move;
+            using spatial::rotate;
+
+        protected:
+            size_t index() const {
+                return _store.index_of(_handle);
+            }
+
+            transform_store & _store;
+            transform_handle _handle;
+        };
+    }
+}
+
+//---------------------------------------------------------------------------
+#endif
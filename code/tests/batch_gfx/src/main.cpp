@@ -12,7 +12,7 @@
 //---------------------------------------------------------------------------
 
 #include <container/map.h>
-#include <container/any_list.h>
+#include <container/segmented_any_list.h>
 #include <meta/class_id.hpp>
 #include <application/starter.h>
 
@@ -44,7 +44,7 @@ namespace asd
 		}
 	
 	protected:
-		any_list _list;
+		segmented_any_list<> _list;
 	};
 	
 	template <class Gfx>
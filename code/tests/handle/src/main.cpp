@@ -1,7 +1,10 @@
 //---------------------------------------------------------------------------
 
 #include <application/starter.h>
+#include <application/thread_loop.h>
 #include <iostream>
+#include <thread>
+#include <future>
 
 //---------------------------------------------------------------------------
 
@@ -18,7 +21,7 @@ namespace asd
 	void create() {
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile boost::intrusive_ptr<object> h(new object, true);
 		}
 		
@@ -27,7 +30,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile boost::movelib::unique_ptr<object> h(new object);
 		}
 		
@@ -36,7 +39,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile handle<object> h(_);
 		}
 		
@@ -45,7 +48,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile unique<object> h(_);
 		}
 		
@@ -54,7 +57,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile std::shared_ptr<object> h(new object);
 		}
 		
@@ -63,7 +66,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			volatile std::unique_ptr<object> h1(new object);
 		}
 		
@@ -81,7 +84,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			boost::intrusive_ptr<object> h = std::move(bst_i);
 			bst_i = std::move(h);
 		}
@@ -91,7 +94,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			boost::movelib::unique_ptr<object> h = std::move(bst_u);
 			bst_u = std::move(h);
 		}
@@ -101,7 +104,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			handle<object> h = std::move(asd_h);
 			asd_h = std::move(h);
 		}
@@ -111,7 +114,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			unique<object> h = std::move(asd_u);
 			asd_u = std::move(h);
 		}
@@ -121,7 +124,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			std::shared_ptr<object> h = std::move(std_s);
 			std_s = std::move(h);
 		}
@@ -131,7 +134,7 @@ namespace asd
 		
 		last = hrc::now();
 		
-		repeat(i, HANDLES_COUNT) {
+		for(int i = 0; i < HANDLES_COUNT; ++i) {
 			std::unique_ptr<object> h = std::move(std_u);
 			std_u = std::move(h);
 		}
@@ -140,12 +143,300 @@ namespace asd
 		std::cout << "std unique_ptr time: " << t << std::endl;
 	}
 	
+	const int THREADS_COUNT = 4;
+	const int COPIES_COUNT = 10000;
+
+	std::atomic<int> destroyed {0};
+
+	template<class Refs>
+	struct counted : shareable<counted<Refs>, Refs>
+	{
+		~counted() {
+			destroyed.fetch_add(1, std::memory_order_relaxed);
+			thread = std::this_thread::get_id();
+		}
+
+		size_t refs() const {
+			return this->_refs.count();
+		}
+
+		static std::thread::id thread;
+	};
+
+	template<class Refs>
+	std::thread::id counted<Refs>::thread;
+
+	template<class Refs>
+	bool count_references(const char * name) {
+		destroyed = 0;
+
+		auto h = make::handle<counted<Refs>>();
+		auto copy = h;
+
+		if(h->refs() != 2) {
+			std::cout << name << ": references were not counted" << std::endl;
+			return false;
+		}
+
+		copy = nullptr;
+
+		if(h->refs() != 1 || destroyed != 0) {
+			std::cout << name << ": object was destroyed before its last reference was released" << std::endl;
+			return false;
+		}
+
+		h = nullptr;
+
+		if(destroyed != 1) {
+			std::cout << name << ": object was not destroyed with its last reference" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	// each thread gets its own copy, copies it repeatedly and releases everything
+	template<class Refs>
+	void release_concurrently(const handle<counted<Refs>> & h) {
+		std::vector<handle<counted<Refs>>> given(THREADS_COUNT, h);
+		std::vector<std::thread> threads;
+
+		for(auto & g : given) {
+			threads.emplace_back([&g]() {
+				for(int i = 0; i < COPIES_COUNT; ++i) {
+					auto copy = g;
+				}
+
+				g = nullptr;
+			});
+		}
+
+		for(auto & t : threads) {
+			t.join();
+		}
+	}
+
+	bool atomic_references() {
+		destroyed = 0;
+
+		auto h = make::handle<counted<atomic_refs>>();
+		release_concurrently(h);
+
+		if(h->refs() != 1 || destroyed != 0) {
+			std::cout << "atomic_refs: references released by several threads were lost" << std::endl;
+			return false;
+		}
+
+		h = nullptr;
+		return destroyed == 1;
+	}
+
+	bool biased_references() {
+		using object = counted<biased_refs>;
+		destroyed = 0;
+
+		auto owner = std::this_thread::get_id();
+		auto h = make::handle<object>();
+		release_concurrently(h);
+
+		// the shared part of the counter is negative until the owner merges it
+		biased_refs::collect();
+
+		if(h->refs() != 1 || destroyed != 0) {
+			std::cout << "biased_refs: references released by several threads were lost" << std::endl;
+			return false;
+		}
+
+		h = nullptr;
+
+		if(destroyed != 1) {
+			std::cout << "biased_refs: merged object was not destroyed with its last reference" << std::endl;
+			return false;
+		}
+
+		// the last reference is released by another thread, the owner destroys the object on collect
+		auto moved = make::handle<object>();
+		std::thread([&moved]() { moved = nullptr; }).join();
+
+		if(destroyed != 1) {
+			std::cout << "biased_refs: object was destroyed before the owner has collected it" << std::endl;
+			return false;
+		}
+
+		biased_refs::collect();
+
+		if(destroyed != 2 || object::thread != owner) {
+			std::cout << "biased_refs: object was not destroyed by the collecting owner" << std::endl;
+			return false;
+		}
+
+		// the owner releases its part first, the other thread destroys the object without a merge
+		auto kept = make::handle<object>();
+		handle<object> other;
+		std::thread([&other, &kept]() { other = kept; }).join();
+		kept = nullptr;
+
+		if(destroyed != 2) {
+			std::cout << "biased_refs: object was destroyed while another thread has referenced it" << std::endl;
+			return false;
+		}
+
+		std::thread::id releaser;
+
+		std::thread([&other, &releaser]() {
+			other = nullptr;
+			releaser = std::this_thread::get_id();
+		}).join();
+
+		if(destroyed != 3 || object::thread != releaser) {
+			std::cout << "biased_refs: object was not destroyed when its merged counter reached zero" << std::endl;
+			return false;
+		}
+
+		// the owner exits while the object is still referenced
+		handle<object> orphan;
+		std::thread([&orphan]() { orphan = make::handle<object>(); }).join();
+
+		if(destroyed != 3) {
+			std::cout << "biased_refs: object was destroyed by its exiting owner" << std::endl;
+			return false;
+		}
+
+		orphan = nullptr;
+
+		if(destroyed != 4 || object::thread != owner) {
+			std::cout << "biased_refs: object of an exited owner was not destroyed" << std::endl;
+			return false;
+		}
+
+		// the owner exits before it has collected the object released by another thread
+		std::promise<handle<object>> passed;
+		std::promise<void> released;
+		std::thread::id exited;
+
+		std::thread exiting([&]() {
+			exited = std::this_thread::get_id();
+			passed.set_value(make::handle<object>());
+			released.get_future().wait();
+		});
+
+		passed.get_future().get() = nullptr;
+		released.set_value();
+		exiting.join();
+
+		if(destroyed != 5 || object::thread != exited) {
+			std::cout << "biased_refs: object queued to an exiting owner was not destroyed" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	// destroys its child when it is destroyed, so the child is deferred during the drain
+	struct parent : shareable<parent, deferred<plain_refs>>
+	{
+		~parent() {
+			destroyed.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		handle<counted<deferred<plain_refs>>> child = make::handle<counted<deferred<plain_refs>>>();
+	};
+
+	bool deferred_releases() {
+		const int OBJECTS_COUNT = 100;
+		destroyed = 0;
+
+		for(int i = 0; i < OBJECTS_COUNT; ++i) {
+			make::handle<counted<deferred<plain_refs>>>();
+		}
+
+		if(destroyed != 0 || release_queue::pending() != OBJECTS_COUNT) {
+			std::cout << "release_queue: released objects were not deferred" << std::endl;
+			return false;
+		}
+
+		// the budget is checked after each batch of objects, at least one batch is destroyed
+		size_t count = release_queue::drain(0ns);
+
+		if(count == 0 || count >= OBJECTS_COUNT || destroyed != static_cast<int>(count)) {
+			std::cout << "release_queue: drain has exceeded its budget" << std::endl;
+			return false;
+		}
+
+		if(release_queue::drain(1s) != OBJECTS_COUNT - count || destroyed != OBJECTS_COUNT) {
+			std::cout << "release_queue: deferred objects were lost" << std::endl;
+			return false;
+		}
+
+		destroyed = 0;
+
+		make::handle<parent>();
+
+		if(release_queue::drain() != 2 || destroyed != 2 || release_queue::pending() != 0) {
+			std::cout << "release_queue: objects released during the drain were not destroyed" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool looped_releases() {
+		using local = counted<deferred<plain_refs>>;
+		using biased = counted<deferred<biased_refs>>;
+
+		destroyed = 0;
+
+		auto h = make::handle<local>();
+		auto b = make::handle<biased>();
+		bool passed = false;
+		int pass = 0;
+
+		thread_loop::add([&]() {
+			switch(pass++) {
+				case 0:
+					h = nullptr;
+					std::thread([&b]() { b = nullptr; }).join();
+
+					// nothing is destroyed until the loop has finished the pass
+					passed = destroyed == 0 && release_queue::pending() == 1;
+					return 0;
+
+				default:
+					passed = passed && destroyed == 2 && release_queue::pending() == 0;
+					return 1;
+			}
+		});
+
+		thread_loop::run();
+
+		if(!passed) {
+			std::cout << "thread_loop: deferred objects were not destroyed after the pass" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
 	static entrance open([]() {
 		std::cout << "create: " << std::endl;
 		create();
 		
 		std::cout << "assign: " << std::endl;
 		assign();
+
+		if(!count_references<plain_refs>("plain_refs") || !count_references<atomic_refs>("atomic_refs") || !count_references<biased_refs>("biased_refs")) {
+			return 1;
+		}
+
+		if(!atomic_references() || !biased_references()) {
+			return 1;
+		}
+
+		if(!deferred_releases() || !looped_releases()) {
+			return 1;
+		}
+
+		return 0;
 	});
 }
 
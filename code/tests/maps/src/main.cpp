@@ -1,101 +1,461 @@
 //---------------------------------------------------------------------------
 
 #include <application/starter.h>
+#include <container/flat_map.h>
+#include <container/flat_set.h>
+#include <core/String.h>
+#include <core/Hash.h>
+#include <core/algorithm/crc32.h>
+#include <meta/class_id.hpp>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <hopscotch_map.h>
 
-#include <benchmark>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
 
 //---------------------------------------------------------------------------
 
-static const int KEYS_COUNT = 1000;
+static const size_t KEYS_COUNTS[] = {1000, 100000, 10000000};
 
 namespace asd
 {
 	template<class Key, class Val, class Hash = std::hash<Key>, class EqualTo = std::equal_to<Key>, class Alloc = std::allocator<std::pair<Key, Val>>>
 	using hash_map = tsl::hopscotch_map<Key, Val, Hash, EqualTo, Alloc, 30, true>;
-	using h_map_t = hash_map<size_t, size_t>;
+
 	using std_map_t = std::unordered_map<size_t, size_t>;
-	
-	static entrance open([]() {
-		h_map_t h_map;
-		std_map_t std_map;
-		
-		std::hash<size_t> hasher;
-		asd::array_list<pair<size_t, size_t>> keys;
-		
-		for(size_t i = 0; i < KEYS_COUNT; ++i) {
-			keys.push_back({i, hasher(i)});
-		}
-		
-		std::shuffle(keys.begin(), keys.end(), std::default_random_engine());
-		
-		benchmark("std::unordered_map sequential insert") << [&]() {
-			for(size_t i = 0; i < KEYS_COUNT; ++i) {
-				std_map.insert(std_map_t::value_type{i, i});
-			}
-			
-			std_map.clear();
-		};
-		
-		benchmark("hopscotch_map sequential insert") << [&]() {
-			for(size_t i = 0; i < KEYS_COUNT; ++i) {
-				h_map.insert(h_map_t::value_type{i, i});
+	using h_map_t = hash_map<size_t, size_t>;
+	using flat_map_t = flat_map<size_t, size_t>;
+
+	/**
+	 *	Checks that <map> holds exactly the entries of <expected>, visiting
+	 *	every entry once both by iteration and by lookup.
+	 */
+	template<class Map, class Expected>
+	static bool same_entries(const Map & map, const Expected & expected)
+	{
+		if(map.size() != expected.size() || map.empty() != expected.empty()) {
+			return false;
+		}
+
+		size_t visited = 0;
+
+		for(auto & entry : map) {
+			auto it = expected.find(entry.first);
+
+			if(it == expected.end() || it->second != entry.second) {
+				return false;
 			}
-			
-			h_map.clear();
-		};
-		
-		std_map.clear();
-		
-		benchmark("std::unordered_map random insert") << [&]() {
-			for(size_t i = 0; i < KEYS_COUNT; ++i) {
-				std_map.insert(std_map_t::value_type{keys[i].first, i});
-			}
-			
-			std_map.clear();
-		};
-		
-		benchmark("hopscotch_map random insert") << [&]() {
-			for(size_t i = 0; i < KEYS_COUNT; ++i) {
-				h_map.insert(h_map_t::value_type{keys[i].first, i});
+
+			++visited;
+		}
+
+		if(visited != expected.size()) {
+			return false;
+		}
+
+		for(auto & entry : expected) {
+			auto it = map.find(entry.first);
+
+			if(it == map.end() || it->second != entry.second || map.count(entry.first) != 1) {
+				return false;
 			}
-			
-			h_map.clear();
-		};
-		
-		for(size_t i = 0; i < KEYS_COUNT; ++i) {
-			std_map.insert(std_map_t::value_type{keys[i].first, i});
 		}
-		
-		for(size_t i = 0; i < KEYS_COUNT; ++i) {
-			h_map.insert(h_map_t::value_type{keys[i].first, i});
+
+		return true;
+	}
+
+	template<class Set, class Expected>
+	static bool same_keys(const Set & set, const Expected & expected)
+	{
+		if(set.size() != expected.size()) {
+			return false;
 		}
-		
-		{
-			size_t acc = 0;
-			
-			benchmark("std::unordered_map get") << [&]() {
-				for(size_t i = 0; i < KEYS_COUNT; ++i) {
-					acc += std_map.at(keys[i].first);
+
+		size_t visited = 0;
+
+		for(auto & key : set) {
+			if(expected.count(key) != 1) {
+				return false;
+			}
+
+			++visited;
+		}
+
+		if(visited != expected.size()) {
+			return false;
+		}
+
+		for(auto & key : expected) {
+			if(!set.contains(key)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 *	Runs a random sequence of inserts, erases and rehashes over a small
+	 *	key range so that the same slots are erased and reused many times
+	 *	(tombstones), checking the flat_map against std::unordered_map.
+	 */
+	static bool check_flat_map()
+	{
+		static const size_t OPS = 200000;
+		static const size_t KEYS = 2000;
+
+		std::mt19937_64 random(1);
+		flat_map_t map;
+		std_map_t expected;
+
+		for(size_t i = 0; i < OPS; ++i) {
+			size_t key = random() % KEYS;
+			size_t value = random();
+
+			switch(random() % 8) {
+				case 0:
+				case 1: {
+					auto a = map.insert({key, value});
+					auto b = expected.insert({key, value});
+
+					if(a.second != b.second || a.first->first != key || a.first->second != b.first->second) {
+						std::cout << "flat_map::insert differs from std::unordered_map at op " << i << std::endl;
+						return false;
+					}
+
+					break;
 				}
-			};
-			
-			std::cout << acc << std::endl;
+
+				case 2: {
+					auto a = map.insert_or_assign(key, value);
+					auto b = expected.find(key) == expected.end();
+					expected[key] = value;
+
+					if(a.second != b || a.first->second != value) {
+						std::cout << "flat_map::insert_or_assign differs from std::unordered_map at op " << i << std::endl;
+						return false;
+					}
+
+					break;
+				}
+
+				case 3:
+					map[key] += value;
+					expected[key] += value;
+					break;
+
+				case 4:
+				case 5:
+					if(map.erase(key) != expected.erase(key)) {
+						std::cout << "flat_map::erase(key) differs from std::unordered_map at op " << i << std::endl;
+						return false;
+					}
+
+					break;
+
+				case 6: {
+					auto it = map.find(key);
+
+					if((it == map.end()) != (expected.find(key) == expected.end())) {
+						std::cout << "flat_map::find differs from std::unordered_map at op " << i << std::endl;
+						return false;
+					}
+
+					if(it != map.end()) {
+						map.erase(it);
+						expected.erase(key);
+					}
+
+					break;
+				}
+
+				default:
+					switch(random() % 64) {
+						case 0:
+							map.rehash(0);
+							break;
+
+						case 1:
+							map.reserve(map.size() + random() % KEYS);
+							break;
+
+						case 2:
+							map.rehash(random() % (4 * KEYS));
+							break;
+
+						case 3:
+							if(random() % 16 == 0) {
+								map.clear();
+								expected.clear();
+							}
+
+							break;
+
+						default:
+							break;
+					}
+
+					if(map.load_factor() > 1.0f || map.size() > map.capacity()) {
+						std::cout << "flat_map is overfilled at op " << i << std::endl;
+						return false;
+					}
+
+					break;
+			}
+
+			if(i % 1000 == 0 && !same_entries(map, expected)) {
+				std::cout << "flat_map contents differ from std::unordered_map at op " << i << std::endl;
+				return false;
+			}
 		}
-		
-		{
-			size_t acc = 0;
-			
-			benchmark("hopscotch_map get") << [&]() {
-				for(int i = 0; i < KEYS_COUNT; ++i) {
-					acc += h_map.at(keys[i].first, keys[i].second);
+
+		if(!same_entries(map, expected)) {
+			std::cout << "flat_map contents differ from std::unordered_map" << std::endl;
+			return false;
+		}
+
+		flat_map_t copy(map);
+		flat_map_t moved(std::move(copy));
+
+		if(!same_entries(moved, expected) || !copy.empty() || copy.find(0) != copy.end()) {
+			std::cout << "flat_map copy or move lost entries" << std::endl;
+			return false;
+		}
+
+		copy = moved;
+		moved.erase(moved.begin(), moved.end());
+
+		if(!same_entries(copy, expected) || !moved.empty() || moved.begin() != moved.end()) {
+			std::cout << "flat_map range erase or copy assignment failed" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool check_flat_set()
+	{
+		static const size_t OPS = 100000;
+		static const size_t KEYS = 1000;
+
+		std::mt19937_64 random(2);
+		flat_set<size_t> set;
+		std::unordered_set<size_t> expected;
+
+		for(size_t i = 0; i < OPS; ++i) {
+			size_t key = random() % KEYS;
+
+			if(random() % 2 == 0) {
+				if(set.insert(key).second != expected.insert(key).second) {
+					std::cout << "flat_set::insert differs from std::unordered_set at op " << i << std::endl;
+					return false;
 				}
-			};
-			
-			std::cout << acc << std::endl;
+			} else if(set.erase(key) != expected.erase(key)) {
+				std::cout << "flat_set::erase differs from std::unordered_set at op " << i << std::endl;
+				return false;
+			}
+
+			if(i % 10000 == 0) {
+				set.rehash(0);
+			}
+
+			if(i % 1000 == 0 && !same_keys(set, expected)) {
+				std::cout << "flat_set contents differ from std::unordered_set at op " << i << std::endl;
+				return false;
+			}
 		}
+
+		return same_keys(set, expected);
+	}
+
+	struct crc32_hash
+	{
+		size_t operator()(const std::string & key) const
+		{
+			return crc32(key.data(), key.size());
+		}
+	};
+
+	/**
+	 *	Fills a flat_map with the given keys next to std::unordered_map with
+	 *	the same hasher, erases every third of them and compares the results.
+	 */
+	template<class Key, class Hash, class Keys>
+	static bool check_keys(const char * name, const Keys & keys)
+	{
+		flat_map<Key, size_t, Hash> map;
+		std::unordered_map<Key, size_t, Hash> expected;
+
+		for(size_t i = 0; i < keys.size(); ++i) {
+			map.emplace(keys[i], i);
+			expected.emplace(keys[i], i);
+		}
+
+		for(size_t i = 0; i < keys.size(); i += 3) {
+			map.erase(keys[i]);
+			expected.erase(keys[i]);
+		}
+
+		for(auto & entry : expected) {
+			auto it = map.find(entry.first, Hash()(entry.first));
+
+			if(it == map.end() || it->second != entry.second) {
+				std::cout << name << " keys aren't found by a precomputed hash" << std::endl;
+				return false;
+			}
+		}
+
+		if(!same_entries(map, expected)) {
+			std::cout << name << " keys differ from std::unordered_map" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	struct class_id_origin {};
+
+	template<int>
+	struct class_id_key {};
+
+	template<int ... I>
+	static array_list<class_id_t> class_ids(std::integer_sequence<int, I...>)
+	{
+		return {relative_class_id<class_id_key<I>, class_id_origin>...};
+	}
+
+	static bool check_hashes()
+	{
+		std::mt19937_64 random(3);
+		array_list<std::string> strings;
+		array_list<hashed<std::string>> hashed_strings;
+
+		for(size_t i = 0; i < 10000; ++i) {
+			strings.push_back("key_" + std::to_string(random() % 20000));
+			hashed_strings.emplace_back(strings.back());
+		}
+
+		return
+			check_keys<std::string, asd::hash<std::string>>("asd::hash", strings) &&
+			check_keys<std::string, lookup3hash<std::string>>("lookup3hash", strings) &&
+			check_keys<std::string, crc32_hash>("crc32", strings) &&
+			check_keys<hashed<std::string>, asd::hash<hashed<std::string>>>("hashed<std::string>", hashed_strings) &&
+			check_keys<class_id_t, asd::hash<class_id_t>>("class_id", class_ids(std::make_integer_sequence<int, 64>()));
+	}
+
+	/**
+	 *	Runs <func> enough times to take at least 100 ms and returns the mean
+	 *	time per one of <ops> operations made by a single run. <prepare> is
+	 *	called before each run and isn't measured.
+	 */
+	template<class P, class F>
+	double measure(size_t ops, P && prepare, F && func)
+	{
+		using namespace std::chrono;
+
+		size_t runs = 0;
+		nanoseconds total {0};
+
+		do {
+			prepare();
+
+			auto start = high_resolution_clock::now();
+			func();
+			total += duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+			++runs;
+		} while(total < milliseconds(100));
+
+		return static_cast<double>(total.count()) / (runs * ops);
+	}
+
+	template<class F>
+	double measure(size_t ops, F && func)
+	{
+		return measure(ops, []() {}, func);
+	}
+
+	static void report(const char * map, const char * test, size_t count, double ns)
+	{
+		std::cout << std::setw(20) << std::left << map << std::setw(12) << test << std::setw(10) << std::right << count << ": " << std::fixed << std::setprecision(2) << ns << " ns/op" << std::endl;
+	}
+
+	template<class Map>
+	void test(const char * name, const array_list<size_t> & keys, const array_list<size_t> & missing)
+	{
+		size_t count = keys.size();
+		size_t acc = 0;
+
+		Map map;
+
+		auto fill = [&]() {
+			for(auto key : keys) {
+				map.insert({key, key});
+			}
+		};
+
+		report(name, "insert", count, measure(count, [&]() {
+			map = Map();
+		}, fill));
+
+		report(name, "hit", count, measure(count, [&]() {
+			for(auto key : keys) {
+				acc += map.find(key)->second;
+			}
+		}));
+
+		report(name, "miss", count, measure(count, [&]() {
+			for(auto key : missing) {
+				acc += map.find(key) == map.end() ? 0 : 1;
+			}
+		}));
+
+		report(name, "iterate", count, measure(count, [&]() {
+			for(auto & entry : map) {
+				acc += entry.second;
+			}
+		}));
+
+		report(name, "erase", count, measure(count, fill, [&]() {
+			for(auto key : keys) {
+				acc += map.erase(key);
+			}
+		}));
+
+		std::cout << acc << std::endl;
+	}
+
+	static entrance open([]() {
+		if(!check_flat_map() || !check_flat_set() || !check_hashes()) {
+			return 1;
+		}
+
+		std::mt19937_64 random;
+
+		for(auto count : KEYS_COUNTS) {
+			array_list<size_t> keys;
+			array_list<size_t> missing;
+
+			keys.reserve(count);
+			missing.reserve(count);
+
+			// present keys are even, missing ones are odd
+			for(size_t i = 0; i < count; ++i) {
+				keys.push_back(random() & ~size_t(1));
+				missing.push_back(random() | 1);
+			}
+
+			test<std_map_t>("std::unordered_map", keys, missing);
+			test<h_map_t>("hopscotch_map", keys, missing);
+			test<flat_map_t>("asd::flat_map", keys, missing);
+
+			std::cout << std::endl;
+		}
+
+		return 0;
 	});
 }
 
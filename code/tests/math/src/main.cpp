@@ -5,8 +5,16 @@
 #include <math/vector.h>
 #include <math/matrix.h>
 #include <math/quaternion.h>
+#include <math/batch.h>
+#include <math/culling.h>
+#include <math/quantized.h>
+#include <math/intersection.h>
+#include <math/approx.h>
+#include <math/small.h>
+#include <core/intrinsic/CpuFeatures.h>
 
 #include <iostream>
+#include <random>
 
 #include <benchmark>
 
@@ -41,6 +49,164 @@ namespace asd
 		math::fvec position;
 	};
 
+	// y += a * x, the 8-wide version is compiled with AVX2 in wide.cpp
+	void axpy_avx2(float a, const float * x, float * y, size_t count);
+
+	// out = approx::sin(x), 8-wide in wide.cpp
+	void sin_avx2(const float * x, float * out, size_t count);
+
+	static void axpy_sse(float a, const float * x, float * y, size_t count) {
+		using Intrin = Intrinsic<float, 4>;
+
+		auto va = Intrin::fill(a);
+		size_t i = 0;
+
+		for(; i + 4 <= count; i += 4) {
+			Intrin::store_unaligned(Intrin::fmadd(va, Intrin::load_unaligned(x + i), Intrin::load_unaligned(y + i)), y + i);
+		}
+
+		for(; i < count; ++i) {
+			y[i] += a * x[i];
+		}
+	}
+
+	static void sin_sse(const float * x, float * out, size_t count) {
+		using Intrin = Intrinsic<float, 4>;
+		size_t i = 0;
+
+		for(; i + 4 <= count; i += 4) {
+			Intrin::store_unaligned(math::approx::sin(Intrin::load_unaligned(x + i)), out + i);
+		}
+
+		for(; i < count; ++i) {
+			out[i] = math::approx::sin(x[i]);
+		}
+	}
+
+	// maximal error of f on [lo, hi] against the reference g, relative to results greater than 1
+	template<class F, class G>
+	static double max_error(F f, G g, double lo, double hi) {
+		const int COUNT = 100000;
+		double error = 0.0;
+
+		for(int i = 0; i <= COUNT; ++i) {
+			float x = static_cast<float>(lo + (hi - lo) * i / COUNT);
+			double r = g(x);
+			error = std::max(error, std::abs(f(x) - r) / std::max(std::abs(r), 1.0));
+		}
+
+		return error;
+	}
+
+	// checks errors of approximations against the bounds of the accuracy tier A
+	template<math::accuracy A>
+	static bool check_accuracy(const char * tier, double bound) {
+		using namespace std;
+		using namespace math;
+
+		struct
+		{
+			const char * name;
+			double error;
+			double bound;
+		} results[] = {
+			{"sin", max_error([](float x) { return approx::sin<A>(x); }, [](double x) { return std::sin(x); }, -100.0, 100.0), bound},
+			{"cos", max_error([](float x) { return approx::cos<A>(x); }, [](double x) { return std::cos(x); }, -100.0, 100.0), bound},
+			{"atan2", max_error([](float a) { return approx::atan2<A>(2.0f * std::sin(a), std::cos(a)); }, [](double a) { return std::atan2(static_cast<double>(2.0f * std::sin(static_cast<float>(a))), static_cast<double>(std::cos(static_cast<float>(a)))); }, -3.14, 3.14), bound},
+			{"exp", max_error([](float x) { return approx::exp<A>(x); }, [](double x) { return std::exp(x); }, -80.0, 80.0), bound},
+			{"log", max_error([](float x) { return approx::log<A>(x); }, [](double x) { return std::log(x); }, 1e-3, 1e3), bound},
+			{"rsqrt", max_error([](float x) { return approx::rsqrt<A>(x); }, [](double x) { return 1.0 / std::sqrt(x); }, 1e-3, 1e3), bound},
+			{"acos", max_error([](float x) { return approx::acos<A>(x); }, [](double x) { return std::acos(x); }, -1.0, 1.0), bound}
+		};
+
+		bool passed = true;
+
+		for(auto & r : results) {
+			cout << "approx::" << r.name << " (" << tier << ") error: " << r.error << endl;
+
+			if(r.error > r.bound) {
+				cout << "  exceeds " << r.bound << endl;
+				passed = false;
+			}
+		}
+
+		return passed;
+	}
+
+	// runs the common operations on vectors of T and returns their times in ns
+	template <class T>
+	static std::vector<long long> precision_benchmark(const char * type) {
+		using namespace std;
+		using vec = math::vector<T>;
+		using mat = math::matrix<T>;
+		using quat = math::quaternion<T>;
+
+		const size_t COUNT = 10000;
+
+		std::vector<vec, aligned_allocator<vec>> a(COUNT), b(COUNT), results(COUNT);
+		std::vector<mat, aligned_allocator<mat>> matrices(COUNT);
+
+		std::mt19937 random;
+		std::uniform_real_distribution<T> distribution(-100, 100);
+
+		for(size_t i = 0; i < COUNT; ++i) {
+			a[i] = vec(distribution(random), distribution(random), distribution(random), 1);
+			b[i] = vec(distribution(random), distribution(random), distribution(random), 0);
+			matrices[i] = quat(a[i].x, a[i].y, a[i].z).to_matrix();
+			matrices[i].translate(b[i]);
+		}
+
+		const mat matrix = matrices[0];
+		const quat rotation(T(4), T(5), T(3));
+		const string suffix = string(" x10k (") + type + ")";
+
+		std::vector<long long> times {
+			benchmark("add/mul" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = a[i] * b[i] + a[i];
+				}
+			},
+			benchmark("dot" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = a[i].dot(b[i]);
+				}
+			},
+			benchmark("cross" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = a[i].cross(b[i]);
+				}
+			},
+			benchmark("normalized" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = a[i].normalized();
+				}
+			},
+			benchmark("transform_point" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = matrix.transform_point(a[i]);
+				}
+			},
+			benchmark("quaternion::apply_to" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = rotation.apply_to(a[i]);
+				}
+			},
+			benchmark("matrix * matrix" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					matrices[i] = matrix * matrices[i];
+				}
+			},
+			benchmark("matrix::inverse" + suffix) << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					matrices[i] = matrices[i].inverse();
+				}
+			}
+		};
+
+		cout << results[COUNT - 1] << " " << matrices[COUNT - 1](0) << endl;
+		return times;
+	}
+
 	static entrance open([]() {
 		using namespace std;
 
@@ -101,6 +267,786 @@ namespace asd
 			cout << Data::get<0>(vec2) << " " << Data::get<1>(vec2) << " " << Data::get<2>(vec2) << " " << Data::get<3>(vec2) << endl;
 		}
 		
+		{
+			const size_t COUNT = 100000;
+
+			std::vector<math::fvec> points(COUNT), results(COUNT);
+			std::vector<float> x(COUNT), y(COUNT), z(COUNT), ox(COUNT), oy(COUNT), oz(COUNT);
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				x[i] = distribution(random);
+				y[i] = distribution(random);
+				z[i] = distribution(random);
+				points[i] = math::vec(x[i], y[i], z[i]);
+			}
+
+			math::soa3<const float> in(x.data(), y.data(), z.data(), COUNT);
+			math::soa3<float> out(ox.data(), oy.data(), oz.data(), COUNT);
+
+			const auto & matrix = obj->matrix;
+			const auto & rotation = dir->rotation;
+
+			benchmark("AoS transform_point x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = matrix.transform_point(points[i]);
+				}
+			};
+
+			benchmark("AoS quaternion::apply_to x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = rotation.apply_to(points[i]);
+				}
+			};
+
+			benchmark("AoS normalized x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					results[i] = points[i].normalized();
+				}
+			};
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				string suffix = string(" x100k (") + simd_path_name(path) + ")";
+
+				benchmark("SoA transform_points" + suffix) << [&]() {
+					math::batch::transform_points(matrix, in, out);
+				};
+
+				benchmark("SoA rotate" + suffix) << [&]() {
+					math::batch::rotate(rotation, in, out);
+				};
+
+				benchmark("SoA normalize" + suffix) << [&]() {
+					math::batch::normalize(in, out);
+				};
+			}
+
+			limit_simd_path(best);
+			cout << results[COUNT - 1] << " " << ox[COUNT - 1] << endl;
+		}
+
+		{
+			const size_t COUNT = 10000;
+
+			std::vector<float> x(COUNT, 1.0f), y(COUNT, 0.0f);
+			simd_dispatch<void(float, const float *, float *, size_t)> axpy(axpy_sse, nullptr, axpy_avx2);
+
+			auto best = current_simd_path();
+
+			limit_simd_path(simd_path::sse2);
+
+			benchmark("axpy x10k (Intrinsic<float, 4>)") << [&]() {
+				axpy(0.5f, x.data(), y.data(), COUNT);
+			};
+
+			limit_simd_path(best);
+
+			benchmark(string("axpy x10k (") + simd_path_name(best) + ")") << [&]() {
+				axpy(0.5f, x.data(), y.data(), COUNT);
+			};
+
+			cout << y[COUNT - 1] << endl;
+		}
+
+		{
+			const size_t COUNT = 100000;
+
+			std::vector<float> x(COUNT), y(COUNT), z(COUNT), r(COUNT), ex(COUNT), ey(COUNT), ez(COUNT);
+			std::vector<uint32_t> visible(COUNT);
+			std::vector<byte> coherency(COUNT, 0);
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> position(-1000.0f, 1000.0f), size(0.5f, 5.0f);
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				x[i] = position(random);
+				y[i] = position(random);
+				z[i] = position(random);
+				r[i] = size(random);
+				ex[i] = r[i];
+				ey[i] = r[i] * 0.5f;
+				ez[i] = r[i];
+			}
+
+			math::soa4<const float> spheres(x.data(), y.data(), z.data(), r.data(), COUNT);
+			math::soa3<const float> centers(x.data(), y.data(), z.data(), COUNT), extents(ex.data(), ey.data(), ez.data(), COUNT);
+
+			auto view = math::fmat::look_to(math::vec(0, 0, 0, 1), math::vector_constants<float>::forward, math::vector_constants<float>::up);
+			const math::ffrustum frustum(view * math::fmat::perspective(60.0f, 1.0f, 0.1f, 1000.0f));
+
+			size_t expected_spheres = 0, expected_boxes = 0;
+
+			benchmark("frustum::intersects (spheres) x100k") << [&]() {
+				expected_spheres = 0;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					expected_spheres += frustum.intersects(math::vec(x[i], y[i], z[i], 1), r[i]);
+				}
+			};
+
+			benchmark("frustum::intersects (boxes) x100k") << [&]() {
+				expected_boxes = 0;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					auto center = math::vec(x[i], y[i], z[i], 1), extent = math::vec(ex[i], ey[i], ez[i], 0);
+					expected_boxes += frustum.intersects(math::fbox(center - extent, center + extent));
+				}
+			};
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				string suffix = string(" x100k (") + simd_path_name(path) + ")";
+				size_t count = 0;
+
+				benchmark("culling::spheres" + suffix) << [&]() {
+					count = math::culling::spheres(frustum, spheres, visible.data());
+				};
+
+				if(count != expected_spheres) {
+					cout << "culling::spheres: " << count << " visible instead of " << expected_spheres << endl;
+					return 1;
+				}
+
+				benchmark("culling::spheres with coherency" + suffix) << [&]() {
+					count = math::culling::spheres(frustum, spheres, visible.data(), coherency.data());
+				};
+
+				if(count != expected_spheres) {
+					cout << "culling::spheres with coherency: " << count << " visible instead of " << expected_spheres << endl;
+					return 1;
+				}
+
+				benchmark("culling::boxes" + suffix) << [&]() {
+					count = math::culling::boxes(frustum, centers, extents, visible.data());
+				};
+
+				if(count != expected_boxes) {
+					cout << "culling::boxes: " << count << " visible instead of " << expected_boxes << endl;
+					return 1;
+				}
+			}
+
+			limit_simd_path(best);
+			cout << expected_spheres << " spheres and " << expected_boxes << " boxes of " << COUNT << " are visible" << endl;
+		}
+
+		{
+			const size_t COUNT = 50000;
+
+			std::vector<math::fmat> local(COUNT), world(COUNT), expected(COUNT), out(COUNT);
+			std::vector<uint32_t> parents(COUNT);
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> angle(-3.0f, 3.0f), offset(-10.0f, 10.0f), scale(0.8f, 1.25f);
+			std::uniform_int_distribution<uint32_t> depth(1, 16);
+
+			// parents precede their children, some nodes are children of the previous ones
+			for(size_t i = 0; i < COUNT; ++i) {
+				local[i] = math::fmat::rotation(math::vec(angle(random), angle(random), angle(random)));
+				local[i].scale(scale(random)).translate(math::vec(offset(random), offset(random), offset(random)));
+
+				auto d = depth(random);
+				parents[i] = i % 1000 == 0 ? math::batch::no_parent : static_cast<uint32_t>(d == 1 ? i - 1 : i > d * 64 ? i - d * 64 : 0);
+			}
+
+			// relative to the greatest element of each matrix
+			auto max_difference = [&](const std::vector<math::fmat> & a, const std::vector<math::fmat> & b) {
+				float difference = 0.0f;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					float d = 0.0f, norm = 1.0f;
+
+					for(int k = 0; k < 16; ++k) {
+						d = std::max(d, std::abs(a[i](k) - b[i](k)));
+						norm = std::max(norm, std::abs(b[i](k)));
+					}
+
+					difference = std::max(difference, d / norm);
+				}
+
+				return difference;
+			};
+
+			auto check = [&](const string & name, const std::vector<math::fmat> & reference) {
+				auto difference = max_difference(out, reference);
+
+				if(difference > 1e-4f) {
+					cout << name << ": difference " << difference << endl;
+					return false;
+				}
+
+				return true;
+			};
+
+			benchmark("matrix * matrix x50k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					expected[i] = local[i] * local[COUNT - 1 - i];
+				}
+			};
+
+			std::vector<math::fmat> reversed(local.rbegin(), local.rend()), inverse(COUNT), affine(COUNT), flat(COUNT);
+
+			benchmark("matrix::inverse x50k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					inverse[i] = local[i].inverse();
+				}
+			};
+
+			benchmark("matrix::affine_inverse x50k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					affine[i] = local[i].affine_inverse();
+				}
+			};
+
+			benchmark("hierarchy x50k (one by one)") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					flat[i] = parents[i] == math::batch::no_parent ? local[i] : local[i] * flat[parents[i]];
+				}
+			};
+
+			if(max_difference(affine, inverse) > 1e-4f) {
+				cout << "matrix::affine_inverse: difference " << max_difference(affine, inverse) << endl;
+				return 1;
+			}
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				string suffix = string(" x50k (") + simd_path_name(path) + ")";
+
+				benchmark("batch::multiply" + suffix) << [&]() {
+					math::batch::multiply(local.data(), reversed.data(), out.data(), COUNT);
+				};
+
+				if(!check("batch::multiply", expected)) {
+					return 1;
+				}
+
+				benchmark("batch::inverse" + suffix) << [&]() {
+					math::batch::inverse(local.data(), out.data(), COUNT);
+				};
+
+				if(!check("batch::inverse", inverse)) {
+					return 1;
+				}
+
+				benchmark("batch::inverse_transpose" + suffix) << [&]() {
+					math::batch::inverse_transpose(local.data(), out.data(), COUNT);
+				};
+
+				for(auto & m : out) {
+					m.transpose();
+				}
+
+				if(!check("batch::inverse_transpose", inverse)) {
+					return 1;
+				}
+
+				benchmark("batch::affine_inverse" + suffix) << [&]() {
+					math::batch::affine_inverse(local.data(), out.data(), COUNT);
+				};
+
+				if(!check("batch::affine_inverse", inverse)) {
+					return 1;
+				}
+
+				benchmark("batch::flatten, 1 thread" + suffix) << [&]() {
+					math::batch::flatten(local.data(), parents.data(), out.data(), COUNT, 1);
+				};
+
+				if(!check("batch::flatten", flat)) {
+					return 1;
+				}
+
+				benchmark("batch::flatten" + suffix) << [&]() {
+					math::batch::flatten(local.data(), parents.data(), out.data(), COUNT);
+				};
+
+				if(!check("batch::flatten", flat)) {
+					return 1;
+				}
+			}
+
+			limit_simd_path(best);
+			cout << out[COUNT - 1] << endl;
+		}
+
+		{
+			// every half, batch decoding must be the same as math::from_half and math::to_half must restore it
+			std::vector<uint16_t> halves(0x10000);
+			std::vector<math::fvec> decoded(0x4000);
+
+			for(size_t i = 0; i < halves.size(); ++i) {
+				halves[i] = static_cast<uint16_t>(i);
+			}
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				math::batch::decode(reinterpret_cast<const math::half_vector *>(halves.data()), decoded.data(), decoded.size());
+
+				for(size_t i = 0; i < halves.size(); ++i) {
+					float expected = math::from_half(halves[i]), result = decoded[i / 4][i % 4];
+
+					// signaling NaNs may be quieted by the conversion
+					bool same = std::isnan(expected) ? std::isnan(result) : std::memcmp(&expected, &result, sizeof(float)) == 0 && math::to_half(expected) == halves[i];
+
+					if(!same) {
+						cout << "half " << i << " is decoded to " << result << " instead of " << expected << " (" << simd_path_name(path) << ")" << endl;
+						return 1;
+					}
+				}
+			}
+
+			limit_simd_path(best);
+		}
+
+		{
+			const size_t COUNT = 1000000;
+
+			std::vector<math::fvec> positions(COUNT), scales(COUNT), decoded_positions(COUNT), decoded_scales(COUNT);
+			std::vector<math::fquat> rotations(COUNT), decoded_rotations(COUNT);
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> position(-64.0f, 64.0f), angle(-3.14f, 3.14f), scale(0.1f, 10.0f);
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				positions[i] = math::vec(position(random), position(random), position(random), 1.0f);
+				rotations[i] = math::fquat(angle(random), angle(random), angle(random));
+				scales[i] = math::vec(scale(random), scale(random), scale(random), 0.0f);
+			}
+
+			const math::fixed_cell cell(math::vec(0, 0, 0, 1), 64.0f);
+
+			std::vector<math::fixed_position> fixed(COUNT);
+			std::vector<math::quaternion32> rotations32(COUNT);
+			std::vector<math::quaternion48> rotations48(COUNT);
+			std::vector<math::half_vector> halves(COUNT);
+
+			benchmark("encode fixed_position x1M") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					fixed[i] = cell.encode(positions[i]);
+				}
+			};
+
+			benchmark("encode quaternion32 x1M") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					rotations32[i] = rotations[i];
+				}
+			};
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				rotations48[i] = rotations[i];
+				halves[i] = scales[i];
+			}
+
+			cout << "1M instances (position, rotation, scale): " <<
+				COUNT * (sizeof(math::fvec) * 2 + sizeof(math::fquat)) / 1024 << " KiB as vectors, " <<
+				COUNT * (sizeof(math::fixed_position) + sizeof(math::quaternion32) + sizeof(math::half_vector)) / 1024 << " KiB quantized" << endl;
+
+			// angle between rotations by the distance of quaternions (acos of floats is too coarse near 1), q and -q are the same
+			auto max_angle = [&](const std::vector<math::fquat> & a) {
+				float error = 0.0f;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					float d = std::min((a[i].v - rotations[i].v).magnitude(), (a[i].v + rotations[i].v).magnitude());
+					error = std::max(error, math::degrees(4.0f * std::asin(std::min(d * 0.5f, 1.0f))));
+				}
+
+				return error;
+			};
+
+			auto max_distance = [&]() {
+				float error = 0.0f;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					error = std::max(error, (decoded_positions[i] - positions[i]).max());
+				}
+
+				return error;
+			};
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				string suffix = string(" x1M (") + simd_path_name(path) + ")";
+
+				benchmark("decode fixed_position" + suffix) << [&]() {
+					math::batch::decode(cell, fixed.data(), decoded_positions.data(), COUNT);
+				};
+
+				benchmark("decode quaternion32" + suffix) << [&]() {
+					math::batch::decode(rotations32.data(), decoded_rotations.data(), COUNT);
+				};
+
+				if(max_distance() > 0.5f * 64.0f / 32767.0f + 1e-5f || max_angle(decoded_rotations) > 0.3f) {
+					cout << "fixed_position and quaternion32: errors " << max_distance() << " and " << max_angle(decoded_rotations) << endl;
+					return 1;
+				}
+
+				benchmark("decode quaternion48" + suffix) << [&]() {
+					math::batch::decode(rotations48.data(), decoded_rotations.data(), COUNT);
+				};
+
+				if(max_angle(decoded_rotations) > 0.01f) {
+					cout << "quaternion48: error " << max_angle(decoded_rotations) << endl;
+					return 1;
+				}
+
+				benchmark("decode half_vector" + suffix) << [&]() {
+					math::batch::decode(halves.data(), decoded_scales.data(), COUNT);
+				};
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					if(decoded_scales[i] != halves[i].decode() || (decoded_rotations[i].v - rotations48[i].decode().v).max() > 1e-6f) {
+						cout << "batch decoding differs from decode() at " << i << endl;
+						return 1;
+					}
+				}
+			}
+
+			limit_simd_path(best);
+		}
+
+		{
+			const size_t COUNT = 100000;
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f), size(0.5f, 5.0f), angle(-3.14f, 3.14f);
+
+			std::vector<math::fbox> boxes(COUNT);
+			std::vector<math::fsphere> spheres(COUNT);
+			std::vector<float> bounds[7]; // min, max and radius
+
+			for(auto & b : bounds) {
+				b.resize(COUNT);
+			}
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				math::fvec center(position(random), position(random), position(random));
+				boxes[i] = math::fbox::around(center, math::fvec(size(random), size(random), size(random)));
+				spheres[i] = math::fsphere(center, size(random));
+
+				for(int c = 0; c < 3; ++c) {
+					bounds[c][i] = boxes[i].min[c];
+					bounds[c + 3][i] = boxes[i].max[c];
+				}
+
+				bounds[6][i] = spheres[i].radius;
+			}
+
+			math::soa3<const float> min(bounds[0].data(), bounds[1].data(), bounds[2].data(), COUNT);
+			math::soa3<const float> max(bounds[3].data(), bounds[4].data(), bounds[5].data(), COUNT);
+			math::soa4<const float> centers(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[6].data(), COUNT); // corners are used as centers
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				spheres[i].center = boxes[i].min;
+			}
+
+			math::fray ray(math::fvec(position(random), position(random), position(random)), math::fvec(position(random), position(random), position(random)).normalize());
+			math::fbox query = math::fbox::around(math::vec(0, 0, 0), math::vec(30, 30, 30));
+			math::fsphere ball(math::vec(0, 0, 0), 30.0f);
+
+			std::vector<uint32_t> hits(COUNT);
+			std::vector<float> distances(COUNT);
+
+			// volumes close to the boundary may go either way, so results must only be between the ones for shrunk and grown volumes
+			auto check = [&](const char * title, size_t count, const std::function<bool(size_t, float)> & expected) {
+				std::vector<bool> hit(COUNT, false);
+
+				for(size_t k = 0; k < count; ++k) {
+					hit[hits[k]] = true;
+				}
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					if(hit[i] ? !expected(i, 1e-3f) : expected(i, -1e-3f)) {
+						cout << title << " gives a wrong result for the volume " << i << endl;
+						return false;
+					}
+				}
+
+				return true;
+			};
+
+			auto grown = [&](size_t i, float margin) {
+				return math::fbox(boxes[i].min - math::fvec(margin, margin, margin), boxes[i].max + math::fvec(margin, margin, margin));
+			};
+
+			size_t count = 0;
+
+			benchmark("fray::intersects(fbox) x100k") << [&]() {
+				count = 0;
+
+				for(size_t i = 0; i < COUNT; ++i) {
+					float d;
+
+					if(ray.intersects(boxes[i], d)) {
+						hits[count] = static_cast<uint32_t>(i);
+						distances[count++] = d;
+					}
+				}
+			};
+
+			cout << "ray hits " << count << " boxes" << endl;
+
+			auto best = cpu_features::get().best();
+
+			for(auto path : {simd_path::sse2, simd_path::sse4, simd_path::avx2, simd_path::avx512}) {
+				if(path > best) {
+					break;
+				}
+
+				limit_simd_path(path);
+				string suffix = string(" x100k (") + simd_path_name(path) + ")";
+
+				benchmark("intersection::ray_boxes" + suffix) << [&]() {
+					count = math::intersection::ray_boxes(ray, min, max, hits.data(), distances.data());
+				};
+
+				bool passed = check("intersection::ray_boxes", count, [&](size_t i, float margin) { return ray.intersects(grown(i, margin)); });
+
+				for(size_t k = 0; k < count && passed; ++k) {
+					float d;
+					ray.intersects(grown(hits[k], 1e-3f), d);
+
+					if(std::abs(distances[k] - d) > 1e-2f) {
+						cout << "intersection::ray_boxes gives the distance " << distances[k] << " instead of " << d << endl;
+						passed = false;
+					}
+				}
+
+				benchmark("intersection::box_boxes" + suffix) << [&]() {
+					count = math::intersection::box_boxes(query, min, max, hits.data());
+				};
+
+				passed = passed && check("intersection::box_boxes", count, [&](size_t i, float margin) { return query.intersects(grown(i, margin)); });
+
+				benchmark("intersection::sphere_spheres" + suffix) << [&]() {
+					count = math::intersection::sphere_spheres(ball, centers, hits.data());
+				};
+
+				passed = passed && check("intersection::sphere_spheres", count, [&](size_t i, float margin) { return ball.intersects(math::fsphere(spheres[i].center, spheres[i].radius + margin)); });
+
+				if(!passed) {
+					return 1;
+				}
+			}
+
+			limit_simd_path(best);
+
+			// queries of single volumes must not depend on rotations of the whole scene
+			std::uniform_real_distribution<float> offset(-5.0f, 5.0f);
+
+			for(int i = 0; i < 1000; ++i) {
+				auto m = math::fmat::rotation(math::vec(angle(random), angle(random), angle(random)));
+				m.translate(math::vec(offset(random), offset(random), offset(random)));
+
+				auto & a = boxes[i];
+				auto b = math::fbox::around(a.center() + math::vec(offset(random), offset(random), offset(random)), math::vec(size(random), size(random), size(random)));
+
+				math::foriented_box oa(a, m), ob(b, m);
+				auto moved = math::fsphere(spheres[i].center, 3.0f).transformed(m);
+				math::fcapsule capsule(oa.center, ob.center, 0.5f);
+
+				bool separated = std::abs(a.center().x - b.center().x) > a.extent().x + b.extent().x + 1e-3f ||
+					std::abs(a.center().y - b.center().y) > a.extent().y + b.extent().y + 1e-3f ||
+					std::abs(a.center().z - b.center().z) > a.extent().z + b.extent().z + 1e-3f;
+
+				auto bounds = a.transformed(m), obb_bounds = oa.bounds();
+				bool same_bounds = (bounds.min - obb_bounds.min).max() < 1e-3f && (bounds.max - obb_bounds.max).max() < 1e-3f;
+
+				if(oa.intersects(ob) == separated || !same_bounds || !oa.contains(oa.closest_point(moved.center) * 0.999f + oa.center * 0.001f) ||
+					!capsule.intersects(math::fsphere(ob.center, 0.1f)) || !ray.intersects(math::fsphere(ray.point_at(50.0f), 0.1f))) {
+					cout << "bounding volumes give wrong results for the pair " << i << endl;
+					return 1;
+				}
+			}
+		}
+
+		{
+			bool passed =
+				check_accuracy<math::accuracy::fast>("fast", 1e-4) &
+				check_accuracy<math::accuracy::medium>("medium", 5e-6) &
+				check_accuracy<math::accuracy::precise>("precise", 2.5e-7);
+
+			if(!passed) {
+				return 1;
+			}
+
+			using Intrin = Intrinsic<float, 4>;
+
+			const size_t COUNT = 100000;
+
+			std::vector<float> x(COUNT), positive(COUNT), out(COUNT);
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				x[i] = distribution(random);
+				positive[i] = x[i] + 1.5f;
+			}
+
+			auto libm = [&](const char * name, auto f, const std::vector<float> & in) {
+				benchmark(string(name) + " x100k") << [&]() {
+					for(size_t i = 0; i < COUNT; ++i) {
+						out[i] = f(in[i]);
+					}
+				};
+			};
+
+			auto vectorised = [&](const char * name, auto f, const std::vector<float> & in) {
+				benchmark(string(name) + " x100k (4-wide)") << [&]() {
+					for(size_t i = 0; i < COUNT; i += 4) {
+						Intrin::store_unaligned(f(Intrin::load_unaligned(&in[i])), &out[i]);
+					}
+				};
+			};
+
+			libm("std::sin", [](float v) { return std::sin(v * 10.0f); }, x);
+			vectorised("approx::sin", [](__m128 v) { return math::approx::sin(Intrin::mul(v, Intrin::fill(10.0f))); }, x);
+			libm("std::exp", [](float v) { return std::exp(v * 10.0f); }, x);
+			vectorised("approx::exp", [](__m128 v) { return math::approx::exp(Intrin::mul(v, Intrin::fill(10.0f))); }, x);
+			libm("std::log", [](float v) { return std::log(v); }, positive);
+			vectorised("approx::log", [](__m128 v) { return math::approx::log(v); }, positive);
+			libm("std::atan2", [](float v) { return std::atan2(v, 0.5f); }, x);
+			vectorised("approx::atan2", [](__m128 v) { return math::approx::atan2(v, Intrin::fill(0.5f)); }, x);
+			libm("std::acos", [](float v) { return std::acos(v); }, x);
+			vectorised("approx::acos", [](__m128 v) { return math::approx::acos(v); }, x);
+			libm("1 / std::sqrt", [](float v) { return 1.0f / std::sqrt(v); }, positive);
+			vectorised("approx::rsqrt", [](__m128 v) { return math::approx::rsqrt(v); }, positive);
+
+			simd_dispatch<void(const float *, float *, size_t)> sin_kernel(sin_sse, nullptr, sin_avx2);
+
+			benchmark(string("approx::sin x100k (") + simd_path_name(current_simd_path()) + ")") << [&]() {
+				sin_kernel(x.data(), out.data(), COUNT);
+			};
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				if(std::abs(out[i] - std::sin(x[i])) > 5e-6f) {
+					cout << "approx::sin (" << simd_path_name(current_simd_path()) << ") error at " << x[i] << endl;
+					return 1;
+				}
+			}
+		}
+
+		{
+			// small types are computed by the compiler and have layouts of uniforms
+			constexpr auto layout = math::small::translation(math::fvec2(3.0f, 4.0f)) * math::small::scaling(math::fvec2(2.0f, 2.0f));
+
+			static_assert(layout.transform_point(math::fvec2(1.0f, 1.0f)) == math::fvec2(8.0f, 10.0f), "2D transforms must be constexpr");
+			static_assert(math::small::inverse(math::fmat2(2, 0, 0, 4)) == math::fmat2(0.5f, 0, 0, 0.25f), "2x2 inverse must be constexpr");
+			static_assert(sizeof(math::fmat3) == sizeof(std::array<float3, 3>) && sizeof(math::fvec3) == sizeof(float3), "small types must have no padding");
+			static_assert(alignof(math::fvec4) == 16 && alignof(math::dvec4) == 32, "small types filling registers must be aligned");
+
+			const size_t COUNT = 100000;
+
+			std::mt19937 random;
+			std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+			std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+			std::vector<math::fmat> models(COUNT), normals(COUNT);
+			std::vector<math::fmat3> small_normals(COUNT);
+
+			for(auto & m : models) {
+				m = math::fmat::rotation(math::vec(angle(random), angle(random), angle(random)));
+				m.scale(math::vec(scale(random), scale(random), scale(random)));
+				m.translate(math::vec(angle(random), angle(random), angle(random)));
+			}
+
+			benchmark("fmat normal matrix x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					normals[i] = models[i].inverse().transposition();
+				}
+			};
+
+			benchmark("fmat3 normal matrix x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					small_normals[i] = math::small::normal_matrix(models[i]);
+				}
+			};
+
+			for(size_t k = 0; k < COUNT; ++k) {
+				for(int i = 0; i < 3; ++i) {
+					for(int j = 0; j < 3; ++j) {
+						if(std::abs(small_normals[k](i, j) - normals[k](i, j)) > 1e-4f * std::max(1.0f, std::abs(normals[k](i, j)))) {
+							cout << "small::normal_matrix gives wrong results for the matrix " << k << endl;
+							return 1;
+						}
+					}
+				}
+			}
+
+			std::vector<math::fvec2> points(COUNT), moved(COUNT);
+			std::vector<math::fvec> wide_points(COUNT), wide_moved(COUNT);
+
+			for(size_t i = 0; i < COUNT; ++i) {
+				points[i] = {angle(random), angle(random)};
+				wide_points[i] = math::fvec(points[i][0], points[i][1], 0.0f);
+			}
+
+			auto ui = math::small::translation(math::fvec2(10.0f, 20.0f)) * math::small::rotation(0.5f) * math::small::scaling(math::fvec2(2.0f, 3.0f));
+			auto wide_ui = math::fmat::translation(math::fvec(10.0f, 20.0f, 0.0f)) * math::fmat::rotation_z(0.5f) * math::fmat::scaling(math::fvec(2.0f, 3.0f, 1.0f));
+
+			benchmark("fmat 2D transform x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					wide_moved[i] = wide_ui.transform_point(wide_points[i]);
+				}
+			};
+
+			benchmark("fmat3 2D transform x100k") << [&]() {
+				for(size_t i = 0; i < COUNT; ++i) {
+					moved[i] = ui.transform_point(points[i]);
+				}
+			};
+
+			cout << "fmat3: " << sizeof(math::fmat3) << " bytes, fmat: " << sizeof(math::fmat) << " bytes" << endl;
+			cout << moved[COUNT - 1][0] << " " << moved[COUNT - 1][1] << " / " << wide_moved[COUNT - 1].x << " " << wide_moved[COUNT - 1].y << endl;
+		}
+
+		{
+			auto f = precision_benchmark<float>("float");
+			auto d = precision_benchmark<double>("double");
+
+			const char * names[] = {"add/mul", "dot", "cross", "normalized", "transform_point", "quaternion::apply_to", "matrix * matrix", "matrix::inverse"};
+
+			cout << "double / float cost ratio:" << endl;
+
+			for(size_t i = 0; i < f.size(); ++i) {
+				cout << "  " << names[i] << ": " << static_cast<double>(d[i]) / std::max(f[i], 1LL) << endl;
+			}
+		}
+
 		return 0;
     });
 }
@@ -0,0 +1,41 @@
+//---------------------------------------------------------------------------
+
+#include <core/intrinsic/Intrinsic.h>
+#include <math/approx.h>
+
+//---------------------------------------------------------------------------
+
+namespace asd
+{
+	// compiled with AVX2 and FMA, called only through simd_dispatch
+	void axpy_avx2(float a, const float * x, float * y, size_t count) {
+		using Intrin = Intrinsic<float, 8>;
+
+		auto va = Intrin::fill(a);
+		size_t i = 0;
+
+		for(; i + 8 <= count; i += 8) {
+			Intrin::store_unaligned(Intrin::fmadd(va, Intrin::load_unaligned(x + i), Intrin::load_unaligned(y + i)), y + i);
+		}
+
+		for(; i < count; ++i) {
+			y[i] += a * x[i];
+		}
+	}
+
+	void sin_avx2(const float * x, float * out, size_t count) {
+		using Intrin = Intrinsic<float, 8>;
+
+		size_t i = 0;
+
+		for(; i + 8 <= count; i += 8) {
+			Intrin::store_unaligned(math::approx::sin(Intrin::load_unaligned(x + i)), out + i);
+		}
+
+		for(; i < count; ++i) {
+			out[i] = math::approx::sin(x[i]);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
@@ -5,6 +5,11 @@
 
 #include <iostream>
 #include <chrono>
+#include <atomic>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 //---------------------------------------------------------------------------
 
@@ -16,6 +21,26 @@ using std::chrono::nanoseconds;
 
 typedef high_resolution_clock hrc;
 
+static std::atomic<size_t> allocations {0};
+
+void * operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if(void * ptr = malloc(size)) {
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept {
+	free(ptr);
+}
+
 namespace asd
 {
 	message_class(
@@ -33,13 +58,80 @@ namespace asd
 		(int, value)
 	)
 
+	struct HeapMessage;
+
+	template<>
+	struct message_alloc<HeapMessage>
+	{
+		using type = heap_message_alloc;
+	};
+
+	message_class(
+		HeapMessage,
+		(int, value)
+	)
+
+	message_class(
+		PooledMessage,
+		(int, value)
+	)
+
+	message_class(
+		InputMessage,
+		(int, value)
+	)
+
+	message_class(
+		MoveMessage,
+		(int, value)
+	)
+
+	message_queueing(MoveMessage, normal, keep_latest);
+
+	message_class(
+		PressMessage,
+		(int, value)
+	)
+
+	message_queueing(PressMessage, urgent, keep_all);
+
 	class DummySubject : public subject
 	{
 	public:
-		bind_messages(DummySubject, DummyMessage1, DummyMessage2, DummyMessage3);
+		bind_messages(DummySubject, DummyMessage1, DummyMessage2, DummyMessage3, HeapMessage, PooledMessage, InputMessage, MoveMessage, PressMessage);
 	};
 
-	channels_api(message_test, DummySubject, DummyMessage1, DummyMessage2, DummyMessage3)
+	channels_api(message_test, DummySubject, DummyMessage1, DummyMessage2, DummyMessage3, HeapMessage, PooledMessage, InputMessage, MoveMessage, PressMessage)
+
+	static long long sum = 0;
+	static handle<PooledMessage> kept;
+	static long long delivered = 0;
+
+	using Registry = Channel<DummySubject, DummyMessage2>;
+	using Churn = Channel<DummySubject, DummyMessage3>;
+
+	static size_t firstId = 0;
+	static size_t secondId = 0;
+	static int firstCalls = 0;
+	static int secondCalls = 0;
+	static int steadyCalls = 0;
+
+	static std::vector<int> handled;
+
+	template<class F>
+	static void bench_sends(const char * name, size_t count, F send) {
+		size_t before = allocations.load();
+		auto start = hrc::now();
+
+		for(size_t i = 0; i < count; ++i) {
+			send(static_cast<int>(i));
+		}
+
+		auto elapsed = duration_cast<nanoseconds>(hrc::now() - start).count();
+		size_t allocated = allocations.load() - before;
+
+		std::cout << name << ": " << static_cast<long long>(count * 1e9 / std::max<long long>(elapsed, 1)) << " sends/s, " << static_cast<double>(allocated) / count << " allocations per send" << std::endl;
+	}
 
 	static entrance open([]() {
 		DummySubject subject;
@@ -66,6 +158,310 @@ namespace asd
 
 		std::cout << "Elapsed time: " << elapsed.count() << " ns" << std::endl;
 		std::cout << "Value: " << msg->value << std::endl;
+
+		DummySubject target;
+
+		subscription(target) {
+			onmessage(HeapMessage) {
+				sum += msg->value;
+			};
+
+			onmessage(PooledMessage) {
+				sum += msg->value;
+
+				if(msg->value == 7) {
+					kept = keep(msg);
+				}
+			};
+		}
+
+		const size_t COUNT = 1000000;
+
+		bench_sends("heap messages", COUNT, [&](int i) { target.send<HeapMessage>(target, i); });
+		bench_sends("pooled messages", COUNT, [&](int i) { target.send<PooledMessage>(target, i); });
+		bench_sends("scoped messages", COUNT, [&](int i) { target.send_scoped<PooledMessage>(target, i); });
+
+		if(kept.pointer() == nullptr || kept->value != 7 || kept->scoped() || kept.refs() != 1) {
+			std::cout << "Scoped message was not kept" << std::endl;
+			return 1;
+		}
+
+		std::cout << "Sum: " << sum << std::endl;
+
+		// events from other threads are delivered by the owner of the mailbox
+		const int SENDERS = 3;
+		const int POSTS = 200000;
+
+		DummySubject sim;
+		mailbox box;
+
+		subscription(sim) {
+			onmessage(InputMessage) {
+				delivered += msg->value;
+				msg->result = msg->value * 2;
+			};
+		}
+
+		std::vector<std::thread> senders;
+		auto posting = hrc::now();
+
+		for(int t = 0; t < SENDERS; ++t) {
+			senders.emplace_back([&sim, &box]() {
+				for(int i = 0; i < POSTS; ++i) {
+					sim.post<InputMessage>(box, sim, 1);
+				}
+			});
+		}
+
+		while(delivered < SENDERS * POSTS) {
+			if(box.drain(256) == 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		auto posted = duration_cast<nanoseconds>(hrc::now() - posting).count();
+
+		for(auto & t : senders) {
+			t.join();
+		}
+
+		std::cout << "mailbox: " << static_cast<long long>(SENDERS * POSTS * 1e9 / std::max<long long>(posted, 1)) << " posts/s from " << SENDERS << " threads" << std::endl;
+
+		std::future<handle<InputMessage>> reply;
+		std::thread requester([&]() { reply = sim.request<InputMessage>(box, sim, 21); });
+		requester.join();
+
+		box.drain();
+
+		if(reply.get()->result != 42 || box.pending() != 0) {
+			std::cout << "Request was not answered" << std::endl;
+			return 1;
+		}
+
+		// receivers may be changed during dispatch, which sees the list as it was at its start
+		DummySubject registry;
+
+		firstId = Registry::connect(registry, Receiver<DummySubject, DummyMessage2>([](handle<DummyMessage2> &, DummySubject & dest) {
+			++firstCalls;
+			Registry::disconnect(dest, firstId);
+
+			secondId = Registry::connect(dest, Receiver<DummySubject, DummyMessage2>([](handle<DummyMessage2> &, DummySubject &) {
+				++secondCalls;
+			}));
+		}));
+
+		send<DummyMessage2>(registry, 0);
+		send<DummyMessage2>(registry, 0);
+
+		if(firstCalls != 1 || secondCalls != 1 || firstId == 0 || secondId == 0 || firstId == secondId) {
+			std::cout << "Receivers were changed during dispatch incorrectly" << std::endl;
+			return 1;
+		}
+
+		// and from other threads while messages are dispatched
+		Churn::connect(registry, Receiver<DummySubject, DummyMessage3>([](handle<DummyMessage3> &, DummySubject &) {
+			++steadyCalls;
+		}));
+
+		std::atomic<bool> stop {false};
+
+		std::thread churn([&registry, &stop]() {
+			while(!stop.load()) {
+				size_t id = Churn::connect(registry, Receiver<DummySubject, DummyMessage3>([](handle<DummyMessage3> & msg, DummySubject &) {
+					++msg->value;
+				}));
+
+				std::this_thread::yield();
+				Churn::disconnect(registry, id);
+			}
+		});
+
+		const int DISPATCHES = 200000;
+
+		for(int i = 0; i < DISPATCHES; ++i) {
+			send<DummyMessage3>(registry, 0);
+		}
+
+		stop = true;
+		churn.join();
+		epoch::collect();
+
+		if(steadyCalls != DISPATCHES || epoch::pending() > 2) {
+			std::cout << "Receivers were lost while they were changed by another thread" << std::endl;
+			return 1;
+		}
+
+		mailbox bounded(16);
+		int accepted = 0;
+
+		for(int i = 0; i < 20; ++i) {
+			accepted += sim.post<InputMessage>(bounded, sim, 0) ? 1 : 0;
+		}
+
+		if(accepted != 16 || bounded.refused() != 4 || bounded.drain() != 16) {
+			std::cout << "Mailbox capacity is not respected" << std::endl;
+			return 1;
+		}
+
+		// presses overtake moves to other destinations, only the latest move is delivered to each destination
+		DummySubject pointer, other;
+
+		for(auto * s : {&pointer, &other}) {
+			subscription(*s) {
+				onmessage(MoveMessage) {
+					handled.push_back(msg->value);
+				};
+
+				onmessage(PressMessage) {
+					handled.push_back(-msg->value);
+				};
+			}
+		}
+
+		mailbox input;
+
+		for(int i = 1; i <= 1000; ++i) {
+			sim.post<MoveMessage>(input, pointer, i);
+			sim.post<MoveMessage>(input, other, i * 10);
+		}
+
+		sim.post<PressMessage>(input, pointer, 1);
+
+		if(input.drain() != 3 || input.coalesced() != 1998 || handled != std::vector<int>{1000, -1, 10000}) {
+			std::cout << "Input messages were not coalesced or prioritized" << std::endl;
+			return 1;
+		}
+
+		handled.clear();
+
+		// moves are not coalesced across presses and releases of their destination, so drags are kept
+		sim.post<MoveMessage>(input, pointer, 1);
+		sim.post<MoveMessage>(input, pointer, 2);
+		sim.post<PressMessage>(input, pointer, 1);
+		sim.post<MoveMessage>(input, pointer, 3);
+		sim.post<MoveMessage>(input, other, 30);
+		sim.post<MoveMessage>(input, pointer, 4);
+		sim.post<PressMessage>(input, pointer, 2);
+		sim.post<MoveMessage>(input, pointer, 5);
+
+		if(input.drain() != 6 || input.coalesced() != 2000 || handled != std::vector<int>{2, -1, 4, -2, 30, 5}) {
+			std::cout << "Drag was reordered by the mailbox" << std::endl;
+			return 1;
+		}
+
+		handled.clear();
+
+		// each press takes only the earlier messages to its own destination along
+		sim.post<MoveMessage>(input, pointer, 1);
+		sim.post<MoveMessage>(input, other, 10);
+		sim.post<PressMessage>(input, other, 1);
+		sim.post<MoveMessage>(input, pointer, 2);
+		sim.post<PressMessage>(input, pointer, 2);
+		sim.post<MoveMessage>(input, other, 20);
+
+		if(input.drain() != 5 || input.coalesced() != 2001 || handled != std::vector<int>{10, -1, 2, -2, 20}) {
+			std::cout << "Presses to different destinations were reordered by the mailbox" << std::endl;
+			return 1;
+		}
+
+		handled.clear();
+
+		std::atomic<bool> moving {true};
+		int moves = 0;
+
+		std::thread mouse([&sim, &input, &pointer, &moving]() {
+			for(int i = 0; i < POSTS; ++i) {
+				sim.post<MoveMessage>(input, pointer, i);
+			}
+
+			moving = false;
+		});
+
+		while(moving.load() || input.pending() != 0) {
+			if(input.drain(256) == 0) {
+				std::this_thread::yield();
+			}
+
+			moves += static_cast<int>(handled.size());
+			handled.clear();
+		}
+
+		mouse.join();
+
+		std::cout << "coalescing: " << moves << " of " << POSTS << " moves handled" << std::endl;
+
+		if(moves == 0 || moves > POSTS || input.coalesced() != 2001 + static_cast<size_t>(POSTS - moves)) {
+			std::cout << "Coalesced moves were lost" << std::endl;
+			return 1;
+		}
+
+		// histograms never underestimate values and keep them within 1/32
+		for(uint64_t v : {0ull, 1ull, 63ull, 64ull, 65ull, 1000ull, 123456789ull, 1ull << 40, ~0ull}) {
+			uint64_t h = latency_histogram::highest(latency_histogram::bucket(v));
+
+			if(h < v || h - v > v / 32) {
+				std::cout << "Histogram bucket of " << v << " is wrong" << std::endl;
+				return 1;
+			}
+		}
+
+		message_tracing::enable();
+		bench_sends("traced messages", COUNT, [&](int i) { target.send<HeapMessage>(target, i); });
+		message_tracing::disable();
+
+		// recorded sessions are replayed into other subjects in the same order
+		std::stringstream log(std::ios::in | std::ios::out | std::ios::binary);
+		mailbox traced;
+		handled.clear();
+
+		message_tracing::record(log);
+
+		if(message_tracing::track(&pointer) != 0) {
+			std::cout << "Destination was not tracked" << std::endl;
+			return 1;
+		}
+
+		for(int i = 1; i <= 100; ++i) {
+			sim.post<PressMessage>(traced, pointer, i);
+			send<MoveMessage>(other, i);
+		}
+
+		traced.drain();
+		message_tracing::disable();
+
+		auto presses = message_stats::of<PressMessage>().get();
+
+		if(presses.dispatches != 100 || presses.receivers != 100 || presses.receiverTime.count != 100 || presses.latency.count != 100) {
+			std::cout << "Messages were not traced" << std::endl;
+			return 1;
+		}
+
+		std::cout << message_tracing::text();
+
+		auto recorded = handled;
+		handled.clear();
+
+		DummySubject replica;
+
+		subscription(replica) {
+			onmessage(MoveMessage) {
+				handled.push_back(msg->value);
+			};
+
+			onmessage(PressMessage) {
+				handled.push_back(-msg->value);
+			};
+		}
+
+		message_player player(log);
+		player.route<PressMessage>(0, replica);
+		player.route<MoveMessage>(replica);
+
+		if(player.play() != 200 || player.skipped() != 0 || handled != recorded) {
+			std::cout << "Recorded messages were not replayed" << std::endl;
+			return 1;
+		}
+		return 0;
 	});
 }
 
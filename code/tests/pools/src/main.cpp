@@ -0,0 +1,862 @@
+//---------------------------------------------------------------------------
+
+#include <application/starter.h>
+#include <container/segmented_any_list.h>
+#include <core/memory/Pool.h>
+#include <core/memory/PagePool.h>
+#include <core/memory/arena.h>
+#include <core/memory/allocator/pool_alloc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+//---------------------------------------------------------------------------
+
+/**
+ * @brief
+ *
+ * Contention benchmark of the thread-safe block pool.
+ * Every thread repeatedly allocates a group of blocks and frees them back,
+ * each group is freed by the neighbouring thread to emulate objects which are
+ * created on one thread and released on another one.
+ * The lock-free pool is compared to the plain block pool guarded by a mutex
+ * and to malloc/free. Then the same is done for objects which use pool_alloc
+ * with and without per-thread magazines.
+ *
+ * Behaviour of the pools is checked before the benchmark, the test exits
+ * with code 1 if a check fails.
+ */
+
+namespace asd
+{
+	using namespace std::chrono;
+	using hrc = high_resolution_clock;
+	
+	struct block
+	{
+		size_t data[4];
+	};
+	
+	static const int OPERATIONS = 200000;
+	static const int GROUP_SIZE = 64;
+	
+	struct lock_free_allocator
+	{
+		block * allocate() {
+			return pool.allocate();
+		}
+		
+		void free(block * ptr) {
+			pool.free(ptr);
+		}
+		
+		block_pool<block, 0x1000, thread_safe_pool> pool;
+	};
+	
+	struct locked_allocator
+	{
+		block * allocate() {
+			std::lock_guard<std::mutex> guard(mutex);
+			return pool.allocate();
+		}
+		
+		void free(block * ptr) {
+			std::lock_guard<std::mutex> guard(mutex);
+			pool.free(ptr);
+		}
+		
+		std::mutex mutex;
+		block_pool<block, 0x1000> pool;
+	};
+	
+	struct malloc_allocator
+	{
+		block * allocate() {
+			return static_cast<block *>(malloc(sizeof(block)));
+		}
+		
+		void free(block * ptr) {
+			::free(ptr);
+		}
+	};
+	
+	template<size_t size, class Tag = void>
+	struct shared_pool
+	{
+		struct type : block_pool<std::aligned_storage_t<size, alignof(magazine_header)>, 0x1000, thread_safe_pool>
+		{
+			static type & instance() {
+				static type pool;
+				return pool;
+			}
+		};
+	};
+	
+	struct pooled_block : block, pool_alloc<shared_pool<sizeof(block)>> {};
+	struct magazine_block : block, pool_alloc<shared_pool<magazine_block_size<block>>, thread_magazines> {};
+	
+	template<class T>
+	struct new_allocator
+	{
+		block * allocate() {
+			return new T;
+		}
+		
+		void free(block * ptr) {
+			delete static_cast<T *>(ptr);
+		}
+	};
+	
+	template<class Allocator>
+	static void run(const char * title, int threads_count) {
+		Allocator allocator;
+		
+		auto start = hrc::now();
+		
+		{
+			int groups_count = OPERATIONS / GROUP_SIZE;
+			array_list<array_list<block *>> groups(threads_count);
+			array_list<std::mutex> locks(threads_count);
+			array_list<std::thread> threads;
+			
+			for(int t = 0; t < threads_count; ++t) {
+				threads.emplace_back([&, t]() {
+					array_list<block *> own;
+					int neighbour = (t + 1) % threads_count;
+					
+					for(int g = 0; g < groups_count; ++g) {
+						for(int i = 0; i < GROUP_SIZE; ++i) {
+							own.push_back(allocator.allocate());
+							own.back()->data[0] = static_cast<size_t>(i);
+						}
+						
+						{
+							std::lock_guard<std::mutex> guard(locks[neighbour]);
+							own.swap(groups[neighbour]);
+						}
+						
+						for(auto * ptr : own) {
+							allocator.free(ptr);
+						}
+						
+						own.clear();
+					}
+				});
+			}
+			
+			for(auto & thread : threads) {
+				thread.join();
+			}
+			
+			for(auto & group : groups) {
+				for(auto * ptr : group) {
+					allocator.free(ptr);
+				}
+			}
+		}
+		
+		long long ns = duration_cast<nanoseconds>(hrc::now() - start).count();
+		long long operations = static_cast<long long>(OPERATIONS) * threads_count;
+		std::cout << title << ", " << threads_count << " threads: " << ns / 1000000 << " ms, "
+			<< operations * 1000 / std::max(ns, 1LL) << " M ops/s" << std::endl;
+	}
+	
+	static void stamp(block * b, size_t thread, size_t sequence) {
+		b->data[0] = thread;
+		b->data[1] = sequence;
+		b->data[2] = ~thread;
+		b->data[3] = ~sequence;
+	}
+	
+	static bool stamped(const block * b, size_t thread, size_t sequence) {
+		return b->data[0] == thread && b->data[1] == sequence && b->data[2] == ~thread && b->data[3] == ~sequence;
+	}
+	
+	// false if any block of <blocks> is handed out twice or overlaps another one
+	static bool distinct(array_list<block *> & blocks) {
+		std::sort(blocks.begin(), blocks.end());
+		
+		for(size_t i = 1; i < blocks.size(); ++i) {
+			if(reinterpret_cast<byte *>(blocks[i]) < reinterpret_cast<byte *>(blocks[i - 1]) + sizeof(block)) {
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	/**
+	 *	Every thread stamps the blocks it allocates, checks that nobody else
+	 *	wrote into them and frees the blocks of its neighbour. Returns the
+	 *	count of damaged stamps, blocks which are still allocated at the end
+	 *	are added to <live>.
+	 */
+	template<class Allocator>
+	static int exchange_stamped(Allocator & allocator, int threads_count, array_list<block *> & live) {
+		static const int ROUNDS = 50;
+		
+		array_list<array_list<block *>> groups(threads_count);
+		array_list<array_list<block *>> held(threads_count);
+		array_list<std::mutex> locks(threads_count);
+		array_list<std::thread> threads;
+		std::atomic<int> damaged {0};
+		
+		for(int t = 0; t < threads_count; ++t) {
+			threads.emplace_back([&, t]() {
+				array_list<block *> own;
+				int neighbour = (t + 1) % threads_count;
+				size_t sequence = 0;
+				
+				for(int r = 0; r < ROUNDS; ++r) {
+					size_t first = sequence;
+					
+					for(int i = 0; i < GROUP_SIZE; ++i) {
+						own.push_back(allocator.allocate());
+						stamp(own.back(), t, sequence++);
+					}
+					
+					std::this_thread::yield();
+					
+					for(int i = 0; i < GROUP_SIZE; ++i) {
+						if(!stamped(own[i], t, first + i)) {
+							++damaged;
+						}
+					}
+					
+					{
+						std::lock_guard<std::mutex> guard(locks[neighbour]);
+						own.swap(groups[neighbour]);
+					}
+					
+					for(auto * ptr : own) {
+						allocator.free(ptr);
+					}
+					
+					own.clear();
+				}
+				
+				for(int i = 0; i < GROUP_SIZE; ++i) {
+					held[t].push_back(allocator.allocate());
+					stamp(held[t].back(), t, sequence++);
+				}
+			});
+		}
+		
+		for(auto & thread : threads) {
+			thread.join();
+		}
+		
+		for(int t = 0; t < threads_count; ++t) {
+			for(int i = 0; i < GROUP_SIZE; ++i) {
+				if(!stamped(held[t][i], t, ROUNDS * GROUP_SIZE + i)) {
+					++damaged;
+				}
+			}
+			
+			live.insert(live.end(), held[t].begin(), held[t].end());
+			live.insert(live.end(), groups[t].begin(), groups[t].end());
+		}
+		
+		return damaged;
+	}
+	
+	static bool check_lock_free_pool() {
+		static const uint PAGE_BLOCKS = 0x40;
+		
+		using pool_type = block_pool<block, PAGE_BLOCKS, thread_safe_pool, pool_stats>;
+		
+		for(int threads_count = 1; threads_count <= 64; threads_count *= 2) {
+			pool_type pool;
+			array_list<block *> live;
+			int damaged = exchange_stamped(pool, threads_count, live);
+			
+			if(damaged > 0) {
+				std::cout << "lock-free block_pool, " << threads_count << " threads: " << damaged << " blocks were written by other threads" << std::endl;
+				return false;
+			}
+			
+			if(!distinct(live)) {
+				std::cout << "lock-free block_pool, " << threads_count << " threads: blocks were handed out twice" << std::endl;
+				return false;
+			}
+			
+			// threads start with empty caches and grow the pool by small pages at the same time
+			auto stats = pool.stats().get();
+			
+			if(stats.live != live.size() || stats.pages * PAGE_BLOCKS < live.size()) {
+				std::cout << "lock-free block_pool, " << threads_count << " threads: pages were not grown under contention" << std::endl;
+				return false;
+			}
+			
+			for(auto * ptr : live) {
+				pool.free(ptr);
+			}
+		}
+		
+		// blocks cached by an exited thread are flushed and reused by other threads without growing the pool
+		pool_type pool;
+		internals::thread_index::get();
+		
+		std::thread([&pool]() {
+			array_list<block *> blocks;
+			
+			for(uint i = 0; i < PAGE_BLOCKS / 2 + 8; ++i) {
+				blocks.push_back(pool.allocate());
+			}
+			
+			for(auto * ptr : blocks) {
+				pool.free(ptr);
+			}
+		}).join();
+		
+		array_list<block *> blocks;
+		
+		for(uint i = 0; i < PAGE_BLOCKS; ++i) {
+			blocks.push_back(pool.allocate());
+		}
+		
+		if(pool.stats().get().pages != 1 || !distinct(blocks)) {
+			std::cout << "lock-free block_pool: cache of an exited thread was not flushed" << std::endl;
+			return false;
+		}
+		
+		for(auto * ptr : blocks) {
+			pool.free(ptr);
+		}
+		
+		return true;
+	}
+	
+	// allocator of the magazine checks, its depot is separated from the benchmark
+	struct checked_magazines
+	{
+		using depot = magazine_depot<pool_t<shared_pool<magazine_block_size<block>, checked_magazines>>>;
+		
+		block * allocate() {
+			return static_cast<block *>(depot::allocate());
+		}
+		
+		void free(block * ptr) {
+			depot::free(ptr);
+		}
+	};
+	
+	static void * owner_of(void * ptr) {
+		return (static_cast<magazine_header *>(ptr) - 1)->owner;
+	}
+	
+	static bool check_magazines() {
+		using depot = checked_magazines::depot;
+		
+		// a block freed by another thread goes to the remote queue of its owner, not to the cache of that thread
+		void * remote = depot::allocate();
+		bool taken = false;
+		
+		std::thread([remote, &taken]() {
+			depot::free(remote);
+			array_list<void *> blocks;
+			
+			for(int i = 0; i < GROUP_SIZE * 2; ++i) {
+				blocks.push_back(depot::allocate());
+				taken = taken || blocks.back() == remote;
+			}
+			
+			for(auto * ptr : blocks) {
+				depot::free(ptr);
+			}
+		}).join();
+		
+		array_list<void *> blocks;
+		bool returned = false;
+		
+		for(int i = 0; i < GROUP_SIZE * 2 && !returned; ++i) {
+			blocks.push_back(depot::allocate());
+			returned = blocks.back() == remote;
+		}
+		
+		for(auto * ptr : blocks) {
+			depot::free(ptr);
+		}
+		
+		if(taken || !returned) {
+			std::cout << "magazines: block freed by another thread didn't return to its owner" << std::endl;
+			return false;
+		}
+		
+		// the cache of an exited thread is adopted by the next thread together with blocks freed to it after the exit
+		void * orphan = nullptr;
+		void * owner = nullptr;
+		void * adopted = nullptr;
+		void * first = nullptr;
+		
+		std::thread([&]() {
+			orphan = depot::allocate();
+			owner = owner_of(orphan);
+		}).join();
+		
+		depot::free(orphan);
+		
+		std::thread([&]() {
+			first = depot::allocate();
+			adopted = owner_of(first);
+			depot::free(first);
+		}).join();
+		
+		if(adopted != owner || first != orphan) {
+			std::cout << "magazines: cache of an exited thread was not adopted" << std::endl;
+			return false;
+		}
+		
+		for(int threads_count = 1; threads_count <= 64; threads_count *= 2) {
+			checked_magazines allocator;
+			array_list<block *> live;
+			int damaged = exchange_stamped(allocator, threads_count, live);
+			
+			if(damaged > 0) {
+				std::cout << "magazines, " << threads_count << " threads: " << damaged << " blocks were written by other threads" << std::endl;
+				return false;
+			}
+			
+			if(!distinct(live)) {
+				std::cout << "magazines, " << threads_count << " threads: blocks were handed out twice" << std::endl;
+				return false;
+			}
+			
+			for(auto * ptr : live) {
+				allocator.free(ptr);
+			}
+		}
+		
+		return true;
+	}
+	
+	static int destroyed = 0;
+	
+	struct tracked
+	{
+		tracked(int value) : value(value) {}
+		
+		~tracked() {
+			++destroyed;
+		}
+		
+		int value;
+	};
+	
+	static bool check_data_pool() {
+		using pool_type = data_pool<tracked, 16>;
+		static const uint BLOCKS = pool_type::pageBlocks;
+		destroyed = 0;
+		
+		// pages take their whole alignment, e.g. 4096 blocks of 32 bytes need 144 KB and get 256 KB
+		using large_pool = data_pool<block, 0x1000>;
+		static const size_t slot = sizeof(block) + sizeof(uint);
+		
+		if(BLOCKS < 16 || large_pool::pageBlocks < 0x1000 || large_pool::pageSize - large_pool::pageBlocks * slot > slot + 128) {
+			std::cout << "data_pool: pages don't fill their alignment" << std::endl;
+			return false;
+		}
+		
+		{
+			pool_type pool;
+			pool.watermarks(1, 2);
+			
+			array_list<tracked *> objects;
+			
+			for(int i = 0; i < static_cast<int>(BLOCKS * 4); ++i) {
+				objects.push_back(pool.create(i));
+			}
+			
+			if(pool.pages() != 4 || pool.emptyPages() != 0 || pool.acquired() != BLOCKS * 4) {
+				std::cout << "data_pool: pages were not counted" << std::endl;
+				return false;
+			}
+			
+			// the page of a block is found by its address, the freed block is acquired from that page again
+			pool.free(objects[BLOCKS + 3]);
+			
+			if(pool.acquire() != objects[BLOCKS + 3] || objects[BLOCKS + 3]->value != static_cast<int>(BLOCKS + 3)) {
+				std::cout << "data_pool: freed block was not returned to its page" << std::endl;
+				return false;
+			}
+			
+			// the third empty page exceeds the high watermark, empty pages are released down to the low one
+			for(uint i = 0; i < BLOCKS * 3; ++i) {
+				pool.free(objects[i]);
+			}
+			
+			if(pool.pages() != 2 || pool.emptyPages() != 1 || destroyed != static_cast<int>(BLOCKS * 2)) {
+				std::cout << "data_pool: empty pages were not released at the high watermark" << std::endl;
+				return false;
+			}
+			
+			if(pool.shrink() != 1 || pool.pages() != 1 || pool.emptyPages() != 0 || destroyed != static_cast<int>(BLOCKS * 3)) {
+				std::cout << "data_pool: empty pages were not released by shrink" << std::endl;
+				return false;
+			}
+			
+			for(uint i = BLOCKS * 3; i < BLOCKS * 4; ++i) {
+				if(objects[i]->value != static_cast<int>(i)) {
+					std::cout << "data_pool: objects of used pages were damaged" << std::endl;
+					return false;
+				}
+			}
+			
+			// lowering the high watermark shrinks the pool at once
+			for(uint i = BLOCKS * 3; i < BLOCKS * 4; ++i) {
+				pool.free(objects[i]);
+			}
+			
+			pool.watermarks(0, 2);
+			
+			if(pool.pages() != 1 || pool.emptyPages() != 1) {
+				std::cout << "data_pool: empty pages below the high watermark were released" << std::endl;
+				return false;
+			}
+			
+			pool.watermarks(0, 0);
+			
+			if(pool.pages() != 0 || destroyed != static_cast<int>(BLOCKS * 4)) {
+				std::cout << "data_pool: empty pages were not released by new watermarks" << std::endl;
+				return false;
+			}
+			
+			pool.create(0);
+		}
+		
+		if(destroyed != static_cast<int>(BLOCKS * 4 + 1)) {
+			std::cout << "data_pool: objects were not destroyed with the pool" << std::endl;
+			return false;
+		}
+		
+		return true;
+	}
+	
+	static bool check_arena() {
+		arena a(0x1000);
+		
+		auto * first = a.allocate(64);
+		auto marker = a.mark();
+		auto * second = a.allocate(64);
+		
+		// doesn't fit into a chunk, so it gets a chunk of its own
+		a.allocate(0x2000);
+		a.rewind(marker);
+		
+		if(a.allocate(64) != second) {
+			std::cout << "arena: allocations after the marker were not released" << std::endl;
+			return false;
+		}
+		
+		void * scoped = nullptr;
+		
+		{
+			arena::scope outer(a);
+			
+			if(arena::current() != &a) {
+				std::cout << "arena: scope didn't make its arena current" << std::endl;
+				return false;
+			}
+			
+			{
+				arena nested;
+				arena::scope inner(nested);
+				
+				if(arena::current() != &nested) {
+					std::cout << "arena: nested scope didn't make its arena current" << std::endl;
+					return false;
+				}
+			}
+			
+			if(arena::current() != &a) {
+				std::cout << "arena: nested scope didn't restore the current arena" << std::endl;
+				return false;
+			}
+			
+			scoped = a.allocate(128);
+			a.allocate(0x3000);
+		}
+		
+		if(arena::current() != nullptr || a.allocate(128) != scoped) {
+			std::cout << "arena: scope didn't rewind its arena" << std::endl;
+			return false;
+		}
+		
+		size_t reserved = a.reserved();
+		a.reset();
+		
+		if(a.allocate(64) != first || a.reserved() != reserved) {
+			std::cout << "arena: reset didn't reuse the chunks" << std::endl;
+			return false;
+		}
+		
+		a.release();
+		
+		if(a.reserved() >= reserved) {
+			std::cout << "arena: chunks were not released" << std::endl;
+			return false;
+		}
+		
+		// every guarded allocation ends right before its protected page
+		arena guarded(0x1000, true);
+		auto unguarded = guarded.reserved();
+		auto guard = guarded.mark();
+		
+		for(int i = 0; i < 4; ++i) {
+			auto end = reinterpret_cast<uintptr_t>(guarded.allocate(100, 16)) + 100;
+			
+			if(end % 16 != 4 || (0x1000 - end % 0x1000) % 0x1000 >= 16) {
+				std::cout << "arena: guarded allocation is not placed before its guard page" << std::endl;
+				return false;
+			}
+		}
+		
+		if(guarded.reserved() <= unguarded) {
+			std::cout << "arena: guarded pages were not counted" << std::endl;
+			return false;
+		}
+		
+		guarded.rewind(guard);
+		
+		if(guarded.reserved() != unguarded) {
+			std::cout << "arena: guarded pages were not unmapped on rewind" << std::endl;
+			return false;
+		}
+		
+		return true;
+	}
+	
+	static bool check_page_pool() {
+		static const size_t PAGE = 0x10000;
+		static const size_t REGION_PAGES = huge_page_size / PAGE;
+		
+		PagePool<PAGE, mapped_pages<huge_pages::advise>> pool;
+		array_list<void *> pages;
+		
+		for(size_t i = 0; i < REGION_PAGES + 1; ++i) {
+			pages.push_back(pool.allocatePage());
+			std::memset(pages.back(), 1, PAGE);
+		}
+		
+		if(reinterpret_cast<uintptr_t>(pages[0]) % huge_page_size != 0) {
+			std::cout << "PagePool: mapped region is not aligned to huge pages" << std::endl;
+			return false;
+		}
+		
+		if(pool.used() != (REGION_PAGES + 1) * PAGE || pool.committed() != pool.used() || pool.reserved() != 2 * huge_page_size) {
+			std::cout << "PagePool: pages were not counted" << std::endl;
+			return false;
+		}
+		
+		// the first region is kept while it has used pages
+		pool.freePage(pages[1]);
+		
+		if(pool.decommit() != 0 || pool.used() != REGION_PAGES * PAGE) {
+			std::cout << "PagePool: region with used pages was decommitted" << std::endl;
+			return false;
+		}
+		
+		for(auto * page : pages) {
+			if(page != pages[1]) {
+				pool.freePage(page);
+			}
+		}
+		
+		// the second region is still carved, so only the first one is decommitted
+		if(pool.decommit(REGION_PAGES + 1) != 0 || pool.decommit() != REGION_PAGES) {
+			std::cout << "PagePool: idle region was not decommitted" << std::endl;
+			return false;
+		}
+		
+		if(pool.used() != 0 || pool.committed() != PAGE || pool.reserved() != 2 * huge_page_size) {
+			std::cout << "PagePool: decommitted pages were not counted" << std::endl;
+			return false;
+		}
+		
+		// committed idle pages are reused first, then the decommitted region is recommitted
+		auto * idle = pool.allocatePage();
+		auto * recommitted = pool.allocatePage();
+		std::memset(recommitted, 2, PAGE);
+		
+		if(idle != pages[REGION_PAGES] || pool.committed() != (REGION_PAGES + 1) * PAGE || pool.used() != 2 * PAGE) {
+			std::cout << "PagePool: decommitted region was not recommitted" << std::endl;
+			return false;
+		}
+		
+		PagePool<PAGE> heap;
+		heap.freePage(heap.allocatePage());
+		
+		if(heap.decommit() != 0 || heap.committed() != PAGE) {
+			std::cout << "PagePool: heap pages were decommitted" << std::endl;
+			return false;
+		}
+		
+		return true;
+	}
+	
+	static bool check_pool_registry() {
+		size_t registered = pool_registry::snapshots().size();
+		
+		{
+			data_pool<tracked, 16, empty, pool_stats> pool;
+			array_list<tracked *> objects;
+			
+			for(int i = 0; i < 10; ++i) {
+				objects.push_back(pool.create(i));
+			}
+			
+			for(int i = 0; i < 4; ++i) {
+				pool.free(objects[i]);
+			}
+			
+			auto snapshots = pool_registry::snapshots();
+			
+			if(snapshots.size() != registered + 1) {
+				std::cout << "pool_registry: pool was not registered" << std::endl;
+				return false;
+			}
+			
+			auto s = std::find_if(snapshots.begin(), snapshots.end(), [](const pool_stats::snapshot & snapshot) { return snapshot.name.find("data_pool") != std::string::npos; });
+			
+			if(s == snapshots.end() || s->blockSize != sizeof(tracked) || s->allocations != 10 || s->frees != 4 || s->live != 6 || s->peak != 10 || s->pages != 1) {
+				std::cout << "pool_registry: stats of the pool are wrong" << std::endl;
+				return false;
+			}
+			
+			auto text = pool_registry::text();
+			
+			if(text.find(s->name) == std::string::npos || text.find("allocations: 10, frees: 4") == std::string::npos || text.find("live: 6, peak: 10, pages: 1") == std::string::npos) {
+				std::cout << "pool_registry: text report is wrong:" << std::endl << text;
+				return false;
+			}
+			
+			auto json = pool_registry::json();
+			
+			if(json.front() != '[' || json.back() != ']' || json.find("\"allocations\":10,\"frees\":4,\"remoteFrees\":0,\"live\":6,\"peak\":10,\"pages\":1") == std::string::npos) {
+				std::cout << "pool_registry: JSON report is wrong:" << std::endl << json << std::endl;
+				return false;
+			}
+		}
+		
+		if(pool_registry::snapshots().size() != registered) {
+			std::cout << "pool_registry: destroyed pool was not unregistered" << std::endl;
+			return false;
+		}
+		
+		return true;
+	}
+	
+	static void add(tracked & object, int & trackedSum, int &) {
+		trackedSum += object.value;
+	}
+	
+	static void add(double &, int &, int & doubles) {
+		++doubles;
+	}
+	
+	static bool check_segmented_list() {
+		static const int COUNT = 200;
+		destroyed = 0;
+		
+		{
+			segmented_any_list<64> list;
+			auto * first = &list.emplace_back<tracked>(0);
+			
+			for(int i = 1; i < COUNT; ++i) {
+				if(i % 2 == 0) {
+					list.emplace_back<tracked>(i);
+				} else {
+					list.emplace_back<double>(i);
+				}
+			}
+			
+			auto * last = &list.get<double>(COUNT - 1);
+			
+			if(list.capacity() <= 64 || &list.get<tracked>(0) != first || &list.get_by_offset<tracked>(list.offset(0)) != first || first->value != 0) {
+				std::cout << "segmented_any_list: elements were relocated while the list has grown" << std::endl;
+				return false;
+			}
+			
+			int trackedSum = 0;
+			int doubles = 0;
+			
+			list.for_each<tracked, double>([&](auto & object) {
+				add(object, trackedSum, doubles);
+			});
+			
+			int expectedSum = 0;
+			
+			for(int i = 0; i < COUNT; i += 2) {
+				expectedSum += i;
+			}
+			
+			if(trackedSum != expectedSum || doubles != COUNT / 2) {
+				std::cout << "segmented_any_list: for_each didn't visit every element" << std::endl;
+				return false;
+			}
+			
+			int visited = 0;
+			list.for_each<double>([&visited](double &) { ++visited; });
+			
+			if(visited != COUNT / 2 || list.visit<double>(0, [](double &) {}) || !list.visit<tracked>(0, [](tracked &) {})) {
+				std::cout << "segmented_any_list: elements of other types were visited" << std::endl;
+				return false;
+			}
+			
+			auto copy = list;
+			
+			if(copy.size() != list.size() || &copy.get<tracked>(0) == first || copy.get<tracked>(COUNT - 2).value != COUNT - 2 || copy.get<double>(COUNT - 1) != COUNT - 1) {
+				std::cout << "segmented_any_list: copy is wrong" << std::endl;
+				return false;
+			}
+			
+			copy.get<tracked>(0).value = -1;
+			
+			if(first->value != 0) {
+				std::cout << "segmented_any_list: copy shares elements with its source" << std::endl;
+				return false;
+			}
+			
+			// elements of the inline buffer are moved, elements of segments keep their addresses
+			auto moved = std::move(list);
+			
+			if(!list.empty() || moved.size() != static_cast<size_t>(COUNT) || moved.get<tracked>(0).value != 0 || &moved.get<double>(COUNT - 1) != last) {
+				std::cout << "segmented_any_list: move is wrong" << std::endl;
+				return false;
+			}
+			
+			int before = destroyed;
+			size_t capacity = moved.capacity();
+			moved.clear();
+			
+			if(destroyed - before != COUNT / 2 || moved.capacity() != capacity) {
+				std::cout << "segmented_any_list: clear didn't destroy the elements or didn't keep the segments" << std::endl;
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	static entrance open([]() {
+		if(!check_lock_free_pool() || !check_magazines() || !check_data_pool() || !check_arena() || !check_page_pool() || !check_pool_registry() || !check_segmented_list()) {
+			return 1;
+		}
+		
+		for(int threads_count = 1; threads_count <= 64; threads_count *= 2) {
+			run<lock_free_allocator>("lock-free block_pool", threads_count);
+			run<locked_allocator>("locked block_pool", threads_count);
+			run<malloc_allocator>("malloc", threads_count);
+			run<new_allocator<pooled_block>>("pool_alloc", threads_count);
+			run<new_allocator<magazine_block>>("pool_alloc with magazines", threads_count);
+			std::cout << std::endl;
+		}
+		
+		return 0;
+	});
+}
+
+//---------------------------------------------------------------------------
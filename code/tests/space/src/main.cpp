@@ -2,7 +2,10 @@
 
 #include <application/starter.h>
 #include <space/spatial.h>
+#include <space/transform_store.h>
 #include <iostream>
+#include <random>
+#include <benchmark>
 
 //---------------------------------------------------------------------------
 
@@ -16,6 +19,108 @@ namespace asd
 	
 	const int COUNT = 10000;
 	
+	static bool same(const space::vector & a, const space::vector & b) {
+		return (a - b).max() < space::scalar(1e-4);
+	}
+	
+	// objects behind space::spatial (one virtual call per object) against space::transform_store
+	static bool bench_store(int count) {
+		std::cout << std::endl << count << " objects:" << std::endl;
+		
+		std::mt19937 random;
+		std::uniform_real_distribution<space::scalar> value(-100, 100);
+		
+		// objects are called through pointers to spatial as if they were created separately
+		array_list<space::oriented, aligned_allocator<space::oriented, alignof(space::oriented)>> storage;
+		array_list<space::spatial *> objects;
+		space::transform_store store;
+		array_list<space::transform_handle> handles;
+		array_list<space::vector> velocities;
+		
+		storage.reserve(count);
+		objects.reserve(count);
+		store.reserve(count);
+		
+		repeat(i, count) {
+			space::vector position(value(random), value(random), value(random), 1);
+			space::quaternion rotation(value(random), value(random), value(random));
+			space::vector velocity(value(random), value(random), value(random), 0);
+			
+			storage.emplace_back(position, rotation);
+			objects.push_back(&storage.back());
+			handles.push_back(store.create(position, rotation));
+			store.set_velocity(store.index_of(handles.back()), velocity);
+			velocities.push_back(velocity);
+		}
+		
+		const space::vector offset(1, 2, 3);
+		const space::quaternion turn(space::vector_constants::positive_y, space::scalar(0.01));
+		const space::scalar dt = space::scalar(1.0 / 60);
+		
+		std::string suffix = " x" + std::to_string(count);
+		
+		benchmark("spatial::set_position" + suffix) << [&]() {
+			for(auto * o : objects) {
+				o->set_position(o->position() + offset);
+			}
+		};
+		
+		benchmark("transform_store::move_all" + suffix) << [&]() {
+			store.move_all(offset);
+		};
+		
+		benchmark("spatial::rotate" + suffix) << [&]() {
+			for(auto * o : objects) {
+				o->rotate(turn);
+			}
+		};
+		
+		benchmark("transform_store::rotate_all" + suffix) << [&]() {
+			store.rotate_all(turn);
+		};
+		
+		benchmark("spatial velocities" + suffix) << [&]() {
+			repeat(i, count) {
+				auto * o = objects[i];
+				o->set_position(o->position() + velocities[i] * dt);
+			}
+		};
+		
+		benchmark("transform_store::integrate" + suffix) << [&]() {
+			store.integrate(dt);
+		};
+		
+		repeat(i, count) {
+			space::stored_transform t(store, handles[i]);
+			
+			if(!same(t.position(), objects[i]->position()) || !same(t.rotation().v, objects[i]->rotation().v)) {
+				std::cout << "transform_store differs from space::oriented at " << i << std::endl;
+				return false;
+			}
+		}
+		
+		space::stored_transform first(store, handles[0]);
+		first.move(offset);
+		objects[0]->move(offset);
+		
+		if(!same(first.position(), objects[0]->position())) {
+			std::cout << "stored_transform::move differs from oriented::move" << std::endl;
+			return false;
+		}
+		
+		// destroyed handles are invalid, the remaining ones keep their transforms
+		auto expected = store.position(store.index_of(handles[count - 1]));
+		store.destroy(handles[0]);
+		auto reused = store.create();
+		
+		if(store.contains(handles[0]) || !store.contains(reused) || store.size() != size_t(count) || !same(store.position(store.index_of(handles[count - 1])), expected)) {
+			std::cout << "transform_store handles are broken" << std::endl;
+			return false;
+		}
+		
+		return true;
+	}
+	
 	static entrance main([]() {
 		space::positioned s;
 		space::vector v;
@@ -39,6 +144,28 @@ namespace asd
 		t = duration_cast<nanoseconds>(hrc::now() - last).count();
 		std::cout << "plain vector time: " << t << std::endl;
 		
+		if(!bench_store(1000) || !bench_store(100000) || !bench_store(1000000)) {
+			return 1;
+		}
+		
+		// float loses centimetres a few kilometres away from the origin
+		space::positioned far(space::vector(10000, 0, 0, 1));
+		
+		repeat(i, 100) {
+			far.move({space::scalar(0.01), 0, 0});
+		}
+		
+		auto error = std::abs(far.position().x - 10001);
+		std::cout << "scalar: " << (sizeof(space::scalar) == sizeof(double) ? "double" : "float") << ", error of 1 cm steps at 10 km: " << error << std::endl;
+		
+#ifdef VECTOR_DOUBLE_PRECISION
+		static_assert(std::is_same<space::scalar, double>::value, "VECTOR_DOUBLE_PRECISION must switch space::scalar to double");
+		
+		if(error > 1e-6) {
+			return 1;
+		}
+#endif
+		
 		return 0;
 	});
 }
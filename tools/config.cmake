@@ -48,6 +48,14 @@ elseif("${CMAKE_CXX_COMPILER_ID}" STREQUAL "Clang")
 	set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -msse3")
 endif()
 
+# Precision of space::scalar (float by default)
+
+option(VECTOR_DOUBLE_PRECISION "Use double precision vectors in the space module" OFF)
+
+if(VECTOR_DOUBLE_PRECISION)
+	set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DVECTOR_DOUBLE_PRECISION")
+endif()
+
 #if("${CMAKE_CXX_COMPILER_ID}" STREQUAL "MSVC")
 	#set(USE_DIRECT3D 1 CACHE INTERNAL "Use direct3d flag")
     #add_module(d3d tests)